@@ -0,0 +1,24 @@
+
+# Consider dependencies only in project.
+set(CMAKE_DEPENDS_IN_PROJECT_ONLY OFF)
+
+# The set of languages for which implicit dependencies are needed:
+set(CMAKE_DEPENDS_LANGUAGES
+  )
+
+# The set of dependency files which are needed:
+set(CMAKE_DEPENDS_DEPENDENCY_FILES
+  "/root/repo/src/server/memcached/memcached.cpp" "src/benchmark/CMakeFiles/benchmark_ascii_parser.dir/__/server/memcached/memcached.cpp.o" "gcc" "src/benchmark/CMakeFiles/benchmark_ascii_parser.dir/__/server/memcached/memcached.cpp.o.d"
+  "/root/repo/src/server/memcached/proto_ascii.cpp" "src/benchmark/CMakeFiles/benchmark_ascii_parser.dir/__/server/memcached/proto_ascii.cpp.o" "gcc" "src/benchmark/CMakeFiles/benchmark_ascii_parser.dir/__/server/memcached/proto_ascii.cpp.o.d"
+  "/root/repo/src/server/memcached/proto_binary.cpp" "src/benchmark/CMakeFiles/benchmark_ascii_parser.dir/__/server/memcached/proto_binary.cpp.o" "gcc" "src/benchmark/CMakeFiles/benchmark_ascii_parser.dir/__/server/memcached/proto_binary.cpp.o.d"
+  "/root/repo/src/server/settings.cpp" "src/benchmark/CMakeFiles/benchmark_ascii_parser.dir/__/server/settings.cpp.o" "gcc" "src/benchmark/CMakeFiles/benchmark_ascii_parser.dir/__/server/settings.cpp.o.d"
+  "/root/repo/src/benchmark/benchmark_ascii_parser.cpp" "src/benchmark/CMakeFiles/benchmark_ascii_parser.dir/benchmark_ascii_parser.cpp.o" "gcc" "src/benchmark/CMakeFiles/benchmark_ascii_parser.dir/benchmark_ascii_parser.cpp.o.d"
+  )
+
+# Targets to which this target links.
+set(CMAKE_TARGET_LINKED_INFO_FILES
+  "/root/repo/_dbg_build/src/cachelot/CMakeFiles/cachelot.dir/DependInfo.cmake"
+  )
+
+# Fortran module output directory.
+set(CMAKE_Fortran_TARGET_MODULE_DIR "")
@@ -0,0 +1,19 @@
+file(REMOVE_RECURSE
+  "/root/repo/bin/Debug/benchmark_ascii_parser"
+  "/root/repo/bin/Debug/benchmark_ascii_parser.pdb"
+  "CMakeFiles/benchmark_ascii_parser.dir/__/server/memcached/memcached.cpp.o"
+  "CMakeFiles/benchmark_ascii_parser.dir/__/server/memcached/memcached.cpp.o.d"
+  "CMakeFiles/benchmark_ascii_parser.dir/__/server/memcached/proto_ascii.cpp.o"
+  "CMakeFiles/benchmark_ascii_parser.dir/__/server/memcached/proto_ascii.cpp.o.d"
+  "CMakeFiles/benchmark_ascii_parser.dir/__/server/memcached/proto_binary.cpp.o"
+  "CMakeFiles/benchmark_ascii_parser.dir/__/server/memcached/proto_binary.cpp.o.d"
+  "CMakeFiles/benchmark_ascii_parser.dir/__/server/settings.cpp.o"
+  "CMakeFiles/benchmark_ascii_parser.dir/__/server/settings.cpp.o.d"
+  "CMakeFiles/benchmark_ascii_parser.dir/benchmark_ascii_parser.cpp.o"
+  "CMakeFiles/benchmark_ascii_parser.dir/benchmark_ascii_parser.cpp.o.d"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/benchmark_ascii_parser.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
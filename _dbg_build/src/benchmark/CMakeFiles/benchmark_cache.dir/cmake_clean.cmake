@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "/root/repo/bin/Debug/benchmark_cache"
+  "/root/repo/bin/Debug/benchmark_cache.pdb"
+  "CMakeFiles/benchmark_cache.dir/benchmark_cache.cpp.o"
+  "CMakeFiles/benchmark_cache.dir/benchmark_cache.cpp.o.d"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/benchmark_cache.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,21 @@
+
+# Consider dependencies only in project.
+set(CMAKE_DEPENDS_IN_PROJECT_ONLY OFF)
+
+# The set of languages for which implicit dependencies are needed:
+set(CMAKE_DEPENDS_LANGUAGES
+  )
+
+# The set of dependency files which are needed:
+set(CMAKE_DEPENDS_DEPENDENCY_FILES
+  "/root/repo/src/thirdparty/TLSF-2.4.6/src/tlsf.c" "src/benchmark/CMakeFiles/benchmark_memalloc.dir/__/thirdparty/TLSF-2.4.6/src/tlsf.c.o" "gcc" "src/benchmark/CMakeFiles/benchmark_memalloc.dir/__/thirdparty/TLSF-2.4.6/src/tlsf.c.o.d"
+  "/root/repo/src/benchmark/benchmark_memalloc.cpp" "src/benchmark/CMakeFiles/benchmark_memalloc.dir/benchmark_memalloc.cpp.o" "gcc" "src/benchmark/CMakeFiles/benchmark_memalloc.dir/benchmark_memalloc.cpp.o.d"
+  )
+
+# Targets to which this target links.
+set(CMAKE_TARGET_LINKED_INFO_FILES
+  "/root/repo/_dbg_build/src/cachelot/CMakeFiles/cachelot.dir/DependInfo.cmake"
+  )
+
+# Fortran module output directory.
+set(CMAKE_Fortran_TARGET_MODULE_DIR "")
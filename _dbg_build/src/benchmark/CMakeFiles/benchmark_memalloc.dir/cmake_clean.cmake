@@ -0,0 +1,13 @@
+file(REMOVE_RECURSE
+  "/root/repo/bin/Debug/benchmark_memalloc"
+  "/root/repo/bin/Debug/benchmark_memalloc.pdb"
+  "CMakeFiles/benchmark_memalloc.dir/__/thirdparty/TLSF-2.4.6/src/tlsf.c.o"
+  "CMakeFiles/benchmark_memalloc.dir/__/thirdparty/TLSF-2.4.6/src/tlsf.c.o.d"
+  "CMakeFiles/benchmark_memalloc.dir/benchmark_memalloc.cpp.o"
+  "CMakeFiles/benchmark_memalloc.dir/benchmark_memalloc.cpp.o.d"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang C CXX)
+  include(CMakeFiles/benchmark_memalloc.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "/root/repo/bin/Debug/benchmark_server"
+  "/root/repo/bin/Debug/benchmark_server.pdb"
+  "CMakeFiles/benchmark_server.dir/benchmark_server.cpp.o"
+  "CMakeFiles/benchmark_server.dir/benchmark_server.cpp.o.d"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/benchmark_server.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,22 @@
+
+# Consider dependencies only in project.
+set(CMAKE_DEPENDS_IN_PROJECT_ONLY OFF)
+
+# The set of languages for which implicit dependencies are needed:
+set(CMAKE_DEPENDS_LANGUAGES
+  )
+
+# The set of dependency files which are needed:
+set(CMAKE_DEPENDS_DEPENDENCY_FILES
+  "/root/repo/src/cachelot/c_api.cpp" "src/cachelot/CMakeFiles/cachelot.dir/c_api.cpp.o" "gcc" "src/cachelot/CMakeFiles/cachelot.dir/c_api.cpp.o.d"
+  "/root/repo/src/cachelot/common.cpp" "src/cachelot/CMakeFiles/cachelot.dir/common.cpp.o" "gcc" "src/cachelot/CMakeFiles/cachelot.dir/common.cpp.o.d"
+  "/root/repo/src/cachelot/item.cpp" "src/cachelot/CMakeFiles/cachelot.dir/item.cpp.o" "gcc" "src/cachelot/CMakeFiles/cachelot.dir/item.cpp.o.d"
+  "/root/repo/src/cachelot/stats.cpp" "src/cachelot/CMakeFiles/cachelot.dir/stats.cpp.o" "gcc" "src/cachelot/CMakeFiles/cachelot.dir/stats.cpp.o.d"
+  )
+
+# Targets to which this target links.
+set(CMAKE_TARGET_LINKED_INFO_FILES
+  )
+
+# Fortran module output directory.
+set(CMAKE_Fortran_TARGET_MODULE_DIR "")
@@ -0,0 +1,17 @@
+file(REMOVE_RECURSE
+  "/root/repo/lib/Debug/libcachelot.a"
+  "/root/repo/lib/Debug/libcachelot.pdb"
+  "CMakeFiles/cachelot.dir/c_api.cpp.o"
+  "CMakeFiles/cachelot.dir/c_api.cpp.o.d"
+  "CMakeFiles/cachelot.dir/common.cpp.o"
+  "CMakeFiles/cachelot.dir/common.cpp.o.d"
+  "CMakeFiles/cachelot.dir/item.cpp.o"
+  "CMakeFiles/cachelot.dir/item.cpp.o.d"
+  "CMakeFiles/cachelot.dir/stats.cpp.o"
+  "CMakeFiles/cachelot.dir/stats.cpp.o.d"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/cachelot.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,76 @@
+# Install script for directory: /root/repo/src/cachelot
+
+# Set the install prefix
+if(NOT DEFINED CMAKE_INSTALL_PREFIX)
+  set(CMAKE_INSTALL_PREFIX "/usr/local")
+endif()
+string(REGEX REPLACE "/$" "" CMAKE_INSTALL_PREFIX "${CMAKE_INSTALL_PREFIX}")
+
+# Set the install configuration name.
+if(NOT DEFINED CMAKE_INSTALL_CONFIG_NAME)
+  if(BUILD_TYPE)
+    string(REGEX REPLACE "^[^A-Za-z0-9_]+" ""
+           CMAKE_INSTALL_CONFIG_NAME "${BUILD_TYPE}")
+  else()
+    set(CMAKE_INSTALL_CONFIG_NAME "Debug")
+  endif()
+  message(STATUS "Install configuration: \"${CMAKE_INSTALL_CONFIG_NAME}\"")
+endif()
+
+# Set the component getting installed.
+if(NOT CMAKE_INSTALL_COMPONENT)
+  if(COMPONENT)
+    message(STATUS "Install component: \"${COMPONENT}\"")
+    set(CMAKE_INSTALL_COMPONENT "${COMPONENT}")
+  else()
+    set(CMAKE_INSTALL_COMPONENT)
+  endif()
+endif()
+
+# Install shared libraries without execute permission?
+if(NOT DEFINED CMAKE_INSTALL_SO_NO_EXE)
+  set(CMAKE_INSTALL_SO_NO_EXE "1")
+endif()
+
+# Is this installation the result of a crosscompile?
+if(NOT DEFINED CMAKE_CROSSCOMPILING)
+  set(CMAKE_CROSSCOMPILING "FALSE")
+endif()
+
+# Set default install directory permissions.
+if(NOT DEFINED CMAKE_OBJDUMP)
+  set(CMAKE_OBJDUMP "/usr/bin/objdump")
+endif()
+
+if(CMAKE_INSTALL_COMPONENT STREQUAL "Unspecified" OR NOT CMAKE_INSTALL_COMPONENT)
+  file(INSTALL DESTINATION "${CMAKE_INSTALL_PREFIX}/lib" TYPE STATIC_LIBRARY FILES "/root/repo/lib/Debug/libcachelot.a")
+endif()
+
+if(CMAKE_INSTALL_COMPONENT STREQUAL "Unspecified" OR NOT CMAKE_INSTALL_COMPONENT)
+  file(INSTALL DESTINATION "${CMAKE_INSTALL_PREFIX}/include" TYPE FILE FILES
+    "/root/repo/src/cachelot/bits.h"
+    "/root/repo/src/cachelot/byte_search.h"
+    "/root/repo/src/cachelot/slice.h"
+    "/root/repo/src/cachelot/cache.h"
+    "/root/repo/src/cachelot/common.h"
+    "/root/repo/src/cachelot/dict.h"
+    "/root/repo/src/cachelot/error.h"
+    "/root/repo/src/cachelot/expiration_clock.h"
+    "/root/repo/src/cachelot/hash_fnv1a.h"
+    "/root/repo/src/cachelot/hash_wyhash.h"
+    "/root/repo/src/cachelot/hash_table.h"
+    "/root/repo/src/cachelot/intrusive_list.h"
+    "/root/repo/src/cachelot/lz4.h"
+    "/root/repo/src/cachelot/item.h"
+    "/root/repo/src/cachelot/memalloc-inl.h"
+    "/root/repo/src/cachelot/memalloc.h"
+    "/root/repo/src/cachelot/mempools.h"
+    "/root/repo/src/cachelot/segmalloc.h"
+    "/root/repo/src/cachelot/random.h"
+    "/root/repo/src/cachelot/stats.h"
+    "/root/repo/src/cachelot/string_conv.h"
+    "/root/repo/src/cachelot/version.h"
+    "/root/repo/src/cachelot/c_api.h"
+    )
+endif()
+
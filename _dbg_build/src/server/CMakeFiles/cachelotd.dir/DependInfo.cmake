@@ -0,0 +1,24 @@
+
+# Consider dependencies only in project.
+set(CMAKE_DEPENDS_IN_PROJECT_ONLY OFF)
+
+# The set of languages for which implicit dependencies are needed:
+set(CMAKE_DEPENDS_LANGUAGES
+  )
+
+# The set of dependency files which are needed:
+set(CMAKE_DEPENDS_DEPENDENCY_FILES
+  "/root/repo/src/server/main.cpp" "src/server/CMakeFiles/cachelotd.dir/main.cpp.o" "gcc" "src/server/CMakeFiles/cachelotd.dir/main.cpp.o.d"
+  "/root/repo/src/server/memcached/memcached.cpp" "src/server/CMakeFiles/cachelotd.dir/memcached/memcached.cpp.o" "gcc" "src/server/CMakeFiles/cachelotd.dir/memcached/memcached.cpp.o.d"
+  "/root/repo/src/server/memcached/proto_ascii.cpp" "src/server/CMakeFiles/cachelotd.dir/memcached/proto_ascii.cpp.o" "gcc" "src/server/CMakeFiles/cachelotd.dir/memcached/proto_ascii.cpp.o.d"
+  "/root/repo/src/server/memcached/proto_binary.cpp" "src/server/CMakeFiles/cachelotd.dir/memcached/proto_binary.cpp.o" "gcc" "src/server/CMakeFiles/cachelotd.dir/memcached/proto_binary.cpp.o.d"
+  "/root/repo/src/server/settings.cpp" "src/server/CMakeFiles/cachelotd.dir/settings.cpp.o" "gcc" "src/server/CMakeFiles/cachelotd.dir/settings.cpp.o.d"
+  )
+
+# Targets to which this target links.
+set(CMAKE_TARGET_LINKED_INFO_FILES
+  "/root/repo/_dbg_build/src/cachelot/CMakeFiles/cachelot.dir/DependInfo.cmake"
+  )
+
+# Fortran module output directory.
+set(CMAKE_Fortran_TARGET_MODULE_DIR "")
@@ -0,0 +1,19 @@
+file(REMOVE_RECURSE
+  "/root/repo/bin/Debug/cachelotd"
+  "/root/repo/bin/Debug/cachelotd.pdb"
+  "CMakeFiles/cachelotd.dir/main.cpp.o"
+  "CMakeFiles/cachelotd.dir/main.cpp.o.d"
+  "CMakeFiles/cachelotd.dir/memcached/memcached.cpp.o"
+  "CMakeFiles/cachelotd.dir/memcached/memcached.cpp.o.d"
+  "CMakeFiles/cachelotd.dir/memcached/proto_ascii.cpp.o"
+  "CMakeFiles/cachelotd.dir/memcached/proto_ascii.cpp.o.d"
+  "CMakeFiles/cachelotd.dir/memcached/proto_binary.cpp.o"
+  "CMakeFiles/cachelotd.dir/memcached/proto_binary.cpp.o.d"
+  "CMakeFiles/cachelotd.dir/settings.cpp.o"
+  "CMakeFiles/cachelotd.dir/settings.cpp.o.d"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/cachelotd.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
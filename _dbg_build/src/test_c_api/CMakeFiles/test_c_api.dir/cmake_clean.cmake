@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "/root/repo/bin/Debug/test_c_api"
+  "/root/repo/bin/Debug/test_c_api.pdb"
+  "CMakeFiles/test_c_api.dir/test_c_api.c.o"
+  "CMakeFiles/test_c_api.dir/test_c_api.c.o.d"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang C)
+  include(CMakeFiles/test_c_api.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,38 @@
+
+# Consider dependencies only in project.
+set(CMAKE_DEPENDS_IN_PROJECT_ONLY OFF)
+
+# The set of languages for which implicit dependencies are needed:
+set(CMAKE_DEPENDS_LANGUAGES
+  )
+
+# The set of dependency files which are needed:
+set(CMAKE_DEPENDS_DEPENDENCY_FILES
+  "/root/repo/src/unit_test/test_bits.cpp" "src/unit_test/CMakeFiles/unit_tests.dir/test_bits.cpp.o" "gcc" "src/unit_test/CMakeFiles/unit_tests.dir/test_bits.cpp.o.d"
+  "/root/repo/src/unit_test/test_cache.cpp" "src/unit_test/CMakeFiles/unit_tests.dir/test_cache.cpp.o" "gcc" "src/unit_test/CMakeFiles/unit_tests.dir/test_cache.cpp.o.d"
+  "/root/repo/src/unit_test/test_cache_stats.cpp" "src/unit_test/CMakeFiles/unit_tests.dir/test_cache_stats.cpp.o" "gcc" "src/unit_test/CMakeFiles/unit_tests.dir/test_cache_stats.cpp.o.d"
+  "/root/repo/src/unit_test/test_cgroup_memory.cpp" "src/unit_test/CMakeFiles/unit_tests.dir/test_cgroup_memory.cpp.o" "gcc" "src/unit_test/CMakeFiles/unit_tests.dir/test_cgroup_memory.cpp.o.d"
+  "/root/repo/src/unit_test/test_dict.cpp" "src/unit_test/CMakeFiles/unit_tests.dir/test_dict.cpp.o" "gcc" "src/unit_test/CMakeFiles/unit_tests.dir/test_dict.cpp.o.d"
+  "/root/repo/src/unit_test/test_hash.cpp" "src/unit_test/CMakeFiles/unit_tests.dir/test_hash.cpp.o" "gcc" "src/unit_test/CMakeFiles/unit_tests.dir/test_hash.cpp.o.d"
+  "/root/repo/src/unit_test/test_hash_table.cpp" "src/unit_test/CMakeFiles/unit_tests.dir/test_hash_table.cpp.o" "gcc" "src/unit_test/CMakeFiles/unit_tests.dir/test_hash_table.cpp.o.d"
+  "/root/repo/src/unit_test/test_intrusive_list.cpp" "src/unit_test/CMakeFiles/unit_tests.dir/test_intrusive_list.cpp.o" "gcc" "src/unit_test/CMakeFiles/unit_tests.dir/test_intrusive_list.cpp.o.d"
+  "/root/repo/src/unit_test/test_io_buffer.cpp" "src/unit_test/CMakeFiles/unit_tests.dir/test_io_buffer.cpp.o" "gcc" "src/unit_test/CMakeFiles/unit_tests.dir/test_io_buffer.cpp.o.d"
+  "/root/repo/src/unit_test/test_io_uring.cpp" "src/unit_test/CMakeFiles/unit_tests.dir/test_io_uring.cpp.o" "gcc" "src/unit_test/CMakeFiles/unit_tests.dir/test_io_uring.cpp.o.d"
+  "/root/repo/src/unit_test/test_item.cpp" "src/unit_test/CMakeFiles/unit_tests.dir/test_item.cpp.o" "gcc" "src/unit_test/CMakeFiles/unit_tests.dir/test_item.cpp.o.d"
+  "/root/repo/src/unit_test/test_lz4.cpp" "src/unit_test/CMakeFiles/unit_tests.dir/test_lz4.cpp.o" "gcc" "src/unit_test/CMakeFiles/unit_tests.dir/test_lz4.cpp.o.d"
+  "/root/repo/src/unit_test/test_memalloc.cpp" "src/unit_test/CMakeFiles/unit_tests.dir/test_memalloc.cpp.o" "gcc" "src/unit_test/CMakeFiles/unit_tests.dir/test_memalloc.cpp.o.d"
+  "/root/repo/src/unit_test/test_mempools.cpp" "src/unit_test/CMakeFiles/unit_tests.dir/test_mempools.cpp.o" "gcc" "src/unit_test/CMakeFiles/unit_tests.dir/test_mempools.cpp.o.d"
+  "/root/repo/src/unit_test/test_segmalloc.cpp" "src/unit_test/CMakeFiles/unit_tests.dir/test_segmalloc.cpp.o" "gcc" "src/unit_test/CMakeFiles/unit_tests.dir/test_segmalloc.cpp.o.d"
+  "/root/repo/src/unit_test/test_slice.cpp" "src/unit_test/CMakeFiles/unit_tests.dir/test_slice.cpp.o" "gcc" "src/unit_test/CMakeFiles/unit_tests.dir/test_slice.cpp.o.d"
+  "/root/repo/src/unit_test/test_stats.cpp" "src/unit_test/CMakeFiles/unit_tests.dir/test_stats.cpp.o" "gcc" "src/unit_test/CMakeFiles/unit_tests.dir/test_stats.cpp.o.d"
+  "/root/repo/src/unit_test/test_string_conv.cpp" "src/unit_test/CMakeFiles/unit_tests.dir/test_string_conv.cpp.o" "gcc" "src/unit_test/CMakeFiles/unit_tests.dir/test_string_conv.cpp.o.d"
+  "/root/repo/src/unit_test/unit_test.cpp" "src/unit_test/CMakeFiles/unit_tests.dir/unit_test.cpp.o" "gcc" "src/unit_test/CMakeFiles/unit_tests.dir/unit_test.cpp.o.d"
+  )
+
+# Targets to which this target links.
+set(CMAKE_TARGET_LINKED_INFO_FILES
+  "/root/repo/_dbg_build/src/cachelot/CMakeFiles/cachelot.dir/DependInfo.cmake"
+  )
+
+# Fortran module output directory.
+set(CMAKE_Fortran_TARGET_MODULE_DIR "")
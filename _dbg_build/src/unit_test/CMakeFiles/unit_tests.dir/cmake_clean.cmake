@@ -0,0 +1,47 @@
+file(REMOVE_RECURSE
+  "/root/repo/bin/Debug/unit_tests"
+  "/root/repo/bin/Debug/unit_tests.pdb"
+  "CMakeFiles/unit_tests.dir/test_bits.cpp.o"
+  "CMakeFiles/unit_tests.dir/test_bits.cpp.o.d"
+  "CMakeFiles/unit_tests.dir/test_cache.cpp.o"
+  "CMakeFiles/unit_tests.dir/test_cache.cpp.o.d"
+  "CMakeFiles/unit_tests.dir/test_cache_stats.cpp.o"
+  "CMakeFiles/unit_tests.dir/test_cache_stats.cpp.o.d"
+  "CMakeFiles/unit_tests.dir/test_cgroup_memory.cpp.o"
+  "CMakeFiles/unit_tests.dir/test_cgroup_memory.cpp.o.d"
+  "CMakeFiles/unit_tests.dir/test_dict.cpp.o"
+  "CMakeFiles/unit_tests.dir/test_dict.cpp.o.d"
+  "CMakeFiles/unit_tests.dir/test_hash.cpp.o"
+  "CMakeFiles/unit_tests.dir/test_hash.cpp.o.d"
+  "CMakeFiles/unit_tests.dir/test_hash_table.cpp.o"
+  "CMakeFiles/unit_tests.dir/test_hash_table.cpp.o.d"
+  "CMakeFiles/unit_tests.dir/test_intrusive_list.cpp.o"
+  "CMakeFiles/unit_tests.dir/test_intrusive_list.cpp.o.d"
+  "CMakeFiles/unit_tests.dir/test_io_buffer.cpp.o"
+  "CMakeFiles/unit_tests.dir/test_io_buffer.cpp.o.d"
+  "CMakeFiles/unit_tests.dir/test_io_uring.cpp.o"
+  "CMakeFiles/unit_tests.dir/test_io_uring.cpp.o.d"
+  "CMakeFiles/unit_tests.dir/test_item.cpp.o"
+  "CMakeFiles/unit_tests.dir/test_item.cpp.o.d"
+  "CMakeFiles/unit_tests.dir/test_lz4.cpp.o"
+  "CMakeFiles/unit_tests.dir/test_lz4.cpp.o.d"
+  "CMakeFiles/unit_tests.dir/test_memalloc.cpp.o"
+  "CMakeFiles/unit_tests.dir/test_memalloc.cpp.o.d"
+  "CMakeFiles/unit_tests.dir/test_mempools.cpp.o"
+  "CMakeFiles/unit_tests.dir/test_mempools.cpp.o.d"
+  "CMakeFiles/unit_tests.dir/test_segmalloc.cpp.o"
+  "CMakeFiles/unit_tests.dir/test_segmalloc.cpp.o.d"
+  "CMakeFiles/unit_tests.dir/test_slice.cpp.o"
+  "CMakeFiles/unit_tests.dir/test_slice.cpp.o.d"
+  "CMakeFiles/unit_tests.dir/test_stats.cpp.o"
+  "CMakeFiles/unit_tests.dir/test_stats.cpp.o.d"
+  "CMakeFiles/unit_tests.dir/test_string_conv.cpp.o"
+  "CMakeFiles/unit_tests.dir/test_string_conv.cpp.o.d"
+  "CMakeFiles/unit_tests.dir/unit_test.cpp.o"
+  "CMakeFiles/unit_tests.dir/unit_test.cpp.o.d"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/unit_tests.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,212 @@
+#include <cachelot/common.h>
+#include <cachelot/cache.h>
+#include <cachelot/random.h>
+#include <server/memcached/memcached.h>
+
+#include <iostream>
+#include <iomanip>
+
+using namespace cachelot;
+
+constexpr size_t cache_memory = 64 * Megabyte;
+constexpr size_t page_size = 4 * Megabyte;
+constexpr size_t hash_initial = 131072;
+constexpr size_t num_keys = 10000;
+constexpr size_t num_passes = 50;
+
+namespace {
+
+    std::vector<string> keys;
+
+    // canned traffic: many pipelined requests of the same kind
+    typedef string (*request_generator)(size_t n);
+
+    string get_request(size_t n) {
+        return "get " + keys[n] + "\r\n";
+    }
+
+    string multiget_request(size_t n) {
+        string request = "get";
+        for (size_t i = 0; i < 16; ++i) {
+            request += " " + keys[(n + i * 31) % keys.size()];
+        }
+        return request + "\r\n";
+    }
+
+    string set_request(size_t n) {
+        const string value(100 + n % 100, 'v');
+        return "set " + keys[n] + " 0 0 " + std::to_string(value.size()) + "\r\n" + value + "\r\n";
+    }
+
+    string cas_request(size_t n) {
+        return "cas " + keys[n] + " 12345 3600 5 " + std::to_string(1000000000000u + n) + " noreply\r\nvalue\r\n";
+    }
+
+    string incr_request(size_t n) {
+        return "incr counter:" + std::to_string(n % 100) + " 100000000\r\n";
+    }
+
+    string meta_get_request(size_t n) {
+        return "mg " + keys[n] + " v f t c k O" + std::to_string(n) + "\r\n";
+    }
+
+    string canned_traffic(request_generator make_request) {
+        string traffic;
+        for (size_t n = 0; n < keys.size(); ++n) {
+            traffic += make_request(n);
+        }
+        return traffic;
+    }
+
+
+    // feed `traffic` to the protocol parser `num_passes` times, return average time per request in ns
+    double handle_requests_ns(const string & traffic, cache::Cache & the_cache) {
+        io_buffer recv_buf(traffic.size(), traffic.size());
+        io_buffer send_buf(16 * Megabyte, 256 * Megabyte);
+        memcached::ParserState state;
+        size_t num_requests = 0;
+        auto start_time = std::chrono::high_resolution_clock::now();
+        for (size_t pass = 0; pass < num_passes; ++pass) {
+            recv_buf.reset();
+            std::memcpy(recv_buf.begin_write(traffic.size()), traffic.data(), traffic.size());
+            recv_buf.confirm_write(traffic.size());
+            while (recv_buf.non_read() > 0) {
+                memcached::handle_received_requests(recv_buf, send_buf, the_cache, state, 1, 0);
+                num_requests += 1;
+            }
+            send_buf.reset();
+        }
+        auto time_passed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::high_resolution_clock::now() - start_time);
+        return static_cast<double>(time_passed.count()) / num_requests;
+    }
+
+
+    // split request headers into tokens, return average time per header in ns
+    template <typename Tokenizer>
+    double tokenize_ns(const std::vector<string> & headers, Tokenizer tokenize) {
+        volatile size_t sink = 0;
+        auto start_time = std::chrono::high_resolution_clock::now();
+        for (size_t pass = 0; pass < num_passes; ++pass) {
+            for (const auto & header : headers) {
+                sink = sink + tokenize(slice(header.data(), header.size()));
+            }
+        }
+        auto time_passed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::high_resolution_clock::now() - start_time);
+        return static_cast<double>(time_passed.count()) / (headers.size() * num_passes);
+    }
+
+    // byte by byte scan (reference)
+    size_t tokenize_scalar(slice header) {
+        const char * end = std::search(header.begin(), header.end(), "\r\n", "\r\n" + 2);
+        size_t num_tokens = 0;
+        for (const char * pos = header.begin(); pos < end; ) {
+            const char * space = std::find(pos, end, ' ');
+            num_tokens += 1;
+            pos = space < end ? space + 1 : end;
+        }
+        return num_tokens;
+    }
+
+    size_t tokenize_vectorized(slice header) {
+        slice line = std::get<0>(header.split(slice::from_literal("\r\n")));
+        size_t num_tokens = 0;
+        while (not line.empty()) {
+            line = std::get<1>(line.split(' '));
+            num_tokens += 1;
+        }
+        return num_tokens;
+    }
+
+
+    // byte by byte conversion works for any iterator, pointer to the contiguous memory lets to convert 8 digits at once
+    string::const_iterator begin_of(const string & s, string::const_iterator) { return s.begin(); }
+    const char * begin_of(const string & s, const char *) { return s.data(); }
+
+    // convert ASCII numbers, return average time per number in ns
+    template <class ConstIterator>
+    double str_to_int_ns(const std::vector<string> & numbers) {
+        volatile uint64 sink = 0;
+        auto start_time = std::chrono::high_resolution_clock::now();
+        for (size_t pass = 0; pass < num_passes; ++pass) {
+            for (const auto & number : numbers) {
+                const ConstIterator begin = begin_of(number, ConstIterator());
+                sink = sink + str_to_int<uint64>(begin, begin + number.size());
+            }
+        }
+        auto time_passed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::high_resolution_clock::now() - start_time);
+        return static_cast<double>(time_passed.count()) / (numbers.size() * num_passes);
+    }
+
+} // anonymous namespace
+
+
+static void benchmark_tokenizer() {
+    std::cout << std::fixed << std::setprecision(1);
+    std::cout << "Tokenizer (ns per header)          byte by byte   vectorized" << std::endl;
+    for (auto generator : { get_request, multiget_request, set_request, meta_get_request }) {
+        std::vector<string> headers;
+        for (size_t n = 0; n < keys.size(); ++n) {
+            const string request = generator(n);
+            headers.push_back(request.substr(0, request.find("\r\n") + 2));
+        }
+        const string title = headers.front().substr(0, headers.front().find(' '));
+        std::cout << std::left << std::setw(35) << title << std::right
+                  << std::setw(12) << tokenize_ns(headers, tokenize_scalar)
+                  << std::setw(13) << tokenize_ns(headers, tokenize_vectorized) << std::endl;
+    }
+    std::cout << std::endl;
+}
+
+
+static void benchmark_numbers() {
+    std::cout << std::fixed << std::setprecision(1);
+    std::cout << "Number parsing (ns per number)     byte by byte   8 digits at once" << std::endl;
+    for (size_t num_digits : { 1, 4, 8, 13, 19 }) {
+        std::vector<string> numbers;
+        random_int<uint64> rnd_digit(0, 9);
+        for (size_t n = 0; n < num_keys; ++n) {
+            string number;
+            for (size_t d = 0; d < num_digits; ++d) {
+                number += static_cast<char>('0' + rnd_digit());
+            }
+            numbers.push_back(number);
+        }
+        const string title = std::to_string(num_digits) + " digits";
+        std::cout << std::left << std::setw(35) << title << std::right
+                  << std::setw(12) << str_to_int_ns<string::const_iterator>(numbers)
+                  << std::setw(13) << str_to_int_ns<const char *>(numbers) << std::endl;
+    }
+    std::cout << std::endl;
+}
+
+
+static void benchmark_requests() {
+    auto the_cache = cache::Cache::Create(cache_memory, page_size, hash_initial, true);
+    std::cout << std::fixed << std::setprecision(1);
+    std::cout << "Requests (ns per request, including cache)" << std::endl;
+    const std::pair<const char *, request_generator> traffic_profiles[] = {
+        { "set 100-200 bytes", set_request },
+        { "get", get_request },
+        { "get 16 keys", multiget_request },
+        { "cas noreply", cas_request },
+        { "incr", incr_request },
+        { "mg v f t c k O", meta_get_request },
+    };
+    for (const auto & profile : traffic_profiles) {
+        const string traffic = canned_traffic(profile.second);
+        std::cout << std::left << std::setw(35) << profile.first << std::right
+                  << std::setw(12) << handle_requests_ns(traffic, the_cache) << std::endl;
+    }
+    std::cout << std::endl;
+}
+
+
+int main(int /*argc*/, char * /*argv*/[]) {
+    for (size_t n = 0; n < num_keys; ++n) {
+        keys.push_back(random_string(10, 40));
+    }
+    benchmark_tokenizer();
+    benchmark_numbers();
+    benchmark_requests();
+    return 0;
+}
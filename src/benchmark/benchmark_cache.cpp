@@ -2,6 +2,7 @@
 #include <cachelot/cache.h>
 #include <cachelot/random.h>
 #include <cachelot/hash_fnv1a.h>
+#include <cachelot/hash_wyhash.h>
 #include <cachelot/stats.h>
 
 #include <iostream>
@@ -27,7 +28,7 @@ constexpr uint32 max_value_len = 40;
 namespace {
 
     // Hash function
-    static auto calc_hash = fnv1a<cache::Cache::hash_type>::hasher();
+    static auto calc_hash = cache::HashFunction();
 
     static struct stats_type {
         uint64 num_get = 0;
@@ -114,11 +115,275 @@ static void warmup() {
 }
 
 
+// measure average time to hash one key from `keys`
+template <typename Hasher>
+static double hash_ns_per_key(const std::vector<slice> & keys, Hasher calc_hash) {
+    constexpr int num_passes = 10;
+    volatile cache::hash_type sink = 0;
+    auto start_time = std::chrono::high_resolution_clock::now();
+    for (int pass = 0; pass < num_passes; ++pass) {
+        for (const auto & k : keys) {
+            sink = sink + calc_hash(k);
+        }
+    }
+    auto time_passed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::high_resolution_clock::now() - start_time);
+    return static_cast<double>(time_passed.count()) / (keys.size() * num_passes);
+}
+
+// same as above, keys are hashed in batches as multi-get does
+template <typename Hasher>
+static double batch_hash_ns_per_key(const std::vector<slice> & keys, Hasher calc_hash) {
+    constexpr int num_passes = 10;
+    constexpr size_t batch_size = 16;
+    cache::hash_type hashes[batch_size];
+    volatile cache::hash_type sink = 0;
+    auto start_time = std::chrono::high_resolution_clock::now();
+    for (int pass = 0; pass < num_passes; ++pass) {
+        for (size_t n = 0; n < keys.size(); n += batch_size) {
+            const size_t count = std::min(batch_size, keys.size() - n);
+            calc_hash(keys.data() + n, hashes, count);
+            sink = sink + hashes[0];
+        }
+    }
+    auto time_passed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::high_resolution_clock::now() - start_time);
+    return static_cast<double>(time_passed.count()) / (keys.size() * num_passes);
+}
+
+static void print_hash_benchmark(const char * title, const std::vector<slice> & keys) {
+    std::cout << std::left << std::setw(16) << title << std::right
+              << " fnv1a: " << std::setw(7) << hash_ns_per_key(keys, fnv1a<cache::hash_type>::hasher()) << "ns"
+              << " wyhash: " << std::setw(7) << hash_ns_per_key(keys, wyhash<cache::hash_type>::hasher()) << "ns"
+              << " wyhash x16: " << std::setw(7) << batch_hash_ns_per_key(keys, wyhash<cache::hash_type>::hasher()) << "ns"
+              << std::endl;
+}
+
+static void benchmark_hash() {
+    std::cout << std::fixed << std::setprecision(2);
+    std::cout << "Hash function (avg. per key)" << std::endl;
+    std::vector<slice> keys;
+    keys.reserve(data_array.size());
+    for (const auto & kv : data_array) {
+        keys.emplace_back(std::get<0>(kv).c_str(), std::get<0>(kv).size());
+    }
+    print_hash_benchmark("keys [14..40]", keys);
+    for (size_t key_len : {4, 8, 16, 32, 64, 128, 250}) {
+        std::vector<string> fixed_len_keys;
+        fixed_len_keys.reserve(65536);
+        for (auto n = 65536; n > 0; --n) {
+            fixed_len_keys.emplace_back(random_string(key_len, key_len));
+        }
+        keys.clear();
+        for (const auto & k : fixed_len_keys) {
+            keys.emplace_back(k.c_str(), k.size());
+        }
+        string title = "keys [" + std::to_string(key_len) + "]";
+        print_hash_benchmark(title.c_str(), keys);
+    }
+    std::cout << std::endl;
+}
+
+
+// how many counter-like items (short key, short numeric value) fit in memory
+static size_t count_counters(bool pack_tiny) {
+    memalloc allocator(cache_memory, page_size, pack_tiny);
+    size_t num_items = 0;
+    char key[32];
+    for (;;) {
+        const auto key_len = snprintf(key, sizeof(key), "counter:%u", static_cast<unsigned>(num_items));
+        const auto value_len = num_items % 5 + 1; // 1..5 digits
+        if (allocator.alloc(cache::Item::CalcSizeRequired(slice(key, key_len), value_len, true)) == nullptr) {
+            return num_items;
+        }
+        num_items += 1;
+    }
+}
+
+static void benchmark_tiny_items() {
+    const double to_GiB = static_cast<double>(Gigabyte) / cache_memory;
+    const auto regular = static_cast<double>(count_counters(false)) * to_GiB;
+    const auto packed = static_cast<double>(count_counters(true)) * to_GiB;
+    std::cout << std::fixed << std::setprecision(0);
+    std::cout << "Counters per GiB" << std::endl;
+    std::cout << "regular blocks: " << regular << std::endl;
+    std::cout << "tiny slots:     " << packed << std::endl;
+    std::cout << std::setprecision(2) << "gain:           " << packed / regular << "x" << std::endl;
+    std::cout << std::endl;
+}
+
+
+// grow `num_lists` values by the small pieces in round-robin, return average time of the `append` in ns
+static double append_ns(size_t num_lists, unsigned headroom) {
+    constexpr size_t list_length = 32 * Kilobyte;
+    const auto piece = slice::from_literal("log entry: the quick brown fox\r\n");
+    auto the_cache = cache::Cache::Create(cache_memory, page_size, hash_initial, false);
+    the_cache.set_extend_headroom(headroom);
+    std::vector<string> keys;
+    for (size_t i = 0; i < num_lists; ++i) {
+        keys.push_back("list:" + std::to_string(i));
+        const slice k(keys.back().c_str(), keys.back().size());
+        the_cache.do_set(the_cache.create_item(k, calc_hash(k), 0, 0, cache::Item::infinite_TTL));
+    }
+    size_t num_appends = 0;
+    auto start_time = std::chrono::high_resolution_clock::now();
+    for (size_t length = 0; length < list_length; length += piece.length()) {
+        for (const auto & key : keys) {
+            const slice k(key.c_str(), key.size());
+            auto item = the_cache.create_item(k, calc_hash(k), piece.length(), 0, cache::Item::infinite_TTL);
+            item->assign_value(piece);
+            the_cache.do_append(item);
+            num_appends += 1;
+        }
+    }
+    auto time_passed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::high_resolution_clock::now() - start_time);
+    return static_cast<double>(time_passed.count()) / num_appends;
+}
+
+static void benchmark_append() {
+    std::cout << std::fixed << std::setprecision(1);
+    std::cout << "Append (ns per command)      1 list   64 lists" << std::endl;
+    for (unsigned headroom : { 0u, 50u, 100u }) {
+        std::cout << "headroom " << std::setw(3) << headroom << "%:          "
+                  << std::setw(8) << append_ns(1, headroom) << std::setw(11) << append_ns(64, headroom) << std::endl;
+    }
+    std::cout << std::endl;
+}
+
+
+// rate-limiter like workload: lots of `incr` over the small set of counters
+static void benchmark_incr() {
+    constexpr size_t num_counters = 1024;
+    constexpr size_t num_incr = 10000000;
+    auto the_cache = cache::Cache::Create(cache_memory, page_size, hash_initial, false);
+    std::vector<string> keys;
+    std::vector<cache::hash_type> hashes;
+    for (size_t i = 0; i < num_counters; ++i) {
+        keys.push_back("rate:" + std::to_string(i));
+        const slice k(keys.back().c_str(), keys.back().size());
+        hashes.push_back(calc_hash(k));
+        auto item = the_cache.create_item(k, hashes.back(), 1, 0, cache::Item::infinite_TTL);
+        item->assign_value(slice::from_literal("0"));
+        the_cache.do_set(item);
+    }
+    ResetStats();
+    auto start_time = std::chrono::high_resolution_clock::now();
+    for (size_t n = 0; n < num_incr; ++n) {
+        const auto i = n % num_counters;
+        the_cache.do_incr(slice(keys[i].c_str(), keys[i].size()), hashes[i], 1);
+    }
+    auto time_passed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::high_resolution_clock::now() - start_time);
+    std::cout << std::fixed << std::setprecision(1);
+    std::cout << "Incr (ns per command): " << static_cast<double>(time_passed.count()) / num_incr << std::endl;
+    std::cout << "allocations:           " << STAT_GET(mem, num_malloc) << std::endl;
+    std::cout << std::endl;
+}
+
+
+// per-user copies of the few config blobs, return memory used per item
+static double bytes_per_dup_item(size_t dedup_threshold) {
+    constexpr size_t num_blobs = 50;
+    constexpr size_t num_users = 20000;
+    std::vector<string> blobs;
+    for (size_t i = 0; i < num_blobs; ++i) {
+        blobs.push_back(random_string(500, 3000));
+    }
+    auto the_cache = cache::Cache::Create(cache_memory, page_size, hash_initial, true);
+    the_cache.set_dedup_threshold(dedup_threshold);
+    ResetStats();
+    for (size_t n = 0; n < num_users; ++n) {
+        const string key = "user:" + std::to_string(n) + ":config";
+        const slice k(key.c_str(), key.size());
+        const string & blob = blobs[n % num_blobs];
+        auto item = the_cache.create_item(k, calc_hash(k), blob.size(), 0, cache::Item::infinite_TTL);
+        item->assign_value(slice(blob.c_str(), blob.size()));
+        the_cache.do_set(item);
+    }
+    return static_cast<double>(STAT_GET(mem, used_memory)) / num_users;
+}
+
+static void benchmark_dedup() {
+    std::cout << std::fixed << std::setprecision(1);
+    std::cout << "Duplicated values (bytes per item)" << std::endl;
+    std::cout << "regular:      " << bytes_per_dup_item(0) << std::endl;
+    std::cout << "deduplicated: " << bytes_per_dup_item(256) << std::endl;
+    std::cout << std::endl;
+}
+
+
+// churn with the mixed-size values, deletes and TTLs; return tuple<ns per command, number of items left in cache>
+template <class CacheType>
+static tuple<double, size_t> churn(const std::vector<string> & keys, const std::vector<string> & values, size_t compaction_budget) {
+    constexpr size_t num_commands = 2000000;
+    auto the_cache = CacheType::Create(cache_memory, page_size, hash_initial, true);
+    the_cache.set_compaction_budget(compaction_budget);
+    random_int<size_t> rnd_key(0, keys.size() - 1);
+    random_int<size_t> rnd_value(0, values.size() - 1);
+    random_int<uint32> rnd_ttl(60, 3600);
+    random_int<unsigned> rnd_command(1, 100);
+    // commands are generated in advance, both engines get the same sequence
+    std::vector<std::tuple<unsigned, size_t, size_t, uint32>> commands;
+    commands.reserve(num_commands);
+    for (size_t n = 0; n < num_commands; ++n) {
+        commands.emplace_back(rnd_command(), rnd_key(), rnd_value(), rnd_ttl());
+    }
+    auto start_time = std::chrono::high_resolution_clock::now();
+    for (const auto & cmd : commands) {
+        const string & key = keys[std::get<1>(cmd)];
+        const slice k(key.c_str(), key.size());
+        const unsigned what = std::get<0>(cmd);
+        if (what <= 40) {
+            const string & value = values[std::get<2>(cmd)];
+            auto item = the_cache.create_item(k, calc_hash(k), value.size(), 0, cache::seconds(std::get<3>(cmd)));
+            item->assign_value(slice(value.c_str(), value.size()));
+            the_cache.do_set(item);
+        } else if (what <= 60) {
+            the_cache.do_delete(k, calc_hash(k));
+        } else {
+            the_cache.do_get(k, calc_hash(k));
+        }
+    }
+    auto time_passed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::high_resolution_clock::now() - start_time);
+    size_t num_left = 0;
+    for (const auto & key : keys) {
+        const slice k(key.c_str(), key.size());
+        num_left += the_cache.do_get(k, calc_hash(k)) != nullptr ? 1 : 0;
+    }
+    return make_tuple(static_cast<double>(time_passed.count()) / num_commands, num_left);
+}
+
+static void benchmark_engines() {
+    std::vector<string> keys;
+    for (size_t i = 0; i < 500000; ++i) {
+        keys.push_back("object:" + std::to_string(i));
+    }
+    std::vector<string> values;
+    for (size_t i = 0; i < 1000; ++i) {
+        values.push_back(random_string(10, i % 10 == 0 ? 4000 : 400));
+    }
+    std::cout << std::fixed << std::setprecision(1);
+    std::cout << "Storage engines                 ns per command   items kept" << std::endl;
+    for (size_t compaction_budget : { size_t(0), 64 * Kilobyte }) {
+        const char * compaction = compaction_budget > 0 ? "compacted" : "         ";
+        double ns; size_t left;
+        tie(ns, left) = churn<cache::Cache>(keys, values, compaction_budget);
+        std::cout << "pages (LRU)          " << compaction << std::setw(11) << ns << std::setw(13) << left << std::endl;
+        tie(ns, left) = churn<cache::SegmentCache>(keys, values, compaction_budget);
+        std::cout << "log segments (FIFO)  " << compaction << std::setw(11) << ns << std::setw(13) << left << std::endl;
+    }
+    std::cout << std::endl;
+}
+
+
 auto chance = random_int<size_t>(1, 100);
 
 int main(int /*argc*/, char * /*argv*/[]) {
     csh.reset(new CacheWrapper());
     generate_test_data();
+    benchmark_hash();
+    benchmark_tiny_items();
+    benchmark_append();
+    benchmark_incr();
+    benchmark_dedup();
+    benchmark_engines();
     warmup();
     reset_stats();
     auto start_time = std::chrono::high_resolution_clock::now();
@@ -0,0 +1,188 @@
+#include <cachelot/common.h>
+#include <server/network.h>
+
+#include <iostream>
+#include <iomanip>
+#include <cstdio>
+
+using namespace cachelot;
+
+// local load generator: many connections pipeline requests to the running server
+// (see `server_benchmark.sh` to compare transports and reactor modes side by side)
+
+constexpr size_t num_keys = 10000;
+constexpr size_t value_size = 100;
+constexpr unsigned milliseconds_per_run = 2000;
+
+namespace {
+
+    typedef std::chrono::steady_clock clock;
+
+    // keys are of the same length, so the size of every reply is known in advance
+    string key(size_t n) {
+        char buf[16];
+        std::snprintf(buf, sizeof(buf), "key:%06u", static_cast<unsigned>(n % num_keys));
+        return buf;
+    }
+
+    const string value(value_size, 'v');
+
+    // request and the exact reply of the server
+    typedef std::pair<string, string> (*request_generator)(size_t n);
+
+    std::pair<string, string> set_request(size_t n) {
+        return std::make_pair("set " + key(n) + " 0 0 " + std::to_string(value.size()) + "\r\n" + value + "\r\n",
+                              string("STORED\r\n"));
+    }
+
+    std::pair<string, string> get_request(size_t n) {
+        return std::make_pair("get " + key(n) + "\r\n",
+                              "VALUE " + key(n) + " 0 " + std::to_string(value.size()) + "\r\n" + value + "\r\nEND\r\n");
+    }
+
+
+    // connection sends the batch of pipelined requests and waits for all of their replies before the next one
+    class load_connection {
+    public:
+        load_connection(net::io_service & ios, const net::tcp::endpoint & server, request_generator make_request, size_t first_key, size_t pipeline_depth)
+            : m_socket(ios)
+            , m_depth(pipeline_depth) {
+            for (size_t n = first_key; n < first_key + pipeline_depth; ++n) {
+                const auto request = make_request(n);
+                m_requests += request.first;
+                m_expected += request.second;
+            }
+            m_replies.resize(m_expected.size());
+            m_socket.connect(server);
+            m_socket.set_option(net::tcp::no_delay(true));
+        }
+
+        void start(clock::time_point deadline) {
+            m_deadline = deadline;
+            send_batch();
+        }
+
+        size_t num_requests() const noexcept { return m_round_trips.size() * m_depth; }
+
+        const std::vector<clock::duration> & round_trips() const noexcept { return m_round_trips; }
+
+    private:
+        void send_batch() {
+            m_sent_at = clock::now();
+            net::asio::async_write(m_socket, net::asio::buffer(m_requests), [this](const error_code error, size_t) {
+                if (error) {
+                    throw system_error(error);
+                }
+            });
+            net::asio::async_read(m_socket, net::asio::buffer(m_replies), [this](const error_code error, size_t) {
+                if (error) {
+                    throw system_error(error);
+                }
+                if (std::memcmp(m_replies.data(), m_expected.data(), m_expected.size()) != 0) {
+                    throw std::runtime_error("unexpected reply: " + string(m_replies.data(), std::min<size_t>(m_replies.size(), 80)));
+                }
+                const auto now = clock::now();
+                m_round_trips.push_back(now - m_sent_at);
+                if (now < m_deadline) {
+                    send_batch();
+                }
+            });
+        }
+
+    private:
+        net::tcp::socket m_socket;
+        const size_t m_depth;
+        string m_requests;
+        string m_expected;
+        std::vector<char> m_replies;
+        clock::time_point m_deadline;
+        clock::time_point m_sent_at;
+        std::vector<clock::duration> m_round_trips;
+    };
+
+
+    struct load_result {
+        double rps;
+        // round trip of the batch of requests in us
+        double p50_us;
+        double p99_us;
+        double p999_us;
+    };
+
+
+    // round trip which `fraction` of all the round trips doesn't exceed, in us
+    double percentile_us(std::vector<clock::duration> & round_trips, double fraction) {
+        if (round_trips.empty()) {
+            return 0;
+        }
+        const auto nth = round_trips.begin() + static_cast<ptrdiff_t>(fraction * (round_trips.size() - 1));
+        std::nth_element(round_trips.begin(), nth, round_trips.end());
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(*nth).count() / 1000.0;
+    }
+
+
+    // run the load of `num_connections` for a while
+    load_result run_load(const net::tcp::endpoint & server, request_generator make_request, size_t num_connections, size_t pipeline_depth) {
+        net::io_service ios;
+        std::vector<std::unique_ptr<load_connection>> connections;
+        for (size_t i = 0; i < num_connections; ++i) {
+            connections.emplace_back(new load_connection(ios, server, make_request, i * pipeline_depth, pipeline_depth));
+        }
+        const auto start_time = clock::now();
+        for (auto & conn : connections) {
+            conn->start(start_time + std::chrono::milliseconds(milliseconds_per_run));
+        }
+        ios.run();
+        const auto time_passed = std::chrono::duration_cast<std::chrono::nanoseconds>(clock::now() - start_time);
+        size_t num_requests = 0;
+        std::vector<clock::duration> round_trips;
+        for (auto & conn : connections) {
+            num_requests += conn->num_requests();
+            round_trips.insert(round_trips.end(), conn->round_trips().begin(), conn->round_trips().end());
+        }
+        load_result result;
+        result.rps = static_cast<double>(num_requests) * 1000000000 / time_passed.count();
+        result.p50_us = percentile_us(round_trips, 0.5);
+        result.p99_us = percentile_us(round_trips, 0.99);
+        result.p999_us = percentile_us(round_trips, 0.999);
+        return result;
+    }
+
+} // anonymous namespace
+
+
+int main(int argc, char * argv[]) {
+    const string host = argc > 1 ? argv[1] : "localhost";
+    const string port = argc > 2 ? argv[2] : "11211";
+    try {
+        net::io_service ios;
+        net::tcp::resolver resolver(ios);
+        const net::tcp::endpoint server = *resolver.resolve(net::tcp::resolver::query(net::tcp::v4(), host, port));
+        // fill the cache, so every get is a hit
+        run_load(server, set_request, num_keys / 100, 100);
+        std::cout << std::fixed << std::setprecision(1);
+        std::cout << "Server " << host << ":" << port << ", " << value_size << " bytes values" << std::endl;
+        std::cout << "Round trip of the batch (us)       requests/s         p50         p99       p99.9" << std::endl;
+        const std::pair<const char *, request_generator> traffic_profiles[] = {
+            { "get", get_request },
+            { "set", set_request },
+        };
+        for (const auto & profile : traffic_profiles) {
+            for (size_t num_connections : { 1, 16, 256 }) {
+                for (size_t pipeline_depth : { 1, 16 }) {
+                    const load_result result = run_load(server, profile.second, num_connections, pipeline_depth);
+                    const string title = string(profile.first) + ", " + std::to_string(num_connections) + " connections, "
+                                       + std::to_string(pipeline_depth) + " pipelined";
+                    std::cout << std::left << std::setw(35) << title << std::right
+                              << std::setw(12) << result.rps << std::setw(12) << result.p50_us
+                              << std::setw(12) << result.p99_us << std::setw(12) << result.p999_us << std::endl;
+                }
+            }
+        }
+        std::cout << std::endl;
+    } catch (const std::exception & exc) {
+        std::cerr << "Error: " << exc.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
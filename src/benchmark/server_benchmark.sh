@@ -0,0 +1,37 @@
+#!/bin/bash
+
+# Run the local load generator against cachelot served by the asio reactor and by the io_uring,
+# with the reactor blocking in wait of events (default) and busy polling for them
+
+BIN_DIR="$(dirname $0)/../../bin/RelWithDebugInfo"
+CACHELOT="${BIN_DIR}/cachelotd"
+LOAD_GENERATOR="${BIN_DIR}/benchmark_server"
+PORT=11212
+BUSY_POLL_US=50
+
+
+function run_test_for() {
+    local title="$1"
+    shift
+    echo "********************************************************"
+    echo "+++ ${title}"
+    echo "********************************************************"
+    ${CACHELOT} -p ${PORT} -U 0 "$@" &
+    local cachelot_pid=$!
+    sleep 1
+    ${LOAD_GENERATOR} localhost ${PORT}
+    local retcode=$?
+    kill ${cachelot_pid}
+    wait ${cachelot_pid} 2>/dev/null
+    if [[ ${retcode} != 0 ]]; then
+        exit 1
+    fi
+}
+
+
+## Main ----------------------------------------------------------
+ulimit -n 4096
+run_test_for "cachelot (asio)"
+run_test_for "cachelot (asio, busy poll)" --busy-poll ${BUSY_POLL_US}
+run_test_for "cachelot (io_uring)" --io-uring
+run_test_for "cachelot (io_uring, busy poll)" --io-uring --busy-poll ${BUSY_POLL_US}
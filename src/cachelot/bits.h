@@ -55,7 +55,7 @@ namespace cachelot {
         /// Test whether `bitno` is set (`bitno` counts from zero)
         template <typename IntType>
         constexpr bool is_set(const IntType value, const unsigned bitno) noexcept {
-            return value & (1 << bitno);
+            return (value & (IntType(1) << bitno)) != 0;
         }
 
         /// Test whether `bitno` is not set (`bitno` counts from zero)
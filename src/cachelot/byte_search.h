@@ -0,0 +1,113 @@
+#ifndef CACHELOT_BYTE_SEARCH_H_INCLUDED
+#define CACHELOT_BYTE_SEARCH_H_INCLUDED
+
+//
+//  (C) Copyright 2015 Iurii Krasnoshchok
+//
+//  Distributed under the terms of Simplified BSD License
+//
+
+
+#ifndef CACHELOT_BITS_H_INCLUDED
+#  include <cachelot/bits.h>
+#endif
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#  define CACHELOT_HAVE_SSE2 1
+#  include <emmintrin.h>
+#endif
+#if defined(__AVX2__)
+#  include <immintrin.h>
+#endif
+
+
+namespace cachelot {
+
+    /// @ingroup common
+    /// @{
+
+    /**
+     * Search of the single byte or of the pair of adjacent bytes (such as "\r\n")
+     *
+     * Bytes are compared 32 (AVX2) or 16 (SSE2) at a time when the target CPU supports it,
+     * the remainder shorter than a vector is compared byte by byte
+     */
+    namespace byte_search {
+
+        /// find the first `c` within [`begin`, `end`), return `end` if there is none
+        inline const char * find(const char * begin, const char * end, const char c) noexcept {
+            const char * pos = begin;
+#if defined(__AVX2__)
+            const __m256i pattern32 = _mm256_set1_epi8(c);
+            for (; end - pos >= 32; pos += 32) {
+                const __m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(pos));
+                const auto mask = static_cast<uint32>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(chunk, pattern32)));
+                if (mask != 0) {
+                    return pos + internal::ffs32(mask) - 1;
+                }
+            }
+#endif
+#if defined(CACHELOT_HAVE_SSE2)
+            const __m128i pattern16 = _mm_set1_epi8(c);
+            for (; end - pos >= 16; pos += 16) {
+                const __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i *>(pos));
+                const auto mask = static_cast<uint32>(_mm_movemask_epi8(_mm_cmpeq_epi8(chunk, pattern16)));
+                if (mask != 0) {
+                    return pos + internal::ffs32(mask) - 1;
+                }
+            }
+#endif
+            for (; pos < end; ++pos) {
+                if (*pos == c) {
+                    return pos;
+                }
+            }
+            return end;
+        }
+
+
+        /// find the first `first` immediately followed by `second` within [`begin`, `end`), return `end` if there is none
+        inline const char * find_pair(const char * begin, const char * end, const char first, const char second) noexcept {
+            const char * pos = begin;
+            // every vector is compared to the `first` and the vector shifted by one byte to the `second`
+#if defined(__AVX2__)
+            const __m256i first32 = _mm256_set1_epi8(first);
+            const __m256i second32 = _mm256_set1_epi8(second);
+            for (; end - pos >= 33; pos += 32) {
+                const __m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(pos));
+                const __m256i next = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(pos + 1));
+                const __m256i matches = _mm256_and_si256(_mm256_cmpeq_epi8(chunk, first32), _mm256_cmpeq_epi8(next, second32));
+                const auto mask = static_cast<uint32>(_mm256_movemask_epi8(matches));
+                if (mask != 0) {
+                    return pos + internal::ffs32(mask) - 1;
+                }
+            }
+#endif
+#if defined(CACHELOT_HAVE_SSE2)
+            const __m128i first16 = _mm_set1_epi8(first);
+            const __m128i second16 = _mm_set1_epi8(second);
+            for (; end - pos >= 17; pos += 16) {
+                const __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i *>(pos));
+                const __m128i next = _mm_loadu_si128(reinterpret_cast<const __m128i *>(pos + 1));
+                const __m128i matches = _mm_and_si128(_mm_cmpeq_epi8(chunk, first16), _mm_cmpeq_epi8(next, second16));
+                const auto mask = static_cast<uint32>(_mm_movemask_epi8(matches));
+                if (mask != 0) {
+                    return pos + internal::ffs32(mask) - 1;
+                }
+            }
+#endif
+            for (; end - pos >= 2; ++pos) {
+                if (pos[0] == first && pos[1] == second) {
+                    return pos;
+                }
+            }
+            return end;
+        }
+
+    } // namespace byte_search
+
+    /// @}
+
+} // namespace cachelot
+
+#endif // CACHELOT_BYTE_SEARCH_H_INCLUDED
@@ -142,13 +142,25 @@ extern "C" {
 
     const char * cachelot_item_get_value(const CachelotConstItemPtr i) {
         auto item = reinterpret_cast<cache::ConstItemPtr>(i);
-        return item->value().begin();
+        return item->is_chained() ? nullptr : item->value().begin();
     }
 
 
     size_t cachelot_item_get_valuelen(const CachelotConstItemPtr i) {
         auto item = reinterpret_cast<cache::ConstItemPtr>(i);
-        return item->value().length();
+        return item->value_length();
+    }
+
+
+    size_t cachelot_item_copy_value(const CachelotConstItemPtr i, char * dest, size_t destlen) {
+        auto item = reinterpret_cast<cache::ConstItemPtr>(i);
+        size_t copied = 0;
+        item->for_each_value_chunk([&](slice chunk) {
+            const size_t n = std::min(chunk.length(), destlen - copied);
+            std::memcpy(dest + copied, chunk.begin(), n);
+            copied += n;
+        });
+        return copied;
     }
 
 
@@ -335,6 +347,25 @@ extern "C" {
         }
     }
 
+    bool cachelot_resize(CachelotPtr c, size_t new_memory_limit, CachelotError * out_error) {
+        try {
+            c->cache.resize(new_memory_limit);
+            none_error(out_error);
+            return true;
+        } catch (const system_error & e) {
+            system_error_to_err_struct(e, out_error);
+        } catch(const std::exception & e) {
+            std_exception_to_err_struct(e, out_error);
+        } catch (...) {
+            unknown_exception_to_err_struct(out_error);
+        }
+        return false;
+    }
+
+    size_t cachelot_memory_limit(CachelotPtr c) {
+        return c->cache.memory_limit();
+    }
+
     void cachelot_on_eviction_callback(CachelotPtr c, CachelotOnEvictedCallback cb) {
         if (cb != nullptr) {
             c->cache.on_eviction = [=](cache::ConstItemPtr i) {
@@ -117,12 +117,19 @@ const char * cachelot_item_get_key(const CachelotConstItemPtr i);
 /** Retrieve Item key length */
 size_t cachelot_item_get_keylen(const CachelotConstItemPtr i);
 
-/** Retrieve Item value */
+/**
+ * Retrieve Item value
+ *
+ * @return `NULL` if value doesn't fit in the single memory page and is split on chunks, use `cachelot_item_copy_value` instead
+ */
 const char * cachelot_item_get_value(const CachelotConstItemPtr i);
 
 /** Retrieve Item value length */
 size_t cachelot_item_get_valuelen(const CachelotConstItemPtr i);
 
+/** Copy up to `destlen` bytes of the Item value into `dest`, return number of bytes copied */
+size_t cachelot_item_copy_value(const CachelotConstItemPtr i, char * dest, size_t destlen);
+
 //! @copydoc cachelot::cache::Cache::do_set
 bool cachelot_set(CachelotPtr c, CachelotItemPtr i, CachelotError * error);
 
@@ -163,6 +170,16 @@ bool cachelot_decr(CachelotPtr c, CachelotItemKey key, uint64_t delta, uint64_t
 /** @copydoc cachelot::cache::Cache::do_flush_all */
 void cachelot_flush_all(CachelotPtr c, CachelotError * error);
 
+/**
+ * Change amount of memory used by the cache without restart (see `cachelot::cache::Cache::resize`)
+ *
+ * `new_memory_limit` must be a multiple of `mem_page_size` and can't exceed the `memory_limit` given to `cachelot_init`
+ */
+bool cachelot_resize(CachelotPtr c, size_t new_memory_limit, CachelotError * error);
+
+/** retrieve amount of memory currently used by the cache */
+size_t cachelot_memory_limit(CachelotPtr c);
+
 /**
  * assign eviction callback
  * @code
@@ -8,8 +8,11 @@
 //  see LICENSE file
 
 
-#ifndef CACHELOT_MEMALLOC_H_INCLUDED
-#  include <cachelot/memalloc.h>
+#ifndef CACHELOT_MEMPOOLS_H_INCLUDED
+#  include <cachelot/mempools.h>
+#endif
+#ifndef CACHELOT_SEGMALLOC_H_INCLUDED
+#  include <cachelot/segmalloc.h>
 #endif
 #ifndef CACHELOT_CACHE_ITEM_H_INCLUDED
 #  include <cachelot/item.h>
@@ -17,9 +20,6 @@
 #ifndef CACHELOT_DICT_H_INCLUDED
 #  include <cachelot/dict.h>
 #endif
-#ifndef CACHELOT_HASH_FNV1A_H_INCLUDED
-#  include <cachelot/hash_fnv1a.h>
-#endif
 #ifndef CACHELOT_ERROR_H_INCLUDED
 #  include <cachelot/error.h>
 #endif
@@ -29,6 +29,10 @@
 #ifndef CACHELOT_STATS_H_INCLUDED
 #  include <cachelot/stats.h>
 #endif
+#ifndef CACHELOT_LZ4_H_INCLUDED
+#  include <cachelot/lz4.h>
+#endif
+#include <unordered_map> // unordered_map
 
 namespace cachelot {
 
@@ -43,8 +47,17 @@ namespace cachelot {
         /// Hash value type
         typedef Item::hash_type hash_type;
 
-        /// Hashing algorithm
-        typedef fnv1a<cache::hash_type>::hasher HashFunction;
+        /// Hashing algorithm (chosen at build time, see CACHELOT_HASH_FUNCTION cmake option)
+        typedef Item::hash_function HashFunction;
+
+        /// Set seed of the hashing algorithm, must be called before any key was hashed
+        inline void SeedHashFunction(uint64 seed) noexcept {
+#if defined(CACHELOT_HASH_FNV1A)
+            (void)seed; // FNV-1a is not seeded
+#else
+            wyhash_seed(seed);
+#endif
+        }
 
         /// Clock to maintain expiration
         typedef Item::clock clock;
@@ -116,10 +129,13 @@ namespace cachelot {
         /**
          * One cache class to rule them all
          *
+         * @tparam Allocator - storage engine, either `mempools` (pages evicted in LRU order, see `Cache`)
+         *                     or `segmalloc` (log-structured segments, see `SegmentCache`)
          * @note Cache is *not* thread safe
          * @ingroup cache
          */
-        class Cache {
+        template <class Allocator>
+        class BasicCache {
            // Underlying dictionary
             typedef dict<slice, ItemPtr, std::equal_to<slice>, ItemDictEntry, DictOptions> dict_type;
             typedef dict_type::iterator iterator;
@@ -129,7 +145,7 @@ namespace cachelot {
             enum class ExtendOperation { APPEND, PREPEND };
 
             // Private constructor
-            explicit Cache(size_t memory_limit, uint32 mem_page_size, dict_type::size_type initial_dict_size, bool enable_evictions);
+            explicit BasicCache(size_t memory_limit, const std::vector<uint32> & mem_page_sizes, dict_type::size_type initial_dict_size, bool enable_evictions, bool enable_CAS);
         public:
             typedef dict_type::hash_type hash_type;
             typedef dict_type::size_type size_type;
@@ -141,21 +157,31 @@ namespace cachelot {
              * @param mem_page_size - size of the allocator memory page
              * @param initial_dict_size - number of reserved items in dictionary
              * @param enable_evictions - evict existing items in order to store new ones
+             * @param enable_CAS - store CAS value (timestamp) within every item
              * @note may throw exception
              */
-            static Cache Create(size_t memory_limit, size_t mem_page_size, size_t initial_dict_size, bool enable_evictions);
+            static BasicCache Create(size_t memory_limit, size_t mem_page_size, size_t initial_dict_size, bool enable_evictions, bool enable_CAS = true);
+
+            /**
+             * constructor of the cache with several memory pools
+             *
+             * @param mem_page_sizes - page size of every memory pool, items are placed in the pool with the smallest suitable page
+             * @see Create(), mempools
+             * @note may throw exception
+             */
+            static BasicCache Create(size_t memory_limit, const std::vector<size_t> & mem_page_sizes, size_t initial_dict_size, bool enable_evictions, bool enable_CAS = true);
 
 
             /**
              * destructor
              */
-            ~Cache();
+            ~BasicCache();
 
 
             /**
              * Move constructor
              */
-            Cache(Cache && c) = default;
+            BasicCache(BasicCache && c) = default;
 
 
             /**
@@ -207,6 +233,31 @@ namespace cachelot {
              */
             tuple<bool, bool> do_cas(ItemPtr item, timestamp_type cas_unique);
 
+            /**
+             * `set` in place - overwrite value of the existing item reusing its memory
+             *
+             * Existing item gets new flags, expiration and CAS value,
+             * the caller must write the value of `value_length` bytes (see Item::assign_value)
+             * @return pointer to the writable item or `nullptr` if there is no such key or the value doesn't fit in the item memory.
+             *         In the later case caller must fall back to `create_item()` and `do_set()`
+             * @warning returned pointer guaranteed to be valid only *until* the next Cachelot call
+             */
+            ItemPtr do_set_inplace(const slice key, const hash_type hash, size_t value_length, opaque_flags_type flags, seconds keepalive) noexcept;
+
+            /**
+             * `replace` in place - the same as `do_set_inplace()`
+             *
+             * @return pointer to the writable item or `nullptr`, then caller must fall back to `create_item()` and `do_replace()`
+             */
+            ItemPtr do_replace_inplace(const slice key, const hash_type hash, size_t value_length, opaque_flags_type flags, seconds keepalive) noexcept;
+
+            /**
+             * `cas` in place - the same as `do_set_inplace()` if item wasn't modified since `cas_unique`
+             *
+             * @return pointer to the writable item or `nullptr`, then caller must fall back to `create_item()` and `do_cas()`
+             */
+            ItemPtr do_cas_inplace(const slice key, const hash_type hash, size_t value_length, opaque_flags_type flags, seconds keepalive, timestamp_type cas_unique) noexcept;
+
             /**
              * `append` - append the data of the existing item
              *
@@ -216,7 +267,19 @@ namespace cachelot {
              *
              * @warning item pointer will not be valid after the call
              */
-            bool do_append(ItemPtr item) { return do_extend(ExtendOperation::APPEND, item); }
+            bool do_append(ItemPtr item) { return std::get<0>(do_extend(ExtendOperation::APPEND, item, 0)); }
+
+            /**
+             * `append` with CAS - append the data of the existing item if it wasn't modified since `cas_unique` (0 - any)
+             *
+             * @return tuple<found, stored item>
+             * - `[true, item]` - item was stored, the pointer is valid until the next call of the cache
+             * - `[true, nullptr]` - item was not updated as it has been modified since
+             * - `[false, nullptr]` - no such key
+             *
+             * @warning item pointer will not be valid after the call
+             */
+            tuple<bool, ConstItemPtr> do_append(ItemPtr item, timestamp_type cas_unique) { return do_extend(ExtendOperation::APPEND, item, cas_unique); }
 
             /**
              * `prepend` - prepend the data of the existing item
@@ -227,7 +290,16 @@ namespace cachelot {
              *
              * @warning item pointer will not be valid after the call
              */
-            bool do_prepend(ItemPtr item) { return do_extend(ExtendOperation::PREPEND, item); }
+            bool do_prepend(ItemPtr item) { return std::get<0>(do_extend(ExtendOperation::PREPEND, item, 0)); }
+
+            /**
+             * `prepend` with CAS - prepend the data of the existing item if it wasn't modified since `cas_unique` (0 - any)
+             *
+             * @return the same as `do_append()` with CAS
+             *
+             * @warning item pointer will not be valid after the call
+             */
+            tuple<bool, ConstItemPtr> do_prepend(ItemPtr item, timestamp_type cas_unique) { return do_extend(ExtendOperation::PREPEND, item, cas_unique); }
 
             /**
              * `delete` - delete existing item
@@ -255,7 +327,8 @@ namespace cachelot {
             /**
              * `incr` - increment counter by its `key`
              *
-             * value is taken as ASCII encoded unsigned 64-bit integer
+             * value is taken as ASCII encoded unsigned 64-bit integer,
+             * counter is then kept as a native integer (updated in place) until it's read by `get`
              * If overflow happens, value will be set to int64_max
              *
              * @return tuple<found, new_value>
@@ -279,6 +352,7 @@ namespace cachelot {
             /**
              * Create new Item from the pre-allocated memory arena
              *
+             * Values which don't fit in the single memory page are split on page-sized chunks (see `Item::for_each_value_chunk()`)
              * @warning returned pointer is only *valid until* next cachelot call
              */
             ItemPtr create_item(const slice key, const hash_type hash, size_t value_length, opaque_flags_type flags, seconds keepalive);
@@ -288,25 +362,136 @@ namespace cachelot {
              */
             void destroy_item(ItemPtr item) noexcept;
 
+            /**
+             * Reserve extra `percent` of the value size when `append` / `prepend` has to re-allocate the item
+             *
+             * Items growing by the series of appends / prepends are then extended in place,
+             * instead of being copied on every command
+             */
+            void set_extend_headroom(unsigned percent) noexcept { m_extend_headroom = percent; }
+
+            /**
+             * Compress values of `threshold` bytes and more (0 - disable compression)
+             *
+             * Values are compressed when item is stored and transparently decompressed on `get`,
+             * poorly compressible values are stored as is
+             * @note may throw exception
+             */
+            void set_compression_threshold(size_t threshold);
+
+            /**
+             * Store values of `threshold` bytes and more once per content (0 - disable deduplication)
+             *
+             * Items having byte-identical values reference single refcounted entry in the shared values pool.
+             * Shared value entry lives in the same memory arena, once it's evicted every referencing item
+             * is evicted as well
+             */
+            void set_dedup_threshold(size_t threshold) noexcept { m_dedup_threshold = threshold; }
+
+            /**
+             * Move up to `max_bytes` of items out of sparsely used pages on every `create_item()`
+             * once most of the free memory is scattered among partially used pages (0 - disable)
+             *
+             * Freed pages are then available for the allocations which otherwise would evict existing items
+             */
+            void set_compaction_budget(size_t max_bytes) noexcept { m_compaction_budget = max_bytes; }
+
+            /**
+             * Move items out of sparsely used pages making the pages whole free blocks again
+             *
+             * Items referencing other memory blocks (shared values, chained items) stay in place
+             * @return amount of moved memory
+             * @warning every previously returned item pointer becomes invalid
+             */
+            size_t compact(size_t max_bytes) noexcept;
+
+            /**
+             * Change amount of memory available to the cache to `new_memory_limit` bytes without restart
+             *
+             * Memory is added or removed by whole pages of the biggest size,
+             * `new_memory_limit` can't exceed the `memory_limit` given to `Create()`.
+             * Items of the removed pages are moved to the remaining memory when possible, the rest is evicted
+             * @note may throw exception
+             * @warning every previously returned item pointer becomes invalid
+             */
+            void resize(size_t new_memory_limit);
+
+            /**
+             * Retrieve amount of memory currently available to the cache (see `resize()`)
+             */
+            size_t memory_limit() const noexcept { return m_allocator.online_size(); }
+
+            /**
+             * Limit total amount of memory of the items, the hash tables and the external memory (see `fit_memory_budget()`)
+             *
+             * Items give memory pages away when the hash tables or the external memory grow and take them back when they shrink,
+             * within the range from the minimal memory limit up to the `memory_limit` given to `Create()` (0 - disable budget)
+             * @note may throw exception
+             * @warning every previously returned item pointer becomes invalid
+             */
+            void set_memory_budget(size_t budget);
+
+            /**
+             * Retrieve total memory limit (see `set_memory_budget()`)
+             */
+            size_t memory_budget() const noexcept { return m_memory_budget; }
+
+            /**
+             * Resize items memory to fit within the memory budget together with the hash tables
+             * and `external_memory` bytes allocated outside of the cache (such as connection buffers)
+             *
+             * @warning every previously returned item pointer becomes invalid
+             */
+            void fit_memory_budget(size_t external_memory) noexcept;
+
             /**
              * Publish dynamic stats
              */
             void publish_stats() noexcept;
 
+            /**
+             * Retrieve state of the memory pools
+             */
+            std::vector<typename Allocator::pool_info> pools_info() const { return m_allocator.pools_info(); }
+
             /**
              * Item eviction callback
              */
             std::function<void (ConstItemPtr)> on_eviction;
 
+            /**
+             * Keep the value memory of the `item` in place, so it can be referenced after the call
+             *
+             * Either stored item (returned by `do_get()`) or the new one (returned by `create_item()`, which value is being filled) may be pinned.
+             * Pinned item is neither moved by compaction nor resize, every pin must be released by `unpin()`.
+             * Item is still overwritten, deleted or evicted as usual, `on_pin_revoked` is called beforehand
+             * and then all pins of the item are forgotten. Evicted new item is freed by the cache, it must not be used anymore
+             * @return `false` if `item` can't be pinned (such as the decompressed copy)
+             */
+            bool pin(ConstItemPtr item);
+
+            /**
+             * Release the pin taken by `pin()`, no-op if item pins were already revoked
+             */
+            void unpin(ConstItemPtr item) noexcept;
+
+            /**
+             * Pinned item callback, called just before the value memory is freed or modified (see `pin()`)
+             */
+            std::function<void (ConstItemPtr)> on_pin_revoked;
+
         private:
             /**
-             * Extend (`prepend` or `append`) existing item with the new data
+             * Extend (`prepend` or `append`) existing item with the new data if it wasn't modified since `cas_unique` (0 - any)
              *
-             * @return
-             * - `true` - item was stored
-             * - `false` - no such key
+             * @return tuple<found, stored item> (see `do_append()`)
+             */
+            tuple<bool, ConstItemPtr> do_extend(ExtendOperation op, ItemPtr item, timestamp_type cas_unique);
+
+            /**
+             * Try to extend existing `item` with the `piece` without moving it to the new location
              */
-            bool do_extend(ExtendOperation op, ItemPtr item);
+            bool extend_inplace(ExtendOperation op, ItemPtr item, slice piece) noexcept;
 
             /**
              * Make one of the ArithmeticOperation
@@ -322,10 +507,10 @@ namespace cachelot {
             tuple<bool, dict_type::iterator> retrieve_item(const slice key, const hash_type hash, bool readonly = false);
 
             class ItemAutoDelete {
-                Cache * m_cache;
+                BasicCache * m_cache;
                 Item * m_item;
             public:
-                explicit ItemAutoDelete(Cache * c, Item * i) noexcept : m_cache(c), m_item(i) {}
+                explicit ItemAutoDelete(BasicCache * c, Item * i) noexcept : m_cache(c), m_item(i) {}
                 ~ItemAutoDelete() { if (m_item) m_cache->destroy_item(m_item); }
                 void reset() noexcept { m_item = nullptr; }
                 ItemPtr get() noexcept { return m_item; }
@@ -341,36 +526,180 @@ namespace cachelot {
              */
             void insert_item_at(const iterator at, ItemAutoDelete & lockedItem) noexcept;
 
+            /**
+             * Check whether the value of `value_length` bytes fits into the memory of the existing `item`
+             */
+            bool fits_inplace(ConstItemPtr item, size_t value_length) const noexcept;
+
+            /**
+             * Compress value of the `item` if it is large enough and compressible, return unused memory to the allocator
+             */
+            void maybe_compress(ItemPtr item) noexcept;
+
+            /**
+             * Replace value of the `item` with the reference to the shared value entry with the same content
+             */
+            void maybe_share(ItemPtr item) noexcept;
+
+            /**
+             * Remove reference to the shared value from the `item`
+             *
+             * @return shared value entry if it has no more references (and must be freed), `nullptr` otherwise
+             */
+            ItemPtr release_shared(ItemPtr item) noexcept;
+
+            /**
+             * Memory block of the `item` was freed by the allocator in order to satisfy new allocation
+             */
+            void on_evicted(ItemPtr item) noexcept;
+
+            /**
+             * Free memory of the items removed from the cache during the eviction
+             */
+            void free_orphans() noexcept;
+
+            /**
+             * Return `item` itself or its decompressed copy
+             *
+             * @warning copy is valid only until the next Cachelot call
+             */
+            ConstItemPtr reveal(ConstItemPtr item) noexcept;
+
+            /**
+             * Move items out of memory beyond `new_memory_limit` (or give memory back) without validation
+             */
+            void resize_arena(size_t new_memory_limit) noexcept;
+
+            /**
+             * Run compaction within the budget if free memory is fragmented
+             */
+            void maybe_compact() noexcept;
+
+            /**
+             * Forget the pins of the `item` which memory is about to be freed or modified (see `pin()`)
+             */
+            void revoke_pins(ConstItemPtr item) noexcept;
+
+            /**
+             * Check whether `item` is in the cache, rather than created and not stored yet
+             */
+            bool is_stored(ConstItemPtr item) const noexcept;
+
+            /**
+             * Check whether allocator may move the memory of `item` (see `compact()`)
+             */
+            bool can_move(ConstItemPtr item) const noexcept;
+
+            /**
+             * Point dictionary to the `item` moved by the allocator
+             */
+            void on_moved(ItemPtr item) noexcept;
+
+            /**
+             * Allocate memory and construct new item, existing item pointers stay valid unless items are evicted
+             */
+            ItemPtr allocate_item(const slice key, const hash_type hash, size_t value_length, opaque_flags_type flags, seconds keepalive);
+
+            /**
+             * Create item which value is split on chunks, each chunk occupies the whole memory page except the last one
+             *
+             * @p evict - whether existing items may be evicted to free the memory
+             */
+            ItemPtr create_chained_item(const slice key, const hash_type hash, size_t value_length, opaque_flags_type flags, seconds keepalive, bool evict);
+
+            /**
+             * Evict chained item together with all its chunks, `evicted_chunk` memory is already freed by the allocator
+             */
+            void evict_chain(ItemPtr item, ItemPtr evicted_chunk) noexcept;
+
+            /**
+             * Maximal size of the single memory allocation
+             */
+            size_t allocation_limit() const noexcept { return m_allocator.page_size - Allocator::header_size(); }
+
+            /**
+             * Check whether `item` is (or can be turned into) the native counter
+             */
+            bool fits_counter(ConstItemPtr item) const noexcept;
+
+            /**
+             * Prepare existing `item` to be overwritten by the new value
+             */
+            ItemPtr overwrite_item(ItemPtr item, size_t value_length, opaque_flags_type flags, seconds keepalive) noexcept;
+
+            /**
+             * Construct Item in the allocated `memory` (with or without CAS depending on the settings)
+             */
+            ItemPtr construct_item(void * memory, const slice key, const hash_type hash, uint32 value_length, opaque_flags_type flags, seconds keepalive) noexcept;
+
         private:
-            memalloc m_allocator;
+            Allocator m_allocator;
             dict_type m_dict;
             const bool m_evictions_enabled;
+            const bool m_cas_enabled;
+            unsigned m_extend_headroom;
+            size_t m_compression_threshold;
+            std::unique_ptr<uint8[]> m_codec_buffer; // compression output / decompressed item copy
+            size_t m_dedup_threshold;
+            size_t m_compaction_budget;
+            size_t m_memory_budget;
+            dict_type m_shared_values; // shared value entries by the content hash
+            std::vector<ItemPtr> m_orphans; // see `free_orphans()`
+            std::unordered_map<ConstItemPtr, size_t> m_pins; // number of pins by item (see `pin()`)
             timestamp_type m_oldest_timestamp;
             timestamp_type m_newest_timestamp;
         };
 
 
-        inline Cache Cache::Create(size_t memory_limit, size_t mem_page_size, size_t initial_dict_size, bool enable_evictions) {
+        /// Cache storing items in the memory pages, least recently used page is evicted when memory is over
+        typedef BasicCache<mempools> Cache;
+
+        /// Cache appending items to the log-structured memory segments, oldest segment is evicted when memory is over
+        typedef BasicCache<segmalloc> SegmentCache;
+
+
+        template <class Allocator>
+        inline BasicCache<Allocator> BasicCache<Allocator>::Create(size_t memory_limit, size_t mem_page_size, size_t initial_dict_size, bool enable_evictions, bool enable_CAS) {
+            return Create(memory_limit, std::vector<size_t>(1, mem_page_size), initial_dict_size, enable_evictions, enable_CAS);
+        }
+
+
+        template <class Allocator>
+        inline BasicCache<Allocator> BasicCache<Allocator>::Create(size_t memory_limit, const std::vector<size_t> & mem_page_sizes, size_t initial_dict_size, bool enable_evictions, bool enable_CAS) {
             if (not ispow2(memory_limit)) {
                 throw std::invalid_argument("memory_limit must be power of 2");
             }
-            if (memory_limit < (mem_page_size * 4)) {
-                throw std::invalid_argument("memory_limit should be enough for at least 4 pages");
-            }
-            if (not ispow2(mem_page_size)) {
-                throw std::invalid_argument("mem_page_size must be power of 2");
+            if (mem_page_sizes.empty()) {
+                throw std::invalid_argument("at least one mem_page_size is required");
             }
-            if (mem_page_size == 0) {
-                throw std::invalid_argument("mem_page_size must be non-zero");
+            if (mem_page_sizes.size() > 16) {
+                throw std::invalid_argument("too many memory pools (max 16)");
             }
-            if (mem_page_size > std::numeric_limits<uint32>::max()) {
-                throw std::invalid_argument("mem_page_size is too big (max is INT32_MAX)");
-            }
-            if (mem_page_size < 256) {
-                throw std::invalid_argument("mem_page_size is too small (min 256b)");
+            std::vector<uint32> page_sizes;
+            for (auto mem_page_size : mem_page_sizes) {
+                if (memory_limit < (mem_page_size * 4)) {
+                    throw std::invalid_argument("memory_limit should be enough for at least 4 pages");
+                }
+                if (not ispow2(mem_page_size)) {
+                    throw std::invalid_argument("mem_page_size must be power of 2");
+                }
+                if (mem_page_size == 0) {
+                    throw std::invalid_argument("mem_page_size must be non-zero");
+                }
+                if (mem_page_size > std::numeric_limits<uint32>::max()) {
+                    throw std::invalid_argument("mem_page_size is too big (max is INT32_MAX)");
+                }
+                if (mem_page_size < 256) {
+                    throw std::invalid_argument("mem_page_size is too small (min 256b)");
+                }
+                if (memory_limit % mem_page_size != 0) {
+                    throw std::invalid_argument("memory_limit must be divisible by mem_page_size");
+                }
+                page_sizes.push_back(static_cast<uint32>(mem_page_size));
             }
-            if (memory_limit % mem_page_size != 0) {
-                throw std::invalid_argument("memory_limit must be divisible by mem_page_size");
+            const size_t max_page_size = *std::max_element(mem_page_sizes.begin(), mem_page_sizes.end());
+            if (memory_limit / max_page_size < mem_page_sizes.size()) {
+                throw std::invalid_argument("memory_limit should be enough for at least one biggest page per pool");
             }
             if (not ispow2(initial_dict_size)) {
                 throw std::invalid_argument("initial_dict_size must be power of 2");
@@ -378,20 +707,30 @@ namespace cachelot {
             if (initial_dict_size > std::numeric_limits<dict_type::size_type>::max()) {
                 throw std::invalid_argument("initial_dict_size is too big");
             }
-            return Cache(memory_limit, mem_page_size, initial_dict_size, enable_evictions);
+            return BasicCache(memory_limit, page_sizes, initial_dict_size, enable_evictions, enable_CAS);
         }
 
 
-        inline Cache::Cache(size_t memory_limit, uint32 mem_page_size, dict_type::size_type initial_dict_size, bool enable_evictions)
-            : m_allocator(memory_limit, mem_page_size)
+        template <class Allocator>
+        inline BasicCache<Allocator>::BasicCache(size_t memory_limit, const std::vector<uint32> & mem_page_sizes, dict_type::size_type initial_dict_size, bool enable_evictions, bool enable_CAS)
+            : m_allocator(memory_limit, mem_page_sizes, /*pack_tiny*/true)
             , m_dict(initial_dict_size)
             , m_evictions_enabled(enable_evictions)
+            , m_cas_enabled(enable_CAS)
+            , m_extend_headroom(0)
+            , m_compression_threshold(0)
+            , m_dedup_threshold(0)
+            , m_compaction_budget(0)
+            , m_memory_budget(0)
+            , m_shared_values(1024)
             , m_oldest_timestamp(std::numeric_limits<timestamp_type>::max())
             , m_newest_timestamp(std::numeric_limits<timestamp_type>::min()) {
         }
 
 
-        inline Cache::~Cache() {
+        template <class Allocator>
+        inline BasicCache<Allocator>::~BasicCache() {
+            m_pins.clear();
             m_dict.remove_if([=](ItemPtr item) -> bool {
                 destroy_item(item);
                 return true;
@@ -399,7 +738,8 @@ namespace cachelot {
         }
 
 
-        inline tuple<bool, Cache::dict_type::iterator> Cache::retrieve_item(const slice key, const hash_type hash, bool readonly) {
+        template <class Allocator>
+        inline tuple<bool, typename BasicCache<Allocator>::iterator> BasicCache<Allocator>::retrieve_item(const slice key, const hash_type hash, bool readonly) {
             bool found; iterator at;
             tie(found, at) = m_dict.entry_for(key, hash, readonly);
             if (found) {
@@ -407,6 +747,13 @@ namespace cachelot {
                 // validate item
                 if (not item->is_expired()) {
                     m_allocator.touch(item);
+                    if (item->is_shared()) {
+                        m_allocator.touch(item->shared_ref()->entry);
+                    } else if (item->is_chained()) {
+                        for (Item * chunk = item->chain_header()->first_chunk; chunk != nullptr; chunk = chunk->chunk_header()->next) {
+                            m_allocator.touch(chunk);
+                        }
+                    }
                 } else {
                     m_dict.remove(at);
                     destroy_item(item);
@@ -417,7 +764,8 @@ namespace cachelot {
         }
 
 
-        inline ConstItemPtr Cache::do_get(const slice key, const hash_type hash) noexcept {
+        template <class Allocator>
+        inline ConstItemPtr BasicCache<Allocator>::do_get(const slice key, const hash_type hash) noexcept {
             STAT_INCR(cache.cmd_get, 1);
             // try to retrieve existing item
             bool found; iterator at; bool readonly = true;
@@ -427,7 +775,10 @@ namespace cachelot {
                 auto item = at.value();
                 debug_assert(item->key() == key);
                 debug_assert(item->hash() == hash);
-                return item;
+                if (item->is_counter()) {
+                    item->render_counter();
+                }
+                return reveal(item);
             } else {
                 STAT_INCR(cache.get_misses, 1);
                 return ItemPtr(nullptr);
@@ -435,7 +786,8 @@ namespace cachelot {
         }
 
 
-        inline void Cache::do_set(ItemPtr item) {
+        template <class Allocator>
+        inline void BasicCache<Allocator>::do_set(ItemPtr item) {
             STAT_INCR(cache.cmd_set, 1);
             ItemAutoDelete _item_uniq_ptr(this, item);
             bool found; iterator at;
@@ -450,7 +802,8 @@ namespace cachelot {
         }
 
 
-        inline bool Cache::do_add(ItemPtr item) {
+        template <class Allocator>
+        inline bool BasicCache<Allocator>::do_add(ItemPtr item) {
             STAT_INCR(cache.cmd_add, 1);
             ItemAutoDelete _item_uniq_ptr(this, item);
             bool found; iterator at;
@@ -466,7 +819,8 @@ namespace cachelot {
         }
 
 
-        inline bool Cache::do_replace(ItemPtr item) {
+        template <class Allocator>
+        inline bool BasicCache<Allocator>::do_replace(ItemPtr item) {
             STAT_INCR(cache.cmd_replace, 1);
             ItemAutoDelete _item_uniq_ptr(this, item);
             bool found; iterator at;
@@ -482,7 +836,8 @@ namespace cachelot {
         }
 
 
-        inline tuple<bool, bool> Cache::do_cas(ItemPtr item, timestamp_type cas_unique) {
+        template <class Allocator>
+        inline tuple<bool, bool> BasicCache<Allocator>::do_cas(ItemPtr item, timestamp_type cas_unique) {
             STAT_INCR(cache.cmd_cas, 1);
             ItemAutoDelete _item_uniq_ptr(this, item);
             bool found; iterator at;
@@ -503,7 +858,47 @@ namespace cachelot {
         }
 
 
-        inline bool Cache::do_extend(ExtendOperation op, ItemPtr piece) {
+        template <class Allocator>
+        inline ItemPtr BasicCache<Allocator>::do_set_inplace(const slice key, const hash_type hash, size_t value_length, opaque_flags_type flags, seconds keepalive) noexcept {
+            bool found; iterator at; const bool readonly = true;
+            tie(found, at) = retrieve_item(key, hash, readonly);
+            if (found && fits_inplace(at.value(), value_length)) {
+                STAT_INCR(cache.cmd_set, 1);
+                STAT_INCR(cache.set_existing, 1);
+                return overwrite_item(at.value(), value_length, flags, keepalive);
+            }
+            return nullptr;
+        }
+
+
+        template <class Allocator>
+        inline ItemPtr BasicCache<Allocator>::do_replace_inplace(const slice key, const hash_type hash, size_t value_length, opaque_flags_type flags, seconds keepalive) noexcept {
+            bool found; iterator at; const bool readonly = true;
+            tie(found, at) = retrieve_item(key, hash, readonly);
+            if (found && fits_inplace(at.value(), value_length)) {
+                STAT_INCR(cache.cmd_replace, 1);
+                STAT_INCR(cache.replace_stored, 1);
+                return overwrite_item(at.value(), value_length, flags, keepalive);
+            }
+            return nullptr;
+        }
+
+
+        template <class Allocator>
+        inline ItemPtr BasicCache<Allocator>::do_cas_inplace(const slice key, const hash_type hash, size_t value_length, opaque_flags_type flags, seconds keepalive, timestamp_type cas_unique) noexcept {
+            bool found; iterator at; const bool readonly = true;
+            tie(found, at) = retrieve_item(key, hash, readonly);
+            if (found && at.value()->timestamp() == cas_unique && fits_inplace(at.value(), value_length)) {
+                STAT_INCR(cache.cmd_cas, 1);
+                STAT_INCR(cache.cas_stored, 1);
+                return overwrite_item(at.value(), value_length, flags, keepalive);
+            }
+            return nullptr;
+        }
+
+
+        template <class Allocator>
+        inline tuple<bool, ConstItemPtr> BasicCache<Allocator>::do_extend(ExtendOperation op, ItemPtr piece, timestamp_type cas_unique) {
             if (op == ExtendOperation::APPEND) {
                 STAT_INCR(cache.cmd_append, 1);
             } else {
@@ -515,18 +910,67 @@ namespace cachelot {
             tie(found, at) = retrieve_item(piece->key(), piece->hash());
             if (found) {
                 auto old_item = at.value();
-                const size_t new_value_size = old_item->value().length() + piece->value().length();
+                if (cas_unique != 0 && old_item->timestamp() != cas_unique) {
+                    return make_tuple(true, ConstItemPtr(nullptr));
+                }
+                if (old_item->is_counter()) {
+                    old_item->render_counter();
+                }
+                if (not old_item->is_compressed() && not old_item->is_shared() && not old_item->is_chained() && not piece->is_chained()
+                        && extend_inplace(op, old_item, piece->value())) {
+                    if (op == ExtendOperation::APPEND) {
+                        STAT_INCR(cache.append_stored, 1);
+                    } else {
+                        debug_assert(op == ExtendOperation::PREPEND);
+                        STAT_INCR(cache.prepend_stored, 1);
+                    }
+                    return make_tuple(true, ConstItemPtr(old_item));
+                }
+                const auto old_revealed = reveal(old_item);
+                const size_t old_value_size = old_revealed->value_length();
+                const size_t piece_size = piece->value_length();
+                const size_t new_value_size = old_value_size + piece_size;
+                size_t size_required = Item::CalcSizeRequired(old_item->key(), new_value_size, m_cas_enabled);
+                if (old_item->is_chained() || size_required > allocation_limit()) {
+                    // do not evict existing items to avoid accidentally free the `piece` or the `old_item`
+                    auto new_item = create_chained_item(old_item->key(), old_item->hash(), new_value_size, old_item->opaque_flags(), old_item->ttl(), false);
+                    ItemAutoDelete _item_uniq_ptr(this, new_item);
+                    const auto copy_value = [=](ConstItemPtr from, size_t offset) {
+                        from->for_each_value_chunk([&](slice chunk) {
+                            new_item->write_value(offset, chunk);
+                            offset += chunk.length();
+                        });
+                    };
+                    if (op == ExtendOperation::APPEND) {
+                        copy_value(old_revealed, 0);
+                        copy_value(piece, old_value_size);
+                        STAT_INCR(cache.append_stored, 1);
+                    } else {
+                        debug_assert(op == ExtendOperation::PREPEND);
+                        copy_value(piece, 0);
+                        copy_value(old_revealed, piece_size);
+                        STAT_INCR(cache.prepend_stored, 1);
+                    }
+                    replace_item_at(at, _item_uniq_ptr);
+                    return make_tuple(true, ConstItemPtr(at.value()));
+                }
+                const slice old_value = old_revealed->value();
+                if (m_extend_headroom > 0) {
+                    // reserve memory for the further extends, but do not exceed the page
+                    const size_t headroom = new_value_size * m_extend_headroom / 100;
+                    size_required = std::min<size_t>(size_required + headroom, allocation_limit());
+                }
                 // do not evict existing items to avoid accidentally free the `piece` or the `old_item`
-                auto memory = m_allocator.alloc_or_evict(Item::CalcSizeRequired(old_item->key(), new_value_size), false, [=](void *){});
+                auto memory = m_allocator.alloc_or_evict(size_required, false, [=](void *){});
                 if (memory != nullptr) {
-                    auto new_item = new (memory) Item(old_item->key(), old_item->hash(), static_cast<uint32>(new_value_size), old_item->opaque_flags(), old_item->ttl(), ++m_newest_timestamp);
+                    auto new_item = construct_item(memory, old_item->key(), old_item->hash(), static_cast<uint32>(new_value_size), old_item->opaque_flags(), old_item->ttl());
                     ItemAutoDelete _item_uniq_ptr(this, new_item);
                     if (op == ExtendOperation::APPEND) {
-                        new_item->assign_compose(old_item->value(), piece->value());
+                        new_item->assign_compose(old_value, piece->value());
                         STAT_INCR(cache.append_stored, 1);
                     } else {
                         debug_assert(op == ExtendOperation::PREPEND);
-                        new_item->assign_compose(piece->value(), old_item->value());
+                        new_item->assign_compose(piece->value(), old_value);
                         STAT_INCR(cache.prepend_stored, 1);
                     }
                     replace_item_at(at, _item_uniq_ptr);
@@ -541,11 +985,35 @@ namespace cachelot {
                     STAT_INCR(cache.prepend_misses, 1);
                 }
             }
-            return found;
+            return make_tuple(found, found ? ConstItemPtr(at.value()) : ConstItemPtr(nullptr));
+        }
+
+
+        template <class Allocator>
+        inline bool BasicCache<Allocator>::extend_inplace(ExtendOperation op, ItemPtr item, slice piece) noexcept {
+            const size_t new_value_size = item->value().length() + piece.length();
+            const size_t size_required = Item::CalcSizeRequired(item->key(), new_value_size, item->has_cas());
+            if (size_required > allocation_limit()) {
+                return false;
+            }
+            // item either has enough of reserved memory or its block can grow to the right
+            if (size_required > m_allocator.usable_size(item) && m_allocator.realloc_inplace(item, size_required) == nullptr) {
+                return false;
+            }
+            revoke_pins(item);
+            const timestamp_type timestamp = item->has_cas() ? ++m_newest_timestamp : 0;
+            if (op == ExtendOperation::APPEND) {
+                item->append(piece, timestamp);
+            } else {
+                debug_assert(op == ExtendOperation::PREPEND);
+                item->prepend(piece, timestamp);
+            }
+            return true;
         }
 
 
-        inline bool Cache::do_delete(const slice key, const hash_type hash) noexcept {
+        template <class Allocator>
+        inline bool BasicCache<Allocator>::do_delete(const slice key, const hash_type hash) noexcept {
             STAT_INCR(cache.cmd_delete, 1);
             bool found; iterator at; const bool readonly = true;
             tie(found, at) = retrieve_item(key, hash, readonly);
@@ -563,7 +1031,8 @@ namespace cachelot {
         }
 
 
-        inline bool Cache::do_touch(const slice key, const hash_type hash, seconds keepalive) noexcept {
+        template <class Allocator>
+        inline bool BasicCache<Allocator>::do_touch(const slice key, const hash_type hash, seconds keepalive) noexcept {
             STAT_INCR(cache.cmd_touch, 1);
             bool found; iterator at; const bool readonly = true;
             tie(found, at) = retrieve_item(key, hash, readonly);
@@ -571,6 +1040,7 @@ namespace cachelot {
                 auto item = at.value();
                 m_allocator.touch(item); // mark item as recent in LRU list
                 item->set_ttl(keepalive); // update lifetime
+                m_allocator.expire_at(item, item->expiration_time());
                 STAT_INCR(cache.touch_hits, 1);
                 return true;
             } else {
@@ -580,7 +1050,8 @@ namespace cachelot {
         }
 
 
-        inline void Cache::do_flush_all() noexcept {
+        template <class Allocator>
+        inline void BasicCache<Allocator>::do_flush_all() noexcept {
             STAT_INCR(cache.cmd_flush, 1);
             m_dict.remove_if([=](ItemPtr item) -> bool {
                 if (item->is_expired()) {
@@ -593,7 +1064,8 @@ namespace cachelot {
         }
 
 
-        inline tuple<bool, uint64> Cache::do_arithmetic(ArithmeticOperation op, const slice key, const hash_type hash, uint64 delta) {
+        template <class Allocator>
+        inline tuple<bool, uint64> BasicCache<Allocator>::do_arithmetic(ArithmeticOperation op, const slice key, const hash_type hash, uint64 delta) {
             if (op == ArithmeticOperation::INCR) {
                 STAT_INCR(cache.cmd_incr, 1);
             } else {
@@ -611,10 +1083,15 @@ namespace cachelot {
                 }
                 return make_tuple(false, 0ull);
             }
-            // retrieve item value stored as an ASCII string
+            // retrieve item value stored either as a native integer or as an ASCII string
             auto old_item = at.value();
-            auto old_ascii_value = at.value()->value();
-            auto old_int_value = str_to_int<uint64>(old_ascii_value.begin(), old_ascii_value.end());
+            uint64 old_int_value;
+            if (old_item->is_counter()) {
+                old_int_value = old_item->counter();
+            } else {
+                auto old_ascii_value = reveal(old_item)->value();
+                old_int_value = str_to_int<uint64>(old_ascii_value.begin(), old_ascii_value.end());
+            }
             // process arithmetic command
             uint64 new_int_value = 0;
             if (op == ArithmeticOperation::INCR) {
@@ -626,72 +1103,590 @@ namespace cachelot {
                 new_int_value = (old_int_value >= delta) ? old_int_value - delta : 0;
                 STAT_INCR(cache.decr_hits, 1);
             }
-            // store new value as an ASCII string
-            AsciiIntegerBuffer new_ascii_value;
-            const auto new_ascii_value_length = int_to_str(new_int_value, new_ascii_value);
-            // create new item to hold value including zero terminator
+            // store new value as a native integer, it's rendered as an ASCII string on `get`
+            if (fits_counter(old_item)) {
+                revoke_pins(old_item);
+                old_item->set_counter(new_int_value, old_item->has_cas() ? ++m_newest_timestamp : 0);
+                return make_tuple(true, new_int_value);
+            }
+            // create new item large enough to render any counter value
             ItemPtr new_item;
-            new_item = create_item(old_item->key(), old_item->hash(), new_ascii_value_length, old_item->opaque_flags(), old_item->ttl());
+            new_item = allocate_item(old_item->key(), old_item->hash(), Item::max_counter_length, old_item->opaque_flags(), old_item->ttl());
             ItemAutoDelete _item_uniq_ptr(this, new_item);
-            new_item->assign_value(slice(new_ascii_value, new_ascii_value_length));
+            new_item->set_counter(new_int_value, new_item->timestamp());
             replace_item_at(at, _item_uniq_ptr);
             return make_tuple(true, new_int_value);
         }
 
 
-        inline ItemPtr Cache::create_item(const slice key, const hash_type hash, size_t value_length, opaque_flags_type flags, seconds keepalive) {
+        template <class Allocator>
+        inline ItemPtr BasicCache<Allocator>::create_item(const slice key, const hash_type hash, size_t value_length, opaque_flags_type flags, seconds keepalive) {
+            maybe_compact();
+            return allocate_item(key, hash, value_length, flags, keepalive);
+        }
+
+
+        template <class Allocator>
+        inline ItemPtr BasicCache<Allocator>::allocate_item(const slice key, const hash_type hash, size_t value_length, opaque_flags_type flags, seconds keepalive) {
             void * memory;
             if (key.length() > Item::max_key_length) {
                 throw system_error(error::key_too_long);
             }
-            const size_t size_required = Item::CalcSizeRequired(key, value_length);
-            if (size_required > m_allocator.page_size) {
-                throw system_error(error::item_too_big);
+            const size_t size_required = Item::CalcSizeRequired(key, value_length, m_cas_enabled);
+            if (size_required > allocation_limit()) {
+                return create_chained_item(key, hash, value_length, flags, keepalive, m_evictions_enabled);
             }
             const auto on_delete = [=](void * ptr) noexcept -> void {
-                auto i = reinterpret_cast<Item *>(ptr);
-                debug_only(bool deleted = ) this->m_dict.del(i->key(), i->hash());
-                debug_assert(deleted);
-                if (on_eviction) {
-                    on_eviction(i);
-                }
+                this->on_evicted(reinterpret_cast<Item *>(ptr));
             };
             memory = m_allocator.alloc_or_evict(size_required, m_evictions_enabled, on_delete);
+            free_orphans();
             if (memory != nullptr) {
-                auto item = new (memory) Item(key, hash, static_cast<uint32>(value_length), flags, keepalive, ++m_newest_timestamp);
-                return item;
+                return construct_item(memory, key, hash, static_cast<uint32>(value_length), flags, keepalive);
             } else {
                 throw system_error(error::out_of_memory);
             }
         }
 
 
-        inline void Cache::destroy_item(ItemPtr item) noexcept {
+        template <class Allocator>
+        inline ItemPtr BasicCache<Allocator>::create_chained_item(const slice key, const hash_type hash, size_t value_length, opaque_flags_type flags, seconds keepalive, bool evict) {
+            const slice chunk_key = Item::ChunkKey();
+            const size_t chunk_overhead = Item::CalcSizeRequired(chunk_key, Item::CalcChunkValueLength(0), false);
+            const size_t chunk_capacity = allocation_limit() - chunk_overhead;
+            const size_t num_chunks = (value_length + chunk_capacity - 1) / chunk_capacity;
+            // allow chain to occupy at most half of the memory, otherwise it would evict itself
+            if (value_length > std::numeric_limits<uint32>::max() || num_chunks > m_allocator.arena_size / m_allocator.page_size / 2) {
+                throw system_error(error::item_too_big);
+            }
+            // memory of the head followed by the memory of every chunk, part `n` keeps `chunk_length(n)` bytes of data
+            std::vector<void *> parts(num_chunks + 1, nullptr);
+            const auto chunk_length = [=](size_t n) -> size_t {
+                return n < num_chunks ? chunk_capacity : value_length - (num_chunks - 1) * chunk_capacity;
+            };
+            const auto part_size = [&](size_t part_no) -> size_t {
+                return part_no == 0 ? Item::CalcSizeRequired(key, Item::chain_ref_length, m_cas_enabled)
+                                    : Item::CalcSizeRequired(chunk_key, Item::CalcChunkValueLength(chunk_length(part_no)), false);
+            };
+            // parts are not in the cache yet, but they may be evicted by the subsequent allocations, such parts are re-allocated
+            const auto on_delete = [&](void * ptr) noexcept -> void {
+                auto part = std::find(parts.begin(), parts.end(), ptr);
+                if (part != parts.end()) {
+                    *part = nullptr;
+                } else {
+                    this->on_evicted(reinterpret_cast<Item *>(ptr));
+                }
+            };
+            const size_t max_allocations = parts.size() * 2;
+            size_t num_allocations = 0;
+            while (std::find(parts.begin(), parts.end(), nullptr) != parts.end()) {
+                for (size_t part_no = 0; part_no < parts.size(); ++part_no) {
+                    if (parts[part_no] != nullptr) {
+                        continue;
+                    }
+                    void * memory = nullptr;
+                    if (num_allocations++ < max_allocations) {
+                        memory = m_allocator.alloc_or_evict(part_size(part_no), evict, on_delete);
+                        free_orphans();
+                    }
+                    if (memory == nullptr) {
+                        for (auto part : parts) {
+                            if (part != nullptr) {
+                                m_allocator.free(part);
+                            }
+                        }
+                        throw system_error(error::out_of_memory);
+                    }
+                    parts[part_no] = memory;
+                }
+            }
+            auto head = construct_item(parts[0], key, hash, Item::chain_ref_length, flags, keepalive);
+            head->make_chain(static_cast<uint32>(value_length));
+            const hash_type chunk_hash = HashFunction()(chunk_key);
+            for (size_t part_no = 1; part_no < parts.size(); ++part_no) {
+                const size_t chunk_value_length = Item::CalcChunkValueLength(chunk_length(part_no));
+                auto chunk = new (parts[part_no]) Item(chunk_key, chunk_hash, static_cast<uint32>(chunk_value_length), 0, Item::infinite_TTL);
+                chunk->make_chunk(head, static_cast<uint32>(chunk_length(part_no)));
+                head->add_chunk(chunk);
+            }
+            return head;
+        }
+
+
+        template <class Allocator>
+        inline bool BasicCache<Allocator>::can_move(ConstItemPtr item) const noexcept {
+            if (item->is_shared() || item->is_shared_entry() || item->is_chained() || item->is_chunk() || item->is_orphan()) {
+                return false;
+            }
+            if (not m_pins.empty() && m_pins.count(item) > 0) {
+                return false;
+            }
+            // item may be not in the cache yet
+            return is_stored(item);
+        }
+
+
+        template <class Allocator>
+        inline bool BasicCache<Allocator>::is_stored(ConstItemPtr item) const noexcept {
+            bool found; ItemPtr stored;
+            tie(found, stored) = m_dict.get(item->key(), item->hash());
+            return found && stored == item;
+        }
+
+
+        template <class Allocator>
+        inline bool BasicCache<Allocator>::pin(ConstItemPtr item) {
+            if (reinterpret_cast<const uint8 *>(item) == m_codec_buffer.get()) {
+                return false; // decompressed copy (see `reveal()`)
+            }
+            m_pins[item] += 1;
+            return true;
+        }
+
+
+        template <class Allocator>
+        inline void BasicCache<Allocator>::unpin(ConstItemPtr item) noexcept {
+            auto pinned = m_pins.find(item);
+            if (pinned != m_pins.end() && --pinned->second == 0) {
+                m_pins.erase(pinned);
+            }
+        }
+
+
+        template <class Allocator>
+        inline void BasicCache<Allocator>::revoke_pins(ConstItemPtr item) noexcept {
+            if (m_pins.empty()) {
+                return;
+            }
+            auto pinned = m_pins.find(item);
+            if (pinned != m_pins.end()) {
+                m_pins.erase(pinned);
+                if (on_pin_revoked) {
+                    on_pin_revoked(item);
+                }
+            }
+        }
+
+
+        template <class Allocator>
+        inline void BasicCache<Allocator>::on_moved(ItemPtr item) noexcept {
+            bool found; iterator at;
+            tie(found, at) = m_dict.entry_for(item->key(), item->hash(), /*readonly*/true);
+            debug_assert(found);
+            at.unsafe_replace_kv(item->key(), item->hash(), item);
+            m_allocator.expire_at(item, item->expiration_time());
+        }
+
+
+        template <class Allocator>
+        inline size_t BasicCache<Allocator>::compact(size_t max_bytes) noexcept {
+            const auto can_move_block = [=](void * ptr) -> bool {
+                return this->can_move(reinterpret_cast<ConstItemPtr>(ptr));
+            };
+            const auto on_moved_block = [=](void *, void * to) noexcept -> void {
+                this->on_moved(reinterpret_cast<ItemPtr>(to));
+            };
+            return m_allocator.compact(max_bytes, can_move_block, on_moved_block);
+        }
+
+
+        template <class Allocator>
+        inline void BasicCache<Allocator>::resize(size_t new_memory_limit) {
+            if (new_memory_limit % m_allocator.page_size != 0) {
+                throw std::invalid_argument("memory_limit must be multiple of the page size");
+            }
+            if (new_memory_limit > m_allocator.arena_size) {
+                throw std::invalid_argument("memory_limit exceeds the initial one");
+            }
+            if (new_memory_limit < m_allocator.min_size()) {
+                throw std::invalid_argument("memory_limit is too small");
+            }
+            resize_arena(new_memory_limit);
+        }
+
+
+        template <class Allocator>
+        inline void BasicCache<Allocator>::resize_arena(size_t new_memory_limit) noexcept {
+            const auto on_delete = [=](void * ptr) noexcept -> void {
+                this->on_evicted(reinterpret_cast<Item *>(ptr));
+            };
+            const auto can_move_block = [=](void * ptr) -> bool {
+                return this->can_move(reinterpret_cast<ConstItemPtr>(ptr));
+            };
+            const auto on_moved_block = [=](void *, void * to) noexcept -> void {
+                this->on_moved(reinterpret_cast<ItemPtr>(to));
+            };
+            m_allocator.resize(new_memory_limit, on_delete, can_move_block, on_moved_block);
+            free_orphans();
+        }
+
+
+        template <class Allocator>
+        inline void BasicCache<Allocator>::set_memory_budget(size_t budget) {
+            if (budget > 0 && budget < m_allocator.min_size()) {
+                throw std::invalid_argument("memory budget is too small");
+            }
+            if (budget > m_allocator.arena_size) {
+                throw std::invalid_argument("memory budget exceeds the initial memory_limit");
+            }
+            m_memory_budget = budget;
+            STAT_SET(mem.memory_budget, budget);
+            if (budget > 0) {
+                fit_memory_budget(0);
+            } else {
+                resize_arena(m_allocator.arena_size);
+            }
+        }
+
+
+        template <class Allocator>
+        inline void BasicCache<Allocator>::fit_memory_budget(size_t external_memory) noexcept {
+            if (m_memory_budget == 0) {
+                return;
+            }
+            const size_t overhead = m_dict.memory_usage() + m_shared_values.memory_usage() + external_memory;
+            const size_t available = m_memory_budget > overhead ? m_memory_budget - overhead : 0;
+            const size_t page_size = m_allocator.page_size;
+            const size_t current_limit = m_allocator.online_size();
+            size_t new_limit = current_limit;
+            if (available < current_limit) {
+                new_limit = available - available % page_size;
+            } else if (available >= current_limit + 2 * page_size) {
+                // keep one page in reserve, so the small fluctuations of the overhead don't move pages back and forth
+                new_limit = available - available % page_size - page_size;
+            }
+            new_limit = std::min(std::max(new_limit, m_allocator.min_size()), m_allocator.arena_size);
+            if (new_limit != current_limit) {
+                resize_arena(new_limit);
+            }
+        }
+
+
+        template <class Allocator>
+        inline void BasicCache<Allocator>::maybe_compact() noexcept {
+            if (m_compaction_budget == 0) {
+                return;
+            }
+            size_t free_total, free_fragmented;
+            tie(free_total, free_fragmented) = m_allocator.free_memory();
+            if (free_fragmented > free_total / 2) {
+                compact(m_compaction_budget);
+            }
+        }
+
+
+        template <class Allocator>
+        inline bool BasicCache<Allocator>::fits_inplace(ConstItemPtr item, size_t value_length) const noexcept {
+            if (item->is_shared() || item->is_chained()) {
+                return false;
+            }
+            const size_t size_required = Item::CalcSizeRequired(item->key(), value_length, item->has_cas());
+            const size_t size_available = m_allocator.usable_size(const_cast<ItemPtr>(item));
+            // don't keep the big chunk of memory for the much smaller value
+            return size_required <= size_available && size_required >= size_available / 2;
+        }
+
+
+        template <class Allocator>
+        inline void BasicCache<Allocator>::set_compression_threshold(size_t threshold) {
+            if (threshold > 0 && not m_codec_buffer) {
+                // the biggest compressible item fits in the single page
+                m_codec_buffer.reset(new uint8[m_allocator.page_size]);
+            }
+            m_compression_threshold = threshold;
+        }
+
+
+        template <class Allocator>
+        inline void BasicCache<Allocator>::maybe_share(ItemPtr item) noexcept {
+            constexpr size_t min_shareable = 64;
+            const slice data = item->value();
+            if (m_dedup_threshold == 0 || data.length() < m_dedup_threshold || data.length() < min_shareable
+                    || item->is_compressed() || item->is_counter() || item->is_shared() || item->is_chained()) {
+                return;
+            }
+            // shared values are looked up by the 64-bit hash of the content
+            const uint64 content_hash = wyhash<uint64>::hasher()(data);
+            const slice content_key(reinterpret_cast<const char *>(&content_hash), sizeof(content_hash));
+            const hash_type content_key_hash = HashFunction()(content_key);
+            bool found; iterator at;
+            try {
+                tie(found, at) = m_shared_values.entry_for(content_key, content_key_hash);
+            } catch (const std::bad_alloc &) {
+                return; // no memory to grow the table, item stays as is
+            }
+            ItemPtr entry;
+            if (found) {
+                entry = at.value();
+                if (entry->value() != data) {
+                    return; // hash collision
+                }
+            } else {
+                // do not evict existing items here to avoid accidentally free the `item`
+                const size_t entry_value_length = Item::CalcSharedEntryValueLength(data.length());
+                const size_t size_required = Item::CalcSizeRequired(content_key, entry_value_length, false);
+                if (size_required > allocation_limit()) {
+                    return;
+                }
+                void * memory = m_allocator.alloc(size_required);
+                if (memory == nullptr) {
+                    return;
+                }
+                entry = new (memory) Item(content_key, content_key_hash, static_cast<uint32>(entry_value_length), 0, Item::infinite_TTL);
+                entry->make_shared_entry(data);
+                m_shared_values.insert(at, entry->key(), content_key_hash, entry);
+                STAT_INCR(mem.num_shared_values, 1);
+            }
+            item->refer_to(entry);
+            STAT_INCR(mem.num_shared_refs, 1);
+            // shrink the item
+            m_allocator.realloc_inplace(item, Item::CalcSizeRequired(item->key(), Item::shared_ref_length, item->has_cas()));
+        }
+
+
+        template <class Allocator>
+        inline ItemPtr BasicCache<Allocator>::release_shared(ItemPtr item) noexcept {
+            auto entry = item->unrefer();
+            STAT_DECR(mem.num_shared_refs, 1);
+            if (entry->shared_header()->num_refs > 0) {
+                return nullptr;
+            }
+            debug_only(bool deleted = ) m_shared_values.del(entry->key(), entry->hash());
+            debug_assert(deleted);
+            STAT_DECR(mem.num_shared_values, 1);
+            return entry;
+        }
+
+
+        template <class Allocator>
+        inline void BasicCache<Allocator>::maybe_compress(ItemPtr item) noexcept {
+            constexpr size_t min_compressible = 64;
+            const slice raw_value = item->value();
+            if (m_compression_threshold == 0 || raw_value.length() < m_compression_threshold || raw_value.length() < min_compressible
+                    || item->is_compressed() || item->is_counter() || item->is_shared() || item->is_chained()) {
+                return;
+            }
+            // it isn't worth to decompress value on every `get` to save less than 1/8
+            const size_t compressed_limit = raw_value.length() - raw_value.length() / 8 - Item::CalcCompressedValueLength(0);
+            auto compressed = reinterpret_cast<char *>(m_codec_buffer.get());
+            const size_t compressed_length = lz4::compress(raw_value, compressed, compressed_limit);
+            if (compressed_length == 0) {
+                STAT_INCR(mem.num_compress_rejected, 1);
+                return;
+            }
+            STAT_INCR(mem.total_compress_raw, raw_value.length());
+            STAT_INCR(mem.total_compress_stored, Item::CalcCompressedValueLength(compressed_length));
+            item->assign_compressed(slice(compressed, compressed_length), static_cast<uint32>(raw_value.length()));
+            // shrink the item
+            m_allocator.realloc_inplace(item, Item::CalcSizeRequired(item->key(), item->value().length(), item->has_cas()));
+        }
+
+
+        template <class Allocator>
+        inline ConstItemPtr BasicCache<Allocator>::reveal(ConstItemPtr item) noexcept {
+            if (not item->is_compressed()) {
+                return item;
+            }
+            void * memory = m_codec_buffer.get();
+            const uint32 value_length = item->uncompressed_length();
+            debug_assert(Item::CalcSizeRequired(item->key(), value_length, item->has_cas()) <= m_allocator.page_size);
+            ItemPtr copy;
+            if (item->has_cas()) {
+                copy = new (memory) Item(item->key(), item->hash(), value_length, item->opaque_flags(), item->ttl(), item->timestamp());
+            } else {
+                copy = new (memory) Item(item->key(), item->hash(), value_length, item->opaque_flags(), item->ttl());
+            }
+            debug_only(const size_t decompressed_length = )
+                lz4::decompress(item->compressed_data(), const_cast<char *>(copy->value().begin()), value_length);
+            debug_assert(decompressed_length == value_length);
+            return copy;
+        }
+
+
+        template <class Allocator>
+        inline bool BasicCache<Allocator>::fits_counter(ConstItemPtr item) const noexcept {
+            if (item->is_counter()) {
+                return true;
+            }
+            if (item->is_shared() || item->is_chained()) {
+                return false;
+            }
+            const size_t size_required = Item::CalcSizeRequired(item->key(), Item::max_counter_length, item->has_cas());
+            return size_required <= m_allocator.usable_size(const_cast<ItemPtr>(item));
+        }
+
+
+        template <class Allocator>
+        inline ItemPtr BasicCache<Allocator>::overwrite_item(ItemPtr item, size_t value_length, opaque_flags_type flags, seconds keepalive) noexcept {
+            debug_assert(fits_inplace(item, value_length));
+            revoke_pins(item);
+            item->reuse(static_cast<uint32>(value_length), item->has_cas() ? ++m_newest_timestamp : 0);
+            item->set_opaque_flags(flags);
+            item->set_ttl(keepalive);
+            m_allocator.expire_at(item, item->expiration_time());
+            return item;
+        }
+
+
+        template <class Allocator>
+        inline ItemPtr BasicCache<Allocator>::construct_item(void * memory, const slice key, const hash_type hash, uint32 value_length, opaque_flags_type flags, seconds keepalive) noexcept {
+            ItemPtr item;
+            if (m_cas_enabled) {
+                item = new (memory) Item(key, hash, value_length, flags, keepalive, ++m_newest_timestamp);
+            } else {
+                item = new (memory) Item(key, hash, value_length, flags, keepalive);
+            }
+            m_allocator.expire_at(item, item->expiration_time());
+            return item;
+        }
+
+
+        template <class Allocator>
+        inline void BasicCache<Allocator>::destroy_item(ItemPtr item) noexcept {
+            revoke_pins(item);
+            if (item->is_shared()) {
+                auto entry = release_shared(item);
+                if (entry != nullptr) {
+                    m_allocator.free(entry);
+                }
+            } else if (item->is_chained()) {
+                for (Item * chunk = item->chain_header()->first_chunk; chunk != nullptr; ) {
+                    auto next = chunk->chunk_header()->next;
+                    m_allocator.free(chunk);
+                    chunk = next;
+                }
+            }
             m_allocator.free(item);
         }
 
 
-        inline void Cache::replace_item_at(iterator at, ItemAutoDelete & lockedItem) noexcept {
+        template <class Allocator>
+        inline void BasicCache<Allocator>::on_evicted(ItemPtr item) noexcept {
+            if (item->is_orphan()) {
+                // item was already removed from the cache, there is nothing to free anymore
+                m_orphans.erase(std::find(m_orphans.begin(), m_orphans.end(), item));
+                return;
+            }
+            if (item->is_shared_entry()) {
+                // evict all the items referencing this value
+                auto header = item->shared_header();
+                while (not header->refs.empty()) {
+                    auto owner = header->refs.pop_front()->owner;
+                    header->num_refs -= 1;
+                    debug_only(bool deleted = ) m_dict.del(owner->key(), owner->hash());
+                    debug_assert(deleted);
+                    revoke_pins(owner);
+                    if (on_eviction) {
+                        on_eviction(owner);
+                    }
+                    owner->set_orphan();
+                    m_orphans.push_back(owner);
+                }
+                debug_only(bool deleted = ) m_shared_values.del(item->key(), item->hash());
+                debug_assert(deleted);
+                STAT_DECR(mem.num_shared_values, 1);
+                return;
+            }
+            if (item->is_chunk()) {
+                evict_chain(item->chunk_header()->owner, item);
+                return;
+            }
+            if (item->is_chained()) {
+                evict_chain(item, nullptr);
+                return;
+            }
+            if (not m_pins.empty() && m_pins.count(item) > 0 && not is_stored(item)) {
+                // new item pinned before it was stored
+                revoke_pins(item);
+                return;
+            }
+            debug_only(bool deleted = ) m_dict.del(item->key(), item->hash());
+            debug_assert(deleted);
+            revoke_pins(item);
+            if (on_eviction) {
+                if (item->is_counter()) {
+                    item->render_counter();
+                }
+                on_eviction(reveal(item));
+            }
+            if (item->is_shared()) {
+                auto entry = release_shared(item);
+                if (entry != nullptr) {
+                    // entry may be evicted by the same allocation, free it later
+                    entry->set_orphan();
+                    m_orphans.push_back(entry);
+                }
+            }
+        }
+
+
+        template <class Allocator>
+        inline void BasicCache<Allocator>::evict_chain(ItemPtr item, ItemPtr evicted_chunk) noexcept {
+            debug_assert(not item->is_orphan());
+            if (m_pins.empty() || m_pins.count(item) == 0 || is_stored(item)) {
+                debug_only(bool deleted = ) m_dict.del(item->key(), item->hash());
+                debug_assert(deleted);
+                if (on_eviction) {
+                    on_eviction(item);
+                }
+            }
+            // new item pinned before it was stored is freed the same way
+            revoke_pins(item);
+            // the rest of the chain may be evicted by the same allocation, free it later
+            for (Item * chunk = item->chain_header()->first_chunk; chunk != nullptr; chunk = chunk->chunk_header()->next) {
+                if (chunk != evicted_chunk) {
+                    chunk->set_orphan();
+                    m_orphans.push_back(chunk);
+                }
+            }
+            if (evicted_chunk != nullptr) {
+                item->set_orphan();
+                m_orphans.push_back(item);
+            }
+        }
+
+
+        template <class Allocator>
+        inline void BasicCache<Allocator>::free_orphans() noexcept {
+            for (auto orphan : m_orphans) {
+                m_allocator.free(orphan);
+            }
+            m_orphans.clear();
+        }
+
+
+        template <class Allocator>
+        inline void BasicCache<Allocator>::replace_item_at(iterator at, ItemAutoDelete & lockedItem) noexcept {
             auto old_item = at.value();
             auto new_item = lockedItem.get();
             debug_assert(old_item->hash() == new_item->hash() && old_item->key() == new_item->key());
+            maybe_share(new_item);
+            maybe_compress(new_item);
             destroy_item(old_item);
             at.unsafe_replace_kv(new_item->key(), new_item->hash(), new_item);
             lockedItem.reset(); // Item will live
         }
 
 
-        inline void Cache::insert_item_at(const iterator at, ItemAutoDelete & lockedItem) noexcept {
+        template <class Allocator>
+        inline void BasicCache<Allocator>::insert_item_at(const iterator at, ItemAutoDelete & lockedItem) noexcept {
             auto i = lockedItem.get();
+            maybe_share(i);
+            maybe_compress(i);
             m_dict.insert(at, i->key(), i->hash(), i);
             lockedItem.reset();
         }
 
 
-        inline void Cache::publish_stats() noexcept {
+        template <class Allocator>
+        inline void BasicCache<Allocator>::publish_stats() noexcept {
             STAT_SET(cache.hash_capacity, m_dict.capacity());
             STAT_SET(cache.curr_items, m_dict.size());
             STAT_SET(cache.hash_is_expanding, m_dict.is_expanding());
+            STAT_SET(mem.dict_memory, m_dict.memory_usage() + m_shared_values.memory_usage());
+            size_t free_total, free_fragmented;
+            tie(free_total, free_fragmented) = m_allocator.free_memory();
+            STAT_SET(mem.fragmentation, free_total > 0 ? free_fragmented * 100 / free_total : 0);
         }
 
     } // namespace cache
@@ -41,6 +41,9 @@
 #include <tuple>    // tuple
 #include <thread>   // thread std::this_thread
 #include <cstring>  // memmove
+#if defined(HAVE_MADVISE)
+#  include <sys/mman.h> // madvise
+#endif
 
 #define __CACHELOT_PP_STR1(X) #X
 #define CACHELOT_PP_STR(X) __CACHELOT_PP_STR1(X)
@@ -126,6 +129,22 @@ namespace cachelot {
     #endif
     }
 
+    /// let OS reclaim physical memory of the [`ptr`, `ptr + size`) range,
+    /// memory stays accessible but its content is lost
+    inline void discard_memory(void * ptr, size_t size) noexcept {
+    #if defined(HAVE_MADVISE)
+        // madvise works on whole OS pages only
+        const size_t os_page = 4 * 1024;
+        const auto begin = (reinterpret_cast<size_t>(ptr) + os_page - 1) & ~(os_page - 1);
+        const auto end = (reinterpret_cast<size_t>(ptr) + size) & ~(os_page - 1);
+        if (begin < end) {
+            (void)::madvise(reinterpret_cast<void *>(begin), end - begin, MADV_DONTNEED);
+        }
+    #else
+        (void)ptr; (void)size;
+    #endif
+    }
+
     constexpr size_t cpu_l1d_cache_line = 64;
     constexpr int the_answer_to_life_the_universe_and_everything = 42;
 
@@ -0,0 +1,23 @@
+#ifndef CACHELOT_CONFIG_H_INCLUDED
+#define CACHELOT_CONFIG_H_INCLUDED
+
+//
+//  (C) Copyright 2015 Iurii Krasnoshchok
+//
+//  Distributed under the terms of Simplified BSD License
+//  see LICENSE file
+
+#define HAVE_ALIGNED_ALLOC 1
+#define HAVE_POSIX_MEMALIGN 1
+#define HAVE_MADVISE 1
+
+// Hash function of the cache keys (wyhash or fnv1a)
+/* #undef CACHELOT_HASH_FNV1A */
+
+// Do not store key hash in the cache item header
+/* #undef CACHELOT_ITEM_NO_HASH */
+
+// io_uring transport of the stream connections
+#define CACHELOT_HAVE_IO_URING 1
+
+#endif // CACHELOT_CONFIG_H_INCLUDED
@@ -22,6 +22,9 @@ namespace cachelot {
      * but when load factor of primary table exceds threshold, primary becomes the secondary,
      * new table allocated as a new primary and every update operation on dict moves some
      * items from the secondary table back to the primary, util no items left in the secondary
+     * The same machinery is used to shrink the dict: when the number of elements drops below
+     * `min_load_factor_percent` of capacity, smaller table becomes the primary and items migrate there incrementally.
+     * dict never shrinks below its initial size
      *
      * @note dict does not manage stored items lifetime. It expects items to be POD data with trivial destructor and copy.
      *
@@ -116,6 +119,12 @@ namespace cachelot {
 
     private:
         static constexpr size_type default_initial_size = 16;
+        // dict shrinks when load factor drops below this value (must be far enough from the max_load_factor_percent)
+        static constexpr size_type min_load_factor_percent = 20;
+        // load factor of a table after shrink
+        static constexpr size_type shrink_load_factor_percent = 50;
+        static_assert(min_load_factor_percent < shrink_load_factor_percent && shrink_load_factor_percent < Options::max_load_factor_percent,
+                      "shrink thresholds must not overlap with the max load factor");
         typedef typename hash_table_type::entry_type entry;
 
     public:
@@ -124,6 +133,7 @@ namespace cachelot {
             : m_primary_tbl(new hash_table_type(roundup_pow2(initial_size)))
             , m_secondary_tbl(nullptr)
             , m_hashpower(log2u(roundup_pow2(initial_size)))
+            , m_min_hashpower(m_hashpower)
             , m_expand_pos(0)
         {
             debug_assert(initial_size > 0);
@@ -157,6 +167,7 @@ namespace cachelot {
 
         /// return either iterator referencing existing entry or pointer to insertion position
         tuple<bool, iterator> entry_for(key_type key, hash_type hash, bool readonly = false) {
+            maybe_shrink();
             if (not is_expanding()) {
                 return search_primary(key, hash, readonly);
             } else {
@@ -200,8 +211,12 @@ namespace cachelot {
         void remove_if(ConditionFun predicate) noexcept {
             if (m_secondary_tbl) {
                 m_secondary_tbl->remove_if(predicate);
+                if (m_secondary_tbl->empty()) {
+                    end_expand();
+                }
             }
             m_primary_tbl->remove_if(predicate);
+            maybe_shrink();
         }
 
         /// @copydoc hash_table::contains
@@ -228,6 +243,15 @@ namespace cachelot {
             return num_elements;
         }
 
+        /// amount of memory occupied by the hash tables
+        size_t memory_usage() const noexcept {
+            size_t result = m_primary_tbl->memory_usage();
+            if (is_expanding()) {
+                result += m_secondary_tbl->memory_usage();
+            }
+            return result;
+        }
+
         /// check whether dict is empty
         bool empty() const noexcept {
             return size() == 0;
@@ -239,6 +263,16 @@ namespace cachelot {
         /// empty the dictionary
         void clear() noexcept {
             m_secondary_tbl.reset(nullptr);
+            m_expand_pos = 0;
+            if (m_hashpower > m_min_hashpower) {
+                // give memory back, initial size is enough for the empty dict
+                std::unique_ptr<hash_table_type> initial_tbl(new (nothrow) hash_table_type(pow2(m_min_hashpower)));
+                if (initial_tbl && initial_tbl->ok()) {
+                    m_primary_tbl.swap(initial_tbl);
+                    m_hashpower = m_min_hashpower;
+                    return;
+                }
+            }
             m_primary_tbl->clear();
         }
 
@@ -286,17 +320,43 @@ namespace cachelot {
         }
 
         void begin_expand() {
+            if (not begin_rehash(m_hashpower + 1)) {
+                throw std::bad_alloc();
+            }
+        }
+
+        /// start moving items into the smaller table if there are too few of them
+        /// shrinking is optional, dict stays as is if there is no memory for the new table
+        void maybe_shrink() noexcept {
+            if (is_expanding() || m_hashpower <= m_min_hashpower) {
+                return;
+            }
+            const uint64 num_elements = m_primary_tbl->size();
+            if (num_elements * 100 >= static_cast<uint64>(capacity()) * min_load_factor_percent) {
+                return;
+            }
+            const auto desired_capacity = static_cast<size_type>(roundup_pow2<uint64>(std::max<uint64>(num_elements * 100 / shrink_load_factor_percent, 1)));
+            const size_type new_hashpower = std::max<size_type>(log2u(desired_capacity), m_min_hashpower);
+            if (new_hashpower < m_hashpower) {
+                begin_rehash(new_hashpower);
+            }
+        }
+
+        /// allocate new primary table of 2^`new_hashpower` capacity and start to move items there
+        /// @return `false` if there was not enough memory
+        bool begin_rehash(const size_type new_hashpower) noexcept {
             debug_assert(not is_expanding());
             m_expand_pos = 0;
             m_primary_tbl.swap(m_secondary_tbl);
-            m_primary_tbl.reset(new hash_table_type(pow2(m_hashpower + 1)));
+            m_primary_tbl.reset(new (nothrow) hash_table_type(pow2(new_hashpower)));
             if (m_primary_tbl && m_primary_tbl->ok()) {
-                m_hashpower += 1;
+                m_hashpower = new_hashpower;
                 rehash_some();
+                return true;
             } else {
                 m_primary_tbl.swap(m_secondary_tbl);
                 m_secondary_tbl.reset(nullptr);
-                throw std::bad_alloc();
+                return false;
             }
         }
 
@@ -309,6 +369,10 @@ namespace cachelot {
 
         void rehash_some() noexcept {
             static constexpr size_type min_batch_size = 512;
+            if (m_secondary_tbl->empty()) {
+                end_expand();
+                return;
+            }
             const size_type batch_size = std::min<size_type>(min_batch_size, m_secondary_tbl->size());
             size_type elements_moved = 0;
             while (elements_moved < batch_size) {
@@ -333,6 +397,7 @@ namespace cachelot {
         std::unique_ptr<hash_table_type> m_primary_tbl;
         std::unique_ptr<hash_table_type> m_secondary_tbl;
         size_type m_hashpower;  // power of 2
+        size_type m_min_hashpower; // dict never shrinks below its initial size
         size_type m_expand_pos; // index of last element moved from secondary table to the primary
     };
 
@@ -32,6 +32,13 @@ namespace cachelot {
                 }
                 return checksum;
             }
+
+            /// calculate hashes of the `count` keys at once
+            void operator()(const slice * keys, hash_type * hashes, size_t count) const noexcept {
+                for (size_t n = 0; n < count; ++n) {
+                    hashes[n] = operator()(keys[n]);
+                }
+            }
         };
 
         // 32-bit variant
@@ -265,6 +265,9 @@ namespace cachelot {
         /// number of items in table
         constexpr size_type size() const noexcept { return m_size; }
 
+        /// amount of memory occupied by the table
+        constexpr size_t memory_usage() const noexcept { return static_cast<size_t>(m_capacity) * (sizeof(hash_type) + sizeof(entry_type)); }
+
         /// check whether number of stored elements equals max_size()
         constexpr bool threshold_reached() const noexcept { return m_size >= max_size(); }
 
@@ -0,0 +1,197 @@
+#ifndef CACHELOT_HASH_WYHASH_H_INCLUDED
+#define CACHELOT_HASH_WYHASH_H_INCLUDED
+
+//
+//  (C) Copyright 2015 Iurii Krasnoshchok
+//
+//  Distributed under the terms of Simplified BSD License
+//  see LICENSE file
+
+
+#include <cachelot/slice.h>
+
+#if defined(_MSC_VER) && defined(_M_X64)
+#  include <intrin.h>
+#  pragma intrinsic(_umul128)
+#endif
+
+namespace cachelot {
+
+    namespace internal {
+
+        // wyhash constants (primes with good bit distribution)
+        constexpr uint64 wyp0 = 0xa0761d6478bd642full;
+        constexpr uint64 wyp1 = 0xe7037ed1a0b428dbull;
+        constexpr uint64 wyp2 = 0x8ebc6af09c88c6e3ull;
+        constexpr uint64 wyp3 = 0x589965cc75374cc3ull;
+
+        /// 64x64 -> 128 bit multiplication, `lo` and `hi` receive corresponding parts of the result
+        inline void wymum(uint64 & lo, uint64 & hi) noexcept {
+#if defined(__SIZEOF_INT128__)
+            __uint128_t r = lo; r *= hi;
+            lo = static_cast<uint64>(r); hi = static_cast<uint64>(r >> 64);
+#elif defined(_MSC_VER) && defined(_M_X64)
+            lo = _umul128(lo, hi, &hi);
+#else
+            const uint64 ha = lo >> 32, hb = hi >> 32, la = static_cast<uint32>(lo), lb = static_cast<uint32>(hi);
+            const uint64 rh = ha * hb, rm0 = ha * lb, rm1 = hb * la, rl = la * lb, t = rl + (rm0 << 32);
+            uint64 c = t < rl;
+            const uint64 l = t + (rm1 << 32);
+            c += l < t;
+            lo = l; hi = rh + (rm0 >> 32) + (rm1 >> 32) + c;
+#endif
+        }
+
+        inline uint64 wymix(uint64 a, uint64 b) noexcept {
+            wymum(a, b);
+            return a ^ b;
+        }
+
+        // unaligned little-endian reads
+        inline uint64 wyr8(const uint8 * p) noexcept { uint64 v; std::memcpy(&v, p, 8); return v; }
+        inline uint64 wyr4(const uint8 * p) noexcept { uint32 v; std::memcpy(&v, p, 4); return v; }
+        inline uint64 wyr3(const uint8 * p, size_t k) noexcept {
+            return (static_cast<uint64>(p[0]) << 16) | (static_cast<uint64>(p[k >> 1]) << 8) | p[k - 1];
+        }
+
+        /// per-process hash seed, see `wyhash_seed()`
+        inline uint64 & wyhash_global_seed() noexcept {
+            static uint64 the_seed = 0;
+            return the_seed;
+        }
+
+
+        /// state of the key hashing before the final multiplication
+        struct wyhash_state {
+            uint64 a, b, seed;
+        };
+
+        /// premix user seed once instead of doing it for every key
+        inline uint64 wyhash_mix_seed(uint64 seed) noexcept {
+            return seed ^ wymix(seed ^ wyp0, wyp1);
+        }
+
+        /// consume all of the key bytes but the final mix, `seed` must be premixed
+        inline wyhash_state wyhash_absorb(const slice data, uint64 seed) noexcept {
+            const uint8 * p = reinterpret_cast<const uint8 *>(data.begin());
+            const size_t len = data.length();
+            uint64 a, b;
+            if (len <= 16) {
+                if (len >= 4) {
+                    a = (wyr4(p) << 32) | wyr4(p + ((len >> 3) << 2));
+                    b = (wyr4(p + len - 4) << 32) | wyr4(p + len - 4 - ((len >> 3) << 2));
+                } else if (len > 0) {
+                    a = wyr3(p, len); b = 0;
+                } else {
+                    a = b = 0;
+                }
+            } else {
+                size_t i = len;
+                if (i > 48) {
+                    uint64 see1 = seed, see2 = seed;
+                    do {
+                        seed = wymix(wyr8(p) ^ wyp1, wyr8(p + 8) ^ seed);
+                        see1 = wymix(wyr8(p + 16) ^ wyp2, wyr8(p + 24) ^ see1);
+                        see2 = wymix(wyr8(p + 32) ^ wyp3, wyr8(p + 40) ^ see2);
+                        p += 48; i -= 48;
+                    } while (i > 48);
+                    seed ^= see1 ^ see2;
+                }
+                while (i > 16) {
+                    seed = wymix(wyr8(p) ^ wyp1, wyr8(p + 8) ^ seed);
+                    p += 16; i -= 16;
+                }
+                a = wyr8(p + i - 16); b = wyr8(p + i - 8);
+            }
+            return wyhash_state { a, b, seed };
+        }
+
+        /// final mix of the absorbed key
+        inline uint64 wyhash_finish(wyhash_state st, const size_t len) noexcept {
+            st.a ^= wyp1; st.b ^= st.seed;
+            wymum(st.a, st.b);
+            return wymix(st.a ^ wyp0 ^ len, st.b ^ wyp1);
+        }
+
+        /// fold 64-bit hash into the narrower type
+        template <typename HashType> inline HashType wyhash_fold(uint64 h) noexcept;
+        template <> inline uint64 wyhash_fold<uint64>(uint64 h) noexcept { return h; }
+        template <> inline uint32 wyhash_fold<uint32>(uint64 h) noexcept { return static_cast<uint32>(h ^ (h >> 32)); }
+
+
+        template <typename HashType>
+        class wyhash_hasher {
+        public:
+            typedef HashType hash_type;
+
+            /// @{ constructors
+            wyhash_hasher() noexcept : m_seed(wyhash_mix_seed(wyhash_global_seed())) {}
+            explicit wyhash_hasher(uint64 seed) noexcept : m_seed(wyhash_mix_seed(seed)) {}
+            wyhash_hasher(const wyhash_hasher &) = default;
+            /// @}
+
+            /// operator() produces hash value
+            hash_type operator()(const slice data) const noexcept {
+                return wyhash_fold<hash_type>(wyhash_finish(wyhash_absorb(data, m_seed), data.length()));
+            }
+
+            /// calculate hashes of the `count` keys at once
+            ///
+            /// The 64x64->128 multiplication the hash is built on has no SIMD equivalent on x86,
+            /// so keys are processed in groups with independent dependency chains interleaved,
+            /// letting the CPU overlap the multiplications of the different keys
+            void operator()(const slice * keys, hash_type * hashes, size_t count) const noexcept {
+                constexpr size_t group = 4;
+                wyhash_state st[group];
+                size_t n = 0;
+                for (; n + group <= count; n += group) {
+                    for (size_t g = 0; g < group; ++g) {
+                        st[g] = wyhash_absorb(keys[n + g], m_seed);
+                    }
+                    for (size_t g = 0; g < group; ++g) {
+                        hashes[n + g] = wyhash_fold<hash_type>(wyhash_finish(st[g], keys[n + g].length()));
+                    }
+                }
+                for (; n < count; ++n) {
+                    hashes[n] = operator()(keys[n]);
+                }
+            }
+
+        private:
+            uint64 m_seed;
+        };
+    }
+
+    /**
+     * wyhash - fast non-cryptographic seeded hash function
+     *
+     * Processes input 8/16 bytes at a time, which makes it several times faster than FNV-1a
+     * on the typical key sizes. Seed makes hash values unpredictable
+     * for the outside world to resist the hash-flooding
+     *
+     * @tparam HashType - unsigned integral type of a hash (`uint32` or `uint64`)
+     * @par Example
+     * @code
+     * wyhash_seed(random_seed);  // once at startup
+     * typedef wyhash<uint32>::hasher hasher_type;
+     * auto hash_function = hasher_type();
+     * uint32 hash = hash_function(some_data);
+     * @endcode
+     * @see [wyhash](https://github.com/wangyi-fudan/wyhash)
+     * @ingroup common
+     */
+    template <typename HashType,
+              class = typename std::enable_if<std::is_unsigned<HashType>::value>::type>
+    struct wyhash { typedef internal::wyhash_hasher<HashType> hasher; };
+
+
+    /// Set seed used by default-constructed wyhash hashers
+    /// @note must be called before any value was hashed, otherwise previously calculated hashes become invalid
+    inline void wyhash_seed(uint64 seed) noexcept {
+        internal::wyhash_global_seed() = seed;
+    }
+
+
+} // namespace cachelot
+
+#endif // CACHELOT_HASH_WYHASH_H_INCLUDED
@@ -17,6 +17,18 @@
 #ifndef CACHELOT_EXPIRATION_CLOCK_H_INCLUDED
 #  include <cachelot/expiration_clock.h> // expiration time
 #endif
+#ifndef CACHELOT_HASH_FNV1A_H_INCLUDED
+#  include <cachelot/hash_fnv1a.h>
+#endif
+#ifndef CACHELOT_HASH_WYHASH_H_INCLUDED
+#  include <cachelot/hash_wyhash.h>
+#endif
+#ifndef CACHELOT_STRING_CONV_H_INCLUDED
+#  include <cachelot/string_conv.h> // counters
+#endif
+#ifndef CACHELOT_INTRUSIVE_LIST_H_INCLUDED
+#  include <cachelot/intrusive_list.h> // shared values
+#endif
 
 
 namespace cachelot {
@@ -28,15 +40,26 @@ namespace cachelot {
          *
          * For the sake of memory economy, Item has tricky placement in memory
          * @code
-         * +---------+-------------------------+-------------------------------------?-------+----------?
-         * |  Item   |  key as a sequence      |  value as a sequence                |[align]|[optional]|
-         * |  struct |  of a[key_length] bytes |  of a [value_length] bytes          |[bytes]|[ CAS_val]|
-         * +---------+-------------------------+-------------------------------------?-------+----------?
+         * +---------+-----------?-------------------------+-------------------------------------+
+         * |  Item   |[optional] |  key as a sequence      |  value as a sequence                |
+         * |  struct |[ CAS_val] |  of a[key_length] bytes |  of a [value_length] bytes          |
+         * +---------+-----------?-------------------------+-------------------------------------+
          * @endcode
-         * Item structure is placed first after it
-         * the key is placed, it's `key_length` bytes long then
-         * item flags as ASCII string (the most of the time it will be '0')
-         * the value slice sequence
+         * Item structure is placed first, it's followed by the 8-byte CAS value
+         * (only if item was created with CAS enabled), then the key is placed,
+         * it's `key_length` bytes long, then the value slice sequence
+         *
+         * Counters (items modified by `incr` / `decr`) keep the value as a native 64-bit integer
+         * and are rendered back to ASCII when read, their memory must fit `max_counter_length` bytes.
+         * Compressed items keep the original value length followed by the LZ4 block as a value.
+         * Items with the shared value keep `SharedRef` (the link to the shared value entry) in place of the value,
+         * shared value entry is an item keeping `SharedHeader` (list of the referencing items) followed by the data.
+         * Values which don't fit in the single memory page are split on chunks, chained item keeps `ChainHeader`
+         * in place of the value and every chunk is an item keeping `ChunkHeader` followed by the piece of value
+         * (see `for_each_value_chunk()`).
+         * Items created with CAS disabled (see `--no-cas`) report zero timestamp.
+         * If `CACHELOT_ITEM_NO_HASH` is defined, hash is not stored in the header
+         * and calculated from the key on demand
          * @ingroup cache
          */
         class Item {
@@ -48,17 +71,71 @@ namespace cachelot {
             typedef ExpirationClock clock;
             typedef clock::time_point expiration_time_point;
             typedef uint64 timestamp_type;
+#if defined(CACHELOT_HASH_FNV1A)
+            typedef fnv1a<hash_type>::hasher hash_function;
+#else
+            typedef wyhash<hash_type>::hasher hash_function;
+#endif
             static constexpr uint8 max_key_length = 250; // ! key size is limited to uint8
             static constexpr uint32 max_value_length = std::numeric_limits<uint32>::max();
+            static constexpr uint32 max_counter_length = 20; // ! digits in the uint64 max
             static const seconds infinite_TTL;
+
+            /// link from the item to the shared value (see `refer_to()`)
+            struct SharedRef {
+                intrusive_list_node link; // node in the list of the entry references
+                Item * owner;             // item owning this link
+                Item * entry;             // shared value entry
+            };
+
+            /// header of the shared value entry (see `make_shared_entry()`)
+            struct SharedHeader {
+                intrusive_list<SharedRef, &SharedRef::link> refs;
+                uint32 num_refs;
+                uint32 data_length;
+            };
+            /// value length of the item referencing shared value (including alignment)
+            static constexpr uint32 shared_ref_length = sizeof(SharedRef) + alignof(SharedRef) - 1;
+
+            /// list of chunks of the value split between memory pages (see `make_chain()`)
+            struct ChainHeader {
+                Item * first_chunk;
+                Item * last_chunk;
+                uint32 value_length;  // total length of the value
+                uint32 num_chunks;
+            };
+
+            /// header of the chunk of a chained value (see `make_chunk()`)
+            struct ChunkHeader {
+                Item * owner;   // chained item
+                Item * next;    // next chunk or `nullptr`
+                uint32 length;  // length of the piece of value
+            };
+            /// value length of the chained item (including alignment)
+            static constexpr uint32 chain_ref_length = sizeof(ChainHeader) + alignof(ChainHeader) - 1;
         private:
+            // bits of the `m_meta`
+            enum : uint8 {
+                META_HAS_CAS = 1 << 0,  // CAS value follows the header
+                META_NATIVE_COUNTER = 1 << 1, // value is the native uint64 rather than the ASCII string
+                META_COMPRESSED = 1 << 2, // value is compressed (see `assign_compressed()`)
+                META_SHARED_VALUE = 1 << 3, // value is kept in the shared value entry (see `refer_to()`)
+                META_SHARED_ENTRY = 1 << 4, // item is the shared value entry (see `make_shared_entry()`)
+                META_ORPHAN = 1 << 5, // item is no longer in the cache, but its memory wasn't freed yet
+                META_CHAINED = 1 << 6, // value is split on chunks (see `make_chain()`)
+                META_CHUNK = 1 << 7  // item is the chunk of the chained value (see `make_chunk()`)
+            };
+
             // Important! declaration order affects item size
-            const timestamp_type m_timestamp; // timestamp of this item
+#if !defined(CACHELOT_ITEM_NO_HASH)
             const hash_type m_hash; // hash value
+#endif
             uint32 m_value_length; // length of value [0..MAX_VALUE_LENGTH]
             expiration_time_point m_expiration_time; // when it expires
+            // flags, key length and meta are packed into the single 32-bit word
             opaque_flags_type m_opaque_flags; // user defined item flags
             const uint8 m_key_length; // length of key [1..MAX_KEY_LENGTH]
+            uint8 m_meta; // item properties (META_XXX bits)
 
         private:
             /// private destructor
@@ -70,9 +147,12 @@ namespace cachelot {
             Item(Item &&) = delete;
             Item & operator= (Item &&) = delete;
         public:
-            /// constructor
+            /// constructor (item with CAS value)
             explicit Item(slice the_key, hash_type the_hash, uint32 value_length, opaque_flags_type the_flags, seconds the_ttl, timestamp_type the_timestamp) noexcept;
 
+            /// constructor (item without CAS value)
+            explicit Item(slice the_key, hash_type the_hash, uint32 value_length, opaque_flags_type the_flags, seconds the_ttl) noexcept;
+
             /// Destroy existing Item
             static void Destroy(Item * item) noexcept;
 
@@ -80,25 +160,132 @@ namespace cachelot {
             slice key() const noexcept;
 
             /// return hash value
-            hash_type hash() const noexcept { return m_hash; }
+            hash_type hash() const noexcept;
 
-            /// return slice sequence occupied by value
+            /// return slice sequence occupied by value (empty for the chained items, see `for_each_value_chunk()`)
             slice value() const noexcept;
 
+            /// return length of the value
+            uint32 value_length() const noexcept;
+
+            /// call `fun(slice)` for every contiguous piece of the value in order
+            template <typename Fun>
+            void for_each_value_chunk(Fun fun) const;
+
+            /// copy `data` into the value at the `offset`
+            void write_value(size_t offset, slice data) noexcept;
+
             /// assign value to the item
             void assign_value(slice the_value) noexcept;
 
             /// assign value from the two parts
             void assign_compose(slice left, slice right) noexcept;
 
+            /// reuse memory of the item to store new value of `value_length` bytes under the same key
+            /// @note timestamp is ignored if item has no CAS value
+            void reuse(uint32 value_length, timestamp_type the_timestamp) noexcept;
+
+            /// add `piece` to the end of the value, item memory must be large enough to hold it
+            void append(slice piece, timestamp_type the_timestamp) noexcept;
+
+            /// add `piece` to the beginning of the value, item memory must be large enough to hold it
+            void prepend(slice piece, timestamp_type the_timestamp) noexcept;
+
+            /// check whether value is stored as the native integer (see `counter()`)
+            bool is_counter() const noexcept { return (m_meta & META_NATIVE_COUNTER) != 0; }
+
+            /// retrieve value of the native counter
+            uint64 counter() const noexcept;
+
+            /// store `counter_value` as the native integer
+            void set_counter(uint64 counter_value, timestamp_type the_timestamp) noexcept;
+
+            /// convert native counter back to the ASCII string, item memory must fit `max_counter_length` bytes of value
+            void render_counter() noexcept;
+
+            /// check whether value is compressed
+            bool is_compressed() const noexcept { return (m_meta & META_COMPRESSED) != 0; }
+
+            /// replace value with its `compressed` representation, item memory must be large enough
+            void assign_compressed(slice compressed, uint32 uncompressed_length) noexcept;
+
+            /// retrieve the original length of compressed value
+            uint32 uncompressed_length() const noexcept;
+
+            /// retrieve compressed data (without length prefix)
+            slice compressed_data() const noexcept;
+
+            /// Calculate memory required to store value compressed to `compressed_length` bytes
+            static size_t CalcCompressedValueLength(const size_t compressed_length) noexcept { return sizeof(uint32) + compressed_length; }
+
+            /// check whether item references the shared value
+            bool is_shared() const noexcept { return (m_meta & META_SHARED_VALUE) != 0; }
+
+            /// check whether item is the shared value entry
+            bool is_shared_entry() const noexcept { return (m_meta & META_SHARED_ENTRY) != 0; }
+
+            /// turn item into the shared value entry holding `data`, item memory must be large enough
+            void make_shared_entry(slice data) noexcept;
+
+            /// retrieve header of the shared value entry
+            SharedHeader * shared_header() const noexcept;
+
+            /// replace value with the reference to the shared value `entry` (see `shared_ref_length`)
+            void refer_to(Item * entry) noexcept;
+
+            /// retrieve the link to the shared value
+            SharedRef * shared_ref() const noexcept;
+
+            /// remove reference to the shared value, return shared value entry
+            Item * unrefer() noexcept;
+
+            /// Calculate memory required to store shared value entry of `data_length` bytes
+            static size_t CalcSharedEntryValueLength(const size_t data_length) noexcept { return sizeof(SharedHeader) + alignof(SharedHeader) - 1 + data_length; }
+
+            /// check whether item was already removed from the cache and waits to be freed
+            bool is_orphan() const noexcept { return (m_meta & META_ORPHAN) != 0; }
+
+            /// mark item as removed from the cache
+            void set_orphan() noexcept { m_meta |= META_ORPHAN; }
+
+            /// check whether value is split on chunks
+            bool is_chained() const noexcept { return (m_meta & META_CHAINED) != 0; }
+
+            /// check whether item is a chunk of the chained value
+            bool is_chunk() const noexcept { return (m_meta & META_CHUNK) != 0; }
+
+            /// make item the head of the chained value of `value_length` bytes, chunks must be added with `add_chunk()`
+            void make_chain(uint32 value_length) noexcept;
+
+            /// retrieve header of the chained item
+            ChainHeader * chain_header() const noexcept;
+
+            /// make item the chunk of the `owner` value holding `data_length` bytes (see `CalcChunkValueLength()`)
+            void make_chunk(Item * owner, uint32 data_length) noexcept;
+
+            /// retrieve header of the chunk
+            ChunkHeader * chunk_header() const noexcept;
+
+            /// append `chunk` to the chained value
+            void add_chunk(Item * chunk) noexcept;
+
+            /// Key of the chunk items
+            static slice ChunkKey() noexcept { return slice::from_literal("~"); }
+
+            /// Calculate value length of the chunk holding `data_length` bytes
+            static size_t CalcChunkValueLength(const size_t data_length) noexcept { return sizeof(ChunkHeader) + alignof(ChunkHeader) - 1 + data_length; }
+
             /// user defined flags
             opaque_flags_type opaque_flags() const noexcept { return m_opaque_flags; }
 
             /// re-assign user defined flags
             void set_opaque_flags(opaque_flags_type f) noexcept { m_opaque_flags = f; }
 
-            /// retrieve timestamp of this item
-            timestamp_type timestamp() const noexcept { return m_timestamp; }
+            /// check whether item holds CAS value
+            bool has_cas() const noexcept { return (m_meta & META_HAS_CAS) != 0; }
+
+            /// retrieve timestamp of this item (zero if item has no CAS value)
+            timestamp_type timestamp() const noexcept;
 
             /// retrieve expiration time of this item
             expiration_time_point expiration_time() const noexcept { return m_expiration_time; }
@@ -113,27 +300,57 @@ namespace cachelot {
             bool is_expired() const noexcept { return m_expiration_time <= clock::now(); }
 
             /// Calculate total size in slice required to store provided fields
-            static size_t CalcSizeRequired(const slice the_key, const size_t value_length) noexcept;
+            static size_t CalcSizeRequired(const slice the_key, const size_t value_length, const bool with_cas) noexcept;
 
         private:
+            // common part of the constructors
+            void init_key(slice the_key, hash_type the_hash) noexcept;
             // Item must be properly initialized to call following functions
             static size_t KeyOffset(const Item * i) noexcept;
             static size_t ValueOffset(const Item * i) noexcept;
+            // aligned pointer within the value for the shared value structures
+            template <typename T> T * value_aligned_as() const noexcept;
         };
 
 
         inline Item::Item(slice the_key, hash_type the_hash, uint32 value_length, opaque_flags_type the_flags, seconds the_ttl, timestamp_type the_timestamp) noexcept
-                : m_timestamp(the_timestamp)
-                , m_hash(the_hash)
+#if !defined(CACHELOT_ITEM_NO_HASH)
+                : m_hash(the_hash)
                 , m_value_length(value_length)
+#else
+                : m_value_length(value_length)
+#endif
                 , m_opaque_flags(the_flags)
-                , m_key_length(the_key.length()) {
+                , m_key_length(the_key.length())
+                , m_meta(META_HAS_CAS) {
             set_ttl(the_ttl);
+            std::memcpy(reinterpret_cast<uint8 *>(this) + sizeof(Item), &the_timestamp, sizeof(timestamp_type));
+            init_key(the_key, the_hash);
+        }
+
+
+        inline Item::Item(slice the_key, hash_type the_hash, uint32 value_length, opaque_flags_type the_flags, seconds the_ttl) noexcept
+#if !defined(CACHELOT_ITEM_NO_HASH)
+                : m_hash(the_hash)
+                , m_value_length(value_length)
+#else
+                : m_value_length(value_length)
+#endif
+                , m_opaque_flags(the_flags)
+                , m_key_length(the_key.length())
+                , m_meta(0) {
+            set_ttl(the_ttl);
+            init_key(the_key, the_hash);
+        }
+
+
+        inline void Item::init_key(slice the_key, hash_type debug_only(the_hash)) noexcept {
             debug_assert(unaligned_bytes(this, alignof(Item) == 0));
             debug_assert(the_key.length() <= max_key_length);
-            debug_assert(value_length <= max_value_length);
+            debug_assert(m_value_length <= max_value_length);
             auto this_ = reinterpret_cast<uint8 *>(this);
             std::memcpy(this_ + KeyOffset(this), the_key.begin(), the_key.length());
+            debug_assert(hash() == the_hash);
         }
 
 
@@ -145,14 +362,87 @@ namespace cachelot {
         }
 
 
+        inline Item::hash_type Item::hash() const noexcept {
+#if !defined(CACHELOT_ITEM_NO_HASH)
+            return m_hash;
+#else
+            return hash_function()(key());
+#endif
+        }
+
+
+        inline Item::timestamp_type Item::timestamp() const noexcept {
+            timestamp_type ts = 0;
+            if (has_cas()) {
+                std::memcpy(&ts, reinterpret_cast<const uint8 *>(this) + sizeof(Item), sizeof(timestamp_type));
+            }
+            return ts;
+        }
+
+
         inline slice Item::value() const noexcept {
+            if (is_chained()) {
+                return slice();
+            }
+            if (is_shared()) {
+                return shared_ref()->entry->value();
+            }
+            if (is_shared_entry()) {
+                const auto header = shared_header();
+                auto data_begin = reinterpret_cast<const char *>(header + 1);
+                return slice(data_begin, header->data_length);
+            }
             auto value_begin = reinterpret_cast<const char *>(this) + ValueOffset(this);
             slice v(value_begin, value_begin + m_value_length);
             return v;
         }
 
 
+        inline uint32 Item::value_length() const noexcept {
+            return is_chained() ? chain_header()->value_length : static_cast<uint32>(value().length());
+        }
+
+
+        template <typename Fun>
+        inline void Item::for_each_value_chunk(Fun fun) const {
+            if (not is_chained()) {
+                fun(value());
+                return;
+            }
+            for (Item * chunk = chain_header()->first_chunk; chunk != nullptr; chunk = chunk->chunk_header()->next) {
+                const auto header = chunk->chunk_header();
+                fun(slice(reinterpret_cast<const char *>(header + 1), header->length));
+            }
+        }
+
+
+        inline void Item::write_value(size_t offset, slice data) noexcept {
+            if (not is_chained()) {
+                debug_assert(offset + data.length() <= m_value_length);
+                std::memcpy(reinterpret_cast<uint8 *>(this) + ValueOffset(this) + offset, data.begin(), data.length());
+                return;
+            }
+            debug_assert(offset + data.length() <= chain_header()->value_length);
+            for (Item * chunk = chain_header()->first_chunk; chunk != nullptr && not data.empty(); chunk = chunk->chunk_header()->next) {
+                const auto header = chunk->chunk_header();
+                if (offset >= header->length) {
+                    offset -= header->length;
+                    continue;
+                }
+                const size_t piece_length = std::min<size_t>(header->length - offset, data.length());
+                std::memcpy(reinterpret_cast<uint8 *>(header + 1) + offset, data.begin(), piece_length);
+                data = slice(data.begin() + piece_length, data.end());
+                offset = 0;
+            }
+        }
+
+
         inline void Item::assign_value(slice the_value) noexcept {
+            if (is_chained()) {
+                debug_assert(the_value.length() == chain_header()->value_length);
+                write_value(0, the_value);
+                return;
+            }
             debug_assert(the_value.length() <= m_value_length);
             auto this_ = reinterpret_cast<uint8 *>(this);
             std::memcpy(this_ + ValueOffset(this), the_value.begin(), the_value.length());
@@ -161,6 +451,12 @@ namespace cachelot {
 
 
         inline void Item::assign_compose(slice left, slice right) noexcept {
+            if (is_chained()) {
+                debug_assert(left.length() + right.length() == chain_header()->value_length);
+                write_value(0, left);
+                write_value(left.length(), right);
+                return;
+            }
             debug_assert(left.length() + right.length() <= m_value_length);
             auto this_ = reinterpret_cast<uint8 *>(this);
             std::memcpy(this_ + ValueOffset(this), left.begin(), left.length());
@@ -170,6 +466,185 @@ namespace cachelot {
 
 
 
+        inline void Item::reuse(uint32 value_length, timestamp_type the_timestamp) noexcept {
+            debug_assert(value_length <= max_value_length);
+            debug_assert(not is_shared() && not is_shared_entry());
+            m_value_length = value_length;
+            m_meta &= ~(META_NATIVE_COUNTER | META_COMPRESSED);
+            if (has_cas()) {
+                std::memcpy(reinterpret_cast<uint8 *>(this) + sizeof(Item), &the_timestamp, sizeof(timestamp_type));
+            }
+        }
+
+
+        inline void Item::append(slice piece, timestamp_type the_timestamp) noexcept {
+            const auto old_length = m_value_length;
+            reuse(static_cast<uint32>(old_length + piece.length()), the_timestamp);
+            auto value_begin = reinterpret_cast<uint8 *>(this) + ValueOffset(this);
+            std::memcpy(value_begin + old_length, piece.begin(), piece.length());
+        }
+
+
+        inline void Item::prepend(slice piece, timestamp_type the_timestamp) noexcept {
+            const auto old_length = m_value_length;
+            reuse(static_cast<uint32>(old_length + piece.length()), the_timestamp);
+            auto value_begin = reinterpret_cast<uint8 *>(this) + ValueOffset(this);
+            std::memmove(value_begin + piece.length(), value_begin, old_length);
+            std::memcpy(value_begin, piece.begin(), piece.length());
+        }
+
+
+        inline uint64 Item::counter() const noexcept {
+            debug_assert(is_counter());
+            debug_assert(m_value_length == sizeof(uint64));
+            uint64 counter_value;
+            std::memcpy(&counter_value, reinterpret_cast<const uint8 *>(this) + ValueOffset(this), sizeof(uint64));
+            return counter_value;
+        }
+
+
+        inline void Item::set_counter(uint64 counter_value, timestamp_type the_timestamp) noexcept {
+            reuse(sizeof(uint64), the_timestamp);
+            m_meta |= META_NATIVE_COUNTER;
+            std::memcpy(reinterpret_cast<uint8 *>(this) + ValueOffset(this), &counter_value, sizeof(uint64));
+        }
+
+
+        inline void Item::render_counter() noexcept {
+            AsciiIntegerBuffer ascii_value;
+            const auto ascii_length = int_to_str(counter(), ascii_value);
+            debug_assert(ascii_length <= max_counter_length);
+            m_value_length = static_cast<uint32>(ascii_length);
+            m_meta &= ~META_NATIVE_COUNTER;
+            std::memcpy(reinterpret_cast<uint8 *>(this) + ValueOffset(this), ascii_value, ascii_length);
+        }
+
+
+        inline void Item::assign_compressed(slice compressed, uint32 the_uncompressed_length) noexcept {
+            debug_assert(CalcCompressedValueLength(compressed.length()) <= m_value_length);
+            auto value_begin = reinterpret_cast<uint8 *>(this) + ValueOffset(this);
+            std::memcpy(value_begin, &the_uncompressed_length, sizeof(uint32));
+            std::memmove(value_begin + sizeof(uint32), compressed.begin(), compressed.length());
+            m_value_length = static_cast<uint32>(CalcCompressedValueLength(compressed.length()));
+            m_meta |= META_COMPRESSED;
+        }
+
+
+        inline uint32 Item::uncompressed_length() const noexcept {
+            debug_assert(is_compressed());
+            uint32 length;
+            std::memcpy(&length, reinterpret_cast<const uint8 *>(this) + ValueOffset(this), sizeof(uint32));
+            return length;
+        }
+
+
+        inline slice Item::compressed_data() const noexcept {
+            debug_assert(is_compressed());
+            const auto v = value();
+            return v.subslice(sizeof(uint32), v.length() - sizeof(uint32));
+        }
+
+
+        template <typename T>
+        inline T * Item::value_aligned_as() const noexcept {
+            auto value_begin = reinterpret_cast<uintptr_t>(this) + ValueOffset(this);
+            return reinterpret_cast<T *>(value_begin + unaligned_bytes(value_begin, alignof(T)));
+        }
+
+
+        inline void Item::make_shared_entry(slice data) noexcept {
+            debug_assert(CalcSharedEntryValueLength(data.length()) <= m_value_length);
+            auto header = new (value_aligned_as<SharedHeader>()) SharedHeader();
+            header->num_refs = 0;
+            header->data_length = static_cast<uint32>(data.length());
+            std::memcpy(header + 1, data.begin(), data.length());
+            m_value_length = static_cast<uint32>(CalcSharedEntryValueLength(data.length()));
+            m_meta |= META_SHARED_ENTRY;
+        }
+
+
+        inline Item::SharedHeader * Item::shared_header() const noexcept {
+            debug_assert(is_shared_entry());
+            return value_aligned_as<SharedHeader>();
+        }
+
+
+        inline void Item::refer_to(Item * entry) noexcept {
+            debug_assert(shared_ref_length <= m_value_length);
+            debug_assert(not is_shared() && not is_shared_entry());
+            auto ref = value_aligned_as<SharedRef>();
+            ref->owner = this;
+            ref->entry = entry;
+            auto header = entry->shared_header();
+            header->refs.push_back(ref);
+            header->num_refs += 1;
+            m_value_length = shared_ref_length;
+            m_meta = static_cast<uint8>((m_meta & ~(META_NATIVE_COUNTER | META_COMPRESSED)) | META_SHARED_VALUE);
+        }
+
+
+        inline Item::SharedRef * Item::shared_ref() const noexcept {
+            debug_assert(is_shared());
+            return value_aligned_as<SharedRef>();
+        }
+
+
+        inline Item * Item::unrefer() noexcept {
+            auto ref = shared_ref();
+            auto header = ref->entry->shared_header();
+            decltype(header->refs)::unlink(ref);
+            header->num_refs -= 1;
+            m_meta &= ~META_SHARED_VALUE;
+            return ref->entry;
+        }
+
+
+        inline void Item::make_chain(uint32 value_length) noexcept {
+            debug_assert(chain_ref_length <= m_value_length);
+            auto header = value_aligned_as<ChainHeader>();
+            header->first_chunk = header->last_chunk = nullptr;
+            header->value_length = value_length;
+            header->num_chunks = 0;
+            m_value_length = chain_ref_length;
+            m_meta |= META_CHAINED;
+        }
+
+
+        inline Item::ChainHeader * Item::chain_header() const noexcept {
+            debug_assert(is_chained());
+            return value_aligned_as<ChainHeader>();
+        }
+
+
+        inline void Item::make_chunk(Item * owner, uint32 data_length) noexcept {
+            debug_assert(CalcChunkValueLength(data_length) <= m_value_length);
+            auto header = value_aligned_as<ChunkHeader>();
+            header->owner = owner;
+            header->next = nullptr;
+            header->length = data_length;
+            m_meta |= META_CHUNK;
+        }
+
+
+        inline Item::ChunkHeader * Item::chunk_header() const noexcept {
+            debug_assert(is_chunk());
+            return value_aligned_as<ChunkHeader>();
+        }
+
+
+        inline void Item::add_chunk(Item * chunk) noexcept {
+            auto header = chain_header();
+            debug_assert(chunk->chunk_header()->owner == this);
+            if (header->last_chunk != nullptr) {
+                header->last_chunk->chunk_header()->next = chunk;
+            } else {
+                header->first_chunk = chunk;
+            }
+            header->last_chunk = chunk;
+            header->num_chunks += 1;
+        }
+
+
         inline seconds Item::ttl() const noexcept {
             if (m_expiration_time == expiration_time_point::max()) {
                 return infinite_TTL;
@@ -188,8 +663,8 @@ namespace cachelot {
         }
 
 
-        inline size_t Item::KeyOffset(const Item *) noexcept {
-            return sizeof(Item);
+        inline size_t Item::KeyOffset(const Item * i) noexcept {
+            return i->has_cas() ? sizeof(Item) + sizeof(timestamp_type) : sizeof(Item);
         }
 
 
@@ -199,11 +674,14 @@ namespace cachelot {
         }
 
 
-        inline size_t Item::CalcSizeRequired(const slice the_key, const size_t value_length) noexcept {
+        inline size_t Item::CalcSizeRequired(const slice the_key, const size_t value_length, const bool with_cas) noexcept {
             debug_assert(the_key.length() > 0);
             debug_assert(the_key.length() <= max_key_length);
             debug_assert(value_length <= std::numeric_limits<uint32>::max());
             size_t item_size = sizeof(Item);
+            if (with_cas) {
+                item_size += sizeof(timestamp_type);
+            }
             item_size += the_key.length();
             item_size += value_length;
             return item_size;
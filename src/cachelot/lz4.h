@@ -0,0 +1,195 @@
+#ifndef CACHELOT_LZ4_H_INCLUDED
+#define CACHELOT_LZ4_H_INCLUDED
+
+//
+//  (C) Copyright 2015 Iurii Krasnoshchok
+//
+//  Distributed under the terms of Simplified BSD License
+//  see LICENSE file
+
+
+#include <cachelot/slice.h>
+
+namespace cachelot {
+
+    /**
+     * Fast compression codec producing [LZ4 block format](https://github.com/lz4/lz4/blob/dev/doc/lz4_Block_format.md)
+     *
+     * Single pass greedy matcher with the small hash table on stack. It doesn't compete with
+     * the reference implementation in ratio, but it's fast and self-contained
+     * @ingroup common
+     */
+    namespace lz4 {
+
+        namespace internal {
+
+            constexpr unsigned hash_log = 12;
+            constexpr size_t min_match = 4;
+            constexpr size_t last_literals = 5;   // last bytes of input are always literals
+            constexpr size_t match_find_limit = 12; // last match must start this far from the end
+            constexpr size_t max_offset = 65535;
+
+            inline uint32 read32(const uint8 * p) noexcept { uint32 v; std::memcpy(&v, p, sizeof(v)); return v; }
+
+            inline uint32 hash4(uint32 sequence) noexcept {
+                return (sequence * 2654435761u) >> (32 - hash_log);
+            }
+
+            /// write length continuation bytes, return new output position or `nullptr` if there is no room
+            inline uint8 * put_length(uint8 * op, const uint8 * oend, size_t length) noexcept {
+                for (; length >= 255; length -= 255) {
+                    if (op >= oend) return nullptr;
+                    *op++ = 255;
+                }
+                if (op >= oend) return nullptr;
+                *op++ = static_cast<uint8>(length);
+                return op;
+            }
+
+            /// write sequence of literals followed by the match (if `match_length` is not zero)
+            inline uint8 * put_sequence(uint8 * op, const uint8 * oend, const uint8 * literals, size_t literal_length, size_t offset, size_t match_length) noexcept {
+                if (op >= oend) return nullptr;
+                uint8 * token = op++;
+                *token = static_cast<uint8>((literal_length < 15 ? literal_length : 15) << 4);
+                if (literal_length >= 15 && (op = put_length(op, oend, literal_length - 15)) == nullptr) {
+                    return nullptr;
+                }
+                if (static_cast<size_t>(oend - op) < literal_length) return nullptr;
+                std::memcpy(op, literals, literal_length);
+                op += literal_length;
+                if (match_length == 0) {
+                    return op;
+                }
+                if (oend - op < 2) return nullptr;
+                *op++ = static_cast<uint8>(offset);
+                *op++ = static_cast<uint8>(offset >> 8);
+                match_length -= min_match;
+                *token |= static_cast<uint8>(match_length < 15 ? match_length : 15);
+                if (match_length >= 15 && (op = put_length(op, oend, match_length - 15)) == nullptr) {
+                    return nullptr;
+                }
+                return op;
+            }
+        }
+
+        /**
+         * Compress `src` into the `dest` buffer of `dest_capacity` bytes
+         *
+         * @return compressed size or 0 if result doesn't fit in the `dest_capacity`
+         */
+        inline size_t compress(const slice src, char * dest, size_t dest_capacity) noexcept {
+            using namespace internal;
+            const uint8 * const base = reinterpret_cast<const uint8 *>(src.begin());
+            const uint8 * const iend = base + src.length();
+            uint8 * op = reinterpret_cast<uint8 *>(dest);
+            const uint8 * const oend = op + dest_capacity;
+            const uint8 * anchor = base;
+            if (src.length() > match_find_limit) {
+                uint32 table[1 << hash_log] = { 0 };
+                const uint8 * const mflimit = iend - match_find_limit;
+                const uint8 * const matchlimit = iend - last_literals;
+                const uint8 * ip = base;
+                while (ip < mflimit) {
+                    const uint32 sequence = read32(ip);
+                    const uint32 h = hash4(sequence);
+                    const uint8 * ref = base + table[h];
+                    table[h] = static_cast<uint32>(ip - base);
+                    if (ref >= ip || static_cast<size_t>(ip - ref) > max_offset || read32(ref) != sequence) {
+                        // skip faster through the incompressible data
+                        ip += 1 + ((ip - anchor) >> 6);
+                        continue;
+                    }
+                    // extend match backward, then forward
+                    while (ip > anchor && ref > base && ip[-1] == ref[-1]) {
+                        --ip; --ref;
+                    }
+                    const uint8 * match_end = ip + min_match;
+                    const uint8 * ref_end = ref + min_match;
+                    while (match_end < matchlimit && *match_end == *ref_end) {
+                        ++match_end; ++ref_end;
+                    }
+                    op = put_sequence(op, oend, anchor, ip - anchor, ip - ref, match_end - ip);
+                    if (op == nullptr) {
+                        return 0;
+                    }
+                    ip = anchor = match_end;
+                    if (ip < mflimit) {
+                        table[hash4(read32(ip - 2))] = static_cast<uint32>(ip - 2 - base);
+                    }
+                }
+            }
+            op = put_sequence(op, oend, anchor, iend - anchor, 0, 0);
+            return op != nullptr ? op - reinterpret_cast<uint8 *>(dest) : 0;
+        }
+
+
+        /**
+         * Decompress `src` into the `dest` buffer of `dest_capacity` bytes
+         *
+         * @return decompressed size or 0 if `src` is malformed or result doesn't fit in the `dest_capacity`
+         */
+        inline size_t decompress(const slice src, char * dest, size_t dest_capacity) noexcept {
+            using namespace internal;
+            const uint8 * ip = reinterpret_cast<const uint8 *>(src.begin());
+            const uint8 * const iend = ip + src.length();
+            uint8 * op = reinterpret_cast<uint8 *>(dest);
+            uint8 * const ostart = op;
+            const uint8 * const oend = op + dest_capacity;
+            auto get_length = [&](size_t & length) -> bool {
+                uint8 b;
+                do {
+                    if (ip >= iend) return false;
+                    b = *ip++;
+                    length += b;
+                } while (b == 255);
+                return true;
+            };
+            while (ip < iend) {
+                const uint8 token = *ip++;
+                size_t literal_length = token >> 4;
+                if (literal_length == 15 && not get_length(literal_length)) {
+                    return 0;
+                }
+                if (literal_length > static_cast<size_t>(iend - ip) || literal_length > static_cast<size_t>(oend - op)) {
+                    return 0;
+                }
+                std::memcpy(op, ip, literal_length);
+                op += literal_length; ip += literal_length;
+                if (ip == iend) {
+                    break; // last sequence has no match
+                }
+                if (iend - ip < 2) {
+                    return 0;
+                }
+                const size_t offset = ip[0] | (static_cast<size_t>(ip[1]) << 8);
+                ip += 2;
+                if (offset == 0 || offset > static_cast<size_t>(op - ostart)) {
+                    return 0;
+                }
+                size_t match_length = token & 15;
+                if (match_length == 15 && not get_length(match_length)) {
+                    return 0;
+                }
+                match_length += min_match;
+                if (match_length > static_cast<size_t>(oend - op)) {
+                    return 0;
+                }
+                const uint8 * match = op - offset;
+                if (offset >= match_length) {
+                    std::memcpy(op, match, match_length);
+                    op += match_length;
+                } else {
+                    // overlapped match repeats the pattern
+                    for (size_t n = 0; n < match_length; ++n) {
+                        *op++ = *match++;
+                    }
+                }
+            }
+            return op - ostart;
+        }
+
+    } // namespace lz4
+
+} // namespace cachelot
+
+#endif // CACHELOT_LZ4_H_INCLUDED
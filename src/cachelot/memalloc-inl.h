@@ -37,6 +37,16 @@
  *  ### Block split / merge and border blocks
  *
  *<br/>
+ *
+ *  ### Tiny slots
+ *  Allocations up to `tiny_allocation_limit` bytes (if enabled) don't get their own block, as the block header
+ *  and the minimal block size would take more memory than the allocation itself.
+ *  Instead, the whole page is checked out as a single block and split on equal slots of one of the `num_tiny_classes` sizes.
+ *  Block memory starts with the bitmap of the used slots followed by the slots themselves:<br/>
+ *  `[block header][used slots bitmap][slot][slot] ... [slot]`<br/>
+ *  Slot size and counters are kept in the `page_info`, pages with free slots are linked in the per-size list.
+ *  Page is evicted as a whole (every used slot is reported) and returned to the free blocks once its last slot is freed.
+ *  If there are no free slots and no whole free page, tiny allocation falls back to the regular block.
  */
 
 
@@ -64,7 +74,20 @@ namespace cachelot {
             intrusive_list_node lru_link;
             uint64 num_hits = 0;
             uint64 num_evictions = 0;
+            // pages split on tiny slots are linked by the slot size if they have free slots
+            intrusive_list_node slots_link;
+            uint32 slot_size = 0; // zero for the regular pages
+            uint32 num_slots = 0;
+            uint32 num_used_slots = 0;
+            uint32 free_slot_hint = 0; // bitmap word to start free slot lookup from
+            // offline pages don't belong to the allocator (see `memalloc::release_pages()`)
+            bool online = true;
+            // memory taken by the used blocks (the whole page if it's split on tiny slots)
+            uint32 used_bytes = 0;
         };
+
+        /// list of the pages with the free slots of the same size
+        typedef intrusive_list<page_info, &page_info::slots_link> slots_page_list;
     public:
         /// Size of the page
         const size_t page_size;
@@ -82,7 +105,11 @@ namespace cachelot {
             , arena_begin(the_arena_begin)
             , arena_end(the_arena_end)
             , log2_page_size(log2u(the_page_size))
-            , all_pages(num_pages) {
+            , all_pages(num_pages)
+            , num_online_pages(num_pages)
+            , num_empty_pages(num_pages)
+            , used_memory(0)
+            , compaction_cursor(0) {
             debug_assert(page_size > 0); debug_assert(ispow2(page_size));
             debug_assert(num_pages >= 4); debug_assert(ispow2(num_pages));
             // base_addr must be properly aligned
@@ -101,6 +128,13 @@ namespace cachelot {
             return &all_pages[page_no];
         }
 
+        /// retrieve pointer to the first byte of the page
+        uint8 * page_begin(const page_info * page) const noexcept {
+            const auto page_no = static_cast<size_t>(page - all_pages.data());
+            debug_assert(page_no < num_pages);
+            return arena_begin + (page_no * page_size);
+        }
+
         /// retrieve boundaries of the page containing address specified
         tuple<const uint8 * const, const uint8 * const> page_boundaries_from_addr(const void * const ptr) const noexcept {
             const auto page_no = page_no_from_addr(ptr);
@@ -117,6 +151,69 @@ namespace cachelot {
             lru_pages.move_front(page);
         }
 
+        /// exclude page from the LRU list, it's not used by the allocator anymore
+        void take_offline(page_info * page) noexcept {
+            debug_assert(page->online);
+            debug_assert(page->used_bytes == 0);
+            lru_pages.remove(page);
+            page->online = false;
+            page->num_hits = 0;
+            num_online_pages -= 1;
+            num_empty_pages -= 1;
+        }
+
+        /// return page back to the allocator as the least recently used one
+        void bring_online(page_info * page) noexcept {
+            debug_assert(not page->online);
+            lru_pages.push_back(page);
+            page->online = true;
+            num_online_pages += 1;
+            num_empty_pages += 1;
+        }
+
+        /// account `bytes` of the page containing `ptr` as used
+        void use(const void * const ptr, const uint32 bytes) noexcept {
+            const auto page = page_info_from_addr(ptr);
+            if (page->used_bytes == 0) {
+                num_empty_pages -= 1;
+            }
+            page->used_bytes += bytes;
+            used_memory += bytes;
+            debug_assert(page->used_bytes <= page_size);
+        }
+
+        /// account `bytes` of the page containing `ptr` as free
+        void unuse(const void * const ptr, const uint32 bytes) noexcept {
+            const auto page = page_info_from_addr(ptr);
+            debug_assert(page->used_bytes >= bytes);
+            if (bytes == 0) {
+                return;
+            }
+            page->used_bytes -= bytes;
+            used_memory -= bytes;
+            if (page->used_bytes == 0) {
+                num_empty_pages += 1;
+            }
+        }
+
+        /// number of pages in use by the allocator
+        size_t num_online() const noexcept { return num_online_pages; }
+
+        /// number of online pages without a single used block
+        size_t num_empty() const noexcept { return num_empty_pages; }
+
+        /// amount of memory taken by the used blocks of all pages
+        size_t used() const noexcept { return used_memory; }
+
+        /// next page to consider for the compaction, pages are visited round-robin
+        page_info * next_to_compact() noexcept {
+            compaction_cursor = (compaction_cursor + 1) & (num_pages - 1);
+            return &all_pages[compaction_cursor];
+        }
+
+        /// least recently used online page or `nullptr`
+        page_info * least_recently_used() noexcept { return lru_pages.empty() ? nullptr : lru_pages.back(); }
+
         /// retrieve the best candidate for eviction and reuse
         tuple<uint8 *, uint8 *> page_to_reuse() noexcept {
             page_info * least_used = lru_pages.back();
@@ -124,16 +221,14 @@ namespace cachelot {
             // make it first to prolong its life
             lru_pages.remove(least_used);
             lru_pages.push_front(least_used);
-            // get
-            for (size_t page_no = 0; page_no < num_pages; ++page_no) {
-                if (least_used == &all_pages[page_no]) {
-                    uint8 * page_begin = arena_begin + (page_no * page_size);
-                    uint8 * page_end = page_begin + page_size;
-                    return make_tuple(page_begin, page_end);
-                }
-            }
-            debug_assert(false);
-            return tuple<uint8 *, uint8 *>(nullptr, nullptr);
+            uint8 * begin = page_begin(least_used);
+            return make_tuple(begin, begin + page_size);
+        }
+
+        /// check whether `ptr` is the first byte of a page (or the arena end),
+        /// blocks never cross page boundaries, so the first block of the page is never linked with the previous page
+        bool is_page_begin(const void * const ptr) const noexcept {
+            return unaligned_bytes(static_cast<size_t>(reinterpret_cast<const uint8 *>(ptr) - arena_begin), page_size) == 0;
         }
 
         /// check that address is within arena range
@@ -150,10 +245,17 @@ namespace cachelot {
             return page_no;
         }
 
+    public:
+        /// pages of every tiny slot size having at least one free slot
+        std::array<slots_page_list, num_tiny_classes> pages_with_free_slots;
     private:
         const size_t log2_page_size;
         std::vector<page_info> all_pages;
         intrusive_list<page_info, &page_info::lru_link> lru_pages;
+        size_t num_online_pages;
+        size_t num_empty_pages;
+        size_t used_memory;
+        size_t compaction_cursor;
     private:
         friend struct test_memalloc::test_pages;
     };
@@ -281,7 +383,7 @@ namespace cachelot {
                 blk->set_size(new_size);
                 debug_assert(old_size - new_size > block::header_size + block::alignment);
                 leftover = new (blk->right_adjacent()) memalloc::block(old_size - new_size - header_size, new_size + header_size);
-                if (reinterpret_cast<uint8 *>(block_after_next) < pgs->arena_end) {
+                if (not pgs->is_page_begin(block_after_next)) {
                     block_after_next->meta.left_adjacent_offset = leftover->size_with_header();
                 }
             }
@@ -301,7 +403,7 @@ namespace cachelot {
             debug_assert(left_block->is_free()); debug_assert(right_block->is_free());
             memalloc::block * block_after_right = right_block->right_adjacent();
             left_block->set_size(left_block->size() + right_block->size_with_header());
-            if (reinterpret_cast<uint8 *>(block_after_right) < pgs->arena_end) {
+            if (not pgs->is_page_begin(block_after_right)) {
                 block_after_right->meta.left_adjacent_offset = left_block->size_with_header();
             }
             debug_only(left_block->__debug_sanity_check(pgs));
@@ -604,9 +706,10 @@ namespace cachelot {
 
 ////////////////////////////////// memalloc //////////////////////////////////////
 
-    inline memalloc::memalloc(const size_t memory_limit, const uint32 the_page_size)
+    inline memalloc::memalloc(const size_t memory_limit, const uint32 the_page_size, const bool pack_tiny_allocations)
         : arena_size(memory_limit)
         , page_size(the_page_size)
+        , pack_tiny(pack_tiny_allocations)
         , m_arena(nullptr, &aligned_free) {
         debug_assert(ispow2(memory_limit));
         debug_assert(page_size > 0);
@@ -645,6 +748,26 @@ namespace cachelot {
         #endif
     }
 
+    inline memalloc::memalloc(void * arena, const size_t arena_size_, const uint32 the_page_size, const bool pack_tiny_allocations)
+        : arena_size(arena_size_)
+        , page_size(the_page_size)
+        , pack_tiny(pack_tiny_allocations)
+        , m_arena(arena, [](void *) noexcept -> void {}) { // arena is owned by the caller
+        debug_assert(page_size > 0);
+        debug_assert(ispow2(page_size));
+        debug_assert(log2u(page_size) >= free_blocks_by_size::first_power_of_2);
+        debug_assert(arena_size >= (page_size * 4));
+        debug_assert(arena_size % page_size == 0);
+        debug_assert(unaligned_bytes(arena, page_size) == 0);
+        auto arena_begin = reinterpret_cast<uint8 *>(arena);
+        m_pages.reset(new pages(page_size, arena_begin, arena_begin + arena_size));
+        m_free_blocks.reset(new free_blocks_by_size(page_size));
+        for (auto page_begin = arena_begin; page_begin < arena_begin + arena_size; page_begin += page_size) {
+            m_pages->take_offline(m_pages->page_info_from_addr(page_begin));
+        }
+    }
+
+
     inline memalloc::block * memalloc::merge_free_left(memalloc::block * blk) noexcept {
         // Note: we may not have 'left_adjacent' here.
         // We have to check that offset is within the page boundaries first.
@@ -702,28 +825,202 @@ namespace cachelot {
             m_free_blocks->put_block(leftover);
         }
         blk->set_used();
+        m_pages->use(blk, blk->size_with_header());
         STAT_INCR(mem.used_memory, blk->size_with_header());
         return blk->memory();
     }
 
 
     inline bool memalloc::valid_addr(void * ptr) const noexcept {
-        if (m_pages->valid_addr(ptr)) {
-            block::from_user_ptr(ptr);
+        if (m_pages->valid_addr(ptr) && m_pages->page_info_from_addr(ptr)->online) {
+            if (not is_tiny(ptr)) {
+                block::from_user_ptr(ptr);
+            }
             return true;
         }
         return false;
     }
 
+
+    namespace internal {
+        // number of 64-bit words in the bitmap of the tiny slots
+        constexpr uint32 tiny_bitmap_words(const uint32 num_slots) noexcept {
+            return (num_slots + 63) / 64;
+        }
+
+        // class of the tiny slot suitable for allocation of the `size` bytes
+        constexpr uint32 tiny_slot_class(const uint32 size) noexcept {
+            return size <= memalloc::tiny_slot_min ? 0 : (size - memalloc::tiny_slot_min + memalloc::tiny_slot_step - 1) / memalloc::tiny_slot_step;
+        }
+    }
+
+
+    inline bool memalloc::is_tiny(const void * ptr) const noexcept {
+        return pack_tiny && m_pages->page_info_from_addr(ptr)->slot_size != 0;
+    }
+
+
+    inline void * memalloc::make_slots_page(uint8 * page_begin, const uint32 slot_class) noexcept {
+        debug_assert(slot_class < num_tiny_classes);
+        auto page = m_pages->page_info_from_addr(page_begin);
+        debug_assert(page->slot_size == 0);
+        auto blk = reinterpret_cast<block *>(page_begin);
+        debug_assert(blk->is_used()); debug_assert(blk->size_with_header() == page_size);
+        const uint32 slot_size = tiny_slot_min + slot_class * tiny_slot_step;
+        // each slot takes `slot_size` bytes plus one bit of bitmap
+        uint32 num_slots = static_cast<uint32>((static_cast<uint64>(blk->size()) * 8) / (slot_size * 8 + 1));
+        while (internal::tiny_bitmap_words(num_slots) * sizeof(uint64) + num_slots * slot_size > blk->size()) {
+            num_slots -= 1;
+        }
+        debug_assert(num_slots > 1);
+        const uint32 num_words = internal::tiny_bitmap_words(num_slots);
+        auto bitmap = reinterpret_cast<uint64 *>(blk->memory());
+        std::fill(bitmap, bitmap + num_words, 0ull);
+        // bits beyond the last slot are marked as used forever
+        if (num_slots % 64 != 0) {
+            bitmap[num_words - 1] = ~((uint64(1) << (num_slots % 64)) - 1);
+        }
+        // the first slot goes to the caller
+        bitmap[0] = bit::set(bitmap[0], 0);
+        page->slot_size = slot_size;
+        page->num_slots = num_slots;
+        page->num_used_slots = 1;
+        page->free_slot_hint = 0;
+        m_pages->pages_with_free_slots[slot_class].push_front(page);
+        m_pages->use(page_begin, page_size);
+        STAT_INCR(mem.num_tiny_pages, 1);
+        STAT_INCR(mem.used_memory, slot_size);
+        return bitmap + num_words;
+    }
+
+
+    inline void * memalloc::alloc_tiny(const uint32 size) noexcept {
+        debug_assert(size <= tiny_allocation_limit);
+        const uint32 slot_class = internal::tiny_slot_class(size);
+        auto & pages_with_free_slots = m_pages->pages_with_free_slots[slot_class];
+        if (not pages_with_free_slots.empty()) {
+            auto page = pages_with_free_slots.front();
+            debug_assert(page->num_used_slots < page->num_slots);
+            auto blk = reinterpret_cast<block *>(m_pages->page_begin(page));
+            auto bitmap = reinterpret_cast<uint64 *>(blk->memory());
+            uint32 word_no = page->free_slot_hint;
+            while (bitmap[word_no] == ~0ull) {
+                word_no += 1;
+                debug_assert(word_no < internal::tiny_bitmap_words(page->num_slots));
+            }
+            const uint32 bit_no = bit::least_significant(~bitmap[word_no]);
+            bitmap[word_no] = bit::set(bitmap[word_no], bit_no);
+            page->free_slot_hint = word_no;
+            page->num_used_slots += 1;
+            if (page->num_used_slots == page->num_slots) {
+                pages_with_free_slots.pop_front();
+            }
+            m_pages->touch(blk);
+            STAT_INCR(mem.used_memory, page->slot_size);
+            auto slots = reinterpret_cast<uint8 *>(bitmap + internal::tiny_bitmap_words(page->num_slots));
+            return slots + (word_no * 64 + bit_no) * page->slot_size;
+        }
+        // split the whole free page on slots
+        block * blk = m_free_blocks->try_get_block(page_size - block::header_size);
+        if (blk != nullptr) {
+            debug_assert(blk->size_with_header() == page_size);
+            blk->set_used();
+            m_pages->touch(blk);
+            return make_slots_page(reinterpret_cast<uint8 *>(blk), slot_class);
+        }
+        return nullptr;
+    }
+
+
+    inline void memalloc::free_tiny(void * ptr) noexcept {
+        auto page = m_pages->page_info_from_addr(ptr);
+        debug_assert(page->slot_size != 0);
+        auto blk = reinterpret_cast<block *>(m_pages->page_begin(page));
+        auto bitmap = reinterpret_cast<uint64 *>(blk->memory());
+        auto slots = reinterpret_cast<uint8 *>(bitmap + internal::tiny_bitmap_words(page->num_slots));
+        const auto offset = static_cast<uint32>(reinterpret_cast<uint8 *>(ptr) - slots);
+        debug_assert(offset % page->slot_size == 0);
+        const uint32 slot_no = offset / page->slot_size;
+        debug_assert(slot_no < page->num_slots);
+        const uint32 word_no = slot_no / 64, bit_no = slot_no % 64;
+        debug_assert(bit::is_set(bitmap[word_no], bit_no));
+        bitmap[word_no] = bit::unset(bitmap[word_no], bit_no);
+        debug_only(std::memset(ptr, 0xC, page->slot_size));
+        STAT_DECR(mem.used_memory, page->slot_size);
+        auto & pages_with_free_slots = m_pages->pages_with_free_slots[internal::tiny_slot_class(page->slot_size)];
+        if (page->num_used_slots == page->num_slots) {
+            // keep filling pages that already have free slots first
+            pages_with_free_slots.push_back(page);
+        }
+        page->num_used_slots -= 1;
+        page->free_slot_hint = std::min(page->free_slot_hint, word_no);
+        if (page->num_used_slots == 0) {
+            // the whole page is free again
+            pages::slots_page_list::unlink(page);
+            page->slot_size = 0;
+            STAT_DECR(mem.num_tiny_pages, 1);
+            blk->set_free();
+            m_pages->unuse(blk, page_size);
+            m_free_blocks->put_block(blk);
+        }
+    }
+
+
+    template <typename ForeachFreed>
+    inline void memalloc::evict_page(uint8 * page_begin, uint8 * page_end, ForeachFreed on_free_block) noexcept {
+        auto page = m_pages->page_info_from_addr(page_begin);
+        auto blk = reinterpret_cast<block *>(page_begin); // every page starts with the block
+        debug_only(blk->assert_dbg_marker());
+        m_pages->unuse(page_begin, page->used_bytes);
+        if (page->slot_size != 0) {
+            // page is split on tiny slots, evict every used slot
+            auto bitmap = reinterpret_cast<uint64 *>(blk->memory());
+            const uint32 num_words = internal::tiny_bitmap_words(page->num_slots);
+            auto slots = reinterpret_cast<uint8 *>(bitmap + num_words);
+            for (uint32 word_no = 0; word_no < num_words; ++word_no) {
+                uint64 used = bitmap[word_no];
+                if (word_no == num_words - 1 && page->num_slots % 64 != 0) {
+                    used &= (uint64(1) << (page->num_slots % 64)) - 1;
+                }
+                while (used != 0) {
+                    const uint32 bit_no = bit::least_significant(used);
+                    on_free_block(slots + (word_no * 64 + bit_no) * page->slot_size);
+                    STAT_INCR(mem.evictions, 1);
+                    STAT_DECR(mem.used_memory, page->slot_size);
+                    used = bit::unset(used, bit_no);
+                }
+            }
+            if (page->num_used_slots < page->num_slots) {
+                pages::slots_page_list::unlink(page);
+            }
+            page->slot_size = 0;
+            STAT_DECR(mem.num_tiny_pages, 1);
+            return;
+        }
+        do {
+            if (blk->is_used()) {
+                // notify user that memory is evicted
+                on_free_block(blk->memory());
+                STAT_INCR(mem.evictions, 1);
+                STAT_DECR(mem.used_memory, blk->size_with_header());
+            } else {
+                // remove block from the free blocks list
+                m_free_blocks->remove_block(blk);
+            }
+            blk = blk->right_adjacent();
+        } while (reinterpret_cast<uint8 *>(blk) < page_end);
+        debug_assert(reinterpret_cast<uint8 *>(blk) == page_end);
+    }
+
     inline void memalloc::touch(void * ptr) noexcept {
         #if defined(ADDRESS_SANITIZER)
         return;
         #endif
         debug_assert(valid_addr(ptr));
         // ensure we're touching the used block
-        debug_assert(block::from_user_ptr(ptr)->is_used());
+        debug_assert(is_tiny(ptr) || block::from_user_ptr(ptr)->is_used());
         // additional sanity check
-        debug_only(block::from_user_ptr(ptr)->__debug_sanity_check(m_pages));
+        debug_only(if (not is_tiny(ptr)) { block::from_user_ptr(ptr)->__debug_sanity_check(m_pages); });
         // touch corresponding page
         m_pages->touch(ptr);
     }
@@ -740,6 +1037,15 @@ namespace cachelot {
 
         STAT_INCR(mem.num_malloc, 1);
         STAT_INCR(mem.total_requested, size);
+        const bool tiny = pack_tiny && size <= tiny_allocation_limit;
+        // 0. Pack tiny allocation into the slot
+        if (tiny) {
+            auto mem = alloc_tiny(size);
+            if (mem != nullptr) {
+                STAT_INCR(mem.total_served, reveal_actual_size(mem));
+                return mem;
+            }
+        }
         // 1. Search among the free blocks
         {
             block * found_blk = m_free_blocks->try_get_block(size);
@@ -751,33 +1057,21 @@ namespace cachelot {
             }
         }
         // 2. Try to evict existing block to free some space
-        if (evict_if_necessary) {
+        if (evict_if_necessary && m_pages->num_online() > 0) {
             uint8 * page_begin, * page_end;
             tie(page_begin, page_end) = m_pages->page_to_reuse();
             // clean the page, evict used blocks, remove free blocks from the free_blocks list
-            auto blk = reinterpret_cast<block *>(page_begin); // every page starts with the block
-            debug_only(blk->assert_dbg_marker());
-            const uint32 left_adjacent_block_offset = blk->meta.left_adjacent_offset;
-            do {
-                if (blk->is_used()) {
-                    // notify user that memory is evicted
-                    on_free_block(blk->memory());
-                    STAT_INCR(mem.evictions, 1);
-                    STAT_DECR(mem.used_memory, blk->size_with_header());
-                } else {
-                    // remove block from the free blocks list
-                    m_free_blocks->remove_block(blk);
-                }
-                blk = blk->right_adjacent();
-            } while (reinterpret_cast<uint8 *>(blk) < page_end);
-            debug_assert(reinterpret_cast<uint8 *>(blk) == page_end);
-
-            // adjust the fist block in the next page
-            if (page_end < reinterpret_cast<uint8 *>(m_arena.get()) + arena_size) {
-                reinterpret_cast<block *>(page_end)->meta.left_adjacent_offset = page_size;
-            }
+            const uint32 left_adjacent_block_offset = reinterpret_cast<block *>(page_begin)->meta.left_adjacent_offset;
+            evict_page(page_begin, page_end, on_free_block);
+            m_num_evicted_pages += 1;
             auto whole_page_block = new (page_begin) block(page_size - block::header_size, left_adjacent_block_offset);
-            auto mem = checkout(whole_page_block, size);
+            void * mem;
+            if (tiny) {
+                whole_page_block->set_used();
+                mem = make_slots_page(page_begin, internal::tiny_slot_class(size));
+            } else {
+                mem = checkout(whole_page_block, size);
+            }
             STAT_INCR(mem.total_served, reveal_actual_size(mem));
             return mem;
         }
@@ -796,10 +1090,22 @@ namespace cachelot {
         debug_assert(valid_addr(ptr));
 
         STAT_INCR(mem.num_realloc, 1);
+        if (is_tiny(ptr)) {
+            // tiny slot can't grow
+            const uint32 slot_size = m_pages->page_info_from_addr(ptr)->slot_size;
+            if (new_size <= slot_size) {
+                return ptr;
+            }
+            STAT_INCR(mem.total_realloc_requested, new_size - slot_size);
+            STAT_INCR(mem.total_realloc_unserved, new_size - slot_size);
+            STAT_INCR(mem.num_realloc_errors, 1);
+            return nullptr;
+        }
         block * blk = block::from_user_ptr(ptr);
         debug_only(blk->__debug_sanity_check(m_pages));
 
         blk->set_free();
+        m_pages->unuse(blk, blk->size_with_header());
         STAT_DECR(mem.used_memory, blk->size_with_header());
 
         const auto size = static_cast<uint32>(new_size);
@@ -836,9 +1142,14 @@ namespace cachelot {
 
         debug_assert(valid_addr(ptr));
         STAT_INCR(mem.num_free, 1);
+        if (is_tiny(ptr)) {
+            free_tiny(ptr);
+            return;
+        }
         block * blk = block::from_user_ptr(ptr);
         debug_only(blk->__debug_sanity_check(m_pages));
         blk->set_free();
+        m_pages->unuse(blk, blk->size_with_header());
         STAT_DECR(mem.used_memory, blk->size_with_header());
         // merge with neighbours
         blk = merge_free(blk);
@@ -853,15 +1164,219 @@ namespace cachelot {
         return 0;
         #endif
         debug_assert(valid_addr(ptr));
+        if (is_tiny(ptr)) {
+            return m_pages->page_info_from_addr(ptr)->slot_size;
+        }
         block * blk = block::from_user_ptr(ptr);
         debug_assert(blk->is_used());
         debug_only(block::from_user_ptr(ptr)->__debug_sanity_check(m_pages));
         return blk->size_with_header();
     }
 
+    inline size_t memalloc::usable_size(void * ptr) const noexcept {
+        #if defined(ADDRESS_SANITIZER)
+        return 0;
+        #endif
+        debug_assert(valid_addr(ptr));
+        if (is_tiny(ptr)) {
+            return m_pages->page_info_from_addr(ptr)->slot_size;
+        }
+        block * blk = block::from_user_ptr(ptr);
+        debug_assert(blk->is_used());
+        return blk->size();
+    }
+
     inline size_t memalloc::header_size() noexcept {
         return block::header_size;
     }
 
+
+    template <typename ForeachFreed>
+    inline void memalloc::release_pages(void * begin, void * end, ForeachFreed on_free_block) noexcept {
+        debug_assert(m_pages->is_page_begin(begin)); debug_assert(m_pages->is_page_begin(end));
+        for (auto page_begin = reinterpret_cast<uint8 *>(begin); page_begin < end; page_begin += page_size) {
+            auto page = m_pages->page_info_from_addr(page_begin);
+            if (not page->online) {
+                continue;
+            }
+            #if !defined(ADDRESS_SANITIZER)
+            evict_page(page_begin, page_begin + page_size, on_free_block);
+            #endif
+            m_pages->take_offline(page);
+        }
+    }
+
+
+    template <typename ForeachFreed, typename CanMove, typename OnMoved>
+    inline void memalloc::release_pages(void * begin, void * end, ForeachFreed on_free_block, CanMove can_move, OnMoved on_moved) noexcept {
+        debug_assert(m_pages->is_page_begin(begin)); debug_assert(m_pages->is_page_begin(end));
+        #if !defined(ADDRESS_SANITIZER)
+        uint8 * const range_begin = reinterpret_cast<uint8 *>(begin);
+        uint8 * const range_end = reinterpret_cast<uint8 *>(end);
+        auto is_regular_page = [=](uint8 * page_begin) -> bool {
+            auto page = m_pages->page_info_from_addr(page_begin);
+            return page->online && page->slot_size == 0;
+        };
+        // take free blocks of the whole range out of the table first, so blocks never move within the range
+        for (auto page_begin = range_begin; page_begin < range_end; page_begin += page_size) {
+            if (not is_regular_page(page_begin)) {
+                continue;
+            }
+            for (auto blk = reinterpret_cast<block *>(page_begin); reinterpret_cast<uint8 *>(blk) < page_begin + page_size; blk = blk->right_adjacent()) {
+                if (blk->is_free()) {
+                    m_free_blocks->remove_block(blk);
+                }
+            }
+        }
+        for (auto page_begin = range_begin; page_begin < range_end; page_begin += page_size) {
+            if (not is_regular_page(page_begin)) {
+                continue;
+            }
+            uint8 * const page_end = page_begin + page_size;
+            size_t moved = 0;
+            for (auto blk = reinterpret_cast<block *>(page_begin); reinterpret_cast<uint8 *>(blk) < page_end; blk = blk->right_adjacent()) {
+                if (blk->is_free() || not can_move(blk->memory())) {
+                    continue;
+                }
+                block * new_blk = m_free_blocks->try_get_block(blk->size());
+                if (new_blk == nullptr) {
+                    continue;
+                }
+                void * new_memory = checkout(new_blk, blk->size());
+                std::memcpy(new_memory, blk->memory(), blk->size());
+                on_moved(blk->memory(), new_memory);
+                blk->set_free();
+                m_pages->unuse(blk, blk->size_with_header());
+                STAT_DECR(mem.used_memory, blk->size_with_header());
+                moved += blk->size_with_header();
+            }
+            STAT_INCR(mem.total_compacted, moved);
+            // whatever remains is evicted, free blocks are already out of the table
+            for (auto blk = reinterpret_cast<block *>(page_begin); reinterpret_cast<uint8 *>(blk) < page_end; blk = blk->right_adjacent()) {
+                if (blk->is_used()) {
+                    on_free_block(blk->memory());
+                    STAT_INCR(mem.evictions, 1);
+                    STAT_DECR(mem.used_memory, blk->size_with_header());
+                    m_pages->unuse(blk, blk->size_with_header());
+                    blk->set_free();
+                }
+            }
+            m_pages->take_offline(m_pages->page_info_from_addr(page_begin));
+        }
+        #endif
+        // pages of tiny slots are evicted as a whole
+        release_pages(begin, end, on_free_block);
+    }
+
+
+    inline void memalloc::acquire_pages(void * begin, void * end) noexcept {
+        debug_assert(m_pages->is_page_begin(begin)); debug_assert(m_pages->is_page_begin(end));
+        for (auto page_begin = reinterpret_cast<uint8 *>(begin); page_begin < end; page_begin += page_size) {
+            auto page = m_pages->page_info_from_addr(page_begin);
+            if (page->online) {
+                continue;
+            }
+            #if !defined(ADDRESS_SANITIZER)
+            // first block of the page is never linked with the previous page
+            auto whole_page_block = new (page_begin) block(page_size - block::header_size, page_size);
+            m_free_blocks->put_block(whole_page_block);
+            #endif
+            m_pages->bring_online(page);
+        }
+    }
+
+
+    inline void * memalloc::least_recently_used_page() const noexcept {
+        auto page = m_pages->least_recently_used();
+        return page != nullptr ? m_pages->page_begin(page) : nullptr;
+    }
+
+
+    inline size_t memalloc::online_size() const noexcept {
+        return m_pages->num_online() * page_size;
+    }
+
+
+    template <typename CanMove, typename OnMoved>
+    inline size_t memalloc::compact(size_t max_bytes, CanMove can_move, OnMoved on_moved) noexcept {
+        #if defined(ADDRESS_SANITIZER)
+        return 0;
+        #endif
+        size_t moved = 0;
+        for (uint32 attempt = 0; attempt < compaction_scan_limit && moved < max_bytes; ++attempt) {
+            auto page = m_pages->next_to_compact();
+            if (not page->online || page->slot_size != 0 || page->used_bytes == 0 || page->used_bytes > page_size / compaction_threshold) {
+                continue;
+            }
+            // the other partially used pages must have enough free memory (page itself has `page_size - used_bytes` free)
+            size_t free_total, free_fragmented;
+            tie(free_total, free_fragmented) = free_memory();
+            if (free_fragmented < page_size) {
+                break;
+            }
+            uint8 * page_begin = m_pages->page_begin(page);
+            moved += compact_page(page_begin, page_begin + page_size, can_move, on_moved);
+        }
+        return moved;
+    }
+
+
+    template <typename CanMove, typename OnMoved>
+    inline size_t memalloc::compact_page(uint8 * page_begin, uint8 * page_end, CanMove can_move, OnMoved on_moved) noexcept {
+        // page can't become free if any of its blocks must stay
+        for (auto blk = reinterpret_cast<block *>(page_begin); reinterpret_cast<uint8 *>(blk) < page_end; blk = blk->right_adjacent()) {
+            if (blk->is_used() && not can_move(blk->memory())) {
+                return 0;
+            }
+        }
+        // take free blocks of the page out of the table, so the blocks never move within the same page
+        for (auto blk = reinterpret_cast<block *>(page_begin); reinterpret_cast<uint8 *>(blk) < page_end; blk = blk->right_adjacent()) {
+            if (blk->is_free()) {
+                m_free_blocks->remove_block(blk);
+            }
+        }
+        size_t moved = 0;
+        for (auto blk = reinterpret_cast<block *>(page_begin); reinterpret_cast<uint8 *>(blk) < page_end; blk = blk->right_adjacent()) {
+            if (blk->is_free()) {
+                continue;
+            }
+            block * new_blk = m_free_blocks->try_get_block(blk->size());
+            if (new_blk == nullptr) {
+                break; // the rest of blocks stay in place
+            }
+            void * new_memory = checkout(new_blk, blk->size());
+            std::memcpy(new_memory, blk->memory(), blk->size());
+            on_moved(blk->memory(), new_memory);
+            blk->set_free();
+            m_pages->unuse(blk, blk->size_with_header());
+            STAT_DECR(mem.used_memory, blk->size_with_header());
+            moved += blk->size_with_header();
+        }
+        // coalesce free blocks of the page and give them back to the table
+        for (auto blk = reinterpret_cast<block *>(page_begin); reinterpret_cast<uint8 *>(blk) < page_end; blk = blk->right_adjacent()) {
+            if (blk->is_used()) {
+                continue;
+            }
+            while (reinterpret_cast<uint8 *>(blk->right_adjacent()) < page_end && blk->right_adjacent()->is_free()) {
+                blk = block::merge(m_pages, blk, blk->right_adjacent());
+            }
+            debug_only(std::memset(blk->memory(), 0xC, blk->size()));
+            m_free_blocks->put_block(blk);
+        }
+        if (m_pages->page_info_from_addr(page_begin)->used_bytes == 0) {
+            STAT_INCR(mem.num_compacted_pages, 1);
+        }
+        STAT_INCR(mem.total_compacted, moved);
+        return moved;
+    }
+
+
+    inline tuple<size_t, size_t> memalloc::free_memory() const noexcept {
+        const size_t free_total = online_size() - m_pages->used();
+        const size_t free_whole_pages = m_pages->num_empty() * page_size;
+        debug_assert(free_total >= free_whole_pages);
+        return make_tuple(free_total, free_total - free_whole_pages);
+    }
+
 } // namespace cachelot
 
@@ -41,6 +41,8 @@ namespace cachelot {
     *  - fast (malloc / free / realloc are amortized O(1) operations)
     *  - efficiently utilizes CPU cache
     *  - has small overhead (8 bytes of metadata per allocation + alignment bytes)
+    *  - optionally packs tiny allocations (up to `tiny_allocation_limit` bytes) densely into the
+    *    fixed-size slots of dedicated pages, there is no per-allocation metadata for them
     *
     * Limitations:
     *  - memalloc is single threaded by design
@@ -57,12 +59,26 @@ namespace cachelot {
         class block;
         class free_blocks_by_size;
     public:
+        /// allocations up to this size may be served from the tiny slots
+        static constexpr uint32 tiny_allocation_limit = 56;
+        /// granularity of the tiny slot sizes
+        static constexpr uint32 tiny_slot_step = 8;
+        /// smallest tiny slot
+        static constexpr uint32 tiny_slot_min = 24;
+        /// number of distinct tiny slot sizes
+        static constexpr uint32 num_tiny_classes = (tiny_allocation_limit - tiny_slot_min) / tiny_slot_step + 1;
+
         /// constructor
         /// @p arena_size - amount of memory in bytes to work with
         /// @p page_size - size of internal allocator page.
         ///                Page size limits single allocation size.
         ///                The less page is, the less items would be evicted when allocator ran out of free memory
-        explicit memalloc(const size_t memory_limit, const uint32 page_size);
+        /// @p pack_tiny - serve allocations up to `tiny_allocation_limit` from the pages split on equal slots
+        explicit memalloc(const size_t memory_limit, const uint32 page_size, const bool pack_tiny = false);
+
+        /// construct allocator over the memory `arena` owned by the caller, all pages are offline (see `acquire_pages()`)
+        /// @p arena - memory aligned to the `page_size`
+        explicit memalloc(void * arena, const size_t arena_size, const uint32 page_size, const bool pack_tiny = false);
 
 
         /// move contructor
@@ -98,8 +114,49 @@ namespace cachelot {
         /// return size of previously allocate memory including alignment bytes
         size_t reveal_actual_size(void * ptr) const noexcept;
 
+        /// return amount of memory available to user in previously allocated `ptr` (may be greater than requested)
+        size_t usable_size(void * ptr) const noexcept;
+
         /// retrieve size of allocator header
         static size_t header_size() noexcept;
+
+        /// take pages within [`begin`, `end`) out of use, every used block there is evicted
+        /// released memory may be given to the other allocator sharing the same arena
+        template <typename ForeachFreed>
+        void release_pages(void * begin, void * end, ForeachFreed on_free_block) noexcept;
+
+        /// same as above, but used blocks accepted by `can_move` are moved to the other pages if possible
+        /// (see `compact()` for `can_move` and `on_moved`), the rest is evicted
+        template <typename ForeachFreed, typename CanMove, typename OnMoved>
+        void release_pages(void * begin, void * end, ForeachFreed on_free_block, CanMove can_move, OnMoved on_moved) noexcept;
+
+        /// take previously released (or offline) pages within [`begin`, `end`) into use
+        void acquire_pages(void * begin, void * end) noexcept;
+
+        /// return first byte of the page which is the best candidate for eviction or `nullptr` if all pages are offline
+        void * least_recently_used_page() const noexcept;
+
+        /// return amount of memory available to allocator (excluding offline pages)
+        size_t online_size() const noexcept;
+
+        /// return number of pages evicted in order to satisfy allocations so far
+        uint64 num_evicted_pages() const noexcept { return m_num_evicted_pages; }
+
+        /// move used blocks out of the sparsely used pages (see `compaction_threshold`) making these pages whole free blocks again
+        /// @p max_bytes - stop once this amount of memory is moved
+        /// @p can_move - `bool can_move(void * ptr)` whether block can be moved, page is skipped if any of its blocks can't
+        /// @p on_moved - `void on_moved(void * from, void * to)` called once block content is copied to the new location
+        /// @return amount of moved memory
+        template <typename CanMove, typename OnMoved>
+        size_t compact(size_t max_bytes, CanMove can_move, OnMoved on_moved) noexcept;
+
+        /// return tuple<free memory, free memory scattered among partially used pages>
+        tuple<size_t, size_t> free_memory() const noexcept;
+
+        /// page is a subject to compaction if its used blocks take no more than 1 / `compaction_threshold` of the page
+        static constexpr uint32 compaction_threshold = 4;
+        /// maximal number of pages to examine per `compact()` call
+        static constexpr uint32 compaction_scan_limit = 16;
     private:
         /// check whether given `ptr` whithin arena bounaries and block information can be retrieved from it
         bool valid_addr(void * ptr) const noexcept;
@@ -117,6 +174,26 @@ namespace cachelot {
         /// mark block as used and give requested memory to user
         void * checkout(block * blk, const uint32 requested_size) noexcept;
 
+        /// check whether `ptr` belongs to the page split on tiny slots
+        bool is_tiny(const void * ptr) const noexcept;
+
+        /// allocate tiny slot from the page having free slots or from the new whole free page
+        void * alloc_tiny(const uint32 size) noexcept;
+
+        /// split the whole page on tiny slots of the `slot_class` and return the first slot
+        void * make_slots_page(uint8 * page_begin, const uint32 slot_class) noexcept;
+
+        /// return tiny slot to its page, page is released once all its slots are free
+        void free_tiny(void * ptr) noexcept;
+
+        /// evict every used block (or tiny slot) of the page
+        template <typename ForeachFreed>
+        void evict_page(uint8 * page_begin, uint8 * page_end, ForeachFreed on_free_block) noexcept;
+
+        /// move every used block of the page to the other pages, return amount of moved memory
+        template <typename CanMove, typename OnMoved>
+        size_t compact_page(uint8 * page_begin, uint8 * page_end, CanMove can_move, OnMoved on_moved) noexcept;
+
         // disallow copying
         memalloc(const memalloc &) = delete;
         memalloc & operator=(const memalloc &) = delete;
@@ -130,6 +207,8 @@ namespace cachelot {
         const size_t arena_size;
         // size of the single page
         const uint32 page_size;
+        // whether tiny allocations are packed into slots
+        const bool pack_tiny;
     private:
         // pointer to the memory arena
         std::unique_ptr<void, decltype(&std::free)> m_arena;
@@ -137,6 +216,8 @@ namespace cachelot {
         std::unique_ptr<pages> m_pages;
         // free memory blocks are placed in the table, grouped by block size
         std::unique_ptr<free_blocks_by_size> m_free_blocks;
+        // number of pages evicted by `alloc_or_evict`
+        uint64 m_num_evicted_pages = 0;
 
         // Test cases
         friend struct test_memalloc::test_free_blocks_by_size;
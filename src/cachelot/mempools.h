@@ -0,0 +1,369 @@
+#ifndef CACHELOT_MEMPOOLS_H_INCLUDED
+#define CACHELOT_MEMPOOLS_H_INCLUDED
+
+//
+//  (C) Copyright 2015 Iurii Krasnoshchok
+//
+//  Distributed under the terms of Simplified BSD License
+//  see LICENSE file
+
+#ifndef CACHELOT_MEMALLOC_H_INCLUDED
+#  include <cachelot/memalloc.h>
+#endif
+
+namespace cachelot {
+
+    /// @ingroup memalloc
+    /// @{
+
+   /**
+    * Set of memalloc pools of the different page sizes sharing the single memory arena
+    *
+    * Single page size is a trade-off: small pages give precise eviction but limit the item size,
+    * large pages let big items in but evict a lot of small ones at once.
+    * Here allocation is routed by its size to the pool with the smallest suitable page,
+    * each pool has its own LRU, so big items never evict pages of the small ones and vice versa.
+    *
+    * Arena is split on regions of the biggest page size, every region belongs to exactly one pool.
+    * Pool which evicts the most relative to its size takes the least recently used region of the pool
+    * which evicts the least (see `rebalance()`)
+    *
+    * mempools mimics memalloc interface, see `memalloc` for the description of the allocation functions
+    */
+    class mempools {
+    public:
+        /// state of the single pool
+        struct pool_info {
+            uint32 page_size;
+            size_t memory;
+            uint64 num_evicted_pages;
+        };
+
+        /// constructor
+        /// @p memory_limit - amount of memory in bytes to work with
+        /// @p page_sizes - page size of every pool (powers of 2), `memory_limit` must fit at least 4 biggest pages
+        /// @p pack_tiny - see `memalloc::memalloc`
+        explicit mempools(const size_t memory_limit, const std::vector<uint32> & page_sizes, const bool pack_tiny = false);
+
+        /// move constructor
+        mempools(mempools &&) = default;
+
+        /// @copydoc memalloc::alloc
+        void * alloc(size_t size) {
+            return alloc_or_evict(size, false, [=](void *) -> void {});
+        }
+
+        /// @copydoc memalloc::alloc_or_evict
+        template <typename ForeachFreed>
+        void * alloc_or_evict(size_t size, bool evict_if_necessary, ForeachFreed on_free_block);
+
+        /// @copydoc memalloc::realloc_inplace
+        void * realloc_inplace(void * ptr, const size_t new_size) noexcept;
+
+        /// @copydoc memalloc::free
+        void free(void * ptr) noexcept { pool_of(ptr).allocator->free(ptr); }
+
+        /// @copydoc memalloc::touch
+        void touch(void * ptr) noexcept { pool_of(ptr).allocator->touch(ptr); }
+
+        /// @copydoc memalloc::reveal_actual_size
+        size_t reveal_actual_size(void * ptr) const noexcept { return pool_of(ptr).allocator->reveal_actual_size(ptr); }
+
+        /// @copydoc memalloc::usable_size
+        size_t usable_size(void * ptr) const noexcept { return pool_of(ptr).allocator->usable_size(ptr); }
+
+        /// @copydoc memalloc::header_size
+        static size_t header_size() noexcept { return memalloc::header_size(); }
+
+        /// expiration hint, pages are evicted by LRU regardless
+        template <typename TimePoint>
+        void expire_at(void *, TimePoint) noexcept {}
+
+        /// @copydoc memalloc::compact
+        template <typename CanMove, typename OnMoved>
+        size_t compact(size_t max_bytes, CanMove can_move, OnMoved on_moved) noexcept;
+
+        /// @copydoc memalloc::free_memory
+        tuple<size_t, size_t> free_memory() const noexcept;
+
+        /// retrieve state of every pool, ordered by page size
+        std::vector<pool_info> pools_info() const;
+
+        /// change amount of memory in use to `new_size` bytes (multiple of `page_size`, no more than `arena_size`)
+        /// shrinking takes whole regions out of use, items are moved to the remaining memory if possible (see `compact()`),
+        /// the rest is evicted, physical memory of the released regions is given back to OS
+        template <typename ForeachFreed, typename CanMove, typename OnMoved>
+        void resize(size_t new_size, ForeachFreed on_free_block, CanMove can_move, OnMoved on_moved) noexcept;
+
+        /// return amount of memory in use (see `resize()`)
+        size_t online_size() const noexcept { return m_num_online_regions << m_log2_region_size; }
+
+        /// minimal amount of memory the allocator can work with
+        size_t min_size() const noexcept { return std::max<size_t>(m_pools.size(), 4) << m_log2_region_size; }
+
+    private:
+        struct pool {
+            std::unique_ptr<memalloc> allocator;
+            size_t num_regions;
+            uint64 pressure;  // amount of evicted memory, decays on every rebalance
+            uint64 num_evicted_pages; // last seen `memalloc::num_evicted_pages()`
+        };
+
+        /// pool serving allocations of `size` bytes
+        pool & pool_for_size(const size_t size) noexcept;
+
+        /// pool owning `ptr`
+        pool & pool_of(const void * ptr) const noexcept;
+
+        /// pool having the least amount of evicted memory per region, it must keep at least one region
+        pool * least_pressured_pool(const pool * exclude) noexcept;
+
+        /// `m_region_owner` of the regions out of use
+        static constexpr uint8 offline_region = std::numeric_limits<uint8>::max();
+
+        /// number of the region containing `ptr`
+        size_t region_of(const void * ptr) const noexcept {
+            return static_cast<size_t>(reinterpret_cast<const uint8 *>(ptr) - m_arena_begin) >> m_log2_region_size;
+        }
+
+        /// give `receiver` memory from the pool under the lowest eviction pressure if `receiver` evicts much more
+        template <typename ForeachFreed>
+        void rebalance(pool & receiver, ForeachFreed on_free_block) noexcept;
+
+        // disallow copying
+        mempools(const mempools &) = delete;
+        mempools & operator=(const mempools &) = delete;
+
+    public:
+        // total amount of memory
+        const size_t arena_size;
+        // size of the biggest page, it limits the single allocation size
+        const uint32 page_size;
+    private:
+        std::unique_ptr<void, decltype(&aligned_free)> m_arena;
+        uint8 * m_arena_begin;
+        uint32 m_log2_region_size;
+        mutable std::vector<pool> m_pools;
+        std::vector<uint8> m_region_owner; // pool number by the region number
+        size_t m_num_online_regions;
+        uint64 m_evicted_since_rebalance;
+    };
+
+    /// @}
+
+
+    inline mempools::mempools(const size_t memory_limit, const std::vector<uint32> & page_sizes, const bool pack_tiny)
+        : arena_size(memory_limit)
+        , page_size(*std::max_element(page_sizes.begin(), page_sizes.end()))
+        , m_arena(nullptr, &aligned_free)
+        , m_log2_region_size(log2u(page_size))
+        , m_num_online_regions(memory_limit / page_size)
+        , m_evicted_since_rebalance(0) {
+        debug_assert(not page_sizes.empty());
+        debug_assert(ispow2(memory_limit));
+        debug_assert(memory_limit >= page_size * 4);
+        std::vector<uint32> sizes(page_sizes);
+        std::sort(sizes.begin(), sizes.end());
+        sizes.erase(std::unique(sizes.begin(), sizes.end()), sizes.end());
+        const size_t num_regions = memory_limit / page_size;
+        debug_assert(num_regions >= sizes.size());
+        debug_assert(sizes.size() < offline_region);
+        m_arena.reset(aligned_alloc(page_size, arena_size));
+        if (m_arena == nullptr) {
+            throw std::bad_alloc();
+        }
+        m_arena_begin = reinterpret_cast<uint8 *>(m_arena.get());
+        m_region_owner.resize(num_regions);
+        // split regions equally, the smallest pages get the remainder
+        size_t region_no = 0;
+        for (size_t pool_no = 0; pool_no < sizes.size(); ++pool_no) {
+            pool p;
+            p.allocator.reset(new memalloc(m_arena_begin, arena_size, sizes[pool_no], pack_tiny));
+            p.num_regions = num_regions / sizes.size() + (pool_no < num_regions % sizes.size() ? 1 : 0);
+            p.pressure = 0;
+            p.num_evicted_pages = 0;
+            p.allocator->acquire_pages(m_arena_begin + (region_no << m_log2_region_size), m_arena_begin + ((region_no + p.num_regions) << m_log2_region_size));
+            std::fill(m_region_owner.begin() + region_no, m_region_owner.begin() + region_no + p.num_regions, static_cast<uint8>(pool_no));
+            region_no += p.num_regions;
+            m_pools.push_back(std::move(p));
+        }
+        debug_assert(region_no == num_regions);
+        STAT_SET(mem.limit_maxbytes, memory_limit);
+        STAT_SET(mem.page_size, page_size);
+        STAT_SET(mem.num_pools, m_pools.size());
+    }
+
+
+    inline mempools::pool & mempools::pool_for_size(const size_t size) noexcept {
+        for (auto & p : m_pools) {
+            if (size <= p.allocator->page_size - header_size()) {
+                return p;
+            }
+        }
+        return m_pools.back();
+    }
+
+
+    inline mempools::pool & mempools::pool_of(const void * ptr) const noexcept {
+        #if defined(ADDRESS_SANITIZER)
+        // memory comes from the malloc, every pool is able to free it
+        return m_pools.front();
+        #endif
+        if (m_pools.size() == 1) {
+            return m_pools.front();
+        }
+        debug_assert(ptr >= m_arena_begin && ptr < m_arena_begin + arena_size);
+        return m_pools[m_region_owner[region_of(ptr)]];
+    }
+
+
+    template <typename ForeachFreed>
+    inline void * mempools::alloc_or_evict(size_t size, bool evict_if_necessary, ForeachFreed on_free_block) {
+        auto & p = pool_for_size(size);
+        void * memory = p.allocator->alloc_or_evict(size, evict_if_necessary, on_free_block);
+        if (m_pools.size() > 1 && p.allocator->num_evicted_pages() != p.num_evicted_pages) {
+            const uint64 evicted = (p.allocator->num_evicted_pages() - p.num_evicted_pages) * p.allocator->page_size;
+            p.num_evicted_pages = p.allocator->num_evicted_pages();
+            p.pressure += evicted;
+            m_evicted_since_rebalance += evicted;
+            // reconsider memory distribution once a region worth of memory was evicted
+            if (m_evicted_since_rebalance >= page_size) {
+                m_evicted_since_rebalance = 0;
+                rebalance(p, on_free_block);
+            }
+        }
+        return memory;
+    }
+
+
+    inline mempools::pool * mempools::least_pressured_pool(const pool * exclude) noexcept {
+        // pressure is the amount of evicted memory per region
+        pool * result = nullptr;
+        for (auto & p : m_pools) {
+            if (&p != exclude && p.num_regions > 1 && (result == nullptr || p.pressure * result->num_regions < result->pressure * p.num_regions)) {
+                result = &p;
+            }
+        }
+        return result;
+    }
+
+
+    template <typename ForeachFreed>
+    inline void mempools::rebalance(pool & receiver, ForeachFreed on_free_block) noexcept {
+        pool * donor = least_pressured_pool(&receiver);
+        // move the region only if `receiver` evicts at least twice as much as `donor`
+        if (donor != nullptr && receiver.pressure * donor->num_regions > 2 * donor->pressure * receiver.num_regions) {
+            const size_t region_no = region_of(donor->allocator->least_recently_used_page());
+            uint8 * const region_begin = m_arena_begin + (region_no << m_log2_region_size);
+            uint8 * const region_end = region_begin + page_size;
+            donor->allocator->release_pages(region_begin, region_end, on_free_block);
+            receiver.allocator->acquire_pages(region_begin, region_end);
+            m_region_owner[region_no] = static_cast<uint8>(&receiver - m_pools.data());
+            donor->num_regions -= 1;
+            receiver.num_regions += 1;
+            STAT_INCR(mem.num_pool_rebalances, 1);
+        }
+        // older evictions matter less
+        for (auto & p : m_pools) {
+            p.pressure /= 2;
+        }
+    }
+
+
+    inline void * mempools::realloc_inplace(void * ptr, const size_t new_size) noexcept {
+        auto & p = pool_of(ptr);
+        if (new_size > p.allocator->page_size - header_size()) {
+            return nullptr;
+        }
+        return p.allocator->realloc_inplace(ptr, new_size);
+    }
+
+
+    template <typename ForeachFreed, typename CanMove, typename OnMoved>
+    inline void mempools::resize(size_t new_size, ForeachFreed on_free_block, CanMove can_move, OnMoved on_moved) noexcept {
+        debug_assert(new_size % page_size == 0);
+        debug_assert(new_size >= min_size() && new_size <= arena_size);
+        const size_t new_num_regions = new_size >> m_log2_region_size;
+        // shrink: the least pressured pool gives away its least recently used region
+        while (m_num_online_regions > new_num_regions) {
+            // prefer the pool which is able to keep its items in the rest of memory
+            pool * donor = nullptr;
+            for (auto & p : m_pools) {
+                if (p.num_regions > 1 && std::get<0>(p.allocator->free_memory()) >= page_size
+                        && (donor == nullptr || p.pressure * donor->num_regions < donor->pressure * p.num_regions)) {
+                    donor = &p;
+                }
+            }
+            if (donor == nullptr) {
+                donor = least_pressured_pool(nullptr);
+            }
+            debug_assert(donor != nullptr);
+            const size_t region_no = region_of(donor->allocator->least_recently_used_page());
+            uint8 * const region_begin = m_arena_begin + (region_no << m_log2_region_size);
+            uint8 * const region_end = region_begin + page_size;
+            donor->allocator->release_pages(region_begin, region_end, on_free_block, can_move, on_moved);
+            m_region_owner[region_no] = offline_region;
+            donor->num_regions -= 1;
+            m_num_online_regions -= 1;
+            discard_memory(region_begin, page_size);
+        }
+        // grow: regions go to the most pressured pool
+        for (size_t region_no = 0; region_no < m_region_owner.size() && m_num_online_regions < new_num_regions; ++region_no) {
+            if (m_region_owner[region_no] != offline_region) {
+                continue;
+            }
+            // the most pressured pool, regions are distributed evenly if there were no evictions
+            pool * receiver = &m_pools.front();
+            for (auto & p : m_pools) {
+                const auto p_pressure = p.pressure * receiver->num_regions;
+                const auto receiver_pressure = receiver->pressure * p.num_regions;
+                if (p_pressure > receiver_pressure || (p_pressure == receiver_pressure && p.num_regions < receiver->num_regions)) {
+                    receiver = &p;
+                }
+            }
+            uint8 * const region_begin = m_arena_begin + (region_no << m_log2_region_size);
+            receiver->allocator->acquire_pages(region_begin, region_begin + page_size);
+            m_region_owner[region_no] = static_cast<uint8>(receiver - m_pools.data());
+            receiver->num_regions += 1;
+            m_num_online_regions += 1;
+        }
+        STAT_SET(mem.limit_maxbytes, online_size());
+    }
+
+
+    template <typename CanMove, typename OnMoved>
+    inline size_t mempools::compact(size_t max_bytes, CanMove can_move, OnMoved on_moved) noexcept {
+        size_t moved = 0;
+        for (auto & p : m_pools) {
+            if (moved >= max_bytes) {
+                break;
+            }
+            moved += p.allocator->compact(max_bytes - moved, can_move, on_moved);
+        }
+        return moved;
+    }
+
+
+    inline tuple<size_t, size_t> mempools::free_memory() const noexcept {
+        size_t free_total = 0, free_fragmented = 0;
+        for (const auto & p : m_pools) {
+            size_t pool_total, pool_fragmented;
+            tie(pool_total, pool_fragmented) = p.allocator->free_memory();
+            free_total += pool_total;
+            free_fragmented += pool_fragmented;
+        }
+        return make_tuple(free_total, free_fragmented);
+    }
+
+
+    inline std::vector<mempools::pool_info> mempools::pools_info() const {
+        std::vector<pool_info> result;
+        for (const auto & p : m_pools) {
+            result.push_back(pool_info { p.allocator->page_size, p.num_regions << m_log2_region_size, p.allocator->num_evicted_pages() });
+        }
+        return result;
+    }
+
+} // namespace cachelot
+
+#endif // CACHELOT_MEMPOOLS_H_INCLUDED
@@ -0,0 +1,501 @@
+#ifndef CACHELOT_SEGMALLOC_H_INCLUDED
+#define CACHELOT_SEGMALLOC_H_INCLUDED
+
+//
+//  (C) Copyright 2015 Iurii Krasnoshchok
+//
+//  Distributed under the terms of Simplified BSD License
+//  see LICENSE file
+
+#ifndef CACHELOT_COMMON_H_INCLUDED
+#  include <cachelot/common.h>
+#endif
+#ifndef CACHELOT_BITS_H_INCLUDED
+#  include <cachelot/bits.h>
+#endif
+#ifndef CACHELOT_STATS_H_INCLUDED
+#  include <cachelot/stats.h>
+#endif
+#ifndef CACHELOT_INTRUSIVE_LIST_H_INCLUDED
+#  include <cachelot/intrusive_list.h>
+#endif
+#ifndef CACHELOT_EXPIRATION_CLOCK_H_INCLUDED
+#  include <cachelot/expiration_clock.h>
+#endif
+
+namespace cachelot {
+
+    /// @ingroup memalloc
+    /// @{
+
+   /**
+    * Log-structured allocator, an alternative storage engine to the `mempools` / `memalloc`
+    *
+    * Memory is split on the fixed-size segments (in the style of RAMCloud / Segcache):
+    *  - allocation is appended to the active segment, once it's full the next free segment becomes active
+    *  - `free` only marks block as dead, segment is reused as soon as all its blocks are dead
+    *  - segment expires as a whole when the latest of its items expired (see `expire_at()`),
+    *    expired segments are dropped in bulk before anything is evicted
+    *  - when there are no free segments the oldest one is evicted (FIFO, access time doesn't matter)
+    *  - cleaner (see `compact()`) moves live blocks out of the segments having few of them
+    *
+    * Comparing to `memalloc` allocation is cheaper and there is no per-page fragmentation,
+    * but memory of the dead blocks is not reused until segment is either empty or cleaned
+    *
+    * segmalloc mimics memalloc interface, see `memalloc` for the description of the allocation functions
+    */
+    class segmalloc {
+        class segments;
+    public:
+        /// time point of the item expiration
+        typedef cache::ExpirationClock::time_point expiration_time_point;
+
+        /// state of the allocator in terms of `mempools::pool_info`
+        struct pool_info {
+            uint32 page_size;
+            size_t memory;
+            uint64 num_evicted_pages;
+        };
+
+        /// segment is cleaned if its live blocks take no more than 1 / `compaction_threshold` of it
+        static constexpr uint32 compaction_threshold = 2;
+
+        /// constructor
+        /// @p memory_limit - amount of memory in bytes to work with
+        /// @p segment_size - size of the segment (power of 2), it limits the single allocation size
+        explicit segmalloc(const size_t memory_limit, const uint32 segment_size);
+
+        /// constructor of the cache storage engine (see `mempools::mempools`)
+        /// segment size is the biggest of `page_sizes`, tiny allocations are never packed
+        explicit segmalloc(const size_t memory_limit, const std::vector<uint32> & page_sizes, const bool pack_tiny)
+            : segmalloc(memory_limit, *std::max_element(page_sizes.begin(), page_sizes.end())) {
+            (void)pack_tiny;
+        }
+
+        /// move constructor
+        segmalloc(segmalloc &&) = default;
+
+        /// @copydoc memalloc::alloc
+        void * alloc(size_t size) {
+            return alloc_or_evict(size, false, [=](void *) -> void {});
+        }
+
+        /// @copydoc memalloc::alloc_or_evict
+        template <typename ForeachFreed>
+        void * alloc_or_evict(size_t size, bool evict_if_necessary, ForeachFreed on_free_block);
+
+        /// @copydoc memalloc::realloc_inplace
+        /// only the last block of the active segment can grow
+        void * realloc_inplace(void * ptr, const size_t new_size) noexcept;
+
+        /// @copydoc memalloc::free
+        void free(void * ptr) noexcept;
+
+        /// segments are evicted in FIFO order, access doesn't matter
+        void touch(void *) noexcept {}
+
+        /// @copydoc memalloc::reveal_actual_size
+        size_t reveal_actual_size(void * ptr) const noexcept { return header_from_user_ptr(ptr)->size + header_size(); }
+
+        /// @copydoc memalloc::usable_size
+        size_t usable_size(void * ptr) const noexcept { return header_from_user_ptr(ptr)->size; }
+
+        /// @copydoc memalloc::header_size
+        static constexpr size_t header_size() noexcept { return sizeof(block_header); }
+
+        /// let the segment of `ptr` expire not earlier than `expiration`
+        /// segment having blocks without expiration never expires
+        void expire_at(void * ptr, const expiration_time_point expiration) noexcept;
+
+        /// move live blocks out of the segments having few of them (see `compaction_threshold`) making these segments free
+        /// @see memalloc::compact
+        template <typename CanMove, typename OnMoved>
+        size_t compact(size_t max_bytes, CanMove can_move, OnMoved on_moved) noexcept;
+
+        /// return tuple<free memory, free memory which is reusable only after cleaning>
+        tuple<size_t, size_t> free_memory() const noexcept;
+
+        /// retrieve state of the allocator as the single pool
+        std::vector<pool_info> pools_info() const {
+            return std::vector<pool_info>(1, pool_info { page_size, arena_size, m_num_evicted_segments });
+        }
+
+    private:
+        struct block_header {
+            uint32 size;    // amount of memory available to user
+            uint32 flags;
+        };
+        static constexpr uint32 BLOCK_LIVE = 1 << 0;
+        static constexpr uint32 BLOCK_HAS_EXPIRATION = 1 << 1;
+        static constexpr uint32 alignment = alignof(void *);
+
+        static block_header * header_from_user_ptr(void * ptr) noexcept {
+            return reinterpret_cast<block_header *>(reinterpret_cast<uint8 *>(ptr) - sizeof(block_header));
+        }
+
+        /// remove block from its segment, segment is freed once there are no more live blocks
+        void release_block(block_header * block) noexcept;
+
+        /// take free segment, drop expired or evict the oldest one if there is none
+        template <typename ForeachFreed>
+        bool next_active_segment(bool evict_if_necessary, ForeachFreed on_free_block) noexcept;
+
+        /// free the whole segment reporting every live block to `on_free_block`
+        template <typename ForeachFreed>
+        void evict_segment(size_t segment_no, ForeachFreed on_free_block) noexcept;
+
+        // disallow copying
+        segmalloc(const segmalloc &) = delete;
+        segmalloc & operator=(const segmalloc &) = delete;
+
+    public:
+        // total amount of memory
+        const size_t arena_size;
+        // size of the segment
+        const uint32 page_size;
+    private:
+        std::unique_ptr<void, decltype(&aligned_free)> m_arena;
+        std::unique_ptr<segments> m_segments;
+        uint64 m_num_evicted_segments;
+    };
+
+    /// @}
+
+
+    /// segments metadata, free segments list and the FIFO of the full ones
+    class segmalloc::segments {
+    public:
+        struct segment {
+            intrusive_list_node link;         // either in the free or in the sealed list
+            uint32 write_offset = 0;          // amount of appended memory
+            uint32 live_bytes = 0;            // memory of the live blocks including headers
+            uint32 num_without_expiration = 0; // live blocks which didn't get `expire_at()`
+            expiration_time_point expires = expiration_time_point::min();
+            bool sealed = false;
+        };
+        typedef intrusive_list<segment, &segment::link> segment_list;
+
+        segments(uint8 * the_arena_begin, const size_t num_segments, const uint32 segment_size)
+            : arena_begin(the_arena_begin)
+            , all(num_segments)
+            , active(nullptr)
+            , num_sealed(0)
+            , live_bytes(0)
+            , log2_segment_size(log2u(segment_size)) {
+            for (auto & seg : all) {
+                free.push_back(&seg);
+            }
+        }
+
+        size_t number(const segment * seg) const noexcept { return static_cast<size_t>(seg - all.data()); }
+
+        uint8 * begin(const segment * seg) const noexcept { return arena_begin + (number(seg) << log2_segment_size); }
+
+        segment * segment_of(const void * ptr) noexcept {
+            const auto offset = static_cast<size_t>(reinterpret_cast<const uint8 *>(ptr) - arena_begin);
+            debug_assert((offset >> log2_segment_size) < all.size());
+            return &all[offset >> log2_segment_size];
+        }
+
+        /// forget everything about segment and put it into the free list
+        void reset(segment * seg) noexcept {
+            debug_assert(seg->live_bytes == 0);
+            if (seg->sealed) {
+                sealed.remove(seg);
+                num_sealed -= 1;
+            }
+            seg->write_offset = 0;
+            seg->num_without_expiration = 0;
+            seg->expires = expiration_time_point::min();
+            seg->sealed = false;
+            if (seg == active) {
+                // active segment is reused in place
+                return;
+            }
+            free.push_back(seg);
+        }
+
+    public:
+        uint8 * const arena_begin;
+        std::vector<segment> all;
+        segment_list free;
+        segment_list sealed; // the oldest is in front
+        segment * active;
+        size_t num_sealed;
+        size_t live_bytes;   // memory of all live blocks
+    private:
+        const uint32 log2_segment_size;
+    };
+
+
+    inline segmalloc::segmalloc(const size_t memory_limit, const uint32 segment_size)
+        : arena_size(memory_limit)
+        , page_size(segment_size)
+        , m_arena(nullptr, &aligned_free)
+        , m_num_evicted_segments(0) {
+        debug_assert(ispow2(memory_limit));
+        debug_assert(ispow2(segment_size));
+        debug_assert(memory_limit >= segment_size * 4);
+        m_arena.reset(aligned_alloc(segment_size, memory_limit));
+        if (m_arena == nullptr) {
+            throw std::bad_alloc();
+        }
+        m_segments.reset(new segments(reinterpret_cast<uint8 *>(m_arena.get()), memory_limit / segment_size, segment_size));
+        STAT_SET(mem.limit_maxbytes, memory_limit);
+        STAT_SET(mem.page_size, segment_size);
+        STAT_SET(mem.num_pools, 1);
+    }
+
+
+    template <typename ForeachFreed>
+    inline void * segmalloc::alloc_or_evict(size_t size, bool evict_if_necessary, ForeachFreed on_free_block) {
+        debug_assert(size > 0); debug_assert(size <= page_size - header_size());
+        STAT_INCR(mem.num_malloc, 1);
+        STAT_INCR(mem.total_requested, size);
+        const uint32 block_size = static_cast<uint32>(size + unaligned_bytes(size, alignment));
+        const uint32 required = block_size + static_cast<uint32>(header_size());
+        auto & segs = *m_segments;
+        if (segs.active == nullptr || segs.active->write_offset + required > page_size) {
+            if (not next_active_segment(evict_if_necessary, on_free_block)) {
+                STAT_INCR(mem.num_alloc_errors, 1);
+                STAT_INCR(mem.total_unserved, size);
+                return nullptr;
+            }
+        }
+        auto seg = segs.active;
+        auto block = reinterpret_cast<block_header *>(segs.begin(seg) + seg->write_offset);
+        block->size = block_size;
+        block->flags = BLOCK_LIVE;
+        seg->write_offset += required;
+        seg->live_bytes += required;
+        seg->num_without_expiration += 1;
+        segs.live_bytes += required;
+        STAT_INCR(mem.used_memory, required);
+        STAT_INCR(mem.total_served, required);
+        return block + 1;
+    }
+
+
+    template <typename ForeachFreed>
+    inline bool segmalloc::next_active_segment(bool evict_if_necessary, ForeachFreed on_free_block) noexcept {
+        auto & segs = *m_segments;
+        if (segs.free.empty() && evict_if_necessary) {
+            // drop expired segments in bulk
+            const auto now = cache::ExpirationClock::now();
+            for (size_t segment_no = 0; segment_no < segs.all.size(); ++segment_no) {
+                const auto & seg = segs.all[segment_no];
+                if (seg.sealed && seg.num_without_expiration == 0 && seg.expires <= now) {
+                    evict_segment(segment_no, on_free_block);
+                    STAT_INCR(mem.num_expired_segments, 1);
+                }
+            }
+            // evict the oldest segment
+            if (segs.free.empty() && not segs.sealed.empty()) {
+                evict_segment(segs.number(segs.sealed.front()), on_free_block);
+                m_num_evicted_segments += 1;
+            }
+        }
+        if (segs.free.empty()) {
+            return false;
+        }
+        if (segs.active != nullptr) {
+            segs.active->sealed = true;
+            segs.sealed.push_back(segs.active);
+            segs.num_sealed += 1;
+        }
+        segs.active = segs.free.pop_front();
+        debug_assert(segs.active->write_offset == 0);
+        return true;
+    }
+
+
+    template <typename ForeachFreed>
+    inline void segmalloc::evict_segment(size_t segment_no, ForeachFreed on_free_block) noexcept {
+        auto & segs = *m_segments;
+        auto seg = &segs.all[segment_no];
+        debug_assert(seg->sealed);
+        uint8 * const begin = segs.begin(seg);
+        for (uint32 offset = 0; offset < seg->write_offset; ) {
+            auto block = reinterpret_cast<block_header *>(begin + offset);
+            offset += block->size + static_cast<uint32>(header_size());
+            if (block->flags & BLOCK_LIVE) {
+                on_free_block(block + 1);
+                STAT_INCR(mem.evictions, 1);
+                STAT_DECR(mem.used_memory, block->size + header_size());
+                segs.live_bytes -= block->size + header_size();
+                block->flags = 0;
+            }
+        }
+        seg->live_bytes = 0;
+        segs.reset(seg);
+    }
+
+
+    inline void segmalloc::release_block(block_header * block) noexcept {
+        debug_assert(block->flags & BLOCK_LIVE);
+        auto & segs = *m_segments;
+        auto seg = segs.segment_of(block);
+        const uint32 block_size = block->size + static_cast<uint32>(header_size());
+        if ((block->flags & BLOCK_HAS_EXPIRATION) == 0) {
+            seg->num_without_expiration -= 1;
+        }
+        block->flags = 0;
+        debug_assert(seg->live_bytes >= block_size);
+        seg->live_bytes -= block_size;
+        segs.live_bytes -= block_size;
+        STAT_DECR(mem.used_memory, block_size);
+        if (seg->live_bytes == 0) {
+            segs.reset(seg);
+        }
+    }
+
+
+    inline void segmalloc::free(void * ptr) noexcept {
+        STAT_INCR(mem.num_free, 1);
+        release_block(header_from_user_ptr(ptr));
+    }
+
+
+    inline void * segmalloc::realloc_inplace(void * ptr, const size_t new_size) noexcept {
+        debug_assert(new_size > 0); debug_assert(new_size <= page_size - header_size());
+        STAT_INCR(mem.num_realloc, 1);
+        auto & segs = *m_segments;
+        auto block = header_from_user_ptr(ptr);
+        debug_assert(block->flags & BLOCK_LIVE);
+        auto seg = segs.segment_of(block);
+        uint8 * const block_end = reinterpret_cast<uint8 *>(ptr) + block->size;
+        const uint32 new_block_size = static_cast<uint32>(new_size + unaligned_bytes(new_size, alignment));
+        const auto block_offset = static_cast<uint32>(reinterpret_cast<uint8 *>(block) - segs.begin(seg));
+        if (seg == segs.active && block_end == segs.begin(seg) + seg->write_offset
+                && block_offset + header_size() + new_block_size <= page_size) {
+            // the last block of the active segment may both shrink and grow
+            seg->write_offset = block_offset + static_cast<uint32>(header_size()) + new_block_size;
+            seg->live_bytes = seg->live_bytes - block->size + new_block_size;
+            segs.live_bytes = segs.live_bytes - block->size + new_block_size;
+            STAT_DECR(mem.used_memory, block->size);
+            STAT_INCR(mem.used_memory, new_block_size);
+            block->size = new_block_size;
+            return ptr;
+        }
+        if (new_size <= block->size) {
+            return ptr;
+        }
+        STAT_INCR(mem.num_realloc_errors, 1);
+        return nullptr;
+    }
+
+
+    inline void segmalloc::expire_at(void * ptr, const expiration_time_point expiration) noexcept {
+        auto block = header_from_user_ptr(ptr);
+        debug_assert(block->flags & BLOCK_LIVE);
+        auto seg = m_segments->segment_of(block);
+        if ((block->flags & BLOCK_HAS_EXPIRATION) == 0) {
+            block->flags |= BLOCK_HAS_EXPIRATION;
+            seg->num_without_expiration -= 1;
+        }
+        seg->expires = std::max(seg->expires, expiration);
+    }
+
+
+    template <typename CanMove, typename OnMoved>
+    inline size_t segmalloc::compact(size_t max_bytes, CanMove can_move, OnMoved on_moved) noexcept {
+        auto & segs = *m_segments;
+        size_t moved = 0;
+        std::vector<bool> skipped(segs.all.size(), false);
+        while (moved < max_bytes) {
+            // the sparsest of the full segments
+            segments::segment * victim = nullptr;
+            for (auto & seg : segs.all) {
+                if (seg.sealed && not skipped[segs.number(&seg)] && seg.live_bytes <= page_size / compaction_threshold
+                        && (victim == nullptr || seg.live_bytes < victim->live_bytes)) {
+                    victim = &seg;
+                }
+            }
+            if (victim == nullptr) {
+                break;
+            }
+            uint8 * const begin = segs.begin(victim);
+            const uint32 write_offset = victim->write_offset;
+            bool movable = true;
+            for (uint32 offset = 0; offset < write_offset && movable; ) {
+                auto block = reinterpret_cast<block_header *>(begin + offset);
+                offset += block->size + static_cast<uint32>(header_size());
+                movable = (block->flags & BLOCK_LIVE) == 0 || can_move(block + 1);
+            }
+            if (not movable) {
+                skipped[segs.number(victim)] = true;
+                continue;
+            }
+            const bool has_room = not segs.free.empty()
+                || (segs.active != nullptr && page_size - segs.active->write_offset >= victim->live_bytes);
+            if (has_room) {
+                // append live blocks to the active segment, victim is freed together with its last live block
+                for (uint32 offset = 0; offset < write_offset; ) {
+                    auto block = reinterpret_cast<block_header *>(begin + offset);
+                    offset += block->size + static_cast<uint32>(header_size());
+                    if ((block->flags & BLOCK_LIVE) == 0) {
+                        continue;
+                    }
+                    void * new_memory = alloc_or_evict(block->size, false, [](void *) noexcept -> void {});
+                    if (new_memory == nullptr) {
+                        return moved;
+                    }
+                    std::memcpy(new_memory, block + 1, block->size);
+                    if (block->flags & BLOCK_HAS_EXPIRATION) {
+                        expire_at(new_memory, victim->expires);
+                    }
+                    on_moved(block + 1, new_memory);
+                    moved += block->size + header_size();
+                    STAT_INCR(mem.total_compacted, block->size + header_size());
+                    const bool last = victim->live_bytes == block->size + header_size();
+                    release_block(block);
+                    if (last) {
+                        STAT_INCR(mem.num_compacted_pages, 1);
+                        break;
+                    }
+                }
+            } else {
+                // no spare memory: slide live blocks to the beginning of the victim and continue to append there
+                segs.sealed.remove(victim);
+                segs.num_sealed -= 1;
+                victim->sealed = false;
+                if (segs.active != nullptr) {
+                    segs.active->sealed = true;
+                    segs.sealed.push_back(segs.active);
+                    segs.num_sealed += 1;
+                }
+                segs.active = victim;
+                uint32 new_offset = 0;
+                for (uint32 offset = 0; offset < write_offset; ) {
+                    auto block = reinterpret_cast<block_header *>(begin + offset);
+                    const uint32 block_size = block->size + static_cast<uint32>(header_size());
+                    const bool live = (block->flags & BLOCK_LIVE) != 0;
+                    if (live && offset != new_offset) {
+                        auto new_block = reinterpret_cast<block_header *>(begin + new_offset);
+                        std::memmove(new_block, block, block_size);
+                        on_moved(block + 1, new_block + 1);
+                        moved += block_size;
+                        STAT_INCR(mem.total_compacted, block_size);
+                    }
+                    new_offset += live ? block_size : 0;
+                    offset += block_size;
+                }
+                debug_assert(new_offset == victim->live_bytes);
+                victim->write_offset = new_offset;
+                STAT_INCR(mem.num_compacted_pages, 1);
+            }
+        }
+        return moved;
+    }
+
+
+    inline tuple<size_t, size_t> segmalloc::free_memory() const noexcept {
+        const auto & segs = *m_segments;
+        const size_t written = segs.num_sealed * page_size + (segs.active != nullptr ? segs.active->write_offset : 0);
+        debug_assert(written >= segs.live_bytes);
+        return make_tuple(arena_size - segs.live_bytes, written - segs.live_bytes);
+    }
+
+} // namespace cachelot
+
+#endif // CACHELOT_SEGMALLOC_H_INCLUDED
@@ -8,6 +8,11 @@
 //
 
 
+#ifndef CACHELOT_BYTE_SEARCH_H_INCLUDED
+#  include <cachelot/byte_search.h>
+#endif
+
+
 namespace cachelot {
 
     /**
@@ -93,7 +98,13 @@ namespace cachelot {
                 if (what.begin() >= begin() && what.end() <= end()) {
                     return what;
                 } else {
-                    const char * pos = std::search(begin(), end(), what.begin(), what.end());
+                    const char * pos;
+                    // separators of the text protocols are 1-2 bytes long
+                    switch (what.length()) {
+                    case 1: pos = byte_search::find(begin(), end(), what[0]); break;
+                    case 2: pos = byte_search::find_pair(begin(), end(), what[0], what[1]); break;
+                    default: pos = std::search(begin(), end(), what.begin(), what.end()); break;
+                    }
                     if (pos != end()) {
                         return slice(pos, what.length());
                     }
@@ -29,7 +29,22 @@ namespace cachelot {
         X(uint64, num_free_table_hits,      "Number of times when memory allocated from the corresponding cell of free blocks table") \
         X(uint64, num_free_table_weak_hits, "Number of times when memory allocated from the bigger cell of free blocks table") \
         X(uint64, limit_maxbytes,           "Maximum amount of memory to use for the storage") \
+        X(uint64, memory_budget,            "Maximum amount of memory of the storage, hash tables and connection buffers together (0 - unlimited)") \
+        X(uint64, dict_memory,              "Amount of memory used by the hash tables") \
+        X(uint64, io_buffers_memory,        "Amount of memory used by the connection buffers") \
         X(uint64, page_size,                "Size of allocator page (max allocation size)") \
+        X(uint64, num_tiny_pages,           "Number of pages split on tiny slots") \
+        X(uint64, num_pools,                "Number of memory pools of the different page sizes") \
+        X(uint64, num_pool_rebalances,      "Number of memory regions moved between pools") \
+        X(uint64, fragmentation,            "Percent of free memory scattered among partially used pages") \
+        X(uint64, num_compacted_pages,      "Number of pages freed by moving their items to the other pages") \
+        X(uint64, total_compacted,          "Amount of memory moved by the compaction") \
+        X(uint64, num_expired_segments,     "Number of log segments dropped at once as all their items expired") \
+        X(uint64, total_compress_raw,       "Amount of values data before compression") \
+        X(uint64, total_compress_stored,    "Amount of compressed values data") \
+        X(uint64, num_compress_rejected,    "Number of values stored uncompressed due to the poor compression ratio") \
+        X(uint64, num_shared_values,        "Number of deduplicated values") \
+        X(uint64, num_shared_refs,          "Number of items referencing deduplicated values") \
         X(uint64, evictions,                "Number of evicted items")
 
     #define CACHE_STATS(X) \
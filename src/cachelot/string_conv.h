@@ -214,6 +214,56 @@ namespace cachelot {
         };
 
 
+        // Convert 8 ASCII digits at once treating them as a single 64-bit word (SWAR)
+        // return `false` if there is a non-digit character
+        inline bool eight_digits_to_unsigned(const char * str, uint64 & result) noexcept {
+            uint64 chunk;
+            std::memcpy(&chunk, str, sizeof(chunk));
+            // every byte must be within '0' (0x30) ... '9' (0x39)
+            if (((chunk & 0xF0F0F0F0F0F0F0F0ull) | (((chunk + 0x0606060606060606ull) & 0xF0F0F0F0F0F0F0F0ull) >> 4)) != 0x3333333333333333ull) {
+                return false;
+            }
+            // first digit is in the lowest byte, merge adjacent digits into 2, 4 and finally 8 digit numbers
+            chunk = ((chunk & 0x0F0F0F0F0F0F0F0Full) * 2561) >> 8;
+            chunk = ((chunk & 0x00FF00FF00FF00FFull) * 6553601) >> 16;
+            result = ((chunk & 0x0000FFFF0000FFFFull) * 42949672960001ull) >> 32;
+            return true;
+        }
+
+
+        // Fast conversion is available only for the contiguous memory
+        template <class ConstIterator>
+        inline bool try_digits_to_unsigned(ConstIterator, ConstIterator, uint64 &) noexcept {
+            return false;
+        }
+
+
+        // Convert up to 19 ASCII digits (they can't overflow uint64) processing 8 digits at once
+        // return `false` if there is a non-digit character
+        inline bool try_digits_to_unsigned(const char * str, const char * end, uint64 & result) noexcept {
+#if (defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__) || defined(_MSC_VER)
+            debug_assert(end - str < 20);
+            result = 0;
+            for (uint64 eight_digits; end - str >= 8; str += 8) {
+                if (not eight_digits_to_unsigned(str, eight_digits)) {
+                    return false;
+                }
+                result = result * 100000000u + eight_digits;
+            }
+            for (; str < end; ++str) {
+                if (*str < '0' || *str > '9') {
+                    return false;
+                }
+                result = result * 10 + static_cast<uint64>(*str - '0');
+            }
+            return true;
+#else
+            (void)str; (void)end; (void)result;
+            return false;
+#endif
+        }
+
+
         // Convert ASCII encoded decimal string to unsigned 64-bit integer
         template <class ConstIterator>
         inline uint64 str_to_big_unsigned(ConstIterator str, ConstIterator end, error_code & out_error) noexcept {
@@ -227,6 +277,12 @@ namespace cachelot {
                 return 0u;
             }
 
+            // fast path, errors and 20 digit numbers are handled below
+            uint64 result;
+            if (length > 0 && length < 20 && try_digits_to_unsigned(str, end, result)) {
+                return result;
+            }
+
             // check that all chars are digits
             for (auto iter = str; iter < end; ++iter) {
                 if (not std::isdigit(*iter)) {
@@ -0,0 +1,109 @@
+#ifndef CACHELOT_CGROUP_MEMORY_H_INCLUDED
+#define CACHELOT_CGROUP_MEMORY_H_INCLUDED
+
+//
+//  (C) Copyright 2015 Iurii Krasnoshchok
+//
+//  Distributed under the terms of Simplified BSD License
+//  see LICENSE file
+
+
+#ifndef CACHELOT_COMMON_H_INCLUDED
+#  include <cachelot/common.h>
+#endif
+
+#include <fstream>
+#include <sstream>
+
+namespace cachelot {
+
+    /// @ingroup settings
+    /// @{
+
+    /// Memory controller of the cgroup v2 (see Documentation/admin-guide/cgroup-v2.rst of the Linux kernel)
+    namespace cgroup {
+
+        /// memory state of the cgroup
+        struct memory_state {
+            size_t max = 0;        // `memory.max`, 0 if there is no limit
+            size_t current = 0;    // `memory.current`
+            double pressure = 0.0; // `some avg10` of the `memory.pressure`: percent of time tasks were stalled on memory
+        };
+
+        /// parse content of the `memory.max` or `memory.current`, "max" (no limit) is 0
+        inline size_t parse_memory_value(const string & content) noexcept {
+            return static_cast<size_t>(std::strtoull(content.c_str(), nullptr, 10));
+        }
+
+        /// parse `some avg10=<percent>` of the `memory.pressure`
+        inline double parse_memory_pressure(const string & content) noexcept {
+            static const char avg10[] = "some avg10=";
+            const auto pos = content.find(avg10);
+            if (pos == string::npos) {
+                return 0.0;
+            }
+            return std::strtod(content.c_str() + pos + sizeof(avg10) - 1, nullptr);
+        }
+
+        /// directory of the cgroup of this process or empty string if cgroup v2 isn't mounted
+        inline string self_path() {
+            // the only line of the cgroup v2 is "0::<path>"
+            std::ifstream proc_cgroup("/proc/self/cgroup");
+            string line;
+            while (std::getline(proc_cgroup, line)) {
+                if (line.compare(0, 3, "0::") == 0) {
+                    const string path = "/sys/fs/cgroup" + line.substr(3);
+                    if (std::ifstream(path + "/memory.current").good()) {
+                        return path;
+                    }
+                }
+            }
+            return string();
+        }
+
+        /// read memory state of the cgroup in the `path` directory, return `false` if memory controller isn't available
+        inline bool read_memory_state(const string & path, memory_state & state) {
+            auto read_file = [&](const char * name) -> string {
+                std::ifstream file(path + "/" + name);
+                std::stringstream content;
+                content << file.rdbuf();
+                return content.str();
+            };
+            const string current = read_file("memory.current");
+            if (current.empty()) {
+                return false;
+            }
+            state.current = parse_memory_value(current);
+            state.max = parse_memory_value(read_file("memory.max"));
+            state.pressure = parse_memory_pressure(read_file("memory.pressure"));
+            return true;
+        }
+
+        /**
+         * Choose the cache memory limit which keeps the cgroup away from OOM-kill
+         *
+         * Cache is trimmed by `step` bytes once the cgroup is close to its `memory.max` or stalls on memory,
+         * it grows back up to `max_limit` when there is enough free memory and no pressure
+         * @return new memory limit within [`min_limit`, `max_limit`]
+         */
+        inline size_t adjust_memory_limit(size_t limit, size_t min_limit, size_t max_limit, size_t step, const memory_state & state) noexcept {
+            // percent of time tasks may stall on memory before cache is trimmed
+            constexpr double high_pressure = 10.0;
+            const bool has_max = state.max > 0;
+            const size_t headroom = has_max && state.max > state.current ? state.max - state.current : 0;
+            if ((has_max && headroom < state.max / 10) || state.pressure > high_pressure) {
+                return limit >= min_limit + step ? limit - step : min_limit;
+            }
+            if (limit < max_limit && state.pressure < 1.0 && (not has_max || headroom > state.max / 4 + step)) {
+                return std::min(limit + step, max_limit);
+            }
+            return limit;
+        }
+
+    } // namespace cgroup
+
+    /// @}
+
+} // namespace cachelot
+
+#endif // CACHELOT_CGROUP_MEMORY_H_INCLUDED
@@ -11,6 +11,7 @@
 #ifndef CACHELOT_SLICE_H_INCLUDED
 #  include <cachelot/slice.h>
 #endif
+#include <functional> // function
 
 namespace cachelot {
 
@@ -37,10 +38,24 @@ namespace cachelot {
      * write:
      *  - get write pointer in buffer by calling begin_write() and
      *  - mark N slice as filled by calling confirm_write()
+     *
+     * Large pieces of the external memory (such as item values) may be referenced rather than copied into the buffer
+     * (see `write_reference()`), such buffer is read by pieces:
+     *  - get the buffered data interleaved with the referenced pieces with for_each_unread_piece()
+     *  - mark N bytes of the pieces as read by calling confirm_read_pieces()
      */
     class io_buffer {
-        enum class internal_write_savepoint_type : size_t { __DUMMY__ };
+        struct internal_write_savepoint_type { size_t position; size_t num_references; };
         enum class internal_read_savepoint_type : size_t { __DUMMY__ };
+        // piece of the external memory read in place (see `write_reference()`)
+        struct reference {
+            size_t position;                 // buffered data preceding the piece
+            slice data;                      // non-read part of the piece
+            const void * owner;              // owner of the memory, `nullptr` once the data is copied (see `detach_references()`)
+            std::function<void ()> release;  // called once the memory is no longer referenced
+            std::unique_ptr<char[]> copy;    // copy of the data made by `detach_references()`
+            size_t copy_length;
+        };
     public:
         typedef internal_write_savepoint_type write_savepoint_type;
         typedef internal_read_savepoint_type read_savepoint_type;
@@ -56,7 +71,9 @@ namespace cachelot {
 
         // dtor
         ~io_buffer() {
+            release_references(m_references.begin(), m_references.end());
             std::free(m_data);
+            total_memory() -= m_capacity;
         }
         // disallowed copy and aasignment
         io_buffer(const io_buffer & ) = delete;
@@ -65,6 +82,9 @@ namespace cachelot {
         /// total buffer capacity
         size_t capacity() const noexcept { return m_capacity; }
 
+        /// amount of memory allocated by all the buffers
+        static size_t total_capacity() noexcept { return total_memory(); }
+
         /// number of written slice
         size_t size() const noexcept { return m_write_pos; }
 
@@ -133,14 +153,105 @@ namespace cachelot {
 
         /// get the write position to be able to discard one or more writes in the future
         write_savepoint_type write_savepoint() noexcept {
-            return static_cast<write_savepoint_type>(m_write_pos);
+            return write_savepoint_type{m_write_pos, m_references.size()};
         }
 
-        /// forget written data above the `savepoint`
+        /// forget written data and references above the `savepoint`
         void rollback_write_transaction(const write_savepoint_type savepoint) noexcept {
-            debug_assert(static_cast<size_t>(savepoint) <= m_write_pos);
-            m_write_pos = static_cast<size_t>(savepoint);
+            debug_assert(savepoint.position <= m_write_pos);
+            m_write_pos = savepoint.position;
             debug_assert(m_write_pos >= m_read_pos);
+            debug_assert(savepoint.num_references <= m_references.size());
+            release_references(m_references.begin() + savepoint.num_references, m_references.end());
+        }
+
+        /// reference pieces of the external memory of `threshold` bytes and more rather than copy them (0 - disable)
+        void set_reference_threshold(const size_t threshold) noexcept { m_reference_threshold = threshold; }
+
+        /// check whether piece of the external memory of `length` bytes is better referenced than copied
+        bool prefers_reference(const size_t length) const noexcept {
+            return m_reference_threshold > 0 && length >= m_reference_threshold;
+        }
+
+        /// insert `data` of the `owner` at the write position without copying, `release()` is called once it's read or discarded
+        /// @warning `data` must stay valid until then, unless its owner calls `detach_references()` before reusing the memory
+        void write_reference(const slice data, const void * owner, std::function<void ()> release) {
+            if (data.empty()) {
+                release();
+                return;
+            }
+            if (m_references.empty()) {
+                referencing_buffers().push_back(this);
+            }
+            m_references.emplace_back(reference{m_write_pos, data, owner, std::move(release), nullptr, 0});
+            m_referenced += data.length();
+        }
+
+        /// check whether there are non-read references (see `write_reference()`)
+        bool has_references() const noexcept { return not m_references.empty(); }
+
+        /// number of non-read bytes including the referenced pieces
+        size_t non_read_pieces() const noexcept { return non_read() + m_referenced; }
+
+        /// memory of the `owner` is about to be reused, every buffer copies the data it still references
+        static void detach_references(const void * owner) {
+            for (auto buffer : referencing_buffers()) {
+                for (auto & ref : buffer->m_references) {
+                    if (ref.owner == owner) {
+                        ref.copy.reset(new char[ref.data.length()]);
+                        std::memcpy(ref.copy.get(), ref.data.begin(), ref.data.length());
+                        ref.copy_length = ref.data.length(); // referenced length stays the same
+                        total_memory() += ref.copy_length;
+                        ref.data = slice(ref.copy.get(), ref.copy_length);
+                        ref.owner = nullptr;
+                        ref.release = nullptr;
+                    }
+                }
+            }
+        }
+
+        /// call `fun(slice)` for every non-read piece of data in order: the buffered data interleaved with the references,
+        /// iteration stops once `fun` returns `false`
+        template <typename Fun>
+        void for_each_unread_piece(Fun fun) const {
+            size_t pos = m_read_pos;
+            for (const auto & ref : m_references) {
+                debug_assert(ref.position >= pos);
+                if (ref.position > pos) {
+                    if (not fun(slice(m_data + pos, ref.position - pos))) {
+                        return;
+                    }
+                    pos = ref.position;
+                }
+                if (not fun(ref.data)) {
+                    return;
+                }
+            }
+            if (m_write_pos > pos) {
+                fun(slice(m_data + pos, m_write_pos - pos));
+            }
+        }
+
+        /// mark `num_bytes` of the pieces as read (see `for_each_unread_piece()`)
+        void confirm_read_pieces(size_t num_bytes) noexcept {
+            while (not m_references.empty()) {
+                auto & ref = m_references.front();
+                const size_t buffered = std::min(num_bytes, ref.position - m_read_pos);
+                m_read_pos += buffered;
+                num_bytes -= buffered;
+                if (num_bytes == 0) {
+                    return;
+                }
+                const size_t referenced = std::min(num_bytes, ref.data.length());
+                ref.data = slice(ref.data.begin() + referenced, ref.data.length() - referenced);
+                m_referenced -= referenced;
+                num_bytes -= referenced;
+                if (not ref.data.empty()) {
+                    return;
+                }
+                release_references(m_references.begin(), m_references.begin() + 1);
+            }
+            confirm_read(num_bytes);
         }
 
         /// number of unfilled slice in buffer
@@ -150,6 +261,7 @@ namespace cachelot {
         void reset() noexcept {
             m_read_pos = 0u;
             m_write_pos = 0u;
+            release_references(m_references.begin(), m_references.end());
         }
 
         /// ensure that buffer is capable to store `at_least` slice; resize if neccessary
@@ -163,6 +275,7 @@ namespace cachelot {
             if (new_capacity - size() >= at_least) {
                 m_data = reinterpret_cast<char *>(std::realloc(m_data, new_capacity));
                 if (m_data != nullptr) {
+                    total_memory() += new_capacity - m_capacity;
                     m_capacity = new_capacity;
                 } else {
                     throw std::bad_alloc();
@@ -174,6 +287,9 @@ namespace cachelot {
 
         // discard all data that was read
         void compact() noexcept {
+            for (auto & ref : m_references) {
+                ref.position -= m_read_pos;
+            }
             if (m_read_pos == m_write_pos) {
                 m_read_pos = 0u;
                 m_write_pos = 0u;
@@ -187,6 +303,39 @@ namespace cachelot {
         }
 
     private:
+        static size_t & total_memory() noexcept {
+            static size_t allocated = 0;
+            return allocated;
+        }
+
+        // buffers having non-read references (see `detach_references()`)
+        static std::vector<io_buffer *> & referencing_buffers() noexcept {
+            static std::vector<io_buffer *> buffers;
+            return buffers;
+        }
+
+        void release_references(std::vector<reference>::iterator first, std::vector<reference>::iterator last) noexcept {
+            if (first == last) {
+                return;
+            }
+            for (auto ref = first; ref != last; ++ref) {
+                if (ref->release) {
+                    ref->release();
+                }
+                total_memory() -= ref->copy_length;
+                m_referenced -= ref->data.length();
+            }
+            m_references.erase(first, last);
+            if (m_references.empty()) {
+                auto & buffers = referencing_buffers();
+                const auto registered = std::find(buffers.begin(), buffers.end(), this);
+                debug_assert(registered != buffers.end());
+                if (registered != buffers.end()) {
+                    buffers.erase(registered);
+                }
+            }
+        }
+
         size_t capacity_advice(size_t at_least) const noexcept {
             const size_t grow_factor = std::max(at_least, std::max(capacity() * 2 - available(), default_min_buffer_size));
             return std::min(capacity() + grow_factor, m_max_size);
@@ -198,6 +347,9 @@ namespace cachelot {
         size_t m_capacity = 0;
         size_t m_read_pos = 0;
         size_t m_write_pos = 0;
+        size_t m_reference_threshold = 0;
+        std::vector<reference> m_references;
+        size_t m_referenced = 0; // non-read bytes of the references
     };
 
     /// @}
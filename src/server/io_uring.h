@@ -0,0 +1,293 @@
+#ifndef CACHELOT_NET_IO_URING_H_INCLUDED
+#define CACHELOT_NET_IO_URING_H_INCLUDED
+
+//
+//  (C) Copyright 2015 Iurii Krasnoshchok
+//
+//  Distributed under the terms of Simplified BSD License
+//  see LICENSE file
+
+
+#ifndef CACHELOT_COMMON_H_INCLUDED
+#  include <cachelot/common.h>
+#endif
+#ifndef CACHELOT_SLICE_H_INCLUDED
+#  include <cachelot/slice.h>
+#endif
+#ifndef CACHELOT_ERROR_H_INCLUDED
+#  include <cachelot/error.h>
+#endif
+
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <cerrno>
+
+namespace cachelot { namespace net {
+
+    /**
+     * io_uring instance: submission and completion queues shared with the kernel
+     * and the ring of buffers provided to the kernel for the receive operations
+     *
+     * The kernel is called directly by the `io_uring_setup()`, `io_uring_enter()` and `io_uring_register()` system calls,
+     * there is no dependency on the liburing. Requests are queued by `get_sqe()` and go to the kernel all at once by `submit()`
+     *
+     * @ingroup net
+     */
+    class io_uring_queue {
+    public:
+        /// group of the provided buffers (see `IOSQE_BUFFER_SELECT`)
+        static constexpr uint16 buffer_group = 0;
+
+        /// constructor
+        /// @p num_entries - size of the submission queue, completion queue is twice larger
+        /// @p num_buffers - number of buffers provided to receive into (must be power of 2)
+        /// @p buffer_size - size of each buffer
+        /// @throw system_error if io_uring isn't supported or isn't allowed
+        explicit io_uring_queue(unsigned num_entries, unsigned num_buffers, unsigned buffer_size);
+
+        /// destructor, pending requests are canceled
+        ~io_uring_queue();
+
+        io_uring_queue(const io_uring_queue &) = delete;
+        io_uring_queue & operator= (const io_uring_queue &) = delete;
+
+        /// file descriptor of the ring, it's readable while there are completions
+        int native_handle() const noexcept { return m_fd; }
+
+        /// get the blank request to fill in, requests queued so far are submitted if queue is full
+        /// @throw system_error if the kernel doesn't take the queued requests
+        io_uring_sqe * get_sqe();
+
+        /// pass all the queued requests to the kernel with the single system call
+        void submit();
+
+        /// check whether there are completions to handle
+        bool has_completions() const noexcept {
+            return *m_cq_head != __atomic_load_n(m_cq_tail, __ATOMIC_ACQUIRE);
+        }
+
+        /// call `fun(const io_uring_cqe &)` for every completion, return number of completions
+        template <typename Fun>
+        unsigned for_each_cqe(Fun fun);
+
+        /// data received into the provided buffer `buffer_id`
+        slice buffer(uint16 buffer_id, size_t length) const noexcept {
+            debug_assert(buffer_id < m_num_buffers && length <= m_buffer_size);
+            return slice(m_buffers + static_cast<size_t>(buffer_id) * m_buffer_size, length);
+        }
+
+        /// give the buffer `buffer_id` back to the kernel once its data is consumed
+        void recycle_buffer(uint16 buffer_id) noexcept;
+
+    private:
+        int enter(unsigned to_submit, unsigned min_complete, unsigned flags) noexcept {
+            return static_cast<int>(::syscall(__NR_io_uring_enter, m_fd, to_submit, min_complete, flags, nullptr, 0));
+        }
+
+        [[noreturn]] static void throw_system_error(const char * what) {
+            throw system_error(error_code(errno, boost::system::system_category()), what);
+        }
+
+        void unmap() noexcept;
+
+    private:
+        int m_fd = -1;
+        // rings shared with the kernel
+        void * m_rings = MAP_FAILED;
+        size_t m_rings_size = 0;
+        io_uring_sqe * m_sqes = reinterpret_cast<io_uring_sqe *>(MAP_FAILED);
+        size_t m_sqes_size = 0;
+        // submission queue
+        unsigned * m_sq_head = nullptr;
+        unsigned * m_sq_tail = nullptr;
+        unsigned * m_sq_flags = nullptr;
+        unsigned * m_sq_array = nullptr;
+        unsigned m_sq_mask = 0;
+        unsigned m_sq_entries = 0;
+        unsigned m_sq_queued = 0;    // local tail, published to the kernel by `submit()`
+        unsigned m_sq_submitted = 0; // tail as known to the kernel
+        // completion queue
+        unsigned * m_cq_head = nullptr;
+        unsigned * m_cq_tail = nullptr;
+        unsigned m_cq_mask = 0;
+        io_uring_cqe * m_cqes = nullptr;
+        // provided buffers
+        io_uring_buf * m_buf_ring = reinterpret_cast<io_uring_buf *>(MAP_FAILED);
+        size_t m_buf_ring_size = 0;
+        uint16 m_buf_tail = 0;
+        char * m_buffers = nullptr;
+        unsigned m_num_buffers = 0;
+        unsigned m_buffer_size = 0;
+    };
+
+
+    inline io_uring_queue::io_uring_queue(unsigned num_entries, unsigned num_buffers, unsigned buffer_size)
+        : m_num_buffers(num_buffers)
+        , m_buffer_size(buffer_size) {
+        debug_assert(ispow2(num_buffers) && num_buffers <= 32768);
+        io_uring_params params;
+        std::memset(&params, 0, sizeof(params));
+        m_fd = static_cast<int>(::syscall(__NR_io_uring_setup, num_entries, &params));
+        if (m_fd < 0) {
+            throw_system_error("io_uring_setup");
+        }
+        try {
+            if ((params.features & IORING_FEAT_SINGLE_MMAP) == 0 || (params.features & IORING_FEAT_NODROP) == 0) {
+                errno = ENOSYS;
+                throw_system_error("io_uring features");
+            }
+            // both queues are mapped at once
+            m_rings_size = std::max(params.sq_off.array + params.sq_entries * sizeof(unsigned),
+                                    params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe));
+            m_rings = ::mmap(nullptr, m_rings_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_fd, IORING_OFF_SQ_RING);
+            if (m_rings == MAP_FAILED) {
+                throw_system_error("mmap");
+            }
+            m_sqes_size = params.sq_entries * sizeof(io_uring_sqe);
+            m_sqes = reinterpret_cast<io_uring_sqe *>(::mmap(nullptr, m_sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_fd, IORING_OFF_SQES));
+            if (m_sqes == MAP_FAILED) {
+                throw_system_error("mmap");
+            }
+            char * const rings = reinterpret_cast<char *>(m_rings);
+            m_sq_head = reinterpret_cast<unsigned *>(rings + params.sq_off.head);
+            m_sq_tail = reinterpret_cast<unsigned *>(rings + params.sq_off.tail);
+            m_sq_flags = reinterpret_cast<unsigned *>(rings + params.sq_off.flags);
+            m_sq_array = reinterpret_cast<unsigned *>(rings + params.sq_off.array);
+            m_sq_mask = *reinterpret_cast<unsigned *>(rings + params.sq_off.ring_mask);
+            m_sq_entries = params.sq_entries;
+            m_sq_queued = m_sq_submitted = *m_sq_tail;
+            m_cq_head = reinterpret_cast<unsigned *>(rings + params.cq_off.head);
+            m_cq_tail = reinterpret_cast<unsigned *>(rings + params.cq_off.tail);
+            m_cq_mask = *reinterpret_cast<unsigned *>(rings + params.cq_off.ring_mask);
+            m_cqes = reinterpret_cast<io_uring_cqe *>(rings + params.cq_off.cqes);
+            // provided buffers ring, its tail overlaps the `resv` field of the first entry
+            m_buf_ring_size = num_buffers * sizeof(io_uring_buf) + num_buffers * static_cast<size_t>(buffer_size);
+            void * buf_ring = ::mmap(nullptr, m_buf_ring_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+            if (buf_ring == MAP_FAILED) {
+                throw_system_error("mmap");
+            }
+            m_buf_ring = reinterpret_cast<io_uring_buf *>(buf_ring);
+            m_buffers = reinterpret_cast<char *>(buf_ring) + num_buffers * sizeof(io_uring_buf);
+            io_uring_buf_reg reg;
+            std::memset(&reg, 0, sizeof(reg));
+            reg.ring_addr = reinterpret_cast<uint64>(m_buf_ring);
+            reg.ring_entries = num_buffers;
+            reg.bgid = buffer_group;
+            if (::syscall(__NR_io_uring_register, m_fd, IORING_REGISTER_PBUF_RING, &reg, 1) < 0) {
+                throw_system_error("io_uring_register");
+            }
+            for (unsigned buffer_id = 0; buffer_id < num_buffers; ++buffer_id) {
+                recycle_buffer(static_cast<uint16>(buffer_id));
+            }
+        } catch (...) {
+            unmap();
+            ::close(m_fd);
+            throw;
+        }
+    }
+
+
+    inline io_uring_queue::~io_uring_queue() {
+        unmap();
+        ::close(m_fd);
+    }
+
+
+    inline void io_uring_queue::unmap() noexcept {
+        if (m_buf_ring != MAP_FAILED) {
+            ::munmap(m_buf_ring, m_buf_ring_size);
+        }
+        if (m_sqes != MAP_FAILED) {
+            ::munmap(m_sqes, m_sqes_size);
+        }
+        if (m_rings != MAP_FAILED) {
+            ::munmap(m_rings, m_rings_size);
+        }
+    }
+
+
+    inline io_uring_sqe * io_uring_queue::get_sqe() {
+        if (m_sq_queued - __atomic_load_n(m_sq_head, __ATOMIC_ACQUIRE) == m_sq_entries) {
+            submit();
+            // kernel didn't take any request as the completion queue is full, there is no room for the new one
+            if (m_sq_queued - __atomic_load_n(m_sq_head, __ATOMIC_ACQUIRE) == m_sq_entries) {
+                throw system_error(error_code(EBUSY, boost::system::system_category()), "io_uring submission queue is full");
+            }
+        }
+        const unsigned index = m_sq_queued & m_sq_mask;
+        io_uring_sqe * sqe = &m_sqes[index];
+        std::memset(sqe, 0, sizeof(io_uring_sqe));
+        m_sq_array[index] = index;
+        m_sq_queued += 1;
+        return sqe;
+    }
+
+
+    inline void io_uring_queue::submit() {
+        __atomic_store_n(m_sq_tail, m_sq_queued, __ATOMIC_RELEASE);
+        while (m_sq_submitted != m_sq_queued) {
+            const int submitted = enter(m_sq_queued - m_sq_submitted, 0, 0);
+            if (submitted < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                if (errno == EAGAIN || errno == EBUSY) {
+                    // completion queue is full, the rest is submitted once completions are consumed
+                    return;
+                }
+                throw_system_error("io_uring_enter");
+            }
+            m_sq_submitted += static_cast<unsigned>(submitted);
+        }
+    }
+
+
+    template <typename Fun>
+    inline unsigned io_uring_queue::for_each_cqe(Fun fun) {
+        unsigned num_completions = 0;
+        do {
+            unsigned head = *m_cq_head;
+            const unsigned tail = __atomic_load_n(m_cq_tail, __ATOMIC_ACQUIRE);
+            for (; head != tail; ++head, ++num_completions) {
+                const io_uring_cqe cqe = m_cqes[head & m_cq_mask];
+                // slot is free before `fun` may cause more completions
+                __atomic_store_n(m_cq_head, head + 1, __ATOMIC_RELEASE);
+                fun(cqe);
+            }
+            // completions which didn't fit into the queue are kept by the kernel until asked
+            if ((__atomic_load_n(m_sq_flags, __ATOMIC_ACQUIRE) & IORING_SQ_CQ_OVERFLOW) == 0) {
+                break;
+            }
+            enter(0, 0, IORING_ENTER_GETEVENTS);
+        } while (true);
+        return num_completions;
+    }
+
+
+    /// check whether the kernel supports io_uring with the provided buffers ring and whether it's allowed to use
+    inline bool io_uring_supported() noexcept {
+        try {
+            io_uring_queue probe(2, 1, 64);
+            return true;
+        } catch (const std::exception &) {
+            return false;
+        }
+    }
+
+
+    inline void io_uring_queue::recycle_buffer(uint16 buffer_id) noexcept {
+        io_uring_buf & entry = m_buf_ring[m_buf_tail & (m_num_buffers - 1)];
+        entry.addr = reinterpret_cast<uint64>(m_buffers + static_cast<size_t>(buffer_id) * m_buffer_size);
+        entry.len = m_buffer_size;
+        entry.bid = buffer_id;
+        m_buf_tail += 1;
+        // the tail of the ring is the `resv` of the first entry (see `struct io_uring_buf_ring`)
+        __atomic_store_n(&m_buf_ring[0].resv, m_buf_tail, __ATOMIC_RELEASE);
+    }
+
+}} // namespace cachelot::net
+
+
+#endif // CACHELOT_NET_IO_URING_H_INCLUDED
@@ -8,11 +8,16 @@
 #include <cachelot/cache.h>
 #include <cachelot/stats.h>
 #include <server/settings.h>
+#include <server/cgroup_memory.h>
 #include <server/memcached/conversation.h>
 
 #include <iostream>
+#include <random>
 #include <boost/program_options.hpp>
 #include <signal.h>
+#if defined(__linux__)
+#  include <sched.h>
+#endif
 
 using std::cerr;
 using std::endl;
@@ -81,15 +86,46 @@ namespace  {
                                                     "it will be taken from -p or -U or default."
                                                     "You may specify multiple addresses separated by comma or by using -l multiple times")
             ("daemon,d",    po::bool_switch(),      "Run as a daemon")
+            ("io-uring",    po::bool_switch(),      "Serve TCP and unix socket connections by the io_uring instead of epoll (Linux only), "
+                                                    "values are always copied through the connection buffers in this mode")
+            ("max-reqs-per-event,R", po::value<size_t>(), "Maximum number of pipelined requests handled at once, the rest is handled "
+                                                    "after the other connections get their turn (default: 20)")
+            ("busy-poll",   po::value<unsigned>(),  "Keep polling for events <arg> microseconds after the last one before blocking in wait of the next one, "
+                                                    "trades CPU for latency (default: 0 - always block)")
+            ("reactor-cpu", po::value<unsigned>(),  "Bind the reactor thread to the CPU core <arg>, use it with --busy-poll and the core isolated "
+                                                    "from the other processes (Linux only, not bound by default)")
+            ("send-watermark", po::value<size_t>(), "Stop receiving requests of the connection while <arg> bytes of its replies are not sent yet, "
+                                                    "resume once the half of them is sent (default: 4194304, 0 to never stop)")
+            ("zero-copy",   po::value<size_t>(),    "Send and receive values of <arg> bytes and more right from / into the item memory instead of copying them "
+                                                    "through the connection buffers (default: 16384, 0 to disable)")
             ("oum-error,M", po::bool_switch(),      "Return error when out of memory (rather than removing items)")
             ("no-cas,C",    po::bool_switch(),      "Disable use of CAS (memory economy)")
             ("memory,m",    po::value<po_memory>(), "Max memory to use for items storage in megabytes (must be power of 2)"
                                                     "You may specify one of the suffixes (K,M,G) to use different units"
                                                     "For instance, -m 8G means 8 Gigabytes of RAM")
+            ("max-memory",  po::value<po_memory>(), "Memory to reserve in megabytes (must be power of 2), cache may grow up to this amount at runtime "
+                                                    "by the 'cache_memory' command or in the --memory-auto mode (default equals to -m)")
+            ("memory-budget", po::bool_switch(),    "Count the hash table and the connection buffers against the -m limit too, "
+                                                    "items storage gives memory pages away when they grow (by default -m limits the items storage only)")
+            ("memory-auto", po::bool_switch(),      "Watch memory.max and memory.pressure of the cgroup v2 and trim the cache before the container "
+                                                    "runs out of memory, cache grows back up to --max-memory once memory is available")
             ("page,P",      po::value<po_memory>(), "Page size in megabytes (must be power of 2)"
                                                     "You may specify one of the suffixes (K,M,G) to use different units"
                                                     "Lesser pages leads to more accurate evictions, although page size affects maximal item size")
+            ("pool",        po::value<std::vector<po_memory>>(),
+                                                    "Add memory pool with the pages of given size (must be power of 2), may be used multiple times "
+                                                    "Items are placed in the pool with the smallest suitable page, each pool evicts independently "
+                                                    "and memory moves to the pool under the highest eviction pressure. For instance, -P 64K --pool 1M --pool 16M")
+            ("max-item-size,I", po::value<po_memory>(), "Maximal value size in megabytes (must be power of 2, default 1M) "
+                                                    "You may specify one of the suffixes (K,M,G) to use different units "
+                                                    "Values larger than page are stored as the chain of page-sized chunks")
             ("hashtable,H", po::value<size_t>(),    "Initial hash table size (default 64K)")
+            ("extend-headroom", po::value<unsigned>(), "Reserve given percent of the value size when append / prepend re-allocates the item "
+                                                    "so the subsequent appends / prepends happen in place (default 0)")
+            ("compress",    po::value<size_t>(),    "Compress values of <arg> bytes and more (disabled by default)")
+            ("dedup",       po::value<size_t>(),    "Store byte-identical values of <arg> bytes and more only once (disabled by default)")
+            ("defrag",      po::value<size_t>(),    "Move up to <arg> bytes of items out of sparsely used pages on every store "
+                                                    "once free memory is fragmented (disabled by default)")
         ;
 
         po::variables_map varmap;
@@ -118,28 +154,108 @@ namespace  {
             settings.net.unix_socket = varmap["socket"].as<string>();
         }
         settings.net.has_unix_socket = not settings.net.unix_socket.empty();
+        settings.net.io_uring = varmap["io-uring"].as<bool>();
+        if (varmap.count("max-reqs-per-event")) {
+            settings.net.max_requests_per_event = varmap["max-reqs-per-event"].as<size_t>();
+        }
+        if (varmap.count("busy-poll")) {
+            settings.net.busy_poll_us = varmap["busy-poll"].as<unsigned>();
+        }
+        if (varmap.count("reactor-cpu")) {
+            settings.net.reactor_cpu = static_cast<int>(varmap["reactor-cpu"].as<unsigned>());
+        }
+        if (settings.net.max_requests_per_event == 0) {
+            throw invalid_configuration("the argument for option '--max-reqs-per-event' must be positive");
+        }
+        if (varmap.count("send-watermark")) {
+            settings.net.snd_high_watermark = varmap["send-watermark"].as<size_t>();
+        }
+        if (varmap.count("zero-copy")) {
+            settings.net.zero_copy_threshold = varmap["zero-copy"].as<size_t>();
+        }
         settings.cache.has_evictions = not varmap["oum-error"].as<bool>();
         settings.cache.has_CAS = not varmap["no-cas"].as<bool>();
         if (varmap.count("memory")) {
             settings.cache.memory_limit = varmap["memory"].as<po_memory>().n;
         }
+        if (varmap.count("max-memory")) {
+            settings.cache.max_memory_limit = varmap["max-memory"].as<po_memory>().n;
+        }
+        settings.cache.max_memory_limit = std::max(settings.cache.max_memory_limit, settings.cache.memory_limit);
+        settings.cache.auto_memory_limit = varmap["memory-auto"].as<bool>();
+        settings.cache.memory_budget = varmap["memory-budget"].as<bool>();
         if (varmap.count("page")) {
             settings.cache.page_size = varmap["page"].as<po_memory>().n;
         }
+        if (varmap.count("pool")) {
+            for (auto pool_page_size : varmap["pool"].as<std::vector<po_memory>>()) {
+                settings.cache.pool_page_sizes.push_back(pool_page_size.n);
+            }
+        }
         if (settings.cache.memory_limit < (settings.cache.page_size * 4)) {
             throw invalid_configuration("There must be at least 4 pages");
         }
         if (settings.cache.page_size > 2*Gigabyte) {
             throw invalid_configuration("Maximal page size is 2Gb");
         }
+        if (varmap.count("max-item-size")) {
+            settings.cache.max_item_size = varmap["max-item-size"].as<po_memory>().n;
+        }
+        if (settings.cache.max_item_size > settings.cache.memory_limit / 2) {
+            throw invalid_configuration("Maximal item size must not exceed half of the memory");
+        }
         if (varmap.count("hashtable")) {
             settings.cache.initial_hash_table_size = varmap["hashtable"].as<size_t>();
         }
         if (not ispow2(settings.cache.initial_hash_table_size)) {
             throw invalid_configuration("the argument for option '--hashtable' must be power of 2");
         }
+        if (varmap.count("extend-headroom")) {
+            settings.cache.extend_headroom = varmap["extend-headroom"].as<unsigned>();
+        }
+        if (varmap.count("compress")) {
+            settings.cache.compression_threshold = varmap["compress"].as<size_t>();
+        }
+        if (varmap.count("dedup")) {
+            settings.cache.dedup_threshold = varmap["dedup"].as<size_t>();
+        }
+        if (varmap.count("defrag")) {
+            settings.cache.compaction_budget = varmap["defrag"].as<size_t>();
+        }
         return EXIT_SUCCESS;
     }
+
+
+    /// Run the reactor loop, spinning for `spin_period` after every handled event before blocking in wait of the next one
+    void run_busy_polling(net::io_service & reactor, const std::chrono::microseconds spin_period) {
+        typedef std::chrono::steady_clock clock;
+        auto last_event = clock::now();
+        while (not reactor.stopped()) {
+            if (reactor.poll() > 0) {
+                last_event = clock::now();
+            } else if (clock::now() - last_event >= spin_period) {
+                reactor.run_one();
+                last_event = clock::now();
+            }
+        }
+    }
+
+
+    /// Bind the calling thread to the CPU core
+    bool bind_to_cpu(const int cpu) noexcept {
+#if defined(__linux__)
+        if (cpu < 0 || cpu >= CPU_SETSIZE) {
+            return false;
+        }
+        cpu_set_t cpus;
+        CPU_ZERO(&cpus);
+        CPU_SET(cpu, &cpus);
+        return ::sched_setaffinity(0, sizeof(cpus), &cpus) == 0;
+#else
+        (void)cpu;
+        return false;
+#endif
+    }
 }
 
 
@@ -148,27 +264,73 @@ int main(int argc, char * argv[]) {
         if (parse_cmdline(argc, argv) != 0) {
             return EXIT_FAILURE;
         }
+        // Random hash seed makes hash values unpredictable to resist hash-flooding
+        std::random_device entropy;
+        cache::SeedHashFunction((static_cast<uint64>(entropy()) << 32) | entropy());
         // Cache Service
-        auto the_cache = cache::Cache::Create(settings.cache.memory_limit,
-                                              settings.cache.page_size,
+        std::vector<size_t> page_sizes(1, settings.cache.page_size);
+        page_sizes.insert(page_sizes.end(), settings.cache.pool_page_sizes.begin(), settings.cache.pool_page_sizes.end());
+        auto the_cache = cache::Cache::Create(settings.cache.max_memory_limit,
+                                              page_sizes,
                                               settings.cache.initial_hash_table_size,
-                                              settings.cache.has_evictions);
+                                              settings.cache.has_evictions,
+                                              settings.cache.has_CAS);
+        if (settings.cache.memory_budget) {
+            the_cache.set_memory_budget(settings.cache.memory_limit);
+        } else if (settings.cache.memory_limit < settings.cache.max_memory_limit) {
+            the_cache.resize(settings.cache.memory_limit);
+        }
+        the_cache.set_extend_headroom(settings.cache.extend_headroom);
+        the_cache.set_compression_threshold(settings.cache.compression_threshold);
+        the_cache.set_dedup_threshold(settings.cache.dedup_threshold);
+        the_cache.set_compaction_budget(settings.cache.compaction_budget);
         // Reactor service
         net::io_service reactor;
 
+        // io_uring
+#if defined(CACHELOT_HAVE_IO_URING)
+        if (settings.net.io_uring && not net::io_uring_supported()) {
+            cerr << "Warning: io_uring is not available, --io-uring is ignored" << endl;
+            settings.net.io_uring = false;
+        }
+        std::unique_ptr<memcached::UringTcpServer> memcached_uring_tcp = nullptr;
+        std::unique_ptr<memcached::UringUnixSocketServer> memcached_uring_unix_socket = nullptr;
+#else
+        if (settings.net.io_uring) {
+            cerr << "Warning: cachelot is built without io_uring, --io-uring is ignored" << endl;
+            settings.net.io_uring = false;
+        }
+#endif
+
         // TCP
         std::unique_ptr<memcached::TcpServer> memcached_tcp = nullptr;
         if (settings.net.has_TCP) {
-            memcached_tcp.reset(new memcached::TcpServer(the_cache, reactor));
             net::tcp::endpoint bind_addr(net::ip::address_v4::any(), settings.net.TCP_port);
-            memcached_tcp->start(bind_addr);
+#if defined(CACHELOT_HAVE_IO_URING)
+            if (settings.net.io_uring) {
+                memcached_uring_tcp.reset(new memcached::UringTcpServer(the_cache, reactor));
+                memcached_uring_tcp->start(bind_addr);
+            } else
+#endif
+            {
+                memcached_tcp.reset(new memcached::TcpServer(the_cache, reactor));
+                memcached_tcp->start(bind_addr);
+            }
         }
 
         // Unix local socket
         std::unique_ptr<memcached::UnixSocketServer> memcached_unix_socket = nullptr;
         if (settings.net.has_unix_socket) {
-            memcached_unix_socket.reset(new memcached::UnixSocketServer(the_cache, reactor));
-            memcached_unix_socket->start(settings.net.unix_socket);
+#if defined(CACHELOT_HAVE_IO_URING)
+            if (settings.net.io_uring) {
+                memcached_uring_unix_socket.reset(new memcached::UringUnixSocketServer(the_cache, reactor));
+                memcached_uring_unix_socket->start(settings.net.unix_socket);
+            } else
+#endif
+            {
+                memcached_unix_socket.reset(new memcached::UnixSocketServer(the_cache, reactor));
+                memcached_unix_socket->start(settings.net.unix_socket);
+            }
         }
 
         // UDP
@@ -179,6 +341,44 @@ int main(int argc, char * argv[]) {
             memcached_udp->start(bind_addr);
         }
 
+        // Follow the cgroup memory state
+        net::asio::steady_timer memory_timer(reactor);
+        std::function<void (const error_code &)> on_memory_timer;
+        const string cgroup_path = settings.cache.auto_memory_limit ? cgroup::self_path() : string();
+        if (settings.cache.auto_memory_limit && cgroup_path.empty()) {
+            cerr << "Warning: cgroup v2 memory controller is not available, --memory-auto is ignored" << endl;
+        }
+        if (not cgroup_path.empty()) {
+            // cache is trimmed or grown by 1/16 of the reserved memory at once, memory is added or removed by the biggest pages
+            const size_t biggest_page = *std::max_element(page_sizes.begin(), page_sizes.end());
+            const size_t step = std::max<size_t>(biggest_page, settings.cache.max_memory_limit / 16);
+            const size_t min_limit = std::max<size_t>(biggest_page * 4, settings.cache.max_memory_limit / 16);
+            on_memory_timer = [&, biggest_page, step, min_limit](const error_code & error) {
+                if (error) { return; }
+                cgroup::memory_state state;
+                if (cgroup::read_memory_state(cgroup_path, state)) {
+                    const size_t limit = settings.cache.memory_budget ? the_cache.memory_budget() : the_cache.memory_limit();
+                    size_t new_limit = cgroup::adjust_memory_limit(limit, min_limit, settings.cache.max_memory_limit, step, state);
+                    new_limit -= new_limit % biggest_page;
+                    if (new_limit != limit) {
+                        try {
+                            if (settings.cache.memory_budget) {
+                                the_cache.set_memory_budget(new_limit);
+                            } else {
+                                the_cache.resize(new_limit);
+                            }
+                        } catch (const std::invalid_argument &) {
+                            // stay within the allowed limits
+                        }
+                    }
+                }
+                memory_timer.expires_from_now(std::chrono::seconds(1));
+                memory_timer.async_wait(on_memory_timer);
+            };
+            memory_timer.expires_from_now(std::chrono::seconds(1));
+            memory_timer.async_wait(on_memory_timer);
+        }
+
         // Signal handlers
         boost::asio::signal_set signals(reactor);
         signals.add(SIGTERM);
@@ -187,7 +387,7 @@ int main(int argc, char * argv[]) {
         signals.add(SIGQUIT);
         signals.add(SIGUSR1);
 #endif
-        signals.async_wait([&reactor](const error_code& error, int signal_number) {
+        signals.async_wait([&reactor, &memory_timer](const error_code& error, int signal_number) {
             if (error) { return; }
             switch (signal_number) {
 #if !defined(_MSC_VER)
@@ -196,14 +396,22 @@ int main(int argc, char * argv[]) {
                 break;
 #endif
             default:
+                memory_timer.cancel();
                 reactor.stop();
             }
         });
 
         // Run reactor loop
-        do {
-            reactor.run();
-        } while (not reactor.stopped());
+        if (settings.net.reactor_cpu >= 0 && not bind_to_cpu(settings.net.reactor_cpu)) {
+            cerr << "Warning: failed to bind reactor to the CPU " << settings.net.reactor_cpu << ", --reactor-cpu is ignored" << endl;
+        }
+        if (settings.net.busy_poll_us > 0) {
+            run_busy_polling(reactor, std::chrono::microseconds(settings.net.busy_poll_us));
+        } else {
+            do {
+                reactor.run();
+            } while (not reactor.stopped());
+        }
 
 
         return EXIT_SUCCESS;
@@ -12,6 +12,9 @@
 #include <server/memcached/memcached.h>
 #include <server/socket_stream.h>
 #include <server/socket_datagram.h>
+#if defined(CACHELOT_HAVE_IO_URING)
+#  include <server/socket_uring.h>
+#endif
 
 namespace cachelot {
 
@@ -26,9 +29,19 @@ namespace cachelot {
             typedef net::stream_connection<SocketType, StreamSocketConversation<SocketType>> super;
         public:
             /// constructor
-            explicit StreamSocketConversation(cache::Cache & the_cache, net::io_service & io_svc, const size_t rcvbuf_max, const size_t sndbuf_max)
-                : super(io_svc, rcvbuf_max, sndbuf_max)
-                , cache_api(the_cache) {
+            explicit StreamSocketConversation(cache::Cache & the_cache, net::io_service & io_svc, const size_t rcvbuf_max, const size_t sndbuf_max,
+                                              const size_t zero_copy_threshold, const size_t sndbuf_high_watermark, const size_t max_requests)
+                : super(io_svc, rcvbuf_max, sndbuf_max, zero_copy_threshold, sndbuf_high_watermark)
+                , cache_api(the_cache)
+                , parser_state(zero_copy_threshold)
+                , max_requests_per_turn(max_requests)
+                , max_unsent_replies(sndbuf_high_watermark) {
+            }
+
+            /// destructor
+            ~StreamSocketConversation() {
+                // connection is closed in the middle of the data block
+                abandon_receiving_value(parser_state, cache_api);
             }
 
 
@@ -36,13 +49,30 @@ namespace cachelot {
             /// @copydoc stream_connection::handle_data()
             net::ConversationReply handle_data(io_buffer & recv_buf, io_buffer & send_buf) noexcept override {
                 try {
-                    return handle_received_data(recv_buf, send_buf, cache_api);
+                    const auto reply = handle_received_requests(recv_buf, send_buf, cache_api, parser_state, max_requests_per_turn, max_unsent_replies);
+                    cache_api.fit_memory_budget(io_buffer::total_capacity());
+                    return reply;
                 } catch (const std::exception &) {
                     return net::CLOSE_IMMEDIATELY;
                 }
             }
+
+            /// @copydoc stream_connection::receive_target()
+            net::asio::mutable_buffer receive_target() noexcept override {
+                char * dest; size_t length;
+                tie(dest, length) = memcached::receive_target(parser_state);
+                return net::asio::buffer(dest, length);
+            }
+
+            /// @copydoc stream_connection::confirm_receive_target()
+            void confirm_receive_target(size_t bytes_received) noexcept override {
+                parser_state.value_received += static_cast<uint32>(bytes_received);
+            }
         private:
             cache::Cache & cache_api;
+            ParserState parser_state;
+            const size_t max_requests_per_turn;
+            const size_t max_unsent_replies;
         };
 
 
@@ -55,10 +85,17 @@ namespace cachelot {
             explicit StreamServer(cache::Cache & the_cache, net::io_service & io_svc)
                 : super(io_svc)
                 , cache_api(the_cache) {
+                // large values are sent right from the item memory (see `write_value()`) and received right into it (see `receive_target()`),
+                // copy them out or stop receiving before the memory is reused
+                cache_api.on_pin_revoked = [](cache::ConstItemPtr item) {
+                    io_buffer::detach_references(item);
+                    forget_receiving_item(item);
+                };
             }
 
             std::shared_ptr<ConversationType> new_conversation() {
-                auto new_conv = new ConversationType(cache_api, super::get_io_service(), settings.net.max_rcv_buffer_size, settings.net.max_snd_buffer_size);
+                auto new_conv = new ConversationType(cache_api, super::get_io_service(), settings.net.max_rcv_buffer_size, settings.net.max_snd_buffer_size,
+                                                     settings.net.zero_copy_threshold, settings.net.snd_high_watermark, settings.net.max_requests_per_event);
                 return std::shared_ptr<ConversationType>(new_conv);
             }
 
@@ -72,6 +109,64 @@ namespace cachelot {
         typedef StreamServer<net::local::stream_protocol::socket> UnixSocketServer;
 
 
+#if defined(CACHELOT_HAVE_IO_URING)
+        /// Memcached stream socket protocol conversation served by the io_uring
+        class UringStreamConversation : public net::uring_stream_connection {
+            typedef net::uring_stream_connection super;
+        public:
+            /// constructor
+            explicit UringStreamConversation(cache::Cache & the_cache, const size_t rcvbuf_max, const size_t sndbuf_max,
+                                             const size_t high_watermark, const size_t max_requests)
+                : super(rcvbuf_max, sndbuf_max, high_watermark)
+                , cache_api(the_cache)
+                , max_requests_per_turn(max_requests)
+                , max_unsent_replies(high_watermark) {
+            }
+
+        protected:
+            /// @copydoc uring_stream_connection::handle_data()
+            net::ConversationReply handle_data(io_buffer & recv_buf, io_buffer & send_buf) noexcept override {
+                try {
+                    const auto reply = handle_received_requests(recv_buf, send_buf, cache_api, parser_state, max_requests_per_turn, max_unsent_replies);
+                    cache_api.fit_memory_budget(io_buffer::total_capacity());
+                    return reply;
+                } catch (const std::exception &) {
+                    return net::CLOSE_IMMEDIATELY;
+                }
+            }
+        private:
+            cache::Cache & cache_api;
+            ParserState parser_state;
+            const size_t max_requests_per_turn;
+            const size_t max_unsent_replies;
+        };
+
+
+        /// Implementation of the memcached stream server over the io_uring
+        template <class Protocol>
+        class UringStreamServer : public net::uring_stream_server<Protocol, UringStreamServer<Protocol>> {
+            typedef net::uring_stream_server<Protocol, UringStreamServer<Protocol>> super;
+        public:
+            explicit UringStreamServer(cache::Cache & the_cache, net::io_service & io_svc)
+                : super(io_svc)
+                , cache_api(the_cache) {
+            }
+
+            UringStreamConversation * new_conversation() {
+                return new UringStreamConversation(cache_api, settings.net.max_rcv_buffer_size, settings.net.max_snd_buffer_size,
+                                                   settings.net.snd_high_watermark, settings.net.max_requests_per_event);
+            }
+
+        private:
+            cache::Cache & cache_api;
+        };
+
+
+        typedef UringStreamServer<net::tcp> UringTcpServer;
+        typedef UringStreamServer<net::local::stream_protocol> UringUnixSocketServer;
+#endif
+
+
         class UdpServer : public net::datagram_server<net::udp::socket> {
             typedef net::datagram_server<net::udp::socket> super;
         public:
@@ -85,7 +180,11 @@ namespace cachelot {
                 auto w_savepoint = send_buf.write_savepoint();
                 try {
                     handle_udp_frame_header(recv_buf, send_buf);
-                    return handle_received_data(recv_buf, send_buf, cache_api);
+                    // every datagram is a complete request
+                    ParserState state;
+                    const auto reply = handle_received_data(recv_buf, send_buf, cache_api, state);
+                    cache_api.fit_memory_budget(io_buffer::total_capacity());
+                    return reply;
                 } catch (const std::exception & exc) {
                     send_buf.rollback_write_transaction(w_savepoint);
                     return net::READ_MORE;
@@ -21,6 +21,8 @@ namespace cachelot {
         x(value_crlf_expected, "Invalid value: \\r\\n expected")                \
         x(key_expected, "Invalid request: key expected")                        \
         x(noreply_expected, "Invalid request: expected noreply")                \
+        x(meta_flag, "Invalid request: unsupported meta flag")                  \
+        x(key_base64, "Invalid request: key is not a valid base64")             \
         x(udp_header_size, "UDP packet header is too small")                    \
         x(udp_proto_reserverd, "UDP reserved flag expected to be zero")
 
@@ -7,18 +7,143 @@ namespace cachelot {
 
     namespace memcached {
 
-        net::ConversationReply handle_received_data(io_buffer & recv_buf, io_buffer & send_buf, cache::Cache & cache_api) {
+        namespace {
+            // parsers receiving the data block into the item (see `forget_receiving_item()`)
+            std::vector<ParserState *> & receiving_parsers() noexcept {
+                static std::vector<ParserState *> parsers;
+                return parsers;
+            }
+
+            void stop_receiving(ParserState & state) noexcept {
+                auto & parsers = receiving_parsers();
+                const auto registered = std::find(parsers.begin(), parsers.end(), &state);
+                debug_assert(registered != parsers.end());
+                if (registered != parsers.end()) {
+                    parsers.erase(registered);
+                }
+            }
+        }
+
+
+        void start_receiving_value(ParserState & state, cache::ItemPtr item, uint32 value_length, cache::Cache & cache_api) {
+            debug_assert(not state.receiving_value());
+            debug_assert(value_length > 0);
+            debug_only(const bool pinned = ) cache_api.pin(item);
+            debug_assert(pinned);
+            try {
+                receiving_parsers().push_back(&state);
+            } catch (...) {
+                cache_api.unpin(item);
+                throw;
+            }
+            state.item = item;
+            state.value_length = value_length;
+            state.value_received = 0;
+        }
+
+
+        tuple<char *, size_t> receive_target(const ParserState & state) noexcept {
+            char * dest = nullptr;
+            size_t length = 0;
+            if (state.item != nullptr && state.value_received < state.value_length) {
+                // value of the chained item is received chunk by chunk
+                size_t offset = 0;
+                state.item->for_each_value_chunk([&](slice chunk) {
+                    if (dest == nullptr && state.value_received < offset + chunk.length()) {
+                        const size_t received_in_chunk = state.value_received - offset;
+                        dest = const_cast<char *>(chunk.begin()) + received_in_chunk;
+                        length = chunk.length() - received_in_chunk;
+                    }
+                    offset += chunk.length();
+                });
+            }
+            return make_tuple(dest, length);
+        }
+
+
+        cache::ItemPtr finish_receiving_value(ParserState & state, cache::Cache & cache_api) noexcept {
+            debug_assert(state.receiving_value());
+            debug_assert(state.value_received == state.value_length);
+            auto item = state.item;
+            if (item != nullptr) {
+                stop_receiving(state);
+                cache_api.unpin(item);
+                state.item = nullptr;
+            }
+            return item;
+        }
+
+
+        void abandon_receiving_value(ParserState & state, cache::Cache & cache_api) noexcept {
+            if (state.item != nullptr) {
+                auto item = state.item;
+                stop_receiving(state);
+                cache_api.unpin(item);
+                state.item = nullptr;
+                cache_api.destroy_item(item);
+            }
+        }
+
+
+        void forget_receiving_item(cache::ConstItemPtr item) noexcept {
+            auto & parsers = receiving_parsers();
+            for (auto parser = parsers.begin(); parser != parsers.end(); ++parser) {
+                if ((*parser)->item == item) {
+                    // the rest of data block is discarded, request fails once it's received
+                    (*parser)->item = nullptr;
+                    parsers.erase(parser);
+                    return;
+                }
+            }
+        }
+
+
+        net::ConversationReply handle_received_data(io_buffer & recv_buf, io_buffer & send_buf, cache::Cache & cache_api, ParserState & state) {
+            if (state.receiving_value()) {
+                // data block may begin with any byte
+                return ascii::handle_received_data(recv_buf, send_buf, cache_api, state);
+            }
             if (recv_buf.non_read() > 0) {
                 if (static_cast<decltype(binary::MAGIC)>(*recv_buf.begin_read()) == binary::MAGIC) {
                     return binary::handle_received_data(recv_buf, send_buf, cache_api);
                 } else {
-                    return ascii::handle_received_data(recv_buf, send_buf, cache_api);
+                    return ascii::handle_received_data(recv_buf, send_buf, cache_api, state);
                 }
             } else {
                 return net::ConversationReply::READ_MORE;
             }
         }
 
+
+        net::ConversationReply handle_received_requests(io_buffer & recv_buf, io_buffer & send_buf, cache::Cache & cache_api, ParserState & state,
+                                                        size_t max_requests, size_t max_unsent) {
+            debug_assert(max_requests > 0);
+            net::ConversationReply result = net::READ_MORE;
+            for (size_t num_requests = 0; recv_buf.non_read() > 0; ++num_requests) {
+                if (num_requests == max_requests) {
+                    // let the other connections proceed
+                    return net::SEND_REPLY_AND_CONTINUE;
+                }
+                if (max_unsent > 0 && send_buf.non_read_pieces() >= max_unsent) {
+                    // the rest is handled once replies are sent
+                    return net::SEND_REPLY_AND_CONTINUE;
+                }
+                const size_t non_read_before = recv_buf.non_read();
+                const auto reply = handle_received_data(recv_buf, send_buf, cache_api, state);
+                if (reply == net::CLOSE_IMMEDIATELY || reply == net::SEND_REPLY_AND_CLOSE) {
+                    return reply;
+                }
+                if (reply == net::SEND_REPLY_AND_READ) {
+                    result = reply;
+                }
+                if (recv_buf.non_read() == non_read_before) {
+                    // request is incomplete, wait for the rest of it
+                    break;
+                }
+            }
+            return result;
+        }
+
     } // namespace memcached
 
 } // namespace cachelot
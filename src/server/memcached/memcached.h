@@ -38,8 +38,81 @@ namespace cachelot {
     /// @{
     namespace memcached {
 
+        /**
+         * Per-connection progress of the incomplete ascii request
+         *
+         * Request is parsed only once no matter how many reads it takes to receive it,
+         * subsequent reads only check whether the remaining bytes have arrived
+         * (binary request has the fixed size header, its length is known immediately).
+         * Large data block of the storage command is received right into the new item
+         * instead of the receive buffer (see `receive_target()`)
+         */
+        struct ParserState {
+            /// constructor
+            /// @p value_threshold - data blocks of this size and more are received right into the item (0 - always buffer)
+            explicit ParserState(size_t value_threshold = 0) noexcept : value_receive_threshold(value_threshold) {}
+
+            Command command = Command::UNDEFINED; ///< command of the request which header is parsed
+            size_t header_length = 0;  ///< length of the `<command line>\r\n`
+            size_t request_length = 0; ///< length of the request including data block, 0 until header is parsed
+            size_t scanned = 0;        ///< bytes already searched for the end of the header
+            size_t value_receive_threshold;  ///< see constructor
+            bool buffer_value = false;       ///< data block is received into the buffer even if it's large (item can't be created ahead)
+            cache::ItemPtr item = nullptr;   ///< new item receiving the data block, `nullptr` if it was evicted before it was stored
+            uint32 value_length = 0;         ///< length of the data block being received into the `item`, 0 if there is none
+            uint32 value_received = 0;       ///< bytes of the data block already received
+            cache::timestamp_type cas_unique = 0; ///< `cas` argument of the request being received
+            bool noreply = false;                 ///< `noreply` argument of the request being received
+
+            /// check whether data block of the request is being received into the item
+            bool receiving_value() const noexcept { return value_length > 0; }
+
+            /// prepare to parse the next request
+            void reset() noexcept {
+                debug_assert(item == nullptr);
+                *this = ParserState(value_receive_threshold);
+            }
+        };
+
+        /// Start receiving the data block of the request into the new `item`, item is pinned until it's stored
+        void start_receiving_value(ParserState & state, cache::ItemPtr item, uint32 value_length, cache::Cache & cache_api);
+
+        /// Memory to receive the next bytes of the data block into, none if there is nothing to receive or item was evicted
+        tuple<char *, size_t> receive_target(const ParserState & state) noexcept;
+
+        /// Take the item which data block is completely received, `nullptr` if it was evicted meanwhile
+        cache::ItemPtr finish_receiving_value(ParserState & state, cache::Cache & cache_api) noexcept;
+
+        /// Free the item which data block is being received (such as when connection is closed)
+        void abandon_receiving_value(ParserState & state, cache::Cache & cache_api) noexcept;
+
+        /// Stop receiving into the memory of the `item` which is evicted (see `cache::Cache::on_pin_revoked`)
+        void forget_receiving_item(cache::ConstItemPtr item) noexcept;
+
         /// Process every received packet
-        net::ConversationReply handle_received_data(io_buffer & recv_buf, io_buffer & send_buf, cache::Cache & cache_api);
+        net::ConversationReply handle_received_data(io_buffer & recv_buf, io_buffer & send_buf, cache::Cache & cache_api, ParserState & state);
+
+        /// Process pipelined requests one after another until the incomplete one, but no more than `max_requests` at once
+        /// and no more once `max_unsent` bytes of replies are waiting in the `send_buf` (0 - no limit)
+        /// @return SEND_REPLY_AND_CONTINUE if processing stopped on the limit and there is more data in the `recv_buf`
+        net::ConversationReply handle_received_requests(io_buffer & recv_buf, io_buffer & send_buf, cache::Cache & cache_api, ParserState & state,
+                                                        size_t max_requests, size_t max_unsent);
+
+        /// Write value of the `item` into the `send_buf`, values which the buffer prefers to reference are sent from the pinned item memory
+        inline void write_value(io_buffer & send_buf, cache::ConstItemPtr item, cache::Cache & cache_api) {
+            const bool by_reference = send_buf.prefers_reference(item->value_length());
+            item->for_each_value_chunk([&](slice chunk) {
+                if (chunk.empty()) {
+                    return;
+                }
+                if (by_reference && cache_api.pin(item)) {
+                    send_buf.write_reference(chunk, item, [&cache_api, item]() { cache_api.unpin(item); });
+                } else {
+                    std::memcpy(send_buf.begin_write(chunk.length()), chunk.begin(), chunk.length());
+                    send_buf.confirm_write(chunk.length());
+                }
+            });
+        }
 
         /// validate the Item key
         inline void validate_key(const slice key) {
@@ -15,6 +15,15 @@ namespace cachelot {
         constexpr slice VERSION =  slice::from_literal("VERSION");
         constexpr slice OK =  slice::from_literal("OK");
 
+        /// Meta protocol response codes
+        constexpr slice META_VALUE = slice::from_literal("VA"); ///< hit, value follows
+        constexpr slice META_HIT = slice::from_literal("HD"); ///< hit / success without the value
+        constexpr slice META_MISS = slice::from_literal("EN"); ///< `mg` miss
+        constexpr slice META_NOT_STORED = slice::from_literal("NS");
+        constexpr slice META_EXISTS = slice::from_literal("EX"); ///< CAS mismatch
+        constexpr slice META_NOT_FOUND = slice::from_literal("NF");
+        constexpr slice META_NOOP = slice::from_literal("MN");
+
         /// Memcached error types
 #if defined(_MSC_VER)
 #undef ERROR // ERROR defined with GDI declarations
@@ -29,6 +38,29 @@ namespace cachelot {
         /// Handle on of the: `add`, `set`, `replace`, `cas`, `append`, `prepend` commands
         net::ConversationReply handle_storage_command(Command cmd, slice args, io_buffer & recv_buf, io_buffer & send_buf, cache::Cache & cache_api);
 
+        /// Arguments of the storage command: `<key> <flags> <exptime> <bytes> [<cas unique>] [noreply]`
+        struct StorageArgs {
+            slice key;
+            cache::opaque_flags_type flags;
+            cache::seconds keep_alive_duration;
+            uint32 datalen;
+            cache::timestamp_type cas_unique;
+            bool noreply;
+        };
+
+        /// Parse arguments of the storage command
+        StorageArgs parse_storage_args(Command cmd, slice args);
+
+        /// Store the `new_item` according to the storage command and write the response
+        net::ConversationReply store_new_item(Command cmd, cache::ItemPtr new_item, cache::timestamp_type cas_unique, bool noreply, io_buffer & send_buf, cache::Cache & cache_api);
+
+        /// Create the item ahead of the large data block of the incomplete storage command, so the rest of block is received right into it
+        /// @return `false` if data block is to be received into the `recv_buf`
+        bool start_receiving_value(io_buffer & recv_buf, ParserState & state, cache::Cache & cache_api);
+
+        /// Move received bytes of the data block into the item, store the item once the whole block is received
+        net::ConversationReply handle_value_receipt(io_buffer & recv_buf, io_buffer & send_buf, cache::Cache & cache_api, ParserState & state);
+
         /// Handle the `delete` command
         net::ConversationReply handle_delete_command(Command cmd, slice args, io_buffer & send_buf, cache::Cache & cache_api);
 
@@ -47,6 +79,27 @@ namespace cachelot {
         /// Handle the `flush` command
         net::ConversationReply handle_flush_all_command(Command cmd, slice args, io_buffer & send_buf, cache::Cache & cache_api);
 
+        /// Handle memory limit change: `cache_memory <megabytes>`
+        net::ConversationReply handle_cache_memory_command(Command cmd, slice args, io_buffer & send_buf, cache::Cache & cache_api);
+
+        /// Handle the meta commands: `mg`, `ms`, `md`, `ma`, `mn`
+        net::ConversationReply handle_meta_command(Command cmd, slice args, io_buffer & recv_buf, io_buffer & send_buf, cache::Cache & cache_api);
+
+        /// Status of the request parsing
+        enum class ParseStatus {
+            COMPLETE,   ///< whole request is received, its header is read from the buffer
+            INCOMPLETE  ///< wait for the rest of the request
+        };
+
+        /// Determine command and length of the request on the beginning of the `recv_buf`
+        ParseStatus parse_request(io_buffer & recv_buf, ParserState & state, slice & header);
+
+        /// Length of the `<data block>\r\n` following the header of the storage command, 0 for other commands
+        size_t data_block_length(Command cmd, slice args);
+
+        /// Read `<data block>\r\n` of the storage command
+        slice read_data_block(io_buffer & recv_buf, uint32 datalen);
+
         /// Write one of the cache responses if `noreply` is not specified, none otherwise
         net::ConversationReply reply_with_response(io_buffer & send_buf, Response response, bool noreply);
 
@@ -124,22 +177,29 @@ namespace cachelot {
         #undef __DO_SERIALIZE_INTEGER_ASCII
 
 
-        net::ConversationReply handle_received_data(io_buffer & recv_buf, io_buffer & send_buf, cache::Cache & cache_api) noexcept {
-            auto r_savepoint = recv_buf.read_savepoint();
+        net::ConversationReply handle_received_data(io_buffer & recv_buf, io_buffer & send_buf, cache::Cache & cache_api, ParserState & state) noexcept {
             auto w_savepoint = send_buf.write_savepoint();
             try {
+                if (state.receiving_value()) {
+                    return handle_value_receipt(recv_buf, send_buf, cache_api, state);
+                }
                 // read command header <cmd> <key> <args...>\r\n
-                slice header = recv_buf.try_read_until(CRLF);
-                if (header.empty()) {
-                    throw system_error(error::incomplete_request);
+                slice header;
+                if (parse_request(recv_buf, state, header) == ParseStatus::INCOMPLETE) {
+                    if (state.request_length == 0) {
+                        return net::READ_MORE;
+                    }
+                    if (start_receiving_value(recv_buf, state, cache_api)) {
+                        return handle_value_receipt(recv_buf, send_buf, cache_api, state);
+                    }
+                    // help buffer to grow up to the necessary size
+                    recv_buf.ensure_capacity(state.request_length - recv_buf.non_read());
+                    return net::READ_MORE;
                 }
-                debug_assert(header.endswith(CRLF));
-                header = header.rtrim_n(CRLF.length());
-
-                // determine command name
+                const auto command = state.command;
+                state.reset();
                 slice ascii_cmd, args;
                 tie(ascii_cmd, args) = header.split(SPACE);
-                auto command = parse_command_name(ascii_cmd);
                 net::ConversationReply reply;
                 // process the command
                 switch (command) {
@@ -180,6 +240,17 @@ namespace cachelot {
                 case Command::FLUSH_ALL:
                     reply = handle_flush_all_command(command, args, send_buf, cache_api);
                     break;
+                case Command::CACHE_MEMORY:
+                    reply = handle_cache_memory_command(command, args, send_buf, cache_api);
+                    break;
+                // meta commands
+                case Command::META_GET:
+                case Command::META_SET:
+                case Command::META_DELETE:
+                case Command::META_ARITHMETIC:
+                case Command::META_NOOP:
+                    reply = handle_meta_command(command, args, recv_buf, send_buf, cache_api);
+                    break;
                 // terminate session
                 case Command::QUIT:
                     return net::CLOSE_IMMEDIATELY;
@@ -190,6 +261,8 @@ namespace cachelot {
                 return reply;
 
             } catch (const system_error & syserr) {
+                abandon_receiving_value(state, cache_api);
+                state.reset();
                 // discard any written data to write error message instead
                 send_buf.rollback_write_transaction(w_savepoint);
                 const auto errmsg = syserr.code().message();
@@ -202,10 +275,6 @@ namespace cachelot {
                 } else {
                     // server error
                     switch (syserr.code().value()) {
-                    case error::incomplete_request:
-                        // rollback read position, start over when more data will come
-                        recv_buf.rollback_read_transaction(r_savepoint);
-                        return net::READ_MORE;
                     case error::broken_request:
                         // ill-formed packet, swallow recv_buf data
                         recv_buf.read_all();
@@ -223,6 +292,8 @@ namespace cachelot {
                     }
                 }
             } catch (const std::exception & exc) {
+                abandon_receiving_value(state, cache_api);
+                state.reset();
                 // discard any written data to write error message instead
                 send_buf.rollback_write_transaction(w_savepoint);
                 send_buf << SERVER_ERROR << SPACE << exc.what() << CRLF;
@@ -231,6 +302,66 @@ namespace cachelot {
         }
 
 
+        inline ParseStatus parse_request(io_buffer & recv_buf, ParserState & state, slice & header) {
+            if (state.request_length == 0) {
+                // search for the end of the header, skip the part searched on the previous reads (except of the possible '\r')
+                const slice received(recv_buf.begin_read(), recv_buf.non_read());
+                const size_t search_from = state.scanned > 0 ? state.scanned - 1 : 0;
+                const slice found = slice(received.begin() + search_from, received.length() - search_from).search(CRLF);
+                if (not found) {
+                    state.scanned = received.length();
+                    return ParseStatus::INCOMPLETE;
+                }
+                state.header_length = static_cast<size_t>(found.end() - received.begin());
+                slice ascii_cmd, args;
+                tie(ascii_cmd, args) = slice(received.begin(), state.header_length - CRLF.length()).split(SPACE);
+                state.command = parse_command_name(ascii_cmd);
+                try {
+                    state.request_length = state.header_length + data_block_length(state.command, args);
+                } catch (...) {
+                    // ill-formed header is skipped, so the next request is parsed right after it
+                    recv_buf.confirm_read(state.header_length);
+                    throw;
+                }
+            }
+            if (recv_buf.non_read() < state.request_length) {
+                return ParseStatus::INCOMPLETE;
+            }
+            header = recv_buf.confirm_read(state.header_length).rtrim_n(CRLF.length());
+            return ParseStatus::COMPLETE;
+        }
+
+
+        inline size_t data_block_length(Command cmd, slice args) {
+            // position of the <datalen> argument: `<cmd> <key> <flags> <exptime> <datalen>` or `ms <key> <datalen>`
+            size_t datalen_pos;
+            switch (cmd) {
+            case Command::ADD:
+            case Command::APPEND:
+            case Command::CAS:
+            case Command::PREPEND:
+            case Command::REPLACE:
+            case Command::SET:
+                datalen_pos = 3;
+                break;
+            case Command::META_SET:
+                datalen_pos = 1;
+                break;
+            default:
+                return 0;
+            }
+            slice parsed;
+            for (size_t pos = 0; pos <= datalen_pos; ++pos) {
+                tie(parsed, args) = args.split(SPACE);
+            }
+            uint32 datalen = str_to_int<uint32>(parsed.begin(), parsed.end());
+            if (datalen > settings.cache.max_item_size) {
+                throw system_error(error::value_length);
+            }
+            return datalen + CRLF.length();
+        }
+
+
         inline tuple<slice, slice> parse_key(slice args) {
             slice key;
             tie(key, args) = args.split(SPACE);
@@ -251,15 +382,29 @@ namespace cachelot {
 
 
         inline net::ConversationReply handle_retrieval_command(Command cmd, slice args, io_buffer & send_buf, cache::Cache & cache_api) {
+            // keys of the multi-get are hashed in batches
+            constexpr size_t batch_size = 16;
+            slice keys[batch_size];
+            cache::hash_type hashes[batch_size];
+            cache::HashFunction calc_hashes;
             do {
-                slice key; tie(key, args) = parse_key(args);
-                auto i = cache_api.do_get(key, calc_hash(key));
-                if (i) {
-                    send_buf << VALUE << SPACE << i->key() << SPACE << i->opaque_flags() << SPACE << static_cast<uint32>(i->value().length());
-                    if (cmd == Command::GETS) {
-                        send_buf << SPACE << i->timestamp();
+                size_t num_keys = 0;
+                do {
+                    tie(keys[num_keys], args) = parse_key(args);
+                    num_keys += 1;
+                } while (num_keys < batch_size && not args.empty());
+                calc_hashes(keys, hashes, num_keys);
+                for (size_t n = 0; n < num_keys; ++n) {
+                    auto i = cache_api.do_get(keys[n], hashes[n]);
+                    if (i) {
+                        send_buf << VALUE << SPACE << i->key() << SPACE << i->opaque_flags() << SPACE << i->value_length();
+                        if (cmd == Command::GETS) {
+                            send_buf << SPACE << i->timestamp();
+                        }
+                        send_buf << CRLF;
+                        write_value(send_buf, i, cache_api);
+                        send_buf << CRLF;
                     }
-                    send_buf << CRLF << i->value() << CRLF;
                 }
             } while (not args.empty());
             send_buf << END << CRLF;
@@ -268,39 +413,59 @@ namespace cachelot {
 
 
         inline net::ConversationReply handle_storage_command(Command cmd, slice args, io_buffer & recv_buf, io_buffer & send_buf, cache::Cache & cache_api) {
-            slice key; tie(key, args) = parse_key(args);
+            const StorageArgs sa = parse_storage_args(cmd, args);
+            const slice value = read_data_block(recv_buf, sa.datalen);
+            const auto hash = calc_hash(sa.key);
+            // try to overwrite existing item if the new value fits into its memory
+            cache::ItemPtr existing_item = nullptr;
+            switch (cmd) {
+            case Command::SET:
+                existing_item = cache_api.do_set_inplace(sa.key, hash, value.length(), sa.flags, sa.keep_alive_duration);
+                break;
+            case Command::REPLACE:
+                existing_item = cache_api.do_replace_inplace(sa.key, hash, value.length(), sa.flags, sa.keep_alive_duration);
+                break;
+            case Command::CAS:
+                existing_item = cache_api.do_cas_inplace(sa.key, hash, value.length(), sa.flags, sa.keep_alive_duration, sa.cas_unique);
+                break;
+            default:
+                break;
+            }
+            if (existing_item != nullptr) {
+                existing_item->assign_value(value);
+                return reply_with_response(send_buf, Response::STORED, sa.noreply);
+            }
+            // create new item and execute the cache API
+            auto new_item = cache_api.create_item(sa.key, hash, value.length(), sa.flags, sa.keep_alive_duration);
+            new_item->assign_value(value);
+            return store_new_item(cmd, new_item, sa.cas_unique, sa.noreply, send_buf, cache_api);
+        }
+
+
+        inline StorageArgs parse_storage_args(Command cmd, slice args) {
+            StorageArgs sa;
+            tie(sa.key, args) = parse_key(args);
             slice parsed;
             tie(parsed, args) = args.split(SPACE);
-            cache::opaque_flags_type flags = str_to_int<cache::opaque_flags_type>(parsed.begin(), parsed.end());
+            sa.flags = str_to_int<cache::opaque_flags_type>(parsed.begin(), parsed.end());
             tie(parsed, args) = args.split(SPACE);
-            auto keep_alive_duration = cache::seconds(str_to_int<cache::seconds::rep>(parsed.begin(), parsed.end()));
+            sa.keep_alive_duration = cache::seconds(str_to_int<cache::seconds::rep>(parsed.begin(), parsed.end()));
             tie(parsed, args) = args.split(SPACE);
-            uint32 datalen = str_to_int<uint32>(parsed.begin(), parsed.end());
-            if (datalen > settings.cache.page_size) {
+            sa.datalen = str_to_int<uint32>(parsed.begin(), parsed.end());
+            if (sa.datalen > settings.cache.max_item_size) {
                 throw system_error(error::value_length);
             }
-            cache::timestamp_type cas_unique = 0;
+            sa.cas_unique = 0;
             if (cmd == Command::CAS) {
                 tie(parsed, args) = args.split(SPACE);
-                cas_unique = str_to_int<cache::timestamp_type>(parsed.begin(), parsed.end());
-            }
-            bool noreply = maybe_noreply(args);
-            // read <value>\r\n
-            if (recv_buf.non_read() < datalen + CRLF.length()) {
-                // help buffer to grow up to the necessary size
-                recv_buf.ensure_capacity(datalen + CRLF.length() - recv_buf.non_read());
-                throw system_error(error::incomplete_request);
-            }
-            auto value = slice(recv_buf.begin_read(), datalen + CRLF.length());
-            if (value.endswith(CRLF)) {
-                value = value.rtrim_n(CRLF.length()); // strip trailing \r\n
-                recv_buf.confirm_read(datalen + CRLF.length());
-            } else {
-                throw system_error(error::value_crlf_expected);
+                sa.cas_unique = str_to_int<cache::timestamp_type>(parsed.begin(), parsed.end());
             }
-            // create new item and execute the cache API
-            auto new_item = cache_api.create_item(key, calc_hash(key), value.length(), flags, keep_alive_duration);
-            new_item->assign_value(value);
+            sa.noreply = maybe_noreply(args);
+            return sa;
+        }
+
+
+        inline net::ConversationReply store_new_item(Command cmd, cache::ItemPtr new_item, cache::timestamp_type cas_unique, bool noreply, io_buffer & send_buf, cache::Cache & cache_api) {
             try {
                 auto response = Response::NOT_A_RESPONSE;
                 bool found = false; bool stored = false;
@@ -344,6 +509,89 @@ namespace cachelot {
         }
 
 
+        inline bool start_receiving_value(io_buffer & recv_buf, ParserState & state, cache::Cache & cache_api) {
+            const size_t datalen = state.request_length - state.header_length - CRLF.length();
+            if (state.value_receive_threshold == 0 || datalen < state.value_receive_threshold || state.buffer_value) {
+                return false;
+            }
+            switch (state.command) {
+            case Command::ADD:
+            case Command::APPEND:
+            case Command::CAS:
+            case Command::PREPEND:
+            case Command::REPLACE:
+            case Command::SET:
+                break;
+            default:
+                return false;
+            }
+            // existing item is never overwritten in place, as its value would be incomplete until the whole block is received
+            slice ascii_cmd, args;
+            tie(ascii_cmd, args) = slice(recv_buf.begin_read(), state.header_length - CRLF.length()).split(SPACE);
+            cache::ItemPtr new_item = nullptr;
+            try {
+                const StorageArgs sa = parse_storage_args(state.command, args);
+                new_item = cache_api.create_item(sa.key, calc_hash(sa.key), sa.datalen, sa.flags, sa.keep_alive_duration);
+                memcached::start_receiving_value(state, new_item, sa.datalen, cache_api);
+                state.cas_unique = sa.cas_unique;
+                state.noreply = sa.noreply;
+            } catch (const std::exception &) {
+                if (new_item != nullptr) {
+                    cache_api.destroy_item(new_item);
+                }
+                // error is reported once the whole request is received
+                state.buffer_value = true;
+                return false;
+            }
+            recv_buf.confirm_read(state.header_length);
+            return true;
+        }
+
+
+        inline net::ConversationReply handle_value_receipt(io_buffer & recv_buf, io_buffer & send_buf, cache::Cache & cache_api, ParserState & state) {
+            // bytes of the data block which got into the buffer, the rest goes right into the item (see `receive_target()`)
+            const size_t buffered = std::min<size_t>(recv_buf.non_read(), state.value_length - state.value_received);
+            if (buffered > 0) {
+                const slice piece = recv_buf.confirm_read(buffered);
+                if (state.item != nullptr) {
+                    state.item->write_value(state.value_received, piece);
+                }
+                state.value_received += static_cast<uint32>(buffered);
+            }
+            if (state.value_received < state.value_length || recv_buf.non_read() < CRLF.length()) {
+                return net::READ_MORE;
+            }
+            if (slice(recv_buf.begin_read(), CRLF.length()) != CRLF) {
+                throw system_error(error::value_crlf_expected);
+            }
+            recv_buf.confirm_read(CRLF.length());
+            const auto command = state.command;
+            const auto cas_unique = state.cas_unique;
+            const bool noreply = state.noreply;
+            auto new_item = finish_receiving_value(state, cache_api);
+            state.reset();
+            if (new_item == nullptr) {
+                // item was evicted before it was stored
+                throw system_error(error::out_of_memory);
+            }
+            return store_new_item(command, new_item, cas_unique, noreply, send_buf, cache_api);
+        }
+
+
+        inline slice read_data_block(io_buffer & recv_buf, uint32 datalen) {
+            // read <value>\r\n, parse_request() ensures that it's completely received
+            debug_assert(recv_buf.non_read() >= datalen + CRLF.length());
+            auto value = slice(recv_buf.begin_read(), datalen + CRLF.length());
+            if (value.endswith(CRLF)) {
+                value = value.rtrim_n(CRLF.length()); // strip trailing \r\n
+                recv_buf.confirm_read(datalen + CRLF.length());
+            } else {
+                throw system_error(error::value_crlf_expected);
+            }
+            return value;
+        }
+
+
         inline net::ConversationReply handle_delete_command(Command, slice args, io_buffer & send_buf, cache::Cache & cache_api) {
             slice key; tie(key, args) = parse_key(args);
             bool noreply = maybe_noreply(args);
@@ -390,10 +638,22 @@ namespace cachelot {
 
 
         inline net::ConversationReply handle_statistics_command(Command, slice args, io_buffer & send_buf, cache::Cache & cache_api) {
+            if (args == slice::from_literal("pools")) {
+                // memory pools (like 'stats slabs' of memcached)
+                const auto pools = cache_api.pools_info();
+                for (size_t pool_no = 0; pool_no < pools.size(); ++pool_no) {
+                    send_buf << STAT << SPACE << pool_no << ':' << slice::from_literal("page_size") << SPACE << pools[pool_no].page_size << CRLF;
+                    send_buf << STAT << SPACE << pool_no << ':' << slice::from_literal("memory") << SPACE << pools[pool_no].memory << CRLF;
+                    send_buf << STAT << SPACE << pool_no << ':' << slice::from_literal("evicted_pages") << SPACE << pools[pool_no].num_evicted_pages << CRLF;
+                }
+                send_buf << END << CRLF;
+                return net::SEND_REPLY_AND_READ;
+            }
             if (not args.empty()) {
                 throw system_error(error::not_implemented);
             }
             cache_api.publish_stats();
+            STAT_SET(mem.io_buffers_memory, io_buffer::total_capacity());
             #define SERIALIZE_STAT(stat_group, stat_type, stat_name, stat_description) \
                 send_buf << STAT << SPACE << slice::from_literal(CACHELOT_PP_STR(stat_name)) << SPACE << STAT_GET(stat_group, stat_name) << CRLF;
 
@@ -431,6 +691,382 @@ namespace cachelot {
         }
 
 
+        inline net::ConversationReply handle_cache_memory_command(Command, slice args, io_buffer & send_buf, cache::Cache & cache_api) {
+            slice parsed;
+            tie(parsed, args) = args.split(SPACE);
+            if (not args.empty()) {
+                throw system_error(error::crlf_expected);
+            }
+            const auto megabytes = str_to_int<uint64>(parsed.begin(), parsed.end());
+            try {
+                if (cache_api.memory_budget() > 0) {
+                    cache_api.set_memory_budget(megabytes * Megabyte);
+                } else {
+                    cache_api.resize(megabytes * Megabyte);
+                }
+            } catch (const std::invalid_argument & exc) {
+                send_buf << CLIENT_ERROR << SPACE << exc.what() << CRLF;
+                return net::SEND_REPLY_AND_READ;
+            }
+            send_buf << OK << CRLF;
+            return net::SEND_REPLY_AND_READ;
+        }
+
+
+        /// Flags of the meta command (see "Meta Commands" of the memcached protocol description)
+        struct MetaFlags {
+            bool base64_key = false;        // b: key is base64 encoded
+            bool return_cas = false;        // c: return CAS value
+            bool return_flags = false;      // f: return client flags
+            bool return_key = false;        // k: return key
+            bool return_size = false;       // s: return value size
+            bool return_ttl = false;        // t: return remaining TTL (-1 for unlimited)
+            bool return_value = false;      // v: return value
+            bool quiet = false;             // q: suppress the common response (miss for `mg`, success for the rest)
+            slice opaque;                   // O<token>: token to be copied back to the response
+            bool has_compare_cas = false;   // C<cas>: compare CAS value
+            cache::timestamp_type compare_cas = 0;
+            bool has_ttl = false;           // T<seconds>: update TTL
+            cache::seconds ttl = cache::Item::infinite_TTL;
+            cache::opaque_flags_type client_flags = 0; // F<flags>: client flags to store
+            char mode = 0;                  // M<mode>: mode switch of `ms` and `ma`
+            bool autovivify = false;        // N<seconds>: create missing counter with the given TTL
+            cache::seconds autovivify_ttl = cache::Item::infinite_TTL;
+            uint64 initial = 0;             // J<value>: initial value of the created counter
+            uint64 delta = 1;               // D<value>: counter delta
+        };
+
+
+        /// Parse flags of the meta command, every flag is a single character optionally followed by a token
+        inline MetaFlags parse_meta_flags(Command cmd, slice args) {
+            const char * supported;
+            switch (cmd) {
+            case Command::META_GET: supported = "bcfkOqstvT"; break;
+            case Command::META_SET: supported = "bcCFkMOqT"; break;
+            case Command::META_DELETE: supported = "bCkOq"; break;
+            case Command::META_ARITHMETIC: supported = "bcDJkMNOqtTv"; break;
+            default: supported = ""; break;
+            }
+            MetaFlags result;
+            while (not args.empty()) {
+                slice flag;
+                tie(flag, args) = args.split(SPACE);
+                if (flag.empty()) {
+                    continue;
+                }
+                const slice token(flag.begin() + 1, flag.length() - 1);
+                if (flag[0] == '\0' || std::strchr(supported, flag[0]) == nullptr) {
+                    throw system_error(error::meta_flag);
+                }
+                switch (flag[0]) {
+                case 'b': result.base64_key = true; break;
+                case 'c': result.return_cas = true; break;
+                case 'f': result.return_flags = true; break;
+                case 'k': result.return_key = true; break;
+                case 's': result.return_size = true; break;
+                case 't': result.return_ttl = true; break;
+                case 'v': result.return_value = true; break;
+                case 'q': result.quiet = true; break;
+                case 'O': result.opaque = token; break;
+                case 'C':
+                    result.has_compare_cas = true;
+                    result.compare_cas = str_to_int<cache::timestamp_type>(token.begin(), token.end());
+                    break;
+                case 'T':
+                    result.has_ttl = true;
+                    result.ttl = cache::seconds(str_to_int<cache::seconds::rep>(token.begin(), token.end()));
+                    break;
+                case 'F': result.client_flags = str_to_int<cache::opaque_flags_type>(token.begin(), token.end()); break;
+                case 'M':
+                    if (token.length() != 1) {
+                        throw system_error(error::meta_flag);
+                    }
+                    result.mode = token[0];
+                    break;
+                case 'N':
+                    result.autovivify = true;
+                    result.autovivify_ttl = cache::seconds(str_to_int<cache::seconds::rep>(token.begin(), token.end()));
+                    break;
+                case 'J': result.initial = str_to_int<uint64>(token.begin(), token.end()); break;
+                case 'D': result.delta = str_to_int<uint64>(token.begin(), token.end()); break;
+                default:
+                    debug_assert(false);
+                }
+            }
+            return result;
+        }
+
+
+        constexpr char base64_alphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+        /// Decode base64 encoded key into the `dest` buffer of `Item::max_key_length` bytes
+        inline slice decode_base64_key(const slice encoded, char * dest) {
+            if (encoded.length() % 4 != 0) {
+                throw system_error(error::key_base64);
+            }
+            size_t decoded_length = 0;
+            uint32 accumulator = 0;
+            size_t num_bits = 0;
+            for (size_t pos = 0; pos < encoded.length(); ++pos) {
+                const char c = encoded[pos];
+                if (c == '=') {
+                    // padding is allowed only at the end
+                    if (pos + 2 < encoded.length() || (pos + 1 < encoded.length() && encoded[pos + 1] != '=')) {
+                        throw system_error(error::key_base64);
+                    }
+                    break;
+                }
+                const char * sextet = c != '\0' ? std::strchr(base64_alphabet, c) : nullptr;
+                if (sextet == nullptr) {
+                    throw system_error(error::key_base64);
+                }
+                accumulator = (accumulator << 6) | static_cast<uint32>(sextet - base64_alphabet);
+                num_bits += 6;
+                if (num_bits >= 8) {
+                    num_bits -= 8;
+                    if (decoded_length == cache::Item::max_key_length) {
+                        throw system_error(error::key_length);
+                    }
+                    dest[decoded_length++] = static_cast<char>((accumulator >> num_bits) & 0xFF);
+                }
+            }
+            return slice(dest, decoded_length);
+        }
+
+
+        /// Encode `data` as base64 into the `dest` buffer of sufficient size
+        inline slice encode_base64(const slice data, char * dest) noexcept {
+            size_t encoded_length = 0;
+            for (size_t pos = 0; pos < data.length(); pos += 3) {
+                const size_t num_bytes = std::min<size_t>(3, data.length() - pos);
+                uint32 triple = 0;
+                for (size_t i = 0; i < 3; ++i) {
+                    triple = (triple << 8) | (i < num_bytes ? static_cast<uint8>(data[pos + i]) : 0u);
+                }
+                for (size_t i = 0; i < 4; ++i) {
+                    dest[encoded_length++] = i <= num_bytes ? base64_alphabet[(triple >> (18 - 6 * i)) & 0x3F] : '=';
+                }
+            }
+            return slice(dest, encoded_length);
+        }
+
+
+        /// Write return flags of the meta command response, `item` may be `nullptr` on miss
+        inline void write_meta_flags(io_buffer & send_buf, const MetaFlags & mf, const slice key, cache::ConstItemPtr item) {
+            if (mf.opaque) {
+                send_buf << SPACE << 'O' << mf.opaque;
+            }
+            if (mf.return_key) {
+                if (mf.base64_key) {
+                    char encoded[(cache::Item::max_key_length + 2) / 3 * 4];
+                    send_buf << SPACE << 'k' << encode_base64(key, encoded) << SPACE << 'b';
+                } else {
+                    send_buf << SPACE << 'k' << key;
+                }
+            }
+            if (item == nullptr) {
+                return;
+            }
+            if (mf.return_cas) {
+                send_buf << SPACE << 'c' << item->timestamp();
+            }
+            if (mf.return_flags) {
+                send_buf << SPACE << 'f' << item->opaque_flags();
+            }
+            if (mf.return_size) {
+                send_buf << SPACE << 's' << item->value_length();
+            }
+            if (mf.return_ttl) {
+                if (item->expiration_time() == cache::expiration_time_point::max()) {
+                    send_buf << SPACE << 't' << slice::from_literal("-1");
+                } else {
+                    send_buf << SPACE << 't' << static_cast<uint64>(std::max<cache::seconds::rep>(item->ttl().count(), 0));
+                }
+            }
+        }
+
+
+        /// Write meta response `code` and the return flags
+        inline net::ConversationReply reply_with_meta_response(io_buffer & send_buf, const slice code, const MetaFlags & mf, const slice key, cache::ConstItemPtr item = nullptr) {
+            send_buf << code;
+            write_meta_flags(send_buf, mf, key, item);
+            send_buf << CRLF;
+            return net::SEND_REPLY_AND_READ;
+        }
+
+
+        inline net::ConversationReply handle_meta_get(slice key, cache::hash_type hash, const MetaFlags & mf, io_buffer & send_buf, cache::Cache & cache_api) {
+            if (mf.has_ttl) {
+                // get and touch in one round trip
+                cache_api.do_touch(key, hash, mf.ttl);
+            }
+            auto i = cache_api.do_get(key, hash);
+            if (not i) {
+                return mf.quiet ? net::READ_MORE : reply_with_meta_response(send_buf, META_MISS, mf, key);
+            }
+            if (not mf.return_value) {
+                return reply_with_meta_response(send_buf, META_HIT, mf, key, i);
+            }
+            send_buf << META_VALUE << SPACE << i->value_length();
+            write_meta_flags(send_buf, mf, key, i);
+            send_buf << CRLF;
+            write_value(send_buf, i, cache_api);
+            send_buf << CRLF;
+            return net::SEND_REPLY_AND_READ;
+        }
+
+
+        inline net::ConversationReply handle_meta_set(slice key, cache::hash_type hash, slice value, const MetaFlags & mf, io_buffer & send_buf, cache::Cache & cache_api) {
+            // modes: (S)et, add (E), (A)ppend, (P)repend, (R)eplace
+            const char mode = static_cast<char>(std::toupper(mf.mode != 0 ? mf.mode : 'S'));
+            const bool is_extend = mode == 'A' || mode == 'P';
+            if (mode != 'S' && mode != 'E' && mode != 'R' && not is_extend) {
+                throw system_error(error::meta_flag);
+            }
+            const bool compare_cas = mf.has_compare_cas && (mode == 'S' || mode == 'R');
+            // try to overwrite existing item if the new value fits into its memory
+            cache::ItemPtr existing_item = nullptr;
+            if (mode == 'S' && compare_cas) {
+                existing_item = cache_api.do_cas_inplace(key, hash, value.length(), mf.client_flags, mf.ttl, mf.compare_cas);
+            } else if (mode == 'S') {
+                existing_item = cache_api.do_set_inplace(key, hash, value.length(), mf.client_flags, mf.ttl);
+            } else if (mode == 'R' && not compare_cas) {
+                existing_item = cache_api.do_replace_inplace(key, hash, value.length(), mf.client_flags, mf.ttl);
+            }
+            if (existing_item != nullptr) {
+                existing_item->assign_value(value);
+                return mf.quiet ? net::READ_MORE : reply_with_meta_response(send_buf, META_HIT, mf, key, existing_item);
+            }
+            auto new_item = cache_api.create_item(key, hash, value.length(), mf.client_flags, mf.ttl);
+            new_item->assign_value(value);
+            bool found = false; bool stored = false;
+            slice response = META_HIT;
+            if (compare_cas) {
+                tie(found, stored) = cache_api.do_cas(new_item, mf.compare_cas);
+                response = found ? (stored ? META_HIT : META_EXISTS) : META_NOT_FOUND;
+            } else {
+                switch (mode) {
+                case 'S': cache_api.do_set(new_item); stored = true; break;
+                case 'E': stored = cache_api.do_add(new_item); break;
+                case 'R': stored = cache_api.do_replace(new_item); break;
+                case 'A': stored = cache_api.do_append(new_item); break;
+                case 'P': stored = cache_api.do_prepend(new_item); break;
+                default: debug_assert(false);
+                }
+                response = stored ? META_HIT : META_NOT_STORED;
+            }
+            if (not stored) {
+                return reply_with_meta_response(send_buf, response, mf, key);
+            }
+            // appended / prepended item is re-created by the cache
+            return mf.quiet ? net::READ_MORE : reply_with_meta_response(send_buf, META_HIT, mf, key, is_extend ? nullptr : new_item);
+        }
+
+
+        inline net::ConversationReply handle_meta_delete(slice key, cache::hash_type hash, const MetaFlags & mf, io_buffer & send_buf, cache::Cache & cache_api) {
+            if (mf.has_compare_cas) {
+                auto i = cache_api.do_get(key, hash);
+                if (i && i->timestamp() != mf.compare_cas) {
+                    return reply_with_meta_response(send_buf, META_EXISTS, mf, key);
+                }
+            }
+            bool found = cache_api.do_delete(key, hash);
+            if (mf.quiet) {
+                return net::READ_MORE;
+            }
+            return reply_with_meta_response(send_buf, found ? META_HIT : META_NOT_FOUND, mf, key);
+        }
+
+
+        inline net::ConversationReply handle_meta_arithmetic(slice key, cache::hash_type hash, const MetaFlags & mf, io_buffer & send_buf, cache::Cache & cache_api) {
+            // modes: (I)ncrement / +, (D)ecrement / -
+            const char mode = static_cast<char>(std::toupper(mf.mode != 0 ? mf.mode : 'I'));
+            bool found; uint64 new_value;
+            if (mode == 'I' || mode == '+') {
+                tie(found, new_value) = cache_api.do_incr(key, hash, mf.delta);
+            } else if (mode == 'D' || mode == '-') {
+                tie(found, new_value) = cache_api.do_decr(key, hash, mf.delta);
+            } else {
+                throw system_error(error::meta_flag);
+            }
+            char ascii_value[internal::numeric<uint64>::max_str_length];
+            if (not found) {
+                if (not mf.autovivify) {
+                    return reply_with_meta_response(send_buf, META_NOT_FOUND, mf, key);
+                }
+                // create the counter with the initial value
+                const size_t ascii_length = int_to_str(mf.initial, ascii_value);
+                auto new_item = cache_api.create_item(key, hash, ascii_length, 0, mf.autovivify_ttl);
+                new_item->assign_value(slice(ascii_value, ascii_length));
+                if (not cache_api.do_add(new_item)) {
+                    return reply_with_meta_response(send_buf, META_NOT_STORED, mf, key);
+                }
+                new_value = mf.initial;
+            }
+            if (mf.has_ttl) {
+                cache_api.do_touch(key, hash, mf.ttl);
+            }
+            if (mf.quiet && not mf.return_value) {
+                return net::READ_MORE;
+            }
+            // item is only needed to return its CAS or TTL
+            cache::ConstItemPtr i = (mf.return_cas || mf.return_ttl) ? cache_api.do_get(key, hash) : nullptr;
+            if (not mf.return_value) {
+                return reply_with_meta_response(send_buf, META_HIT, mf, key, i);
+            }
+            const size_t ascii_length = int_to_str(new_value, ascii_value);
+            send_buf << META_VALUE << SPACE << static_cast<uint64>(ascii_length);
+            write_meta_flags(send_buf, mf, key, i);
+            send_buf << CRLF << slice(ascii_value, ascii_length) << CRLF;
+            return net::SEND_REPLY_AND_READ;
+        }
+
+
+        inline net::ConversationReply handle_meta_command(Command cmd, slice args, io_buffer & recv_buf, io_buffer & send_buf, cache::Cache & cache_api) {
+            if (cmd == Command::META_NOOP) {
+                // replies of the preceding quiet commands are already in the send buffer
+                if (not args.empty()) {
+                    throw system_error(error::crlf_expected);
+                }
+                send_buf << META_NOOP << CRLF;
+                return net::SEND_REPLY_AND_READ;
+            }
+            slice key;
+            tie(key, args) = args.split(SPACE);
+            slice value;
+            if (cmd == Command::META_SET) {
+                // ms <key> <datalen> <flags>*\r\n<data block>\r\n
+                slice parsed;
+                tie(parsed, args) = args.split(SPACE);
+                uint32 datalen = str_to_int<uint32>(parsed.begin(), parsed.end());
+                if (datalen > settings.cache.max_item_size) {
+                    throw system_error(error::value_length);
+                }
+                value = read_data_block(recv_buf, datalen);
+            }
+            const MetaFlags mf = parse_meta_flags(cmd, args);
+            char decoded_key[cache::Item::max_key_length];
+            if (mf.base64_key) {
+                key = decode_base64_key(key, decoded_key);
+            }
+            validate_key(key);
+            const auto hash = calc_hash(key);
+            switch (cmd) {
+            case Command::META_GET:
+                return handle_meta_get(key, hash, mf, send_buf, cache_api);
+            case Command::META_SET:
+                return handle_meta_set(key, hash, value, mf, send_buf, cache_api);
+            case Command::META_DELETE:
+                return handle_meta_delete(key, hash, mf, send_buf, cache_api);
+            case Command::META_ARITHMETIC:
+                return handle_meta_arithmetic(key, hash, mf, send_buf, cache_api);
+            default:
+                debug_assert(false);
+                throw system_error(error::unknown_error);
+            }
+        }
+
+
         inline net::ConversationReply reply_with_response(io_buffer & send_buf, Response response, bool noreply) {
             if (not noreply) {
                 send_buf << response << CRLF;
@@ -441,58 +1077,53 @@ namespace cachelot {
         }
 
 
+        /// Perfect hash of the command names: length, the first and the last characters are unique for every command
+        constexpr uint32 command_name_hash(size_t length, char first, char last) noexcept {
+            return static_cast<uint32>(length + static_cast<uint8>(first) + static_cast<uint8>(last) * 22u) & 63u;
+        }
+
+        /// @copydoc command_name_hash()
+        template <size_t N>
+        constexpr uint32 command_name_hash(const char (&name)[N]) noexcept {
+            return command_name_hash(N - 1, name[0], name[N - 2]);
+        }
+
+
         inline Command parse_command_name(slice command) noexcept {
-            static const auto is_3 = [=](const char literal[4], slice cmd) -> bool {  return cmd[1] == literal[1] && cmd[2] == literal[2]; };
-            static const auto is_4 = [=](const char literal[5], slice cmd) -> bool {  return is_3(literal, cmd) && cmd[3] == literal[3]; };
-            static const auto is_5 = [=](const char literal[6], slice cmd) -> bool {  return is_4(literal, cmd) && cmd[4] == literal[4]; };
-            static const auto is_6 = [=](const char literal[7], slice cmd) -> bool {  return is_5(literal, cmd) && cmd[5] == literal[5]; };
-            static const auto is_7 = [=](const char literal[8], slice cmd) -> bool {  return is_6(literal, cmd) && cmd[6] == literal[6]; };
-
-            if (command) {
-                const char first_char = command[0];
-                switch (command.length()) {
-                case 3:
-                    switch (first_char) {
-                    case 'a': return is_3("add", command) ? Command::ADD : Command::UNDEFINED;
-                    case 'c': return is_3("cas", command) ? Command::CAS : Command::UNDEFINED;
-                    case 'g': return is_3("get", command) ? Command::GET : Command::UNDEFINED;
-                    case 's': return is_3("set", command) ? Command::SET : Command::UNDEFINED;
-                    default : return Command::UNDEFINED;
-                    }
-                case 4:
-                    switch (first_char) {
-                    case 'd': return is_4("decr", command) ? Command::DECR : Command::UNDEFINED;
-                    case 'g': return is_4("gets", command) ? Command::GETS : Command::UNDEFINED;
-                    case 'i': return is_4("incr", command) ? Command::INCR : Command::UNDEFINED;
-                    case 'q': return is_4("quit", command) ? Command::QUIT : Command::UNDEFINED;
-                    default : return Command::UNDEFINED;
-                    }
-                case 5:
-                    switch (first_char) {
-                    case 't': return is_5("touch", command) ? Command::TOUCH : Command::UNDEFINED;
-                    case 's': return is_5("stats", command) ? Command::STATS : Command::UNDEFINED;
-                    default : return Command::UNDEFINED;
-                    }
-                case 6:
-                    switch (first_char) {
-                    case 'a': return is_6("append", command) ? Command::APPEND : Command::UNDEFINED;
-                    case 'd': return is_6("delete", command) ? Command::DEL : Command::UNDEFINED;
-                    default : return Command::UNDEFINED;
-                    }
-                case 7:
-                    switch (first_char) {
-                    case 'p': return is_7("prepend", command) ? Command::PREPEND : Command::UNDEFINED;
-                    case 'r': return is_7("replace", command) ? Command::REPLACE : Command::UNDEFINED;
-                    case 'v': return is_7("version", command) ? Command::VERSION : Command::UNDEFINED;
-                    default : return Command::UNDEFINED;
-                    }
-                case 9:
-                    return std::strncmp("flush_all", command.begin(), 9) == 0 ? Command::FLUSH_ALL : Command::UNDEFINED;
-                default :
-                    return Command::UNDEFINED;
-                }
+            if (not command) {
+                return Command::UNDEFINED;
+            }
+            // case labels are computed at compile time, collision of two commands is a duplicate label error
+            #define CACHELOT_ASCII_COMMAND(name, cmd) \
+            case command_name_hash(name): return command == slice::from_literal(name) ? cmd : Command::UNDEFINED;
+
+            switch (command_name_hash(command.length(), command[0], command[command.length() - 1])) {
+            CACHELOT_ASCII_COMMAND("get", Command::GET)
+            CACHELOT_ASCII_COMMAND("gets", Command::GETS)
+            CACHELOT_ASCII_COMMAND("set", Command::SET)
+            CACHELOT_ASCII_COMMAND("add", Command::ADD)
+            CACHELOT_ASCII_COMMAND("replace", Command::REPLACE)
+            CACHELOT_ASCII_COMMAND("cas", Command::CAS)
+            CACHELOT_ASCII_COMMAND("append", Command::APPEND)
+            CACHELOT_ASCII_COMMAND("prepend", Command::PREPEND)
+            CACHELOT_ASCII_COMMAND("delete", Command::DEL)
+            CACHELOT_ASCII_COMMAND("incr", Command::INCR)
+            CACHELOT_ASCII_COMMAND("decr", Command::DECR)
+            CACHELOT_ASCII_COMMAND("touch", Command::TOUCH)
+            CACHELOT_ASCII_COMMAND("stats", Command::STATS)
+            CACHELOT_ASCII_COMMAND("version", Command::VERSION)
+            CACHELOT_ASCII_COMMAND("flush_all", Command::FLUSH_ALL)
+            CACHELOT_ASCII_COMMAND("cache_memory", Command::CACHE_MEMORY)
+            CACHELOT_ASCII_COMMAND("quit", Command::QUIT)
+            CACHELOT_ASCII_COMMAND("mg", Command::META_GET)
+            CACHELOT_ASCII_COMMAND("ms", Command::META_SET)
+            CACHELOT_ASCII_COMMAND("md", Command::META_DELETE)
+            CACHELOT_ASCII_COMMAND("ma", Command::META_ARITHMETIC)
+            CACHELOT_ASCII_COMMAND("mn", Command::META_NOOP)
+            default:
+                return Command::UNDEFINED;
             }
-            return Command::UNDEFINED;
+            #undef CACHELOT_ASCII_COMMAND
         }
 
 
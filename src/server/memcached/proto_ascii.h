@@ -18,7 +18,8 @@ namespace cachelot { namespace memcached {
     namespace ascii {
 
         /// Main function that process ascii protocol packets
-        net::ConversationReply handle_received_data(io_buffer & recv_buf, io_buffer & send_buf, cache::Cache & cache_api) noexcept;
+        /// Incomplete request is not an error: `state` remembers the parsed header and READ_MORE is returned
+        net::ConversationReply handle_received_data(io_buffer & recv_buf, io_buffer & send_buf, cache::Cache & cache_api, ParserState & state) noexcept;
 
     } // namespace ascii
 
@@ -8,15 +8,510 @@ namespace cachelot {
 
         const uint8 MAGIC = PROTOCOL_BINARY_REQ;
 
+        constexpr size_t header_size = sizeof(protocol_binary_request_header);
+
+        /// expiration value of the `incr` / `decr` requests meaning "do not create the missing counter"
+        constexpr uint32 no_auto_create = 0xffffffff;
+
+        /// Parsed request packet, slices reference data in the receive buffer
+        struct Request {
+            uint8 opcode;
+            uint32 opaque;
+            uint64 cas;
+            slice extras;
+            slice key;
+            slice value;
+        };
+
+        /// Handle `get`, `getq`, `getk`, `getkq`, `gat`, `gatq`, `gatk`, `gatkq`
+        net::ConversationReply handle_retrieval_command(const Request & req, io_buffer & send_buf, cache::Cache & cache_api);
+
+        /// Handle `set`, `add`, `replace`, `append`, `prepend` and their quiet versions
+        net::ConversationReply handle_storage_command(const Request & req, io_buffer & send_buf, cache::Cache & cache_api);
+
+        /// Handle `delete` and `deleteq`
+        net::ConversationReply handle_delete_command(const Request & req, io_buffer & send_buf, cache::Cache & cache_api);
+
+        /// Handle `increment`, `decrement` and their quiet versions
+        net::ConversationReply handle_arithmetic_command(const Request & req, io_buffer & send_buf, cache::Cache & cache_api);
+
+        /// Handle `touch`
+        net::ConversationReply handle_touch_command(const Request & req, io_buffer & send_buf, cache::Cache & cache_api);
+
+        /// Handle `stat`, every stat is sent as a separate packet terminated by the empty one
+        net::ConversationReply handle_statistics_command(const Request & req, io_buffer & send_buf, cache::Cache & cache_api);
+
+        /// Handle `flush` and `flushq`
+        net::ConversationReply handle_flush_command(const Request & req, io_buffer & send_buf, cache::Cache & cache_api);
+
+        /// Write response header, `body_length` bytes of extras, key and value must follow
+        void write_response_header(io_buffer & send_buf, const Request & req, uint16 status, uint8 extras_length, uint16 key_length, uint32 body_length, uint64 cas);
+
+        /// Write the complete response packet
+        net::ConversationReply reply_with_response(io_buffer & send_buf, const Request & req, uint16 status, slice extras = slice(), slice key = slice(), slice value = slice(), uint64 cas = 0);
+
+        /// Write response with the error `status`, quiet commands have their errors sent as well
+        net::ConversationReply reply_with_error(io_buffer & send_buf, const Request & req, uint16 status);
+
+        /// Check whether response to the successful `opcode` must be suppressed
+        bool is_quiet(uint8 opcode) noexcept;
+
+        // hash function
+        inline cache::hash_type calc_hash(const slice key) noexcept {
+            cache::HashFunction do_calc_hash;
+            return do_calc_hash(key);
+        }
+
+
+        /// Read big-endian (network byte order) integer
+        template <typename UIntT>
+        inline UIntT load_big_endian(const char * data) noexcept {
+            UIntT result = 0;
+            for (size_t i = 0; i < sizeof(UIntT); ++i) {
+                result = static_cast<UIntT>((result << 8) | static_cast<uint8>(data[i]));
+            }
+            return result;
+        }
+
+
+        /// Write integer in big-endian (network byte order)
+        template <typename UIntT>
+        inline void store_big_endian(char * dest, UIntT value) noexcept {
+            for (size_t i = sizeof(UIntT); i > 0; --i) {
+                dest[i - 1] = static_cast<char>(value & 0xFF);
+                value = static_cast<UIntT>(value >> 8);
+            }
+        }
+
+
+        // Stream operator to serialize `slice`
+        inline io_buffer & operator<<(io_buffer & buf, const slice value) {
+            if (value.empty()) {
+                // response key, extras and value are optional
+                return buf;
+            }
+            auto dest = buf.begin_write(value.length());
+            std::memcpy(dest, value.begin(), value.length());
+            buf.confirm_write(value.length());
+            return buf;
+        }
+
 
-        /// Main function that process binary protocol packets
         net::ConversationReply handle_received_data(io_buffer & recv_buf, io_buffer & send_buf, cache::Cache & cache_api) {
-            // suppress warning about the unused wariables in Release builds
-            (void)recv_buf; (void)send_buf; (void)cache_api;
-            throw system_error(cachelot::error::not_implemented);
+            // request header:
+            // 0      1       2       4        5         6          8         12       16     24
+            // +------+-------+-------+--------+---------+----------+---------+--------+------+
+            // | magic| opcode| keylen| extlen | datatype| reserved | bodylen | opaque | cas  |
+            // +------+-------+-------+--------+---------+----------+---------+--------+------+
+            if (recv_buf.non_read() < header_size) {
+                return net::READ_MORE;
+            }
+            const char * const header = recv_buf.begin_read();
+            debug_assert(static_cast<uint8>(header[0]) == MAGIC);
+            Request req;
+            req.opcode = static_cast<uint8>(header[1]);
+            const uint16 key_length = load_big_endian<uint16>(header + 2);
+            const uint8 extras_length = static_cast<uint8>(header[4]);
+            const uint32 body_length = load_big_endian<uint32>(header + 8);
+            req.opaque = load_big_endian<uint32>(header + 12);
+            req.cas = load_big_endian<uint64>(header + 16);
+            // body is either received completely or the connection is closed
+            static constexpr size_t max_body_overhead = 1024;
+            if (body_length > settings.cache.max_item_size + max_body_overhead) {
+                reply_with_error(send_buf, req, PROTOCOL_BINARY_RESPONSE_E2BIG);
+                recv_buf.read_all();
+                return net::SEND_REPLY_AND_CLOSE;
+            }
+            if (recv_buf.non_read() < header_size + body_length) {
+                // help buffer to grow up to the necessary size
+                recv_buf.ensure_capacity(header_size + body_length - recv_buf.non_read());
+                return net::READ_MORE;
+            }
+            recv_buf.confirm_read(header_size);
+            const slice body = recv_buf.confirm_read(body_length);
+            if (static_cast<size_t>(extras_length) + key_length > body_length) {
+                return reply_with_error(send_buf, req, PROTOCOL_BINARY_RESPONSE_EINVAL);
+            }
+            req.extras = slice(body.begin(), extras_length);
+            req.key = slice(req.extras.end(), key_length);
+            req.value = slice(req.key.end(), body_length - extras_length - key_length);
+
+            auto w_savepoint = send_buf.write_savepoint();
+            try {
+                switch (req.opcode) {
+                case PROTOCOL_BINARY_CMD_GET:
+                case PROTOCOL_BINARY_CMD_GETQ:
+                case PROTOCOL_BINARY_CMD_GETK:
+                case PROTOCOL_BINARY_CMD_GETKQ:
+                case PROTOCOL_BINARY_CMD_GAT:
+                case PROTOCOL_BINARY_CMD_GATQ:
+                case PROTOCOL_BINARY_CMD_GATK:
+                case PROTOCOL_BINARY_CMD_GATKQ:
+                    return handle_retrieval_command(req, send_buf, cache_api);
+                case PROTOCOL_BINARY_CMD_SET:
+                case PROTOCOL_BINARY_CMD_SETQ:
+                case PROTOCOL_BINARY_CMD_ADD:
+                case PROTOCOL_BINARY_CMD_ADDQ:
+                case PROTOCOL_BINARY_CMD_REPLACE:
+                case PROTOCOL_BINARY_CMD_REPLACEQ:
+                case PROTOCOL_BINARY_CMD_APPEND:
+                case PROTOCOL_BINARY_CMD_APPENDQ:
+                case PROTOCOL_BINARY_CMD_PREPEND:
+                case PROTOCOL_BINARY_CMD_PREPENDQ:
+                    return handle_storage_command(req, send_buf, cache_api);
+                case PROTOCOL_BINARY_CMD_DELETE:
+                case PROTOCOL_BINARY_CMD_DELETEQ:
+                    return handle_delete_command(req, send_buf, cache_api);
+                case PROTOCOL_BINARY_CMD_INCREMENT:
+                case PROTOCOL_BINARY_CMD_INCREMENTQ:
+                case PROTOCOL_BINARY_CMD_DECREMENT:
+                case PROTOCOL_BINARY_CMD_DECREMENTQ:
+                    return handle_arithmetic_command(req, send_buf, cache_api);
+                case PROTOCOL_BINARY_CMD_TOUCH:
+                    return handle_touch_command(req, send_buf, cache_api);
+                case PROTOCOL_BINARY_CMD_STAT:
+                    return handle_statistics_command(req, send_buf, cache_api);
+                case PROTOCOL_BINARY_CMD_FLUSH:
+                case PROTOCOL_BINARY_CMD_FLUSHQ:
+                    return handle_flush_command(req, send_buf, cache_api);
+                case PROTOCOL_BINARY_CMD_NOOP:
+                    // responses of the preceding quiet commands are already in the send buffer
+                    return reply_with_response(send_buf, req, PROTOCOL_BINARY_RESPONSE_SUCCESS);
+                case PROTOCOL_BINARY_CMD_VERSION:
+                    return reply_with_response(send_buf, req, PROTOCOL_BINARY_RESPONSE_SUCCESS, slice(), slice(), slice::from_literal(CACHELOT_VERSION_FULL));
+                case PROTOCOL_BINARY_CMD_QUIT:
+                    reply_with_response(send_buf, req, PROTOCOL_BINARY_RESPONSE_SUCCESS);
+                    return net::SEND_REPLY_AND_CLOSE;
+                case PROTOCOL_BINARY_CMD_QUITQ:
+                    return net::SEND_REPLY_AND_CLOSE;
+                default:
+                    return reply_with_error(send_buf, req, PROTOCOL_BINARY_RESPONSE_UNKNOWN_COMMAND);
+                }
+            } catch (const system_error & syserr) {
+                // discard any written data to write error response instead
+                send_buf.rollback_write_transaction(w_savepoint);
+                const auto code = syserr.code();
+                if (code == error::key_length || code == error::key_expected) {
+                    return reply_with_error(send_buf, req, PROTOCOL_BINARY_RESPONSE_EINVAL);
+                } else if (code == error::value_length || code == error::item_too_big) {
+                    return reply_with_error(send_buf, req, PROTOCOL_BINARY_RESPONSE_E2BIG);
+                } else if (code == error::numeric_convert || code == error::numeric_overflow) {
+                    return reply_with_error(send_buf, req, PROTOCOL_BINARY_RESPONSE_DELTA_BADVAL);
+                } else if (code == error::out_of_memory) {
+                    return reply_with_error(send_buf, req, PROTOCOL_BINARY_RESPONSE_ENOMEM);
+                } else {
+                    return reply_with_error(send_buf, req, PROTOCOL_BINARY_RESPONSE_EINVAL);
+                }
+            } catch (const std::bad_alloc &) {
+                send_buf.rollback_write_transaction(w_savepoint);
+                return reply_with_error(send_buf, req, PROTOCOL_BINARY_RESPONSE_ENOMEM);
+            }
+        }
+
+
+        inline net::ConversationReply handle_retrieval_command(const Request & req, io_buffer & send_buf, cache::Cache & cache_api) {
+            const bool is_gat = req.opcode == PROTOCOL_BINARY_CMD_GAT || req.opcode == PROTOCOL_BINARY_CMD_GATQ
+                             || req.opcode == PROTOCOL_BINARY_CMD_GATK || req.opcode == PROTOCOL_BINARY_CMD_GATKQ;
+            if (req.extras.length() != (is_gat ? sizeof(uint32) : 0) || not req.value.empty()) {
+                return reply_with_error(send_buf, req, PROTOCOL_BINARY_RESPONSE_EINVAL);
+            }
+            validate_key(req.key);
+            const auto hash = calc_hash(req.key);
+            if (is_gat) {
+                const cache::seconds keep_alive_duration(load_big_endian<uint32>(req.extras.begin()));
+                cache_api.do_touch(req.key, hash, keep_alive_duration);
+            }
+            const bool quiet = is_quiet(req.opcode);
+            auto i = cache_api.do_get(req.key, hash);
+            if (not i) {
+                // quiet retrieval commands don't report misses
+                return quiet ? net::READ_MORE : reply_with_error(send_buf, req, PROTOCOL_BINARY_RESPONSE_KEY_ENOENT);
+            }
+            const bool with_key = req.opcode == PROTOCOL_BINARY_CMD_GETK || req.opcode == PROTOCOL_BINARY_CMD_GETKQ
+                               || req.opcode == PROTOCOL_BINARY_CMD_GATK || req.opcode == PROTOCOL_BINARY_CMD_GATKQ;
+            const slice key = with_key ? i->key() : slice();
+            char flags[sizeof(uint32)];
+            store_big_endian<uint32>(flags, i->opaque_flags());
+            const uint32 body_length = static_cast<uint32>(sizeof(flags) + key.length() + i->value_length());
+            write_response_header(send_buf, req, PROTOCOL_BINARY_RESPONSE_SUCCESS, sizeof(flags), static_cast<uint16>(key.length()), body_length, i->timestamp());
+            send_buf << slice(flags, sizeof(flags)) << key;
+            write_value(send_buf, i, cache_api);
+            return net::SEND_REPLY_AND_READ;
+        }
+
+
+        inline net::ConversationReply handle_storage_command(const Request & req, io_buffer & send_buf, cache::Cache & cache_api) {
+            const bool is_extend = req.opcode == PROTOCOL_BINARY_CMD_APPEND || req.opcode == PROTOCOL_BINARY_CMD_APPENDQ
+                                || req.opcode == PROTOCOL_BINARY_CMD_PREPEND || req.opcode == PROTOCOL_BINARY_CMD_PREPENDQ;
+            // set / add / replace have <flags><expiration> extras, append / prepend have none
+            if (req.extras.length() != (is_extend ? 0 : 2 * sizeof(uint32))) {
+                return reply_with_error(send_buf, req, PROTOCOL_BINARY_RESPONSE_EINVAL);
+            }
+            validate_key(req.key);
+            if (req.value.length() > settings.cache.max_item_size) {
+                throw system_error(error::value_length);
+            }
+            cache::opaque_flags_type flags = 0;
+            cache::seconds keep_alive_duration = cache::Item::infinite_TTL;
+            if (not is_extend) {
+                flags = load_big_endian<uint32>(req.extras.begin());
+                keep_alive_duration = cache::seconds(load_big_endian<uint32>(req.extras.begin() + sizeof(uint32)));
+            }
+            const slice value = req.value;
+            const auto hash = calc_hash(req.key);
+            const bool quiet = is_quiet(req.opcode);
+            // try to overwrite existing item if the new value fits into its memory
+            cache::ItemPtr existing_item = nullptr;
+            switch (req.opcode) {
+            case PROTOCOL_BINARY_CMD_SET:
+            case PROTOCOL_BINARY_CMD_SETQ:
+                existing_item = req.cas == 0 ? cache_api.do_set_inplace(req.key, hash, value.length(), flags, keep_alive_duration)
+                                             : cache_api.do_cas_inplace(req.key, hash, value.length(), flags, keep_alive_duration, req.cas);
+                break;
+            case PROTOCOL_BINARY_CMD_REPLACE:
+            case PROTOCOL_BINARY_CMD_REPLACEQ:
+                if (req.cas == 0) {
+                    existing_item = cache_api.do_replace_inplace(req.key, hash, value.length(), flags, keep_alive_duration);
+                }
+                break;
+            default:
+                break;
+            }
+            if (existing_item != nullptr) {
+                existing_item->assign_value(value);
+                return quiet ? net::READ_MORE : reply_with_response(send_buf, req, PROTOCOL_BINARY_RESPONSE_SUCCESS, slice(), slice(), slice(), existing_item->timestamp());
+            }
+            // create new item and execute the cache API
+            auto new_item = cache_api.create_item(req.key, hash, value.length(), flags, keep_alive_duration);
+            new_item->assign_value(value);
+            uint16 status = PROTOCOL_BINARY_RESPONSE_SUCCESS;
+            bool found = false; bool stored = false;
+            cache::ConstItemPtr extended_item = nullptr;
+            switch (req.opcode) {
+            case PROTOCOL_BINARY_CMD_SET:
+            case PROTOCOL_BINARY_CMD_SETQ:
+            case PROTOCOL_BINARY_CMD_REPLACE:
+            case PROTOCOL_BINARY_CMD_REPLACEQ:
+                if (req.cas != 0) {
+                    // `replace` with CAS is the same as `set` with CAS: item must exist and must not be modified
+                    tie(found, stored) = cache_api.do_cas(new_item, req.cas);
+                    status = found ? (stored ? PROTOCOL_BINARY_RESPONSE_SUCCESS : PROTOCOL_BINARY_RESPONSE_KEY_EEXISTS) : PROTOCOL_BINARY_RESPONSE_KEY_ENOENT;
+                } else if (req.opcode == PROTOCOL_BINARY_CMD_SET || req.opcode == PROTOCOL_BINARY_CMD_SETQ) {
+                    cache_api.do_set(new_item);
+                } else {
+                    found = cache_api.do_replace(new_item);
+                    status = found ? PROTOCOL_BINARY_RESPONSE_SUCCESS : PROTOCOL_BINARY_RESPONSE_KEY_ENOENT;
+                }
+                break;
+            case PROTOCOL_BINARY_CMD_ADD:
+            case PROTOCOL_BINARY_CMD_ADDQ:
+                stored = cache_api.do_add(new_item);
+                status = stored ? PROTOCOL_BINARY_RESPONSE_SUCCESS : PROTOCOL_BINARY_RESPONSE_KEY_EEXISTS;
+                break;
+            case PROTOCOL_BINARY_CMD_APPEND:
+            case PROTOCOL_BINARY_CMD_APPENDQ:
+                tie(found, extended_item) = cache_api.do_append(new_item, req.cas);
+                status = found ? (extended_item ? PROTOCOL_BINARY_RESPONSE_SUCCESS : PROTOCOL_BINARY_RESPONSE_KEY_EEXISTS) : PROTOCOL_BINARY_RESPONSE_NOT_STORED;
+                break;
+            case PROTOCOL_BINARY_CMD_PREPEND:
+            case PROTOCOL_BINARY_CMD_PREPENDQ:
+                tie(found, extended_item) = cache_api.do_prepend(new_item, req.cas);
+                status = found ? (extended_item ? PROTOCOL_BINARY_RESPONSE_SUCCESS : PROTOCOL_BINARY_RESPONSE_KEY_EEXISTS) : PROTOCOL_BINARY_RESPONSE_NOT_STORED;
+                break;
+            default:
+                debug_assert(false);
+                throw system_error(error::unknown_error);
+            }
+            if (status != PROTOCOL_BINARY_RESPONSE_SUCCESS) {
+                return reply_with_error(send_buf, req, status);
+            }
+            if (quiet) {
+                return net::READ_MORE;
+            }
+            // CAS of the stored item (appended / prepended item may be re-created by the cache)
+            const uint64 cas = is_extend ? extended_item->timestamp() : new_item->timestamp();
+            return reply_with_response(send_buf, req, PROTOCOL_BINARY_RESPONSE_SUCCESS, slice(), slice(), slice(), cas);
+        }
+
+
+        inline net::ConversationReply handle_delete_command(const Request & req, io_buffer & send_buf, cache::Cache & cache_api) {
+            if (not req.extras.empty() || not req.value.empty()) {
+                return reply_with_error(send_buf, req, PROTOCOL_BINARY_RESPONSE_EINVAL);
+            }
+            validate_key(req.key);
+            bool found = cache_api.do_delete(req.key, calc_hash(req.key));
+            if (not found) {
+                return reply_with_error(send_buf, req, PROTOCOL_BINARY_RESPONSE_KEY_ENOENT);
+            }
+            return is_quiet(req.opcode) ? net::READ_MORE : reply_with_response(send_buf, req, PROTOCOL_BINARY_RESPONSE_SUCCESS);
+        }
+
+
+        inline net::ConversationReply handle_arithmetic_command(const Request & req, io_buffer & send_buf, cache::Cache & cache_api) {
+            // extras: <delta:8><initial:8><expiration:4>
+            if (req.extras.length() != 2 * sizeof(uint64) + sizeof(uint32) || not req.value.empty()) {
+                return reply_with_error(send_buf, req, PROTOCOL_BINARY_RESPONSE_EINVAL);
+            }
+            validate_key(req.key);
+            const uint64 delta = load_big_endian<uint64>(req.extras.begin());
+            const uint64 initial = load_big_endian<uint64>(req.extras.begin() + sizeof(uint64));
+            const uint32 expiration = load_big_endian<uint32>(req.extras.begin() + 2 * sizeof(uint64));
+            const auto hash = calc_hash(req.key);
+            bool found; uint64 new_value;
+            if (req.opcode == PROTOCOL_BINARY_CMD_INCREMENT || req.opcode == PROTOCOL_BINARY_CMD_INCREMENTQ) {
+                tie(found, new_value) = cache_api.do_incr(req.key, hash, delta);
+            } else {
+                tie(found, new_value) = cache_api.do_decr(req.key, hash, delta);
+            }
+            if (not found) {
+                if (expiration == no_auto_create) {
+                    return reply_with_error(send_buf, req, PROTOCOL_BINARY_RESPONSE_KEY_ENOENT);
+                }
+                // create the counter with the initial value
+                char ascii_value[internal::numeric<uint64>::max_str_length];
+                const size_t ascii_length = int_to_str(initial, ascii_value);
+                auto new_item = cache_api.create_item(req.key, hash, ascii_length, 0, cache::seconds(expiration));
+                new_item->assign_value(slice(ascii_value, ascii_length));
+                if (not cache_api.do_add(new_item)) {
+                    return reply_with_error(send_buf, req, PROTOCOL_BINARY_RESPONSE_KEY_EEXISTS);
+                }
+                new_value = initial;
+            }
+            if (is_quiet(req.opcode)) {
+                return net::READ_MORE;
+            }
+            char value[sizeof(uint64)];
+            store_big_endian<uint64>(value, new_value);
+            return reply_with_response(send_buf, req, PROTOCOL_BINARY_RESPONSE_SUCCESS, slice(), slice(), slice(value, sizeof(value)));
+        }
+
+
+        inline net::ConversationReply handle_touch_command(const Request & req, io_buffer & send_buf, cache::Cache & cache_api) {
+            if (req.extras.length() != sizeof(uint32) || not req.value.empty()) {
+                return reply_with_error(send_buf, req, PROTOCOL_BINARY_RESPONSE_EINVAL);
+            }
+            validate_key(req.key);
+            const cache::seconds keep_alive_duration(load_big_endian<uint32>(req.extras.begin()));
+            bool found = cache_api.do_touch(req.key, calc_hash(req.key), keep_alive_duration);
+            if (not found) {
+                return reply_with_error(send_buf, req, PROTOCOL_BINARY_RESPONSE_KEY_ENOENT);
+            }
+            return reply_with_response(send_buf, req, PROTOCOL_BINARY_RESPONSE_SUCCESS);
+        }
+
+
+        /// Write single stat as the `stat` response packet
+        template <typename ValueType>
+        inline void write_stat(io_buffer & send_buf, const Request & req, const slice name, const ValueType stat_value) {
+            char value[internal::numeric<uint64>::max_str_length];
+            const size_t value_length = int_to_str(static_cast<uint64>(stat_value), value);
+            reply_with_response(send_buf, req, PROTOCOL_BINARY_RESPONSE_SUCCESS, slice(), name, slice(value, value_length));
+        }
+
+
+        inline net::ConversationReply handle_statistics_command(const Request & req, io_buffer & send_buf, cache::Cache & cache_api) {
+            if (not req.extras.empty() || not req.value.empty()) {
+                return reply_with_error(send_buf, req, PROTOCOL_BINARY_RESPONSE_EINVAL);
+            }
+            if (not req.key.empty()) {
+                // stat groups are not supported
+                return reply_with_error(send_buf, req, PROTOCOL_BINARY_RESPONSE_KEY_ENOENT);
+            }
+            cache_api.publish_stats();
+            STAT_SET(mem.io_buffers_memory, io_buffer::total_capacity());
+            #define SERIALIZE_STAT(stat_group, stat_type, stat_name, stat_description) \
+                write_stat(send_buf, req, slice::from_literal(CACHELOT_PP_STR(stat_name)), STAT_GET(stat_group, stat_name));
+
+            #define SERIALIZE_CACHE_STAT(typ, name, desc) SERIALIZE_STAT(cache, typ, name, desc)
+            CACHE_STATS(SERIALIZE_CACHE_STAT)
+            #undef SERIALIZE_CACHE_STAT
+
+            #define SERIALIZE_MEM_STAT(typ, name, desc) SERIALIZE_STAT(mem, typ, name, desc)
+            MEMORY_STATS(SERIALIZE_MEM_STAT)
+            #undef SERIALIZE_MEM_STAT
+
+            #undef SERIALIZE_STAT
+            // the empty packet terminates the sequence
+            return reply_with_response(send_buf, req, PROTOCOL_BINARY_RESPONSE_SUCCESS);
+        }
+
+
+        inline net::ConversationReply handle_flush_command(const Request & req, io_buffer & send_buf, cache::Cache & cache_api) {
+            // optional extras: <expiration:4>, delayed flush is not supported
+            if ((not req.extras.empty() && req.extras.length() != sizeof(uint32)) || not req.key.empty() || not req.value.empty()) {
+                return reply_with_error(send_buf, req, PROTOCOL_BINARY_RESPONSE_EINVAL);
+            }
+            if (not req.extras.empty() && load_big_endian<uint32>(req.extras.begin()) != 0) {
+                return reply_with_error(send_buf, req, PROTOCOL_BINARY_RESPONSE_EINVAL);
+            }
+            cache_api.do_flush_all();
+            return is_quiet(req.opcode) ? net::READ_MORE : reply_with_response(send_buf, req, PROTOCOL_BINARY_RESPONSE_SUCCESS);
+        }
+
+
+        inline void write_response_header(io_buffer & send_buf, const Request & req, uint16 status, uint8 extras_length, uint16 key_length, uint32 body_length, uint64 cas) {
+            char * header = send_buf.begin_write(header_size);
+            header[0] = static_cast<char>(PROTOCOL_BINARY_RES);
+            header[1] = static_cast<char>(req.opcode);
+            store_big_endian<uint16>(header + 2, key_length);
+            header[4] = static_cast<char>(extras_length);
+            header[5] = static_cast<char>(PROTOCOL_BINARY_RAW_BYTES);
+            store_big_endian<uint16>(header + 6, status);
+            store_big_endian<uint32>(header + 8, body_length);
+            // opaque is copied as is
+            store_big_endian<uint32>(header + 12, req.opaque);
+            store_big_endian<uint64>(header + 16, cas);
+            send_buf.confirm_write(header_size);
+        }
+
+
+        inline net::ConversationReply reply_with_response(io_buffer & send_buf, const Request & req, uint16 status, slice extras, slice key, slice value, uint64 cas) {
+            const uint32 body_length = static_cast<uint32>(extras.length() + key.length() + value.length());
+            write_response_header(send_buf, req, status, static_cast<uint8>(extras.length()), static_cast<uint16>(key.length()), body_length, cas);
+            send_buf << extras << key << value;
+            return net::SEND_REPLY_AND_READ;
+        }
+
+
+        inline net::ConversationReply reply_with_error(io_buffer & send_buf, const Request & req, uint16 status) {
+            slice message;
+            switch (status) {
+            case PROTOCOL_BINARY_RESPONSE_KEY_ENOENT:    message = slice::from_literal("Not found"); break;
+            case PROTOCOL_BINARY_RESPONSE_KEY_EEXISTS:   message = slice::from_literal("Data exists for key"); break;
+            case PROTOCOL_BINARY_RESPONSE_E2BIG:         message = slice::from_literal("Too large"); break;
+            case PROTOCOL_BINARY_RESPONSE_EINVAL:        message = slice::from_literal("Invalid arguments"); break;
+            case PROTOCOL_BINARY_RESPONSE_NOT_STORED:    message = slice::from_literal("Not stored"); break;
+            case PROTOCOL_BINARY_RESPONSE_DELTA_BADVAL:  message = slice::from_literal("Non-numeric server-side value for incr or decr"); break;
+            case PROTOCOL_BINARY_RESPONSE_ENOMEM:        message = slice::from_literal("Out of memory"); break;
+            case PROTOCOL_BINARY_RESPONSE_UNKNOWN_COMMAND: message = slice::from_literal("Unknown command"); break;
+            default: break;
+            }
+            return reply_with_response(send_buf, req, status, slice(), slice(), message);
+        }
+
+
+        inline bool is_quiet(uint8 opcode) noexcept {
+            switch (opcode) {
+            case PROTOCOL_BINARY_CMD_GETQ:
+            case PROTOCOL_BINARY_CMD_GETKQ:
+            case PROTOCOL_BINARY_CMD_GATQ:
+            case PROTOCOL_BINARY_CMD_GATKQ:
+            case PROTOCOL_BINARY_CMD_SETQ:
+            case PROTOCOL_BINARY_CMD_ADDQ:
+            case PROTOCOL_BINARY_CMD_REPLACEQ:
+            case PROTOCOL_BINARY_CMD_APPENDQ:
+            case PROTOCOL_BINARY_CMD_PREPENDQ:
+            case PROTOCOL_BINARY_CMD_DELETEQ:
+            case PROTOCOL_BINARY_CMD_INCREMENTQ:
+            case PROTOCOL_BINARY_CMD_DECREMENTQ:
+            case PROTOCOL_BINARY_CMD_FLUSHQ:
+            case PROTOCOL_BINARY_CMD_QUITQ:
+                return true;
+            default:
+                return false;
+            }
         }
 
     }} // namespace memcached::binary
 
 } // namespace cachelot
-
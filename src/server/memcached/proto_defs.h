@@ -33,6 +33,12 @@ namespace cachelot { namespace memcached {
         x(QUIT)                 \
         x(VERSION)              \
         x(FLUSH_ALL)            \
+        x(CACHE_MEMORY)         \
+        x(META_GET)             \
+        x(META_SET)             \
+        x(META_DELETE)          \
+        x(META_ARITHMETIC)      \
+        x(META_NOOP)            \
         x(UNDEFINED)
 
 
@@ -55,6 +55,8 @@ namespace cachelot {
         enum ConversationReply {
             READ_MORE,
             SEND_REPLY_AND_READ,
+            SEND_REPLY_AND_CONTINUE, // there are more requests in the receive buffer, handle them on the next turn
+            SEND_REPLY_AND_CLOSE,
             CLOSE_IMMEDIATELY
         };
 
@@ -16,10 +16,19 @@ namespace cachelot {
     struct settings {
         struct {
             size_t memory_limit = 64 * Megabyte; // 64Mb
+            size_t max_memory_limit = 0; // memory reserved to grow at runtime (0 - same as `memory_limit`)
+            bool auto_memory_limit = false; // follow the cgroup memory limit and pressure
+            bool memory_budget = false; // `memory_limit` includes hash tables and connection buffers
             size_t page_size =  1 * Megabyte; // 1Mb
+            size_t max_item_size = 1 * Megabyte; // values larger than page are split on chunks
+            std::vector<size_t> pool_page_sizes; // page sizes of the additional memory pools
             size_t initial_hash_table_size = 65536;
             bool has_CAS = true;
             bool has_evictions = true;
+            unsigned extend_headroom = 0; // percent of value size
+            size_t compression_threshold = 0; // compress values of this size and more (0 - disabled)
+            size_t dedup_threshold = 0; // share identical values of this size and more (0 - disabled)
+            size_t compaction_budget = 0; // bytes of items to move out of sparse pages per store (0 - disabled)
         } cache;
         struct {
             size_t number_of_threads = 4;
@@ -35,6 +44,12 @@ namespace cachelot {
             size_t initial_snd_buffer_size = 2048;
             size_t max_rcv_buffer_size = 32*1024*1024;
             size_t max_snd_buffer_size = 32*1024*1024;
+            size_t snd_high_watermark = 4*1024*1024; // stop receiving requests while this much of replies is not sent yet (0 - never)
+            size_t zero_copy_threshold = 16*1024; // values of this size and more are sent from / received into the item memory (0 - always copy)
+            bool io_uring = false; // serve TCP and unix socket connections by the io_uring instead of the asio reactor
+            size_t max_requests_per_event = 20; // pipelined requests handled at once before the other connections get their turn
+            unsigned busy_poll_us = 0; // keep polling for events this long after the last one before blocking (0 - always block)
+            int reactor_cpu = -1; // CPU core the reactor thread is bound to (-1 - any)
         } net;
     };
 
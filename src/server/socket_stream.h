@@ -29,7 +29,10 @@ namespace cachelot { namespace net {
         stream_connection & operator= (const stream_connection &) = delete;
     protected:
         /// constructor
-        explicit stream_connection(io_service & io_svc, const size_t rcvbuf_max = default_max_buffer_size, const size_t sndbuf_max = default_max_buffer_size);
+        /// @p sndbuf_reference_threshold - pieces of this size and more are sent without copying into the send buffer (0 - disabled)
+        /// @p sndbuf_high_watermark - receiving stops while this many bytes of replies are not sent yet (0 - never stops)
+        explicit stream_connection(io_service & io_svc, const size_t rcvbuf_max = default_max_buffer_size, const size_t sndbuf_max = default_max_buffer_size,
+                                   const size_t sndbuf_reference_threshold = 0, const size_t sndbuf_high_watermark = 0);
 
         /// virtual destructor
         virtual ~stream_connection() = default;
@@ -39,6 +42,12 @@ namespace cachelot { namespace net {
         /// @return ConversationReply indicates whether to send reply or just wait for more data
         virtual net::ConversationReply handle_data(io_buffer & recv_buf, io_buffer & send_buf) noexcept = 0;
 
+        /// Memory where the next received bytes go instead of the receive buffer (such as the large value being received)
+        virtual asio::mutable_buffer receive_target() noexcept { return asio::mutable_buffer(); }
+
+        /// Confirm that `bytes_received` were written into the `receive_target()`
+        virtual void confirm_receive_target(size_t /*bytes_received*/) noexcept {}
+
     public:
         /// Type of the underlying socket
         typedef SocketType socket_type;
@@ -52,22 +61,41 @@ namespace cachelot { namespace net {
         bool is_open() const noexcept { return m_socket.is_open(); }
 
         /// start communication for connection
-        void start() noexcept { async_receive_some(); }
+        void start() noexcept {
+            // replies are written directly as long as socket accepts them (see `send_some()`)
+            error_code ignored;
+            m_socket.non_blocking(true, ignored);
+            async_receive_some();
+        }
 
         /// immediately cancel all pending operations and close the connection
         void close() noexcept;
 
     private:
 
-        /// start asynchronous receive operation, call the Conversation::handle_data on complete
+        /// wait until socket is readable, call the Conversation::handle_data on received data
         void async_receive_some() noexcept;
 
+        /// read as much as socket has into the receive target and the receive buffer
+        void receive_some() noexcept;
+
+        /// call the Conversation::handle_data and proceed depending on its reply
+        void handle_received() noexcept;
+
         /// start asynchronous send of the send buffer
         void async_send_all() noexcept;
 
+        /// write as much of the send buffer as socket accepts, wait until socket is writable to send the rest
+        void send_some() noexcept;
+
+        /// check whether so many replies are waiting to be sent that no more requests should be received
+        bool send_backlogged() const noexcept {
+            return m_sending && m_send_high_watermark > 0 && m_send_buf.non_read_pieces() >= m_send_high_watermark;
+        }
+
         /// schedule arbitrary function into IO loop
         template <typename Function>
-        void post(Function fun) noexcept { m_socket.get_io_service().post(fun); }
+        void post(Function fun) noexcept { asio::post(m_socket.get_executor(), fun); }
 
         /// publish dynamic stats
         void publish_stats() noexcept;
@@ -76,7 +104,13 @@ namespace cachelot { namespace net {
         SocketType m_socket;
         io_buffer m_recv_buf;
         io_buffer m_send_buf;
+        std::vector<asio::const_buffer> m_send_pieces; // gathered pieces of the send buffer
+        const size_t m_send_high_watermark;
         bool m_killed;
+        bool m_sending; // send operation is in progress
+        bool m_receive_paused; // client doesn't read replies as fast as it sends requests (see `send_backlogged()`)
+        bool m_continue_after_send; // there are unhandled requests in the receive buffer
+        bool m_close_after_send; // conversation is over
     };
 
 
@@ -130,58 +164,144 @@ namespace cachelot { namespace net {
 ///////////// stream connection implementation ////////////////////
 
 
+    // maximal number of pieces gathered by a single write
+    constexpr size_t max_send_pieces = 64;
+
+
     template <class Sock, class Conversation>
-    inline stream_connection<Sock, Conversation>::stream_connection(io_service & io_svc, const size_t rcvbuf_max, const size_t sndbuf_max)
+    inline stream_connection<Sock, Conversation>::stream_connection(io_service & io_svc, const size_t rcvbuf_max, const size_t sndbuf_max,
+                                                                    const size_t sndbuf_reference_threshold, const size_t sndbuf_high_watermark)
         : m_socket(io_svc)
         , m_recv_buf(default_min_buffer_size, rcvbuf_max)
         , m_send_buf(default_min_buffer_size, sndbuf_max)
-        , m_killed(false) {
+        , m_send_high_watermark(sndbuf_high_watermark)
+        , m_killed(false)
+        , m_sending(false)
+        , m_receive_paused(false)
+        , m_continue_after_send(false)
+        , m_close_after_send(false) {
         static_assert(std::is_base_of<stream_connection<Sock, Conversation>, Conversation>::value, "Conversation must be derived class");
+        m_send_buf.set_reference_threshold(sndbuf_reference_threshold);
+        m_send_pieces.reserve(max_send_pieces);
     }
 
 
     template <class Sock, class Conversation>
     inline void stream_connection<Sock, Conversation>::async_receive_some() noexcept {
         auto self = this->shared_from_this();
-        m_socket.async_read_some(asio::buffer(m_recv_buf.begin_write(), m_recv_buf.available()),
-            [=](const error_code error, const size_t bytes_received) {
-                slice receive_result;
-                if (not error) {
-                    self->m_recv_buf.confirm_write(bytes_received);
-                    ConversationReply reply = handle_data(m_recv_buf, m_send_buf);
-                    self->m_recv_buf.compact();
-                    switch (reply) {
-                    case SEND_REPLY_AND_READ:
-                        self->async_send_all();
-                        // there is no `break` so we'll continue receive
-                    case READ_MORE:
-                        self->async_receive_some();
-                        break;
-                    case CLOSE_IMMEDIATELY:
-                        break;
-                    }
-                } else {
-                    if (error == io_error::message_size) {
-                        self->m_recv_buf.confirm_write(bytes_received);
-                        self->async_receive_some();
-                    }
-                }
-            });
+        m_socket.async_wait(Sock::wait_read, [=](const error_code wait_error) {
+            if (not wait_error) {
+                self->receive_some();
+            }
+        });
+    }
+
+
+    template <class Sock, class Conversation>
+    inline void stream_connection<Sock, Conversation>::receive_some() noexcept {
+        // receive target may vanish while socket isn't readable (see `Conversation::receive_target()`),
+        // so it's requested right before the read
+        const asio::mutable_buffer target = receive_target();
+        const std::array<asio::mutable_buffer, 2> pieces = {{ target, asio::buffer(m_recv_buf.begin_write(), m_recv_buf.available()) }};
+        error_code error;
+        const size_t bytes_received = m_socket.read_some(pieces, error);
+        if (error == asio::error::would_block || error == asio::error::try_again) {
+            async_receive_some();
+            return;
+        }
+        const size_t into_target = std::min(bytes_received, asio::buffer_size(target));
+        confirm_receive_target(into_target);
+        m_recv_buf.confirm_write(bytes_received - into_target);
+        if (not error) {
+            handle_received();
+        } else if (error == io_error::message_size) {
+            async_receive_some();
+        }
+    }
+
+
+    template <class Sock, class Conversation>
+    inline void stream_connection<Sock, Conversation>::handle_received() noexcept {
+        ConversationReply reply = handle_data(m_recv_buf, m_send_buf);
+        m_recv_buf.compact();
+        switch (reply) {
+        case SEND_REPLY_AND_READ:
+            async_send_all();
+            // there is no `break` so we'll continue receive
+        case READ_MORE:
+            if (send_backlogged()) {
+                // receiving is resumed once the most of replies is sent (see `send_some()`)
+                m_receive_paused = true;
+            } else {
+                async_receive_some();
+            }
+            break;
+        case SEND_REPLY_AND_CONTINUE:
+            // the rest of requests is handled once reply is sent, other connections are served meanwhile
+            m_continue_after_send = true;
+            async_send_all();
+            break;
+        case SEND_REPLY_AND_CLOSE:
+            m_close_after_send = true;
+            async_send_all();
+            break;
+        case CLOSE_IMMEDIATELY:
+            break;
+        }
     }
 
 
     template <class Sock, class Conversation>
     inline void stream_connection<Sock, Conversation>::async_send_all() noexcept {
-        if (m_killed) { return; }
-        auto self = this->shared_from_this();
-        asio::async_write(m_socket, asio::buffer(m_send_buf.begin_read(), m_send_buf.non_read()), asio::transfer_all(),
-            [=](error_code error, size_t bytes_sent) {
-                if (not error) {
-                    debug_assert(self->m_send_buf.non_read() == bytes_sent);
-                    self->m_send_buf.confirm_read(bytes_sent);
-                    self->m_send_buf.compact();
-                }
+        if (m_killed || m_sending) { return; }
+        m_sending = true;
+        send_some();
+    }
+
+
+    template <class Sock, class Conversation>
+    inline void stream_connection<Sock, Conversation>::send_some() noexcept {
+        // there is a single send operation at a time, replies written into the buffer meanwhile go with the subsequent writes;
+        // referenced pieces may be replaced by their copies while socket isn't writable (see `io_buffer::detach_references()`),
+        // so the pieces are gathered anew right before every write
+        while (m_send_buf.non_read() > 0 || m_send_buf.has_references()) {
+            m_send_pieces.clear();
+            m_send_buf.for_each_unread_piece([this](slice piece) -> bool {
+                m_send_pieces.push_back(asio::buffer(piece.begin(), piece.length()));
+                return m_send_pieces.size() < max_send_pieces;
             });
+            error_code error;
+            const size_t bytes_sent = m_socket.write_some(m_send_pieces, error);
+            if (error == asio::error::would_block || error == asio::error::try_again) {
+                auto self = this->shared_from_this();
+                m_socket.async_wait(Sock::wait_write, [=](const error_code wait_error) {
+                    if (not wait_error) {
+                        self->send_some();
+                    } else {
+                        self->m_sending = false;
+                    }
+                });
+                return;
+            } else if (error) {
+                m_sending = false;
+                return;
+            }
+            m_send_buf.confirm_read_pieces(bytes_sent);
+            if (m_receive_paused && m_send_buf.non_read_pieces() <= m_send_high_watermark / 2) {
+                m_receive_paused = false;
+                async_receive_some();
+            }
+        }
+        m_sending = false;
+        m_send_buf.compact();
+        if (m_close_after_send) {
+            close();
+        } else if (m_continue_after_send) {
+            m_continue_after_send = false;
+            // let the other connections get their turn
+            auto self = this->shared_from_this();
+            post([=]() { self->handle_received(); });
+        }
     }
 
 
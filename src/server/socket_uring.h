@@ -0,0 +1,523 @@
+#ifndef CACHELOT_NET_SOCKET_URING_H_INCLUDED
+#define CACHELOT_NET_SOCKET_URING_H_INCLUDED
+
+//
+//  (C) Copyright 2015 Iurii Krasnoshchok
+//
+//  Distributed under the terms of Simplified BSD License
+//  see LICENSE file
+
+
+#ifndef CACHELOT_NETWORK_H_INCLUDED
+#  include <server/network.h>
+#endif
+#ifndef CACHELOT_NET_IO_URING_H_INCLUDED
+#  include <server/io_uring.h>
+#endif
+
+#include <sys/socket.h>
+#include <unordered_set>
+
+namespace cachelot { namespace net {
+
+    /**
+     * Stream connection served by the io_uring rather than the asio reactor (see `uring_stream_server`)
+     *
+     * Requests received while reply is being sent are handled after it, so the send buffer isn't modified
+     * under the kernel and all their replies are coalesced into the next send.
+     * Values are always copied into the send buffer, as item memory may be reused before the kernel sends it
+     * @ingroup net
+     */
+    class uring_stream_connection {
+        uring_stream_connection(const uring_stream_connection &) = delete;
+        uring_stream_connection & operator= (const uring_stream_connection &) = delete;
+        template <class Protocol, class ImplType> friend class uring_stream_server;
+    protected:
+        /// constructor
+        /// @p rcvbuf_high_watermark - receiving stops while this many bytes of requests wait for the reply to be sent (0 - never stops)
+        explicit uring_stream_connection(const size_t rcvbuf_max, const size_t sndbuf_max, const size_t rcvbuf_high_watermark)
+            : m_recv_buf(default_min_buffer_size, rcvbuf_max)
+            , m_send_buf(default_min_buffer_size, sndbuf_max)
+            , m_recv_high_watermark(rcvbuf_high_watermark) {
+        }
+
+        /// virtual destructor
+        virtual ~uring_stream_connection() = default;
+
+        /// React on the data
+        /// Parse incoming message from the `recv_buf`, call the Cache API functions and write reply into the `send_buf`
+        /// @return ConversationReply indicates whether to send reply or just wait for more data
+        virtual net::ConversationReply handle_data(io_buffer & recv_buf, io_buffer & send_buf) noexcept = 0;
+
+    private:
+        int m_fd = -1;
+        io_buffer m_recv_buf;
+        io_buffer m_send_buf;
+        const size_t m_recv_high_watermark;
+        bool m_receiving = false; // multishot receive is armed
+        bool m_receive_paused = false; // client doesn't read replies as fast as it sends requests
+        bool m_sending = false;   // send is in flight
+        bool m_deferred = false;  // there are unhandled requests, they're handled after the other connections
+        bool m_close_after_send = false;
+        bool m_closing = false;   // connection is shut down, it's destroyed once the kernel is done with it
+    };
+
+
+    /**
+     * uring_stream_server is an acceptor and connection manager for the `SOCK_STREAM` sockets (TCP/IP and local unix stream socket)
+     * which does all the socket IO by the io_uring
+     *
+     * Connections are accepted by the multishot accept and receive by the multishot receive into the buffers provided to the kernel,
+     * so every operation is submitted once and keeps producing completions. Requests of all the connections go to the kernel
+     * by a single system call once the completions are handled. The ring is watched by the asio reactor,
+     * so the io_uring connections are served by the same thread along with the timers, signals and UDP
+     *
+     * @tparam Protocol -   Stream protocol from the boost::asio (used to set up the listening socket)
+     * @tparam ImplType -   Actual server implementation class, must be derived from the uring_stream_server
+     *                      and provide `ConversationType * new_conversation()`, conversation must be derived from the `uring_stream_connection`
+     * @ingroup net
+     */
+    template <class Protocol, class ImplType>
+    class uring_stream_server {
+        typedef uring_stream_server<Protocol, ImplType> this_type;
+        typedef Protocol protocol_type;
+    public:
+        /// constructor
+        /// @throw system_error if io_uring isn't available
+        explicit uring_stream_server(io_service & ios)
+            : m_ios(ios)
+            , m_acceptor(ios)
+            , m_ring(ring_entries, num_recv_buffers, recv_buffer_size)
+            , m_ring_watch(ios)
+            , m_accept_timer(ios) {
+            static_assert(std::is_base_of<this_type, ImplType>::value, "<ImplType> must be derived from the uring_stream_server");
+            m_ring_watch.assign(m_ring.native_handle());
+        }
+
+        /// destructor
+        ~uring_stream_server() {
+            stop();
+            // ring is closed by the io_uring_queue
+            m_ring_watch.release();
+            for (auto conn : m_connections) {
+                ::close(conn->m_fd);
+                delete conn;
+            }
+        }
+
+        uring_stream_server(const uring_stream_server &) = delete;
+        uring_stream_server & operator= (const uring_stream_server &) = delete;
+
+        /// start accept connections
+        void start(const typename protocol_type::endpoint bind_addr);
+
+        /// interrupt all activity
+        void stop() noexcept {
+            error_code ignored;
+            m_ring_watch.cancel(ignored);
+            m_accept_timer.cancel(ignored);
+            m_acceptor.close(ignored);
+        }
+
+        io_service & get_io_service() noexcept { return m_ios; }
+
+    private:
+        // type of the operation is kept in the lower bits of the `user_data`, connection pointer in the rest
+        enum operation : uint64 { op_accept = 1, op_receive = 2, op_send = 3, op_ignore = 4, op_mask = 7 };
+
+        static uint64 user_data(uring_stream_connection * conn, operation op) noexcept {
+            debug_assert((reinterpret_cast<uint64>(conn) & op_mask) == 0);
+            return reinterpret_cast<uint64>(conn) | op;
+        }
+
+        /// wait until there are completions
+        void async_wait_completions() noexcept;
+
+        /// handle all the completions and submit the new requests
+        void handle_completions() noexcept;
+
+        void handle_accept(const io_uring_cqe & cqe) noexcept;
+
+        void handle_receive(uring_stream_connection * conn, const io_uring_cqe & cqe) noexcept;
+
+        void handle_send(uring_stream_connection * conn, const io_uring_cqe & cqe) noexcept;
+
+        void async_accept();
+
+        /// accept again after a while, when it fails right away or there is no room in the submission queue
+        void pause_accept() noexcept;
+
+        void async_receive(uring_stream_connection * conn);
+
+        void async_send(uring_stream_connection * conn);
+
+        /// call the Conversation::handle_data and proceed depending on its reply
+        void handle_received(uring_stream_connection * conn) noexcept;
+
+        /// shut the connection down, it's destroyed once there are no operations in flight
+        void close(uring_stream_connection * conn) noexcept;
+
+        void destroy_if_closed(uring_stream_connection * conn) noexcept;
+
+    private:
+        static constexpr unsigned ring_entries = 1024;
+        static constexpr unsigned num_recv_buffers = 1024;
+        static constexpr unsigned recv_buffer_size = 16 * 1024;
+
+        io_service & m_ios;
+        typename protocol_type::acceptor m_acceptor;
+        io_uring_queue m_ring;
+        asio::posix::stream_descriptor m_ring_watch;
+        asio::steady_timer m_accept_timer;
+        std::unordered_set<uring_stream_connection *> m_connections;
+        std::vector<uring_stream_connection *> m_deferred; // connections with requests left after their turn
+    };
+
+
+///////////// uring stream server implementation ///////////////////////
+
+
+    template <class Protocol, class ImplType>
+    inline void uring_stream_server<Protocol, ImplType>::start(const typename protocol_type::endpoint bind_addr) {
+        m_acceptor.open(bind_addr.protocol());
+        error_code ignore_error;
+        m_acceptor.set_option(typename protocol_type::acceptor::reuse_address(true), ignore_error);
+        m_acceptor.bind(bind_addr);
+        m_acceptor.listen();
+        async_accept();
+        m_ring.submit();
+        async_wait_completions();
+    }
+
+
+    template <class Protocol, class ImplType>
+    inline void uring_stream_server<Protocol, ImplType>::async_wait_completions() noexcept {
+        m_ring_watch.async_wait(asio::posix::stream_descriptor::wait_read, [this](const error_code error) {
+            if (not error) {
+                this->handle_completions();
+            }
+        });
+    }
+
+
+    template <class Protocol, class ImplType>
+    inline void uring_stream_server<Protocol, ImplType>::handle_completions() noexcept {
+        m_ring.for_each_cqe([this](const io_uring_cqe & cqe) {
+            auto conn = reinterpret_cast<uring_stream_connection *>(cqe.user_data & ~static_cast<uint64>(op_mask));
+            switch (static_cast<operation>(cqe.user_data & op_mask)) {
+            case op_accept:
+                handle_accept(cqe);
+                break;
+            case op_receive:
+                handle_receive(conn, cqe);
+                break;
+            case op_send:
+                handle_send(conn, cqe);
+                break;
+            default:
+                break;
+            }
+        });
+        // the rest of pipelined requests of the busy connections, after every other connection got its turn
+        std::vector<uring_stream_connection *> deferred;
+        deferred.swap(m_deferred);
+        for (auto conn : deferred) {
+            conn->m_deferred = false;
+            handle_received(conn);
+            destroy_if_closed(conn);
+        }
+        try {
+            m_ring.submit();
+        } catch (const std::exception &) {
+            // requests stay in the queue until the next attempt
+        }
+        // requests which the kernel completes right away (typically sends) are handled without waiting on the reactor
+        if (not m_deferred.empty() || m_ring.has_completions()) {
+            auto self = this;
+            m_ios.post([self]() { self->handle_completions(); });
+        } else {
+            async_wait_completions();
+        }
+    }
+
+
+    template <class Protocol, class ImplType>
+    inline void uring_stream_server<Protocol, ImplType>::async_accept() {
+        io_uring_sqe * sqe = m_ring.get_sqe();
+        sqe->opcode = IORING_OP_ACCEPT;
+        sqe->fd = m_acceptor.native_handle();
+        sqe->ioprio = IORING_ACCEPT_MULTISHOT;
+        sqe->accept_flags = SOCK_CLOEXEC | SOCK_NONBLOCK;
+        sqe->user_data = user_data(nullptr, op_accept);
+    }
+
+
+    template <class Protocol, class ImplType>
+    inline void uring_stream_server<Protocol, ImplType>::handle_accept(const io_uring_cqe & cqe) noexcept {
+        if (cqe.res >= 0) {
+            uring_stream_connection * conn = nullptr;
+            try {
+                conn = static_cast<ImplType *>(this)->new_conversation();
+                conn->m_fd = cqe.res;
+                m_connections.insert(conn);
+                async_receive(conn);
+            } catch (const std::exception &) {
+                if (conn != nullptr) {
+                    m_connections.erase(conn);
+                    delete conn;
+                }
+                ::close(cqe.res);
+            }
+        }
+        if ((cqe.flags & IORING_CQE_F_MORE) == 0 && m_acceptor.is_open()) {
+            switch (-cqe.res) {
+            case EMFILE:
+            case ENFILE:
+            case ENOBUFS:
+            case ENOMEM:
+                // out of descriptors or memory, accept would fail right away again (memcached pauses accept as well)
+                pause_accept();
+                break;
+            case EBADF:
+            case EINVAL:
+            case ENOTSOCK:
+            case EOPNOTSUPP:
+                // listening socket is unusable
+                break;
+            default:
+                try {
+                    async_accept();
+                } catch (const std::exception &) {
+                    pause_accept();
+                }
+            }
+        }
+    }
+
+
+    template <class Protocol, class ImplType>
+    inline void uring_stream_server<Protocol, ImplType>::pause_accept() noexcept {
+        m_accept_timer.expires_from_now(std::chrono::milliseconds(10));
+        m_accept_timer.async_wait([this](const error_code error) {
+            if (error || not m_acceptor.is_open()) {
+                return;
+            }
+            try {
+                async_accept();
+            } catch (const std::exception &) {
+                pause_accept();
+                return;
+            }
+            try {
+                m_ring.submit();
+            } catch (const std::exception &) {
+                // request stays in the queue until the next attempt
+            }
+        });
+    }
+
+
+    template <class Protocol, class ImplType>
+    inline void uring_stream_server<Protocol, ImplType>::async_receive(uring_stream_connection * conn) {
+        debug_assert(not conn->m_receiving);
+        io_uring_sqe * sqe = m_ring.get_sqe();
+        sqe->opcode = IORING_OP_RECV;
+        sqe->fd = conn->m_fd;
+        sqe->ioprio = IORING_RECV_MULTISHOT;
+        sqe->flags = IOSQE_BUFFER_SELECT;
+        sqe->buf_group = io_uring_queue::buffer_group;
+        sqe->user_data = user_data(conn, op_receive);
+        conn->m_receiving = true;
+    }
+
+
+    template <class Protocol, class ImplType>
+    inline void uring_stream_server<Protocol, ImplType>::handle_receive(uring_stream_connection * conn, const io_uring_cqe & cqe) noexcept {
+        const bool more = (cqe.flags & IORING_CQE_F_MORE) != 0;
+        if (not more) {
+            conn->m_receiving = false;
+        }
+        if (cqe.flags & IORING_CQE_F_BUFFER) {
+            const uint16 buffer_id = static_cast<uint16>(cqe.flags >> IORING_CQE_BUFFER_SHIFT);
+            if (cqe.res > 0 && not conn->m_closing) {
+                const slice received = m_ring.buffer(buffer_id, static_cast<size_t>(cqe.res));
+                try {
+                    std::memcpy(conn->m_recv_buf.begin_write(received.length()), received.begin(), received.length());
+                    conn->m_recv_buf.confirm_write(received.length());
+                } catch (const std::exception &) {
+                    // request doesn't fit into the maximal buffer
+                    close(conn);
+                }
+            }
+            m_ring.recycle_buffer(buffer_id);
+        }
+        if (conn->m_closing) {
+            destroy_if_closed(conn);
+            return;
+        }
+        if (cqe.res == 0 || (cqe.res < 0 && cqe.res != -ENOBUFS && cqe.res != -ECANCELED)) {
+            // connection is closed by the peer
+            close(conn);
+            destroy_if_closed(conn);
+            return;
+        }
+        if (cqe.res > 0 && not conn->m_sending) {
+            handle_received(conn);
+        }
+        if (conn->m_closing) {
+            destroy_if_closed(conn);
+            return;
+        }
+        if (conn->m_sending && conn->m_recv_high_watermark > 0 && conn->m_recv_buf.non_read() >= conn->m_recv_high_watermark) {
+            // receiving is resumed once reply is sent (see `handle_send()`)
+            conn->m_receive_paused = true;
+            if (conn->m_receiving) {
+                io_uring_sqe * sqe = m_ring.get_sqe();
+                sqe->opcode = IORING_OP_ASYNC_CANCEL;
+                sqe->addr = user_data(conn, op_receive);
+                sqe->user_data = user_data(nullptr, op_ignore);
+            }
+        } else if (not conn->m_receiving && not conn->m_receive_paused) {
+            // multishot receive stops when there are no provided buffers left
+            try {
+                async_receive(conn);
+            } catch (const std::exception &) {
+                close(conn);
+                destroy_if_closed(conn);
+            }
+        }
+    }
+
+
+    template <class Protocol, class ImplType>
+    inline void uring_stream_server<Protocol, ImplType>::async_send(uring_stream_connection * conn) {
+        debug_assert(not conn->m_sending);
+        debug_assert(not conn->m_send_buf.has_references());
+        io_uring_sqe * sqe = m_ring.get_sqe();
+        sqe->opcode = IORING_OP_SEND;
+        sqe->fd = conn->m_fd;
+        sqe->addr = reinterpret_cast<uint64>(conn->m_send_buf.begin_read());
+        sqe->len = static_cast<uint32>(std::min<size_t>(conn->m_send_buf.non_read(), std::numeric_limits<int32>::max()));
+        sqe->msg_flags = MSG_NOSIGNAL;
+        sqe->user_data = user_data(conn, op_send);
+        conn->m_sending = true;
+    }
+
+
+    template <class Protocol, class ImplType>
+    inline void uring_stream_server<Protocol, ImplType>::handle_send(uring_stream_connection * conn, const io_uring_cqe & cqe) noexcept {
+        conn->m_sending = false;
+        if (conn->m_closing) {
+            destroy_if_closed(conn);
+            return;
+        }
+        if (cqe.res < 0) {
+            close(conn);
+            destroy_if_closed(conn);
+            return;
+        }
+        conn->m_send_buf.confirm_read(static_cast<size_t>(cqe.res));
+        try {
+            if (conn->m_send_buf.non_read() > 0) {
+                async_send(conn);
+                return;
+            }
+            conn->m_send_buf.compact();
+            if (conn->m_close_after_send) {
+                close(conn);
+                destroy_if_closed(conn);
+                return;
+            }
+            // requests received meanwhile
+            if (conn->m_recv_buf.non_read() > 0) {
+                handle_received(conn);
+            }
+            if (conn->m_receive_paused && not conn->m_closing && not conn->m_sending) {
+                conn->m_receive_paused = false;
+                if (not conn->m_receiving) {
+                    async_receive(conn);
+                }
+            }
+        } catch (const std::exception &) {
+            close(conn);
+        }
+        destroy_if_closed(conn);
+    }
+
+
+    template <class Protocol, class ImplType>
+    inline void uring_stream_server<Protocol, ImplType>::handle_received(uring_stream_connection * conn) noexcept {
+        debug_assert(not conn->m_sending);
+        if (conn->m_closing || conn->m_deferred) {
+            return;
+        }
+        const ConversationReply reply = conn->handle_data(conn->m_recv_buf, conn->m_send_buf);
+        conn->m_recv_buf.compact();
+        try {
+            switch (reply) {
+            case SEND_REPLY_AND_CONTINUE:
+                if (conn->m_send_buf.non_read() == 0) {
+                    conn->m_deferred = true;
+                    m_deferred.push_back(conn);
+                    break;
+                }
+                // the rest of requests is handled once reply is sent
+            case SEND_REPLY_AND_READ:
+            case READ_MORE:
+                if (conn->m_send_buf.non_read() > 0) {
+                    async_send(conn);
+                }
+                break;
+            case SEND_REPLY_AND_CLOSE:
+                if (conn->m_send_buf.non_read() > 0) {
+                    conn->m_close_after_send = true;
+                    async_send(conn);
+                } else {
+                    close(conn);
+                }
+                break;
+            case CLOSE_IMMEDIATELY:
+                close(conn);
+                break;
+            }
+        } catch (const std::exception &) {
+            close(conn);
+        }
+    }
+
+
+    template <class Protocol, class ImplType>
+    inline void uring_stream_server<Protocol, ImplType>::close(uring_stream_connection * conn) noexcept {
+        if (not conn->m_closing) {
+            conn->m_closing = true;
+            ::shutdown(conn->m_fd, SHUT_RDWR);
+            if (conn->m_receiving || conn->m_sending) {
+                // send to the peer which has gone may wait for a long time
+                try {
+                    io_uring_sqe * sqe = m_ring.get_sqe();
+                    sqe->opcode = IORING_OP_ASYNC_CANCEL;
+                    sqe->fd = conn->m_fd;
+                    sqe->cancel_flags = IORING_ASYNC_CANCEL_FD | IORING_ASYNC_CANCEL_ALL;
+                    sqe->user_data = user_data(nullptr, op_ignore);
+                } catch (const std::exception &) {
+                    // operations complete once the socket is shut down
+                }
+            }
+        }
+    }
+
+
+    template <class Protocol, class ImplType>
+    inline void uring_stream_server<Protocol, ImplType>::destroy_if_closed(uring_stream_connection * conn) noexcept {
+        if (conn->m_closing && not conn->m_receiving && not conn->m_sending && not conn->m_deferred) {
+            ::close(conn->m_fd);
+            m_connections.erase(conn);
+            delete conn;
+        }
+    }
+
+
+}} // namespace cachelot::net
+
+
+#endif // CACHELOT_NET_SOCKET_URING_H_INCLUDED
@@ -282,6 +282,46 @@ cleanup:
 }
 
 
+bool test_large_value(CachelotPtr c, CachelotError * out_err) {
+    // value spans several memory pages
+    const size_t valuelen = options.mem_page_size * 3 + 100;
+    char * value = malloc(valuelen);
+    char * copy = malloc(valuelen);
+    bool ret = false;
+    for (size_t n = 0; n < valuelen; ++n) {
+        value[n] = 'a' + (char)(n % 26);
+    }
+    CachelotItemKey k = new_key("LargeItem");
+    CachelotItemPtr i = cachelot_create_item_raw(c, k, value, valuelen, out_err);
+    if (i == NULL) {
+        print_cachelot_error("Failed to create large item", out_err);
+        goto cleanup;
+    }
+    if (!cachelot_set(c, i, out_err) ) {
+        print_cachelot_error("Failed to set large item", out_err);
+        goto cleanup;
+    }
+    CachelotConstItemPtr stored = cachelot_get_unsafe(c, k, out_err);
+    if (stored == NULL) {
+        print_cachelot_error("Failed to retrieve large item", out_err);
+        goto cleanup;
+    }
+    if (cachelot_item_get_valuelen(stored) != valuelen) {
+        printf("large value length: '%zu' != '%zu'\n", cachelot_item_get_valuelen(stored), valuelen);
+        goto cleanup;
+    }
+    if (cachelot_item_copy_value(stored, copy, valuelen) != valuelen || memcmp(copy, value, valuelen) != 0) {
+        printf("cachelot_item_copy_value: large value mismatch\n");
+        goto cleanup;
+    }
+    ret = true;
+cleanup:
+    free(value);
+    free(copy);
+    return ret;
+}
+
+
 static bool __test_cb_on_eviction_callback_succeded = true;
 static bool __at_this_point_callback_should_not_be_called = false;
 static const char * __large_value = "There must be value large enough to fill 256b page. So there will be one long value that will do it. The other values are just too small, so this one should be long enough.";
@@ -339,6 +379,54 @@ bool test_on_eviction_callback(CachelotError * out_err) {
 }
 
 
+bool test_resize(CachelotError * out_err) {
+    const CachelotOptions resizableCache = {
+        .memory_limit = 1024u * 1024u,
+        .mem_page_size = 64u * 1024u,
+        .initial_dict_size = 1024u,
+        .enable_evictions = true,
+    };
+    CachelotPtr c = cachelot_init(resizableCache, out_err);
+    if (c == NULL) {
+        print_cachelot_error("test resize: failed to create cache", out_err);
+        return false;
+    }
+    bool ret = false;
+    char theKey[16];
+    for (int i = 0; i < 100; ++i) {
+        sprintf(theKey, "Key%03d", i);
+        if (!cachelot_set(c, new_item(c, theKey, __large_value, out_err), out_err)) {
+            print_cachelot_error("test resize: failed to set item", out_err);
+            goto cleanup;
+        }
+    }
+    if (!cachelot_resize(c, 256u * 1024u, out_err) || cachelot_memory_limit(c) != 256u * 1024u) {
+        print_cachelot_error("test resize: failed to shrink", out_err);
+        goto cleanup;
+    }
+    // items are moved out of the released memory
+    for (int i = 0; i < 100; ++i) {
+        sprintf(theKey, "Key%03d", i);
+        if (cachelot_get_unsafe(c, new_key(theKey), out_err) == NULL) {
+            printf("test resize: item '%s' is lost\n", theKey);
+            goto cleanup;
+        }
+    }
+    if (cachelot_resize(c, 2u * 1024u * 1024u, out_err)) {
+        printf("test resize: cache grown beyond the initial memory limit\n");
+        goto cleanup;
+    }
+    if (!cachelot_resize(c, 1024u * 1024u, out_err) || cachelot_memory_limit(c) != 1024u * 1024u) {
+        print_cachelot_error("test resize: failed to grow", out_err);
+        goto cleanup;
+    }
+    ret = true;
+cleanup:
+    cachelot_destroy(c);
+    return ret;
+}
+
+
 int main() {
     printf("Testing ver. %s C API ....\n", cachelot_version());
     printf("memory_limit = %zu\n", options.memory_limit);
@@ -373,11 +461,21 @@ int main() {
         ret = 1;
         goto cleanup;
     }
+    if (! test_large_value(cache, err)) {
+        print_cachelot_error("large value tests failed", err);
+        ret = 1;
+        goto cleanup;
+    }
     if (! test_on_eviction_callback(err)) {
         print_cachelot_error("on eviction callback tests failed", err);
         ret = 1;
         goto cleanup;
     }
+    if (! test_resize(err)) {
+        print_cachelot_error("resize tests failed", err);
+        ret = 1;
+        goto cleanup;
+    }
     printf("All tests passes\n");
 
 cleanup:
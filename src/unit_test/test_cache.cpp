@@ -1,5 +1,8 @@
 #include "unit_test.h"
 #include <cachelot/cache.h>
+#include <cachelot/random.h>
+#include <set>
+#include <map>
 
 namespace {
 
@@ -7,6 +10,44 @@ using namespace cachelot;
 
 BOOST_AUTO_TEST_SUITE(test_cache)
 
+// store copy of the `v` under the key `k`
+template <class CacheType>
+void StoreItem(CacheType & c, const string & k, const string & v, cache::opaque_flags_type flags = 0) {
+    const auto calc_hash = cache::HashFunction();
+    const slice key(k.c_str(), k.size());
+    auto item = c.create_item(key, calc_hash(key), v.size(), flags, cache::Item::infinite_TTL);
+    item->assign_value(slice(v.c_str(), v.size()));
+    c.do_set(item);
+}
+
+// item stored under the key `k`, `nullptr` if there is no such item
+template <class CacheType>
+cache::ConstItemPtr FindItem(CacheType & c, const string & k) {
+    const auto calc_hash = cache::HashFunction();
+    const slice key(k.c_str(), k.size());
+    return c.do_get(key, calc_hash(key));
+}
+
+// value stored under the key `k` (chunks of the chained item are joined), empty if there is no such item
+template <class CacheType>
+string GetValue(CacheType & c, const string & k) {
+    auto item = FindItem(c, k);
+    string value;
+    if (item != nullptr) {
+        item->for_each_value_chunk([&](slice chunk) { value.append(chunk.begin(), chunk.length()); });
+        BOOST_CHECK_EQUAL(value.size(), item->value_length());
+    }
+    return value;
+}
+
+// collect keys of the evicted items into `evicted` (in order of eviction unless it's a set)
+template <class CacheType, class Container>
+void TrackEvictions(CacheType & c, Container & evicted) {
+    c.on_eviction = [&evicted](cache::ConstItemPtr item) {
+        evicted.insert(evicted.end(), string(item->key().begin(), item->key().length()));
+    };
+}
+
 
 BOOST_AUTO_TEST_CASE(test_cache_basic) {
     BOOST_CHECK_EQUAL(2, 2);
@@ -18,6 +59,470 @@ BOOST_AUTO_TEST_CASE(test_expiration) {
 }
 
 
+BOOST_AUTO_TEST_CASE(test_inplace_update) {
+#if !defined(ADDRESS_SANITIZER) // allocator doesn't reveal block sizes under ASAN
+    auto calc_hash = cache::HashFunction();
+    auto the_cache = cache::Cache::Create(4 * Megabyte, 4 * Kilobyte, 16, false);
+    const auto key = slice::from_literal("Key");
+    const auto hash = calc_hash(key);
+    const auto value1 = slice::from_literal("Value1");
+    const auto value2 = slice::from_literal("Value2");
+    // nothing to overwrite
+    BOOST_CHECK(the_cache.do_set_inplace(key, hash, value1.length(), 0, cache::Item::infinite_TTL) == nullptr);
+    auto item = the_cache.create_item(key, hash, value1.length(), 0, cache::Item::infinite_TTL);
+    item->assign_value(value1);
+    the_cache.do_set(item);
+    const auto old_timestamp = item->timestamp();
+    // set
+    auto same_item = the_cache.do_set_inplace(key, hash, value2.length(), 42, cache::Item::infinite_TTL);
+    BOOST_REQUIRE(same_item == item);
+    same_item->assign_value(value2);
+    BOOST_CHECK(the_cache.do_get(key, hash)->value() == value2);
+    BOOST_CHECK_EQUAL(the_cache.do_get(key, hash)->opaque_flags(), 42);
+    BOOST_CHECK(item->timestamp() > old_timestamp);
+    // cas
+    BOOST_CHECK(the_cache.do_cas_inplace(key, hash, value1.length(), 0, cache::Item::infinite_TTL, old_timestamp) == nullptr);
+    same_item = the_cache.do_cas_inplace(key, hash, value1.length(), 0, cache::Item::infinite_TTL, item->timestamp());
+    BOOST_REQUIRE(same_item == item);
+    same_item->assign_value(value1);
+    BOOST_CHECK(the_cache.do_get(key, hash)->value() == value1);
+    // replace with the value that doesn't fit
+    BOOST_CHECK(the_cache.do_replace_inplace(key, hash, 1 * Kilobyte, 0, cache::Item::infinite_TTL) == nullptr);
+    BOOST_CHECK(the_cache.do_get(key, hash)->value() == value1);
+#endif
+}
+
+
+BOOST_AUTO_TEST_CASE(test_extend_inplace) {
+    auto calc_hash = cache::HashFunction();
+    auto the_cache = cache::Cache::Create(4 * Megabyte, 4 * Kilobyte, 16, false);
+    the_cache.set_extend_headroom(100);
+    const auto key = slice::from_literal("Key");
+    const auto hash = calc_hash(key);
+    auto make_item = [&](const slice value) -> cache::ItemPtr {
+        auto item = the_cache.create_item(key, hash, value.length(), 0, cache::Item::infinite_TTL);
+        item->assign_value(value);
+        return item;
+    };
+    BOOST_CHECK(not the_cache.do_append(make_item(slice::from_literal("miss"))));
+    the_cache.do_set(make_item(slice::from_literal("middle")));
+    string expected = "middle";
+    cache::timestamp_type prev_timestamp = the_cache.do_get(key, hash)->timestamp();
+    for (int i = 0; i < 100; ++i) {
+        BOOST_CHECK(the_cache.do_append(make_item(slice::from_literal("_right"))));
+        BOOST_CHECK(the_cache.do_prepend(make_item(slice::from_literal("left_"))));
+        expected = "left_" + expected + "_right";
+        auto item = the_cache.do_get(key, hash);
+        BOOST_REQUIRE(item != nullptr);
+        BOOST_CHECK(item->value() == slice(expected.c_str(), expected.length()));
+        BOOST_CHECK(item->timestamp() > prev_timestamp);
+        prev_timestamp = item->timestamp();
+    }
+    // item is extended only if it wasn't modified since the given CAS
+    bool found; cache::ConstItemPtr stored;
+    tie(found, stored) = the_cache.do_append(make_item(slice::from_literal("!")), prev_timestamp + 1);
+    BOOST_CHECK(found);
+    BOOST_CHECK(stored == nullptr);
+    tie(found, stored) = the_cache.do_prepend(make_item(slice::from_literal("!")), prev_timestamp);
+    BOOST_CHECK(found);
+    BOOST_REQUIRE(stored != nullptr);
+    BOOST_CHECK(stored == the_cache.do_get(key, hash));
+    BOOST_CHECK(stored->timestamp() > prev_timestamp);
+    BOOST_CHECK(stored->value() == slice(("!" + expected).c_str(), expected.length() + 1));
+}
+
+
+BOOST_AUTO_TEST_CASE(test_native_counters) {
+    auto calc_hash = cache::HashFunction();
+    auto the_cache = cache::Cache::Create(4 * Megabyte, 4 * Kilobyte, 16, false);
+    const auto key = slice::from_literal("Counter");
+    const auto hash = calc_hash(key);
+    auto item = the_cache.create_item(key, hash, 1, 0, cache::Item::infinite_TTL);
+    item->assign_value(slice::from_literal("9"));
+    the_cache.do_set(item);
+    bool found; uint64 new_value;
+    tie(found, new_value) = the_cache.do_incr(key, hash, 1);
+    BOOST_CHECK(found);
+    BOOST_CHECK_EQUAL(new_value, 10);
+    const cache::ConstItemPtr counter = the_cache.do_get(key, hash);
+    BOOST_CHECK(not counter->is_counter());
+    BOOST_CHECK(counter->value() == slice::from_literal("10"));
+    // once counter has enough memory it's updated in place
+    for (int i = 0; i < 1000; ++i) {
+        tie(found, new_value) = the_cache.do_incr(key, hash, 1000000000000000ull);
+    }
+    BOOST_CHECK_EQUAL(new_value, 1000000000000000010ull);
+    tie(found, new_value) = the_cache.do_incr(key, hash, std::numeric_limits<uint64>::max());
+    BOOST_CHECK_EQUAL(new_value, std::numeric_limits<uint64>::max());
+    BOOST_CHECK(the_cache.do_get(key, hash) == counter);
+    BOOST_CHECK(counter->value() == slice::from_literal("18446744073709551615"));
+    tie(found, new_value) = the_cache.do_decr(key, hash, std::numeric_limits<uint64>::max() - 5);
+    BOOST_CHECK_EQUAL(new_value, 5);
+    // append renders counter first
+    item = the_cache.create_item(key, hash, 1, 0, cache::Item::infinite_TTL);
+    item->assign_value(slice::from_literal("1"));
+    BOOST_CHECK(the_cache.do_append(item));
+    BOOST_CHECK(the_cache.do_get(key, hash)->value() == slice::from_literal("51"));
+    tie(found, new_value) = the_cache.do_decr(key, hash, 50);
+    BOOST_CHECK_EQUAL(new_value, 1);
+    BOOST_CHECK(the_cache.do_get(key, hash)->value() == slice::from_literal("1"));
+}
+
+
+BOOST_AUTO_TEST_CASE(test_compression) {
+    auto calc_hash = cache::HashFunction();
+    auto the_cache = cache::Cache::Create(4 * Megabyte, 64 * Kilobyte, 16, false);
+    the_cache.set_compression_threshold(1 * Kilobyte);
+    string json;
+    while (json.size() < 16 * Kilobyte) {
+        json += "{\"id\": " + std::to_string(json.size()) + ", \"kind\": \"compressible\"},";
+    }
+    const string noise = random_string(4 * Kilobyte, 4 * Kilobyte);
+    const string small = "{\"id\": 1, \"kind\": \"compressible\"}";
+    const auto json_key = slice::from_literal("json");
+    const auto noise_key = slice::from_literal("noise");
+    const auto small_key = slice::from_literal("small");
+    ResetStats();
+    StoreItem(the_cache, "json", json, 7);
+    StoreItem(the_cache, "noise", noise, 7);
+    StoreItem(the_cache, "small", small, 7);
+    BOOST_CHECK_EQUAL(STAT_GET(mem, total_compress_raw), json.size());
+    BOOST_CHECK(STAT_GET(mem, total_compress_stored) * 4 < json.size());
+    BOOST_CHECK_EQUAL(STAT_GET(mem, num_compress_rejected), 1);
+    auto item = the_cache.do_get(json_key, calc_hash(json_key));
+    BOOST_REQUIRE(item != nullptr);
+    BOOST_CHECK(not item->is_compressed());
+    BOOST_CHECK(item->value() == slice(json.c_str(), json.size()));
+    BOOST_CHECK_EQUAL(item->opaque_flags(), 7);
+    BOOST_CHECK(the_cache.do_get(noise_key, calc_hash(noise_key))->value() == slice(noise.c_str(), noise.size()));
+    BOOST_CHECK(the_cache.do_get(small_key, calc_hash(small_key))->value() == slice(small.c_str(), small.size()));
+    // append to compressed item
+    auto piece = the_cache.create_item(json_key, calc_hash(json_key), 3, 0, cache::Item::infinite_TTL);
+    piece->assign_value(slice::from_literal("end"));
+    BOOST_CHECK(the_cache.do_append(piece));
+    json += "end";
+    BOOST_CHECK(the_cache.do_get(json_key, calc_hash(json_key))->value() == slice(json.c_str(), json.size()));
+}
+
+
+BOOST_AUTO_TEST_CASE(test_dedup) {
+    auto calc_hash = cache::HashFunction();
+    auto the_cache = cache::Cache::Create(1 * Megabyte, 64 * Kilobyte, 16, true);
+    the_cache.set_dedup_threshold(256);
+    std::set<string> evicted;
+    TrackEvictions(the_cache, evicted);
+    const string blob = random_string(4 * Kilobyte, 4 * Kilobyte);
+    ResetStats();
+    for (int i = 0; i < 100; ++i) {
+        StoreItem(the_cache, "user:" + std::to_string(i), blob);
+    }
+    BOOST_CHECK_EQUAL(STAT_GET(mem, num_shared_values), 1);
+    BOOST_CHECK_EQUAL(STAT_GET(mem, num_shared_refs), 100);
+    // 100 copies would take 400K
+    BOOST_CHECK(STAT_GET(mem, used_memory) < 32 * Kilobyte);
+    for (int i = 0; i < 100; ++i) {
+        auto item = FindItem(the_cache, "user:" + std::to_string(i));
+        BOOST_REQUIRE(item != nullptr);
+        BOOST_CHECK(item->value() == slice(blob.c_str(), blob.size()));
+    }
+    // overwrite and delete keep shared value alive until the last reference is gone
+    const string other = random_string(1 * Kilobyte, 1 * Kilobyte);
+    StoreItem(the_cache, "user:0", other);
+    BOOST_CHECK(FindItem(the_cache, "user:0")->value() == slice(other.c_str(), other.size()));
+    BOOST_CHECK_EQUAL(STAT_GET(mem, num_shared_refs), 100);
+    BOOST_CHECK_EQUAL(STAT_GET(mem, num_shared_values), 2);
+    for (int i = 1; i < 100; ++i) {
+        const auto k = "user:" + std::to_string(i);
+        BOOST_CHECK(the_cache.do_delete(slice(k.c_str(), k.size()), calc_hash(slice(k.c_str(), k.size()))));
+    }
+    BOOST_CHECK_EQUAL(STAT_GET(mem, num_shared_values), 1);
+    BOOST_CHECK_EQUAL(STAT_GET(mem, num_shared_refs), 1);
+    // eviction of the shared value evicts all of its references
+    for (int i = 0; i < 10; ++i) {
+        StoreItem(the_cache, "user:" + std::to_string(i), blob);
+    }
+    for (int i = 0; i < 300; ++i) {
+        StoreItem(the_cache, "unique:" + std::to_string(i), random_string(4 * Kilobyte, 4 * Kilobyte));
+    }
+    BOOST_CHECK(evicted.count("user:1") > 0);
+    for (int i = 1; i < 10; ++i) {
+        BOOST_CHECK(FindItem(the_cache, "user:" + std::to_string(i)) == nullptr);
+    }
+}
+
+
+BOOST_AUTO_TEST_CASE(test_chained_items) {
+    auto calc_hash = cache::HashFunction();
+    auto the_cache = cache::Cache::Create(1 * Megabyte, 16 * Kilobyte, 16, true);
+    std::set<string> evicted;
+    TrackEvictions(the_cache, evicted);
+    // value spans several pages
+    const string big = random_string(100 * Kilobyte, 100 * Kilobyte);
+    StoreItem(the_cache, "big", big);
+    BOOST_CHECK(GetValue(the_cache, "big") == big);
+    // item larger than half of the memory would evict itself
+    const string huge(600 * Kilobyte, 'x');
+    BOOST_CHECK_THROW(StoreItem(the_cache, "huge", huge), system_error);
+    // append / prepend to the chained item
+    const string piece = random_string(20 * Kilobyte, 20 * Kilobyte);
+    auto extend = [&](bool append) {
+        const slice key = slice::from_literal("big");
+        auto item = the_cache.create_item(key, calc_hash(key), piece.size(), 0, cache::Item::infinite_TTL);
+        item->assign_value(slice(piece.c_str(), piece.size()));
+        return append ? the_cache.do_append(item) : the_cache.do_prepend(item);
+    };
+    BOOST_CHECK(extend(true));
+    BOOST_CHECK(extend(false));
+    BOOST_CHECK(GetValue(the_cache, "big") == piece + big + piece);
+    // regular item grows into the chained one
+    const string small = random_string(10 * Kilobyte, 10 * Kilobyte);
+    StoreItem(the_cache, "small", small);
+    BOOST_CHECK(GetValue(the_cache, "small") == small);
+    const slice small_key = slice::from_literal("small");
+    auto item = the_cache.create_item(small_key, calc_hash(small_key), big.size(), 0, cache::Item::infinite_TTL);
+    item->assign_value(slice(big.c_str(), big.size()));
+    BOOST_CHECK(the_cache.do_append(item));
+    BOOST_CHECK(GetValue(the_cache, "small") == small + big);
+    // eviction of any chunk evicts the whole item
+    for (int i = 0; i < 300; ++i) {
+        StoreItem(the_cache, "filler:" + std::to_string(i), random_string(8 * Kilobyte, 8 * Kilobyte));
+    }
+    BOOST_CHECK(evicted.count("big") > 0);
+    BOOST_CHECK(GetValue(the_cache, "big").empty());
+    // chained items are evicted as well as regular ones
+    for (int i = 0; i < 20; ++i) {
+        StoreItem(the_cache, "big:" + std::to_string(i), big);
+        BOOST_CHECK(GetValue(the_cache, "big:" + std::to_string(i)) == big);
+    }
+    BOOST_CHECK(evicted.count("big:0") > 0);
+}
+
+
+BOOST_AUTO_TEST_CASE(test_compaction) {
+    auto calc_hash = cache::HashFunction();
+    auto the_cache = cache::Cache::Create(1 * Megabyte, 16 * Kilobyte, 16, true);
+    std::set<string> evicted;
+    TrackEvictions(the_cache, evicted);
+    std::map<string, string> stored;
+    auto store = [&](const string & k, const string & v) {
+        StoreItem(the_cache, k, v);
+        stored[k] = v;
+    };
+    // leave few small items on every page
+    for (int i = 0; i < 3000; ++i) {
+        store("small:" + std::to_string(i), random_string(200, 200));
+    }
+    for (int i = 0; i < 3000; ++i) {
+        if (i % 8 != 0) {
+            const auto k = "small:" + std::to_string(i);
+            BOOST_CHECK(the_cache.do_delete(slice(k.c_str(), k.size()), calc_hash(slice(k.c_str(), k.size()))));
+            stored.erase(k);
+        }
+    }
+    BOOST_REQUIRE(evicted.empty());
+    the_cache.publish_stats();
+    BOOST_CHECK(STAT_GET(mem, fragmentation) > 50);
+    // big items take pages freed by the compaction instead of evicting small ones
+    the_cache.set_compaction_budget(64 * Kilobyte);
+    const auto compacted_before = STAT_GET(mem, num_compacted_pages);
+    for (int i = 0; i < 40; ++i) {
+        store("big:" + std::to_string(i), random_string(12 * Kilobyte, 12 * Kilobyte));
+    }
+    BOOST_CHECK(evicted.empty());
+    BOOST_CHECK(STAT_GET(mem, num_compacted_pages) > compacted_before);
+    for (const auto & kv : stored) {
+        auto item = FindItem(the_cache, kv.first);
+        BOOST_REQUIRE(item != nullptr);
+        BOOST_CHECK(item->value() == slice(kv.second.c_str(), kv.second.size()));
+    }
+}
+
+
+BOOST_AUTO_TEST_CASE(test_resize) {
+    auto the_cache = cache::Cache::Create(1 * Megabyte, 16 * Kilobyte, 16, true);
+    BOOST_CHECK_EQUAL(the_cache.memory_limit(), 1 * Megabyte);
+    BOOST_CHECK_THROW(the_cache.resize(2 * Megabyte), std::invalid_argument);
+    BOOST_CHECK_THROW(the_cache.resize(1000), std::invalid_argument);
+    BOOST_CHECK_THROW(the_cache.resize(16 * Kilobyte), std::invalid_argument);
+    auto key_of = [](int i) { return "key:" + std::to_string(i); };
+    const auto value = random_string(1000, 1000);
+    for (int i = 0; i < 100; ++i) {
+        StoreItem(the_cache, key_of(i), value);
+    }
+    // items fit in the remaining memory
+    the_cache.resize(256 * Kilobyte);
+    BOOST_CHECK_EQUAL(the_cache.memory_limit(), 256 * Kilobyte);
+    BOOST_CHECK_EQUAL(STAT_GET(mem, limit_maxbytes), 256 * Kilobyte);
+    for (int i = 0; i < 100; ++i) {
+        auto item = FindItem(the_cache, key_of(i));
+        BOOST_REQUIRE(item != nullptr);
+        BOOST_CHECK(item->value() == slice(value.c_str(), value.size()));
+    }
+    // the rest is evicted
+    size_t num_evicted = 0;
+    the_cache.on_eviction = [&](cache::ConstItemPtr) { num_evicted += 1; };
+    the_cache.resize(64 * Kilobyte);
+    BOOST_CHECK(num_evicted > 0);
+    the_cache.resize(1 * Megabyte);
+    BOOST_CHECK_EQUAL(the_cache.memory_limit(), 1 * Megabyte);
+    the_cache.on_eviction = nullptr;
+}
+
+
+BOOST_AUTO_TEST_CASE(test_pinned_items) {
+    auto calc_hash = cache::HashFunction();
+    auto the_cache = cache::Cache::Create(1 * Megabyte, 16 * Kilobyte, 16, true);
+    std::vector<cache::ConstItemPtr> revoked;
+    the_cache.on_pin_revoked = [&](cache::ConstItemPtr item) { revoked.push_back(item); };
+    const auto key = slice::from_literal("pinned");
+    const auto hash = calc_hash(key);
+    const auto value = random_string(1000, 1000);
+    StoreItem(the_cache, "pinned", value);
+    auto item = the_cache.do_get(key, hash);
+    BOOST_REQUIRE(item != nullptr);
+    // pin is released by the holder
+    BOOST_CHECK(the_cache.pin(item));
+    BOOST_CHECK(the_cache.pin(item));
+    the_cache.unpin(item);
+    the_cache.unpin(item);
+    BOOST_CHECK(the_cache.do_delete(key, hash));
+    BOOST_CHECK(revoked.empty());
+    // pin is revoked when item is deleted, overwritten or evicted
+    StoreItem(the_cache, "pinned", value);
+    item = the_cache.do_get(key, hash);
+    BOOST_CHECK(the_cache.pin(item));
+    BOOST_CHECK(the_cache.do_delete(key, hash));
+    BOOST_REQUIRE_EQUAL(revoked.size(), 1);
+    BOOST_CHECK(revoked.back() == item);
+    the_cache.unpin(item); // no-op
+    StoreItem(the_cache, "pinned", value);
+    item = the_cache.do_get(key, hash);
+    BOOST_CHECK(the_cache.pin(item));
+    BOOST_CHECK(the_cache.do_set_inplace(key, hash, value.size(), 0, cache::Item::infinite_TTL) == item);
+    BOOST_REQUIRE_EQUAL(revoked.size(), 2);
+    BOOST_CHECK(revoked.back() == item);
+    BOOST_CHECK(the_cache.pin(item));
+    for (int i = 0; i < 3000; ++i) {
+        StoreItem(the_cache, "key:" + std::to_string(i), value);
+    }
+    BOOST_CHECK(the_cache.do_get(key, hash) == nullptr);
+    BOOST_REQUIRE_EQUAL(revoked.size(), 3);
+    BOOST_CHECK(revoked.back() == item);
+    // new item may be pinned while its value is filled
+    auto new_item = the_cache.create_item(key, hash, value.size(), 0, cache::Item::infinite_TTL);
+    BOOST_CHECK(the_cache.pin(new_item));
+    the_cache.unpin(new_item);
+    the_cache.do_set(new_item);
+    BOOST_CHECK(the_cache.do_get(key, hash) == new_item);
+    // evicted new item is freed by the cache
+    const auto other_key = slice::from_literal("not stored yet");
+    new_item = the_cache.create_item(other_key, calc_hash(other_key), value.size(), 0, cache::Item::infinite_TTL);
+    BOOST_CHECK(the_cache.pin(new_item));
+    for (int i = 0; i < 3000; ++i) {
+        StoreItem(the_cache, "key:" + std::to_string(i), value);
+    }
+    BOOST_REQUIRE_EQUAL(revoked.size(), 4);
+    BOOST_CHECK(revoked.back() == new_item);
+    BOOST_CHECK(the_cache.do_get(other_key, calc_hash(other_key)) == nullptr);
+    the_cache.set_compression_threshold(100);
+    StoreItem(the_cache, "compressed", string(value.size(), 'x'));
+    const auto compressed_key = slice::from_literal("compressed");
+    auto decompressed = the_cache.do_get(compressed_key, calc_hash(compressed_key));
+    BOOST_REQUIRE(decompressed != nullptr);
+    BOOST_CHECK(not the_cache.pin(decompressed));
+    the_cache.on_pin_revoked = nullptr;
+}
+
+
+BOOST_AUTO_TEST_CASE(test_memory_budget) {
+    auto the_cache = cache::Cache::Create(4 * Megabyte, 64 * Kilobyte, 16 * 1024, true);
+    BOOST_CHECK_THROW(the_cache.set_memory_budget(8 * Megabyte), std::invalid_argument);
+    BOOST_CHECK_THROW(the_cache.set_memory_budget(64 * Kilobyte), std::invalid_argument);
+    auto dict_memory = [&]() -> size_t {
+        the_cache.publish_stats();
+        return STAT_GET(mem, dict_memory);
+    };
+    // items give memory away to the hash tables
+    the_cache.set_memory_budget(4 * Megabyte);
+    BOOST_CHECK_EQUAL(STAT_GET(mem, memory_budget), 4 * Megabyte);
+    BOOST_CHECK(dict_memory() > 0);
+    BOOST_CHECK(the_cache.memory_limit() < 4 * Megabyte);
+    BOOST_CHECK(the_cache.memory_limit() + dict_memory() <= 4 * Megabyte);
+    // and to the external memory
+    const size_t before = the_cache.memory_limit();
+    the_cache.fit_memory_budget(1 * Megabyte);
+    BOOST_CHECK(the_cache.memory_limit() + dict_memory() + 1 * Megabyte <= 4 * Megabyte);
+    BOOST_CHECK(the_cache.memory_limit() < before);
+    // the expanded hash table takes more memory
+    const auto value = random_string(10, 10);
+    for (int i = 0; i < 20000; ++i) {
+        StoreItem(the_cache, "key:" + std::to_string(i), value);
+    }
+    the_cache.fit_memory_budget(1 * Megabyte);
+    BOOST_CHECK(the_cache.memory_limit() + dict_memory() + 1 * Megabyte <= 4 * Megabyte);
+    // memory comes back once the external memory is released
+    const size_t shrunk = the_cache.memory_limit();
+    the_cache.fit_memory_budget(0);
+    BOOST_CHECK(the_cache.memory_limit() > shrunk);
+    BOOST_CHECK(the_cache.memory_limit() + dict_memory() <= 4 * Megabyte);
+    // budget is disabled
+    the_cache.set_memory_budget(0);
+    BOOST_CHECK_EQUAL(the_cache.memory_limit(), 4 * Megabyte);
+    the_cache.fit_memory_budget(1 * Megabyte);
+    BOOST_CHECK_EQUAL(the_cache.memory_limit(), 4 * Megabyte);
+}
+
+
+BOOST_AUTO_TEST_CASE(test_segment_cache) {
+    auto calc_hash = cache::HashFunction();
+    auto the_cache = cache::SegmentCache::Create(1 * Megabyte, 64 * Kilobyte, 16, true);
+    std::vector<string> evicted;
+    TrackEvictions(the_cache, evicted);
+    const auto value = random_string(1000, 1000);
+    for (int i = 0; i < 100; ++i) {
+        StoreItem(the_cache, "key:" + std::to_string(i), value);
+    }
+    for (int i = 0; i < 100; ++i) {
+        BOOST_CHECK(GetValue(the_cache, "key:" + std::to_string(i)) == value);
+    }
+    // overwritten item replaces the old one
+    StoreItem(the_cache, "key:0", "new value");
+    BOOST_CHECK(GetValue(the_cache, "key:0") == "new value");
+    const slice deleted_key = slice::from_literal("key:1");
+    BOOST_CHECK(the_cache.do_delete(deleted_key, calc_hash(deleted_key)));
+    BOOST_CHECK(GetValue(the_cache, "key:1").empty());
+    // the oldest items are evicted first regardless of access
+    for (int i = 100; i < 2000; ++i) {
+        BOOST_CHECK(GetValue(the_cache, "key:2") == value || evicted.size() > 0);
+        StoreItem(the_cache, "key:" + std::to_string(i), value);
+    }
+    BOOST_REQUIRE(not evicted.empty());
+    BOOST_CHECK(evicted.front() == "key:2");
+    BOOST_CHECK(GetValue(the_cache, "key:1999") == value);
+    // compaction gets segments back from the deleted items
+    std::vector<string> kept;
+    for (int i = 1000; i < 2000; ++i) {
+        const auto k = "key:" + std::to_string(i);
+        if (i % 8 != 0) {
+            the_cache.do_delete(slice(k.c_str(), k.size()), calc_hash(slice(k.c_str(), k.size())));
+        } else if (GetValue(the_cache, k) == value) {
+            kept.push_back(k);
+        }
+    }
+    the_cache.set_compaction_budget(64 * Kilobyte);
+    const auto compacted_before = STAT_GET(mem, num_compacted_pages);
+    evicted.clear();
+    for (int i = 0; i < 100; ++i) {
+        StoreItem(the_cache, "more:" + std::to_string(i), value);
+    }
+    BOOST_CHECK(evicted.empty());
+    BOOST_CHECK(STAT_GET(mem, num_compacted_pages) > compacted_before);
+    for (const auto & k : kept) {
+        BOOST_CHECK(GetValue(the_cache, k) == value);
+    }
+}
+
+
 BOOST_AUTO_TEST_SUITE_END()
 
 }
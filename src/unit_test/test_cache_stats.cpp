@@ -8,7 +8,7 @@ using namespace cachelot;
 
 BOOST_AUTO_TEST_SUITE(test_cache_stats)
 
-static auto calc_hash = fnv1a<cache::Cache::hash_type>::hasher();
+static auto calc_hash = cache::HashFunction();
 
 cache::ItemPtr CreateItem(cache::Cache & c, const string k, const string v, cache::opaque_flags_type flags = 0, cache::seconds keepalive = cache::Item::infinite_TTL) {
     const auto key = slice(k.c_str(), k.length());
@@ -200,7 +200,8 @@ BOOST_AUTO_TEST_CASE(test_cache_size_stats) {
         BOOST_CHECK_EQUAL(the_cache.do_delete(key, calc_hash(key)), true);
     }
     the_cache.publish_stats();
-    BOOST_CHECK_EQUAL(STAT_GET(cache,hash_capacity), 32);
+    // hash table shrinks back to its initial size
+    BOOST_CHECK_EQUAL(STAT_GET(cache,hash_capacity), 16);
     BOOST_CHECK_EQUAL(STAT_GET(cache,curr_items), 0);
     BOOST_CHECK_EQUAL(STAT_GET(cache,hash_is_expanding), false);
 }
@@ -0,0 +1,43 @@
+#include "unit_test.h"
+#include <server/cgroup_memory.h>
+
+namespace {
+
+using namespace cachelot;
+
+BOOST_AUTO_TEST_SUITE(test_cgroup_memory)
+
+BOOST_AUTO_TEST_CASE(test_parse) {
+    BOOST_CHECK_EQUAL(cgroup::parse_memory_value("536870912\n"), 536870912);
+    BOOST_CHECK_EQUAL(cgroup::parse_memory_value("max\n"), 0);
+    const string pressure = "some avg10=12.50 avg60=3.00 avg300=0.70 total=1234567\n"
+                            "full avg10=1.00 avg60=0.20 avg300=0.05 total=234567\n";
+    BOOST_CHECK_CLOSE(cgroup::parse_memory_pressure(pressure), 12.5, 0.001);
+    BOOST_CHECK_EQUAL(cgroup::parse_memory_pressure(""), 0.0);
+}
+
+
+BOOST_AUTO_TEST_CASE(test_adjust_memory_limit) {
+    const size_t min_limit = 64 * Megabyte, max_limit = 1 * Gigabyte, step = 64 * Megabyte;
+    cgroup::memory_state state;
+    state.max = 2 * Gigabyte;
+    // plenty of memory, cache grows up to the maximum
+    state.current = 512 * Megabyte;
+    BOOST_CHECK_EQUAL(cgroup::adjust_memory_limit(512 * Megabyte, min_limit, max_limit, step, state), 576 * Megabyte);
+    BOOST_CHECK_EQUAL(cgroup::adjust_memory_limit(max_limit, min_limit, max_limit, step, state), max_limit);
+    // close to the cgroup limit
+    state.current = state.max - 100 * Megabyte;
+    BOOST_CHECK_EQUAL(cgroup::adjust_memory_limit(512 * Megabyte, min_limit, max_limit, step, state), 448 * Megabyte);
+    BOOST_CHECK_EQUAL(cgroup::adjust_memory_limit(min_limit, min_limit, max_limit, step, state), min_limit);
+    // in between, nothing changes
+    state.current = state.max - 400 * Megabyte;
+    BOOST_CHECK_EQUAL(cgroup::adjust_memory_limit(512 * Megabyte, min_limit, max_limit, step, state), 512 * Megabyte);
+    // tasks stall on memory even without limit
+    state.max = 0;
+    state.pressure = 25.0;
+    BOOST_CHECK_EQUAL(cgroup::adjust_memory_limit(512 * Megabyte, min_limit, max_limit, step, state), 448 * Megabyte);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+}
@@ -47,6 +47,51 @@ BOOST_AUTO_TEST_CASE(test_dict_basic) {
     BOOST_CHECK_EQUAL(the_dict.size(), 0);
 }
 
+// grow dict, then remove most of the elements and check that it shrinks back
+BOOST_AUTO_TEST_CASE(test_dict_shrink) {
+    static const size_t num_elements = 50000;
+    static const size_t num_left = 100;
+    std::vector<string> keys;
+    dict_type the_dict(64);
+    std::hash<string> hasher;
+    for (uint i = 0; i < num_elements; ++i) {
+        string key = random_string(14, 45);
+        bool found; dict_type::iterator at; auto hash = hasher(key);
+        tie(found, at) = the_dict.entry_for(key, hash);
+        if (not found) {
+            the_dict.insert(at, key, hash, key);
+            keys.push_back(key);
+        }
+    }
+    const auto grown_capacity = the_dict.capacity();
+    BOOST_CHECK(grown_capacity >= keys.size());
+    // leave only few elements
+    for (size_t i = num_left; i < keys.size(); ++i) {
+        BOOST_CHECK(the_dict.del(keys[i], hasher(keys[i])));
+    }
+    keys.resize(num_left);
+    // every lookup moves some elements into the smaller table
+    while (the_dict.is_expanding() || the_dict.capacity() == grown_capacity) {
+        bool found; dict_type::iterator at;
+        tie(found, at) = the_dict.entry_for(keys[0], hasher(keys[0]), true);
+        BOOST_CHECK(found);
+    }
+    BOOST_CHECK(the_dict.capacity() < grown_capacity);
+    BOOST_CHECK(the_dict.capacity() >= 64);
+    BOOST_CHECK_EQUAL(the_dict.size(), num_left);
+    for (const auto & key : keys) {
+        bool found; dict_type::mapped_type value;
+        std::tie(found, value) = the_dict.get(key, hasher(key));
+        BOOST_CHECK(found);
+        BOOST_CHECK_EQUAL(key, value);
+    }
+    // dict never shrinks below initial size
+    the_dict.remove_if([](const string &) { return true; });
+    BOOST_CHECK_EQUAL(the_dict.size(), 0);
+    BOOST_CHECK(not the_dict.is_expanding());
+    BOOST_CHECK_EQUAL(the_dict.capacity(), 64);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
 
 }
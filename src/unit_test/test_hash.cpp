@@ -0,0 +1,81 @@
+#include "unit_test.h"
+#include <cachelot/hash_fnv1a.h>
+#include <cachelot/hash_wyhash.h>
+#include <cachelot/random.h>
+#include <unordered_set>
+
+namespace {
+
+using namespace cachelot;
+
+BOOST_AUTO_TEST_SUITE(test_hash)
+
+BOOST_AUTO_TEST_CASE(test_wyhash_seed) {
+    const slice key = slice::from_literal("Hello, World!");
+    const auto h1 = wyhash<uint64>::hasher(1)(key);
+    BOOST_CHECK_EQUAL(h1, wyhash<uint64>::hasher(1)(key));
+    BOOST_CHECK_NE(h1, wyhash<uint64>::hasher(2)(key));
+    // default constructed hasher picks up global seed
+    const auto h0 = wyhash<uint64>::hasher()(key);
+    wyhash_seed(1);
+    BOOST_CHECK_EQUAL(wyhash<uint64>::hasher()(key), h1);
+    wyhash_seed(0);
+    BOOST_CHECK_EQUAL(wyhash<uint64>::hasher()(key), h0);
+}
+
+BOOST_AUTO_TEST_CASE(test_wyhash_all_lengths) {
+    // every key length hits different code path, check that every byte matters
+    const string data = random_string(300, 300);
+    wyhash<uint64>::hasher calc_hash(0x1234);
+    std::unordered_set<uint64> hashes;
+    for (size_t len = 0; len <= data.length(); ++len) {
+        string key = data.substr(0, len);
+        const auto h = calc_hash(slice(key.c_str(), key.length()));
+        BOOST_CHECK(hashes.insert(h).second);
+        for (size_t pos = 0; pos < len; ++pos) {
+            key[pos] ^= 1;
+            BOOST_CHECK_NE(calc_hash(slice(key.c_str(), key.length())), h);
+            key[pos] ^= 1;
+        }
+    }
+}
+
+template <typename Hasher>
+void check_batch(const Hasher & calc_hash) {
+    typedef typename Hasher::hash_type hash_type;
+    std::vector<string> strings;
+    std::vector<slice> keys;
+    for (size_t n = 0; n < 37; ++n) {
+        strings.push_back(random_string(0, 100));
+    }
+    for (const auto & s : strings) {
+        keys.push_back(slice(s.c_str(), s.length()));
+    }
+    std::vector<hash_type> hashes(keys.size());
+    calc_hash(keys.data(), hashes.data(), keys.size());
+    for (size_t n = 0; n < keys.size(); ++n) {
+        BOOST_CHECK_EQUAL(hashes[n], calc_hash(keys[n]));
+    }
+}
+
+BOOST_AUTO_TEST_CASE(test_hash_batch) {
+    check_batch(wyhash<uint32>::hasher(42));
+    check_batch(wyhash<uint64>::hasher(42));
+    check_batch(fnv1a<uint32>::hasher());
+    check_batch(fnv1a<uint64>::hasher());
+}
+
+BOOST_AUTO_TEST_CASE(test_wyhash_collisions) {
+    wyhash<uint64>::hasher calc_hash(7);
+    std::unordered_set<uint64> hashes;
+    char key[16];
+    for (uint32 n = 0; n < 100000; ++n) {
+        auto len = snprintf(key, sizeof(key), "key:%u", n);
+        BOOST_CHECK(hashes.insert(calc_hash(slice(key, len))).second);
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+} //anonymous namespace
+
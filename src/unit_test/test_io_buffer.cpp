@@ -18,6 +18,18 @@ BOOST_AUTO_TEST_CASE(test_io_buffer_capacity) {
     BOOST_CHECK_EQUAL(buf.non_read(), 0);
 }
 
+BOOST_AUTO_TEST_CASE(test_io_buffer_total_capacity) {
+    const size_t initial = io_buffer::total_capacity();
+    {
+        io_buffer buf1(100, 1000);
+        io_buffer buf2(0, 1000);
+        BOOST_CHECK_EQUAL(io_buffer::total_capacity(), initial + buf1.capacity());
+        buf2.begin_write(200);
+        BOOST_CHECK_EQUAL(io_buffer::total_capacity(), initial + buf1.capacity() + buf2.capacity());
+    }
+    BOOST_CHECK_EQUAL(io_buffer::total_capacity(), initial);
+}
+
 BOOST_AUTO_TEST_CASE(test_io_buffer_read_write) {
     io_buffer buf(0, 64);
     static const char pattern[] = "Test string [separator] more [separator]";
@@ -62,6 +74,65 @@ BOOST_AUTO_TEST_CASE(test_io_buffer_savepoint) {
     BOOST_CHECK_EQUAL(buf.non_read(), 16);
 }
 
+BOOST_AUTO_TEST_CASE(test_io_buffer_references) {
+    io_buffer buf(0, 64);
+    auto write = [&buf](const char * data) {
+        std::memcpy(buf.begin_write(std::strlen(data)), data, std::strlen(data));
+        buf.confirm_write(std::strlen(data));
+    };
+    auto read_pieces = [&buf](size_t max_length) -> string {
+        string result;
+        buf.for_each_unread_piece([&](slice piece) -> bool {
+            result.append(piece.begin(), std::min(piece.length(), max_length - result.size()));
+            return result.size() < max_length;
+        });
+        buf.confirm_read_pieces(result.size());
+        return result;
+    };
+    char owner1[] = "<value1>";
+    char owner2[] = "<value2>";
+    int num_released = 0;
+    write("VALUE ");
+    buf.write_reference(slice(owner1, std::strlen(owner1)), owner1, [&]() { num_released += 1; });
+    write(" VALUE ");
+    buf.write_reference(slice(owner2, std::strlen(owner2)), owner2, [&]() { num_released += 1; });
+    BOOST_CHECK(buf.has_references());
+    BOOST_CHECK_EQUAL(buf.non_read_pieces(), std::strlen("VALUE <value1> VALUE <value2>"));
+    // discarded references are released
+    auto w_savepoint = buf.write_savepoint();
+    buf.write_reference(slice(owner1, std::strlen(owner1)), owner1, [&]() { num_released += 1; });
+    write("garbage");
+    buf.rollback_write_transaction(w_savepoint);
+    BOOST_CHECK_EQUAL(num_released, 1);
+    BOOST_CHECK_EQUAL(buf.non_read_pieces(), std::strlen("VALUE <value1> VALUE <value2>"));
+    write(" END");
+    // read by pieces of arbitrary length
+    BOOST_CHECK_EQUAL(read_pieces(3), "VAL");
+    BOOST_CHECK_EQUAL(read_pieces(6), "UE <va");
+    BOOST_CHECK_EQUAL(num_released, 1);
+    buf.compact();
+    BOOST_CHECK_EQUAL(read_pieces(7), "lue1> V");
+    BOOST_CHECK_EQUAL(buf.non_read_pieces(), std::strlen("ALUE <value2> END"));
+    BOOST_CHECK_EQUAL(num_released, 2);
+    // owner is about to reuse the memory, buffer keeps its own copy
+    BOOST_CHECK_EQUAL(read_pieces(8), "ALUE <va");
+    const size_t capacity_before = io_buffer::total_capacity();
+    io_buffer::detach_references(owner2);
+    std::strcpy(owner2, "XXXXXXXX");
+    BOOST_CHECK_EQUAL(io_buffer::total_capacity(), capacity_before + std::strlen("lue2>"));
+    BOOST_CHECK_EQUAL(buf.non_read_pieces(), std::strlen("lue2> END"));
+    BOOST_CHECK_EQUAL(read_pieces(100), "lue2> END");
+    BOOST_CHECK_EQUAL(num_released, 2); // detached reference isn't released
+    BOOST_CHECK(not buf.has_references());
+    BOOST_CHECK_EQUAL(io_buffer::total_capacity(), capacity_before);
+    // references are released together with the buffer
+    buf.write_reference(slice(owner1, std::strlen(owner1)), owner1, [&]() { num_released += 1; });
+    buf.reset();
+    BOOST_CHECK_EQUAL(num_released, 3);
+    BOOST_CHECK(not buf.has_references());
+    BOOST_CHECK_EQUAL(buf.non_read_pieces(), 0);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
 
 } // anonymouse namespace
@@ -0,0 +1,63 @@
+#include "unit_test.h"
+#include <cachelot/common.h>
+
+#if defined(CACHELOT_HAVE_IO_URING)
+
+#include <server/io_uring.h>
+#include <sys/socket.h>
+
+namespace {
+
+using namespace cachelot;
+
+BOOST_AUTO_TEST_SUITE(test_io_uring)
+
+BOOST_AUTO_TEST_CASE(test_io_uring_provided_buffers) {
+    if (not net::io_uring_supported()) {
+        BOOST_TEST_MESSAGE("io_uring is not available, test skipped");
+        return;
+    }
+    net::io_uring_queue ring(4, 2, 16);
+    int sockets[2];
+    BOOST_REQUIRE(::socketpair(AF_UNIX, SOCK_STREAM, 0, sockets) == 0);
+    // single multishot receive consumes provided buffers one by one
+    io_uring_sqe * sqe = ring.get_sqe();
+    sqe->opcode = IORING_OP_RECV;
+    sqe->fd = sockets[0];
+    sqe->ioprio = IORING_RECV_MULTISHOT;
+    sqe->flags = IOSQE_BUFFER_SELECT;
+    sqe->buf_group = net::io_uring_queue::buffer_group;
+    sqe->user_data = 42;
+    ring.submit();
+    BOOST_CHECK(not ring.has_completions());
+    string received;
+    auto receive = [&](const char * data) {
+        BOOST_REQUIRE(::send(sockets[1], data, std::strlen(data), 0) == static_cast<ssize_t>(std::strlen(data)));
+        for (int attempt = 0; attempt < 1000 && not ring.has_completions(); ++attempt) {
+            ::usleep(1000);
+        }
+        return ring.for_each_cqe([&](const io_uring_cqe & cqe) {
+            BOOST_CHECK_EQUAL(cqe.user_data, 42);
+            BOOST_CHECK(cqe.flags & IORING_CQE_F_MORE);
+            BOOST_REQUIRE(cqe.flags & IORING_CQE_F_BUFFER);
+            BOOST_REQUIRE(cqe.res > 0);
+            const uint16 buffer_id = static_cast<uint16>(cqe.flags >> IORING_CQE_BUFFER_SHIFT);
+            const slice piece = ring.buffer(buffer_id, static_cast<size_t>(cqe.res));
+            received.append(piece.begin(), piece.length());
+            ring.recycle_buffer(buffer_id);
+        });
+    };
+    // recycled buffers are reused, so there is always one to receive into
+    for (auto data : { "first", "second", "third", "fourth" }) {
+        BOOST_CHECK_EQUAL(receive(data), 1);
+    }
+    BOOST_CHECK_EQUAL(received, "firstsecondthirdfourth");
+    ::close(sockets[1]);
+    ::close(sockets[0]);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+} // anonymouse namespace
+
+#endif // CACHELOT_HAVE_IO_URING
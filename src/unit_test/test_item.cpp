@@ -3,5 +3,48 @@
 
 namespace {
 
-} // anonymouse namespace
+using namespace cachelot;
+using cache::Item;
+
+BOOST_AUTO_TEST_SUITE(test_item)
+
+BOOST_AUTO_TEST_CASE(test_item_layout) {
+#if defined(CACHELOT_ITEM_NO_HASH)
+    BOOST_CHECK_EQUAL(sizeof(Item), 12u);
+#else
+    BOOST_CHECK_EQUAL(sizeof(Item), 16u);
+#endif
+    const slice key = slice::from_literal("Key");
+    const slice value = slice::from_literal("Value");
+    BOOST_CHECK_EQUAL(Item::CalcSizeRequired(key, value.length(), false), sizeof(Item) + key.length() + value.length());
+    BOOST_CHECK_EQUAL(Item::CalcSizeRequired(key, value.length(), true), sizeof(Item) + sizeof(Item::timestamp_type) + key.length() + value.length());
+}
 
+BOOST_AUTO_TEST_CASE(test_item_cas) {
+    const slice key = slice::from_literal("Key");
+    const slice value = slice::from_literal("Value");
+    const auto hash = Item::hash_function()(key);
+    alignas(8) uint8 memory[64];
+    // with CAS
+    auto item = new (memory) Item(key, hash, value.length(), 42, Item::infinite_TTL, 0x0102030405060708ull);
+    item->assign_value(value);
+    BOOST_CHECK(item->has_cas());
+    BOOST_CHECK_EQUAL(item->timestamp(), 0x0102030405060708ull);
+    BOOST_CHECK(item->key() == key);
+    BOOST_CHECK(item->value() == value);
+    BOOST_CHECK_EQUAL(item->hash(), hash);
+    BOOST_CHECK_EQUAL(item->opaque_flags(), 42);
+    // without CAS
+    item = new (memory) Item(key, hash, value.length(), 42, Item::infinite_TTL);
+    item->assign_value(value);
+    BOOST_CHECK(not item->has_cas());
+    BOOST_CHECK_EQUAL(item->timestamp(), 0u);
+    BOOST_CHECK(item->key() == key);
+    BOOST_CHECK(item->value() == value);
+    BOOST_CHECK_EQUAL(item->hash(), hash);
+    BOOST_CHECK_EQUAL(item->opaque_flags(), 42);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+} // anonymouse namespace
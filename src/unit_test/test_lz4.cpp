@@ -0,0 +1,63 @@
+#include "unit_test.h"
+#include <cachelot/lz4.h>
+#include <cachelot/random.h>
+
+namespace {
+
+using namespace cachelot;
+
+BOOST_AUTO_TEST_SUITE(test_lz4)
+
+static string roundtrip(const string & original, size_t & compressed_length) {
+    std::vector<char> compressed(original.size() + original.size() / 255 + 16);
+    compressed_length = lz4::compress(slice(original.c_str(), original.size()), compressed.data(), compressed.size());
+    BOOST_REQUIRE(compressed_length > 0);
+    string restored(original.size(), '\0');
+    const auto restored_length = lz4::decompress(slice(compressed.data(), compressed_length), &restored[0], restored.size());
+    BOOST_CHECK_EQUAL(restored_length, original.size());
+    return restored;
+}
+
+BOOST_AUTO_TEST_CASE(test_lz4_roundtrip) {
+    size_t compressed_length;
+    // short inputs are stored as literals
+    for (size_t len = 0; len < 20; ++len) {
+        const string original = random_string(len, len);
+        BOOST_CHECK(roundtrip(original, compressed_length) == original);
+    }
+    // random data doesn't compress
+    const string noise = random_string(100000, 100000);
+    BOOST_CHECK(roundtrip(noise, compressed_length) == noise);
+    // repetitive data and long runs (overlapping matches)
+    string json;
+    for (int i = 0; i < 1000; ++i) {
+        json += "{\"id\": " + std::to_string(i) + ", \"name\": \"item\", \"tags\": [\"a\", \"b\"]},";
+    }
+    BOOST_CHECK(roundtrip(json, compressed_length) == json);
+    BOOST_CHECK(compressed_length * 4 < json.size());
+    const string run(70000, 'x');
+    BOOST_CHECK(roundtrip(run, compressed_length) == run);
+    BOOST_CHECK(compressed_length < 400);
+}
+
+BOOST_AUTO_TEST_CASE(test_lz4_limits) {
+    string json;
+    for (int i = 0; i < 100; ++i) {
+        json += "{\"id\": " + std::to_string(i) + "},";
+    }
+    char compressed[4096];
+    const size_t compressed_length = lz4::compress(slice(json.c_str(), json.size()), compressed, sizeof(compressed));
+    BOOST_REQUIRE(compressed_length > 0);
+    // output doesn't fit
+    BOOST_CHECK_EQUAL(lz4::compress(slice(json.c_str(), json.size()), compressed, compressed_length - 1), 0);
+    string restored(json.size(), '\0');
+    BOOST_CHECK_EQUAL(lz4::decompress(slice(compressed, compressed_length), &restored[0], json.size() - 1), 0);
+    // malformed input
+    BOOST_CHECK_EQUAL(lz4::decompress(slice(compressed, compressed_length - 1), &restored[0], json.size()), 0);
+    const char bad_offset[] = { 0x10, 'a', 0x05, 0x00 };
+    BOOST_CHECK_EQUAL(lz4::decompress(slice(bad_offset, sizeof(bad_offset)), &restored[0], json.size()), 0);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+}
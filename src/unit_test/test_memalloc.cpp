@@ -1,5 +1,7 @@
 #include "unit_test.h"
 #include <cachelot/memalloc.h>
+#include <set>
+#include <map>
 
 
 namespace {
@@ -373,6 +375,141 @@ BOOST_AUTO_TEST_CASE(memalloc_stress_test) {
 }
 
 
+BOOST_AUTO_TEST_CASE(test_tiny_slots) {
+    static constexpr size_t MEM_SIZE = 64 * Kilobyte;
+    static constexpr size_t MEM_PAGE_SIZE = 4 * Kilobyte;
+    static constexpr size_t num_pages = MEM_SIZE / MEM_PAGE_SIZE;
+    ResetStats();
+    // fill allocator with tiny allocations without eviction
+    size_t num_packed = 0;
+    {
+        memalloc allocator(MEM_SIZE, MEM_PAGE_SIZE, true);
+        std::vector<void *> allocations;
+        while (void * ptr = allocator.alloc(32)) {
+            BOOST_CHECK_EQUAL(allocator.reveal_actual_size(ptr), 32u);
+            BOOST_CHECK(unaligned_bytes(ptr, alignof(void *)) == 0);
+            std::memset(ptr, static_cast<int>(allocations.size() & 0xFF), 32);
+            allocations.push_back(ptr);
+        }
+        num_packed = allocations.size();
+        BOOST_CHECK_EQUAL(STAT_GET(mem,num_tiny_pages), num_pages);
+        BOOST_CHECK_EQUAL(STAT_GET(mem,used_memory), num_packed * 32);
+        // tiny slot can't grow
+        BOOST_CHECK(allocator.realloc_inplace(allocations[0], 24) == allocations[0]);
+        BOOST_CHECK(allocator.realloc_inplace(allocations[0], 100) == nullptr);
+        // content is intact
+        for (size_t n = 0; n < allocations.size(); ++n) {
+            auto bytes = reinterpret_cast<const uint8 *>(allocations[n]);
+            BOOST_CHECK(std::all_of(bytes, bytes + 32, [=](uint8 b) { return b == (n & 0xFF); }));
+        }
+        // freed slot is reused
+        void * freed = allocations[allocations.size() / 2];
+        allocator.free(freed);
+        BOOST_CHECK(allocator.alloc(30) == freed);
+        // whole pages are released once all slots are free
+        for (auto ptr : allocations) {
+            allocator.free(ptr);
+        }
+        BOOST_CHECK_EQUAL(STAT_GET(mem,num_tiny_pages), 0u);
+        BOOST_CHECK_EQUAL(STAT_GET(mem,used_memory), 0u);
+        // now we can allocate the whole page
+        BOOST_CHECK(allocator.alloc(MEM_PAGE_SIZE - memalloc::header_size()) != nullptr);
+    }
+    // the same without packing
+    size_t num_regular = 0;
+    {
+        memalloc allocator(MEM_SIZE, MEM_PAGE_SIZE, false);
+        while (allocator.alloc(32) != nullptr) {
+            num_regular += 1;
+        }
+    }
+    BOOST_CHECK(num_packed > num_regular * 3 / 2);
+    // evictions
+    ResetStats();
+    {
+        memalloc allocator(MEM_SIZE, MEM_PAGE_SIZE, true);
+        std::set<void *> allocations;
+        random_int<size_t> random_size(1, 300);
+        uint64 my_used_memory = 0;
+        for (size_t n = 0; n < 100000; ++n) {
+            auto ptr = allocator.alloc_or_evict(random_size(), true, [&](void * mem) {
+                BOOST_CHECK(allocations.erase(mem) == 1);
+                my_used_memory -= allocator.reveal_actual_size(mem);
+            });
+            BOOST_CHECK(ptr != nullptr);
+            BOOST_CHECK(allocations.insert(ptr).second);
+            my_used_memory += allocator.reveal_actual_size(ptr);
+            if (probably(30)) {
+                auto it = allocations.begin();
+                std::advance(it, random_int<size_t>(0, allocations.size() - 1)());
+                my_used_memory -= allocator.reveal_actual_size(*it);
+                allocator.free(*it);
+                allocations.erase(it);
+            }
+        }
+        BOOST_CHECK_EQUAL(STAT_GET(mem,used_memory), my_used_memory);
+        BOOST_CHECK(STAT_GET(mem,evictions) > 0);
+        for (auto ptr : allocations) {
+            allocator.free(ptr);
+        }
+        BOOST_CHECK_EQUAL(STAT_GET(mem,used_memory), 0u);
+        BOOST_CHECK_EQUAL(STAT_GET(mem,num_tiny_pages), 0u);
+    }
+}
+
+
+BOOST_AUTO_TEST_CASE(test_compaction) {
+    static constexpr size_t MEM_SIZE = 64 * Kilobyte;
+    static constexpr size_t MEM_PAGE_SIZE = 4 * Kilobyte;
+    memalloc allocator(MEM_SIZE, MEM_PAGE_SIZE, false);
+    // fill the whole memory, then free 7 of every 8 blocks leaving every page sparse
+    std::vector<void *> all;
+    while (void * ptr = allocator.alloc(200)) {
+        all.push_back(ptr);
+    }
+    std::map<void *, uint8> allocations;
+    for (size_t n = 0; n < all.size(); ++n) {
+        if (n % 8 == 0) {
+            std::memset(all[n], static_cast<int>(n & 0xFF), 200);
+            allocations[all[n]] = static_cast<uint8>(n & 0xFF);
+        } else {
+            allocator.free(all[n]);
+        }
+    }
+    size_t free_total, free_fragmented;
+    tie(free_total, free_fragmented) = allocator.free_memory();
+    BOOST_CHECK(free_fragmented == free_total);
+    BOOST_CHECK(allocator.alloc(MEM_PAGE_SIZE - memalloc::header_size()) == nullptr);
+    // pinned block keeps its page
+    void * pinned = allocations.begin()->first;
+    const auto can_move = [=](void * ptr) { return ptr != pinned; };
+    const auto on_moved = [&](void * from, void * to) {
+        BOOST_REQUIRE(allocations.count(from) == 1);
+        allocations[to] = allocations[from];
+        allocations.erase(from);
+    };
+    size_t total_moved = 0;
+    while (size_t moved = allocator.compact(MEM_SIZE, can_move, on_moved)) {
+        total_moved += moved;
+    }
+    BOOST_CHECK(total_moved > 0);
+    BOOST_CHECK(allocations.count(pinned) == 1);
+    tie(free_total, free_fragmented) = allocator.free_memory();
+    BOOST_CHECK(free_fragmented < free_total / 2);
+    // content survived relocation
+    for (const auto & a : allocations) {
+        auto bytes = reinterpret_cast<const uint8 *>(a.first);
+        BOOST_CHECK(std::all_of(bytes, bytes + 200, [=](uint8 b) { return b == a.second; }));
+    }
+    // freed pages serve the big allocations
+    BOOST_CHECK(allocator.alloc(MEM_PAGE_SIZE - memalloc::header_size()) != nullptr);
+    for (const auto & a : allocations) {
+        allocator.free(a.first);
+    }
+}
+
+
+
 BOOST_AUTO_TEST_SUITE_END()
 
 #endif // ifndef ADDRESS_SANITIZER
@@ -0,0 +1,124 @@
+#include "unit_test.h"
+#include <cachelot/mempools.h>
+#include <cachelot/random.h>
+#include <set>
+#include <map>
+
+namespace {
+
+using namespace cachelot;
+
+BOOST_AUTO_TEST_SUITE(test_mempools)
+
+// allocator doesn't evict under ASAN
+#if !defined(ADDRESS_SANITIZER)
+
+BOOST_AUTO_TEST_CASE(test_pools_routing) {
+    mempools allocator(1 * Megabyte, { 64 * Kilobyte, 4 * Kilobyte }, true);
+    BOOST_CHECK_EQUAL(allocator.page_size, 64 * Kilobyte);
+    auto pools = allocator.pools_info();
+    BOOST_REQUIRE_EQUAL(pools.size(), 2);
+    BOOST_CHECK_EQUAL(pools[0].page_size, 4 * Kilobyte);
+    BOOST_CHECK_EQUAL(pools[1].page_size, 64 * Kilobyte);
+    BOOST_CHECK_EQUAL(pools[0].memory + pools[1].memory, 1 * Megabyte);
+    // small and big allocations are placed in the different pools
+    void * small = allocator.alloc(100);
+    void * big = allocator.alloc(32 * Kilobyte);
+    BOOST_REQUIRE(small != nullptr && big != nullptr);
+    BOOST_CHECK(allocator.usable_size(small) < 4 * Kilobyte);
+    BOOST_CHECK(allocator.usable_size(big) >= 32 * Kilobyte);
+    // block can't grow beyond the page of its pool
+    BOOST_CHECK(allocator.realloc_inplace(small, 8 * Kilobyte) == nullptr);
+    BOOST_CHECK(allocator.realloc_inplace(big, 48 * Kilobyte) != nullptr);
+    allocator.free(small);
+    allocator.free(big);
+}
+
+
+BOOST_AUTO_TEST_CASE(test_pools_rebalance) {
+    mempools allocator(1 * Megabyte, { 4 * Kilobyte, 64 * Kilobyte }, false);
+    std::set<void *> live;
+    auto on_evict = [&](void * ptr) {
+        BOOST_CHECK(live.erase(ptr) == 1);
+    };
+    // fill the big pool
+    for (int i = 0; i < 32; ++i) {
+        void * ptr = allocator.alloc_or_evict(30 * Kilobyte, true, on_evict);
+        BOOST_REQUIRE(ptr != nullptr);
+        live.insert(ptr);
+    }
+    const auto initial_small_pool = allocator.pools_info()[0].memory;
+    // small pool is under pressure, big pool isn't evicting at all
+    const auto initial_rebalances = STAT_GET(mem, num_pool_rebalances);
+    random_int<size_t> rnd_size(100, 1000);
+    for (int i = 0; i < 20000; ++i) {
+        void * ptr = allocator.alloc_or_evict(rnd_size(), true, on_evict);
+        BOOST_REQUIRE(ptr != nullptr);
+        live.insert(ptr);
+    }
+    const auto pools = allocator.pools_info();
+    BOOST_CHECK(STAT_GET(mem, num_pool_rebalances) > initial_rebalances);
+    BOOST_CHECK(pools[0].memory > initial_small_pool);
+    BOOST_CHECK_EQUAL(pools[1].memory, 64 * Kilobyte);  // the last region is kept
+    BOOST_CHECK_EQUAL(pools[0].memory + pools[1].memory, 1 * Megabyte);
+    // every surviving block is valid
+    for (auto ptr : live) {
+        allocator.free(ptr);
+    }
+}
+
+
+BOOST_AUTO_TEST_CASE(test_resize) {
+    mempools allocator(1 * Megabyte, { 4 * Kilobyte, 64 * Kilobyte }, false);
+    std::map<void *, uint8> live;
+    auto on_evict = [&](void * ptr) {
+        BOOST_CHECK(live.erase(ptr) == 1);
+    };
+    // a quarter of memory is in use
+    for (int i = 0; i < 64; ++i) {
+        void * ptr = allocator.alloc(4000);
+        BOOST_REQUIRE(ptr != nullptr);
+        std::memset(ptr, i, 4000);
+        live[ptr] = static_cast<uint8>(i);
+    }
+    const auto on_moved = [&](void * from, void * to) {
+        BOOST_REQUIRE(live.count(from) == 1);
+        live[to] = live[from];
+        live.erase(from);
+    };
+    const auto can_move = [](void *) { return true; };
+    allocator.resize(512 * Kilobyte, on_evict, can_move, on_moved);
+    BOOST_CHECK_EQUAL(allocator.online_size(), 512 * Kilobyte);
+    const auto pools = allocator.pools_info();
+    BOOST_CHECK_EQUAL(pools[0].memory + pools[1].memory, 512 * Kilobyte);
+    // items are moved out of the released regions, nothing is evicted
+    BOOST_CHECK_EQUAL(live.size(), 64);
+    for (const auto & kv : live) {
+        auto bytes = reinterpret_cast<const uint8 *>(kv.first);
+        BOOST_CHECK(std::all_of(bytes, bytes + 4000, [=](uint8 b) { return b == kv.second; }));
+    }
+    // shrink to the minimum, items which don't fit are evicted
+    allocator.resize(allocator.min_size(), on_evict, can_move, on_moved);
+    BOOST_CHECK_EQUAL(allocator.online_size(), 256 * Kilobyte);
+    BOOST_CHECK(live.size() < 64);
+    // memory comes back
+    allocator.resize(1 * Megabyte, on_evict, can_move, on_moved);
+    BOOST_CHECK_EQUAL(allocator.online_size(), 1 * Megabyte);
+    std::vector<void *> big;
+    while (void * ptr = allocator.alloc(60 * Kilobyte)) {
+        big.push_back(ptr);
+    }
+    BOOST_CHECK(big.size() >= 8);
+    for (auto ptr : big) {
+        allocator.free(ptr);
+    }
+    for (const auto & kv : live) {
+        allocator.free(kv.first);
+    }
+}
+
+#endif // ADDRESS_SANITIZER
+
+BOOST_AUTO_TEST_SUITE_END()
+
+}
@@ -0,0 +1,158 @@
+#include "unit_test.h"
+#include <cachelot/segmalloc.h>
+#include <cachelot/random.h>
+#include <deque>
+#include <map>
+
+namespace {
+
+using namespace cachelot;
+
+BOOST_AUTO_TEST_SUITE(test_segmalloc)
+
+static constexpr size_t MEM_SIZE = 1 * Megabyte;
+static constexpr uint32 SEGMENT_SIZE = 64 * Kilobyte;
+
+
+BOOST_AUTO_TEST_CASE(test_append_and_free) {
+    segmalloc allocator(MEM_SIZE, SEGMENT_SIZE);
+    BOOST_CHECK_EQUAL(allocator.page_size, SEGMENT_SIZE);
+    void * first = allocator.alloc(100);
+    void * second = allocator.alloc(100);
+    BOOST_REQUIRE(first != nullptr && second != nullptr);
+    // blocks are appended one after another
+    BOOST_CHECK_EQUAL(allocator.usable_size(first), 104);
+    BOOST_CHECK(reinterpret_cast<uint8 *>(second) == reinterpret_cast<uint8 *>(first) + 104 + segmalloc::header_size());
+    // only the last block is able to grow
+    BOOST_CHECK(allocator.realloc_inplace(first, 200) == nullptr);
+    BOOST_CHECK(allocator.realloc_inplace(first, 50) == first);
+    BOOST_CHECK(allocator.realloc_inplace(second, 1000) == second);
+    BOOST_CHECK_EQUAL(allocator.usable_size(second), 1000);
+    // the biggest allocation takes the whole segment
+    void * big = allocator.alloc(SEGMENT_SIZE - segmalloc::header_size());
+    BOOST_REQUIRE(big != nullptr);
+    allocator.free(first);
+    allocator.free(second);
+    allocator.free(big);
+    size_t free_total, free_fragmented;
+    tie(free_total, free_fragmented) = allocator.free_memory();
+    BOOST_CHECK_EQUAL(free_total, MEM_SIZE);
+    BOOST_CHECK_EQUAL(free_fragmented, 0);
+}
+
+
+BOOST_AUTO_TEST_CASE(test_fifo_eviction) {
+    segmalloc allocator(MEM_SIZE, SEGMENT_SIZE);
+    std::deque<void *> live;
+    size_t num_evicted = 0;
+    auto on_evict = [&](void * ptr) {
+        // the oldest blocks go first
+        BOOST_REQUIRE(not live.empty());
+        BOOST_CHECK(live.front() == ptr);
+        live.pop_front();
+        num_evicted += 1;
+    };
+    for (int i = 0; i < 5000; ++i) {
+        void * ptr = allocator.alloc_or_evict(1000, true, on_evict);
+        BOOST_REQUIRE(ptr != nullptr);
+        live.push_back(ptr);
+    }
+    BOOST_CHECK(num_evicted > 0);
+    BOOST_CHECK(allocator.pools_info()[0].num_evicted_pages > 0);
+    // allocations fail once the eviction is not allowed
+    BOOST_CHECK(allocator.alloc(SEGMENT_SIZE - segmalloc::header_size()) == nullptr);
+    for (auto ptr : live) {
+        allocator.free(ptr);
+    }
+}
+
+
+BOOST_AUTO_TEST_CASE(test_expired_segments) {
+    segmalloc allocator(MEM_SIZE, SEGMENT_SIZE);
+    const auto past = cache::ExpirationClock::now() - cache::seconds(1);
+    const auto future = cache::ExpirationClock::now() + cache::seconds(3600);
+    std::map<void *, bool> live; // block -> whether it's expired
+    size_t num_evicted_expired = 0, num_evicted_alive = 0;
+    auto on_evict = [&](void * ptr) {
+        BOOST_REQUIRE(live.count(ptr) == 1);
+        (live[ptr] ? num_evicted_expired : num_evicted_alive) += 1;
+        live.erase(ptr);
+    };
+    // the memory is filled with the items expiring in the future except the single segment in the middle
+    const size_t blocks_per_segment = SEGMENT_SIZE / (1000 + segmalloc::header_size());
+    const size_t num_blocks = (MEM_SIZE / SEGMENT_SIZE) * blocks_per_segment;
+    for (size_t n = 0; n < num_blocks; ++n) {
+        void * ptr = allocator.alloc_or_evict(1000, true, on_evict);
+        BOOST_REQUIRE(ptr != nullptr);
+        const bool expired = n / blocks_per_segment == 5;
+        allocator.expire_at(ptr, expired ? past : future);
+        live[ptr] = expired;
+    }
+    BOOST_REQUIRE_EQUAL(num_evicted_expired + num_evicted_alive, 0);
+    const auto expired_before = STAT_GET(mem, num_expired_segments);
+    // expired segment is dropped instead of the oldest one
+    void * ptr = allocator.alloc_or_evict(1000, true, on_evict);
+    BOOST_REQUIRE(ptr != nullptr);
+    BOOST_CHECK_EQUAL(num_evicted_expired, blocks_per_segment);
+    BOOST_CHECK_EQUAL(num_evicted_alive, 0);
+    BOOST_CHECK_EQUAL(STAT_GET(mem, num_expired_segments), expired_before + 1);
+    allocator.free(ptr);
+    for (const auto & kv : live) {
+        allocator.free(kv.first);
+    }
+}
+
+
+BOOST_AUTO_TEST_CASE(test_cleaner) {
+    segmalloc allocator(MEM_SIZE, SEGMENT_SIZE);
+    std::vector<void *> all;
+    while (void * ptr = allocator.alloc(200)) {
+        all.push_back(ptr);
+    }
+    // keep 1 of every 8 blocks
+    std::map<void *, uint8> allocations;
+    for (size_t n = 0; n < all.size(); ++n) {
+        if (n % 8 == 0) {
+            std::memset(all[n], static_cast<int>(n & 0xFF), 200);
+            allocations[all[n]] = static_cast<uint8>(n & 0xFF);
+        } else {
+            allocator.free(all[n]);
+        }
+    }
+    size_t free_total, free_fragmented;
+    tie(free_total, free_fragmented) = allocator.free_memory();
+    BOOST_CHECK(free_fragmented > free_total / 2);
+    BOOST_CHECK(allocator.alloc(SEGMENT_SIZE - segmalloc::header_size()) == nullptr);
+    // pinned block keeps its segment
+    void * pinned = allocations.begin()->first;
+    const auto can_move = [=](void * ptr) { return ptr != pinned; };
+    const auto on_moved = [&](void * from, void * to) {
+        BOOST_REQUIRE(allocations.count(from) == 1);
+        allocations[to] = allocations[from];
+        allocations.erase(from);
+    };
+    size_t total_moved = 0;
+    while (size_t moved = allocator.compact(MEM_SIZE, can_move, on_moved)) {
+        total_moved += moved;
+    }
+    BOOST_CHECK(total_moved > 0);
+    BOOST_CHECK(allocations.count(pinned) == 1);
+    tie(free_total, free_fragmented) = allocator.free_memory();
+    BOOST_CHECK(free_fragmented < free_total / 2);
+    for (const auto & a : allocations) {
+        auto bytes = reinterpret_cast<const uint8 *>(a.first);
+        BOOST_CHECK(std::all_of(bytes, bytes + 200, [=](uint8 b) { return b == a.second; }));
+    }
+    // cleaned segments serve the big allocations
+    void * big = allocator.alloc(SEGMENT_SIZE - segmalloc::header_size());
+    BOOST_CHECK(big != nullptr);
+    allocator.free(big);
+    for (const auto & a : allocations) {
+        allocator.free(a.first);
+    }
+}
+
+
+BOOST_AUTO_TEST_SUITE_END()
+
+}
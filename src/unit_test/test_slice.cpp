@@ -48,6 +48,31 @@ BOOST_AUTO_TEST_CASE(test_basic) {
     BOOST_CHECK(rest2.endswith(slice::from_literal("World?")));
 }
 
+BOOST_AUTO_TEST_CASE(test_search_separator) {
+    // separator at every position of the buffer longer than a few vector registers
+    constexpr size_t buffer_length = 100;
+    char buffer[buffer_length + 1];
+    for (size_t length = 0; length <= buffer_length; ++length) {
+        const slice haystack(buffer, length);
+        for (size_t pos = 0; pos < length; ++pos) {
+            std::memset(buffer, 'a', buffer_length);
+            buffer[pos] = ' ';
+            BOOST_CHECK(haystack.search(slice::from_literal(" ")).begin() == buffer + pos);
+            slice before, after;
+            tie(before, after) = haystack.split(' ');
+            BOOST_CHECK(before.length() == pos && after.length() == length - pos - 1);
+            // "\r\n" must not be found when '\n' is beyond the end
+            buffer[pos] = '\r';
+            buffer[pos + 1] = '\n';
+            const slice found = haystack.search(slice::from_literal("\r\n"));
+            BOOST_CHECK(pos + 1 < length ? found.begin() == buffer + pos : found.empty());
+        }
+        std::memset(buffer, '\r', buffer_length);
+        BOOST_CHECK(haystack.search(slice::from_literal(" ")).empty());
+        BOOST_CHECK(haystack.search(slice::from_literal("\r\n")).empty());
+    }
+}
+
 
 BOOST_AUTO_TEST_SUITE_END()
 
@@ -146,6 +146,27 @@ BOOST_AUTO_TEST_CASE(test_str_to_int) {
     CHECK_SYSTEM_ERROR(str_to_int<unsigned int>(s.begin(), s.end()), error::numeric_convert);
 }
 
+BOOST_AUTO_TEST_CASE(test_str_to_int_contiguous) {
+    // `const char *` input is converted 8 digits at once
+    const auto convert = [](const string & s) -> uint64 { return str_to_int<uint64>(s.data(), s.data() + s.size()); };
+    string s = "1234567";
+    for (uint64 expected = 1234567; s.size() < 20; s += '8', expected = expected * 10 + 8) {
+        BOOST_CHECK_EQUAL(convert(s), expected);
+    }
+    BOOST_CHECK_EQUAL(convert("18446744073709551615"), std::numeric_limits<uint64>::max());
+    BOOST_CHECK_EQUAL(convert("0000000000000000042"), 42);
+    // non-digit at every position
+    for (size_t length = 1; length < 20; ++length) {
+        for (size_t pos = 0; pos < length; ++pos) {
+            for (char non_digit : { '/', ':', ' ', '\x80', '\xff' }) {
+                s.assign(length, '5');
+                s[pos] = non_digit;
+                CHECK_SYSTEM_ERROR(convert(s), error::numeric_convert);
+            }
+        }
+    }
+}
+
 BOOST_AUTO_TEST_SUITE_END()
 
 } // anonymouse namespace
@@ -22,6 +22,7 @@ SELF, _ = os.path.splitext(os.path.basename(sys.argv[0]))
 BASEDIR = os.path.normpath(os.path.dirname(os.path.abspath(sys.argv[0])) + '/..')
 MEMORY_LIMIT = 1024*1024*1024*4  # Gb
 CACHELOTD = os.path.join(BASEDIR, 'bin/RelWithDebugInfo/cachelotd -m%d' % toMb(MEMORY_LIMIT))
+CACHELOTD_NO_CAS = CACHELOTD + ' --no-cas'
 MEMCACHED = '/usr/bin/memcached -m%d' % toMb(MEMORY_LIMIT)
 NUM_RUNS = 10
 
@@ -29,7 +30,8 @@ KEY_ALPHABET = string.ascii_letters + string.digits
 KEY_MINLEN = 10
 KEY_MAXLEN = 60
 
-VALUE_RANGES = [('small',    10,    1024),
+VALUE_RANGES = [('tiny',     10,     100),
+                ('small',    10,    1024),
                 ('medium', 1024,    4096),
                 ('large',  4096, 1000000),
                 ('all',      10, 1000000)]
@@ -92,6 +94,19 @@ def log_stats(mc):
             log.log(logging.STAT, '%30s:  %s' % (stat, value))
 
 
+def bytes_per_item(mc, effective_mem, stored_items):
+    """ Calculate average amount of memory occupied by the single item
+        and its overhead (memory occupied in addition to the key and value)
+    """
+    stats = dict(mc.stats())
+    used_memory = int(stats.get('used_memory', stats.get('bytes', 0)))
+    curr_items = int(stats.get('curr_items', 0))
+    if curr_items == 0 or stored_items == 0:
+        return 0.0, 0.0
+    per_item = used_memory * 1.0 / curr_items
+    return per_item, per_item - effective_mem * 1.0 / stored_items
+
+
 def shell_exec(command):
     devnull = open(os.devnull, 'w')
     return subprocess.Popen(args=shlex.split(command), stdout=devnull, stderr=devnull)
@@ -144,20 +159,24 @@ def execute_test(mc, minval, maxval, memlimit):
     log.debug('  Took: %.2f sec', time.time() - start_time)
     # print statistics
     log_stats(mc)
-    log.info('External effective memory: %.02f/%.02f Mb. (%d/%d items)', toMb(cache_effective_mem), stored_items,
-                                                                         toMb(local_effective_mem), len(all_keys))
-    return (cache_effective_mem, stored_items)
+    log.info('External effective memory: %.02f/%.02f Mb. (%d/%d items)', toMb(cache_effective_mem), toMb(local_effective_mem),
+                                                                         stored_items, len(all_keys))
+    per_item, overhead = bytes_per_item(mc, cache_effective_mem, stored_items)
+    log.info('Bytes per item: %.02f (overhead %.02f)', per_item, overhead)
+    return (cache_effective_mem, stored_items, overhead)
 
 
 def execute_test_n_times(times, mc, minval, maxval, memlimit):
     all_effective_mem = []
     all_stored_items = []
+    all_overhead = []
     for run_no in range(1, times+1):
         log.info('Run #%2d', run_no)
-        effective_mem, stored_items = execute_test(mc, minval, maxval, memlimit)
+        effective_mem, stored_items, overhead = execute_test(mc, minval, maxval, memlimit)
         all_effective_mem.append(effective_mem)
         all_stored_items.append(stored_items)
-    return all_effective_mem, all_stored_items
+        all_overhead.append(overhead)
+    return all_effective_mem, all_stored_items, all_overhead
 
 
 def execute_test_for_values_range(range_name, minval, maxval):
@@ -167,7 +186,16 @@ def execute_test_for_values_range(range_name, minval, maxval):
     cache_process = shell_exec(CACHELOTD + ' -p 11211')
     time.sleep(1) # ensure network is up
     mc = memcached.connect_tcp('localhost', 11211)
-    cachelot_eff_mem, cachelot_items = execute_test_n_times(NUM_RUNS, mc, minval, maxval, MEMORY_LIMIT)
+    cachelot_eff_mem, cachelot_items, cachelot_overhead = execute_test_n_times(NUM_RUNS, mc, minval, maxval, MEMORY_LIMIT)
+    cache_process.terminate()
+    log.info('-' * 60)
+
+    # Run dataset on cachelot without CAS
+    log.info('*** CACHELOT (no CAS) - range "%s" [%d:%d]' % (range_name, minval, maxval))
+    cache_process = shell_exec(CACHELOTD_NO_CAS + ' -p 11213')
+    time.sleep(1)
+    mc = memcached.connect_tcp('localhost', 11213)
+    _, nocas_items, nocas_overhead = execute_test_n_times(NUM_RUNS, mc, minval, maxval, MEMORY_LIMIT)
     cache_process.terminate()
     log.info('-' * 60)
 
@@ -176,7 +204,7 @@ def execute_test_for_values_range(range_name, minval, maxval):
     cache_process = shell_exec(MEMCACHED + ' -p 11212')
     time.sleep(1)
     mc = memcached.connect_tcp('localhost', 11212)
-    memcached_eff_mem, memcached_items = execute_test_n_times(NUM_RUNS, mc, minval, maxval, MEMORY_LIMIT)
+    memcached_eff_mem, memcached_items, memcached_overhead = execute_test_n_times(NUM_RUNS, mc, minval, maxval, MEMORY_LIMIT)
     cache_process.terminate()
     log.info('-' * 60)
     log.info('\n\n')
@@ -185,6 +213,10 @@ def execute_test_for_values_range(range_name, minval, maxval):
     r += 'memDiff: [%s]\n' % ', '.join('%.02f' % toMb(abs(m1 - m2)) for m1, m2 in zip(cachelot_eff_mem, memcached_eff_mem))
     r += 'cachelotItems: [%s]\n' % ', '.join('%d' % i for i in cachelot_items)
     r += 'memcachedItems: [%s]\n' % ', '.join('%d' % i for i in memcached_items)
+    r += 'cachelotNoCASItems: [%s]\n' % ', '.join('%d' % i for i in nocas_items)
+    r += 'cachelotOverheadPerItem: [%s]\n' % ', '.join('%.02f' % b for b in cachelot_overhead)
+    r += 'cachelotNoCASOverheadPerItem: [%s]\n' % ', '.join('%.02f' % b for b in nocas_overhead)
+    r += 'memcachedOverheadPerItem: [%s]\n' % ', '.join('%.02f' % b for b in memcached_overhead)
     return r
 
 
@@ -11,6 +11,9 @@ import memcached
 import time
 import os
 import subprocess
+import socket
+import struct
+import threading
 
 
 SELF, _ = os.path.splitext(os.path.basename(sys.argv[0]))
@@ -170,6 +173,293 @@ def run_smoke_test(mc):
     log.info("all basic functionality tests passed")
 
 
+# binary protocol opcodes and statuses (see thirdparty/memcached/protocol_binary.h)
+BIN_GET, BIN_SET, BIN_ADD, BIN_DELETE, BIN_INCREMENT, BIN_QUIT, BIN_GETQ, BIN_NOOP, BIN_GETK, BIN_APPEND, BIN_PREPEND, BIN_SETQ, BIN_STAT, BIN_TOUCH, BIN_GAT = \
+    0x00, 0x01, 0x02, 0x04, 0x05, 0x07, 0x09, 0x0a, 0x0c, 0x0e, 0x0f, 0x11, 0x10, 0x1c, 0x1d
+BIN_SUCCESS, BIN_KEY_ENOENT, BIN_KEY_EEXISTS, BIN_UNKNOWN_COMMAND = 0x00, 0x01, 0x02, 0x81
+
+
+def bin_request(opcode, key='', value='', extras='', cas=0, opaque=0):
+    header = struct.pack('>BBHBBHIIQ', 0x80, opcode, len(key), len(extras), 0, 0, len(extras) + len(key) + len(value), opaque, cas)
+    return header + extras + key + value
+
+
+def bin_response(sock):
+    def receive(size):
+        data = ''
+        while len(data) < size:
+            chunk = sock.recv(size - len(data))
+            CHECK(chunk)
+            data += chunk
+        return data
+    magic, opcode, keylen, extlen, _, status, bodylen, opaque, cas = struct.unpack('>BBHBBHIIQ', receive(24))
+    CHECK_EQ(magic, 0x81)
+    body = receive(bodylen)
+    return opcode, status, body[:extlen], body[extlen:extlen + keylen], body[extlen + keylen:], opaque, cas
+
+
+def basic_binary_protocol_test(host, port):
+    log.info("binary protocol")
+    sock = socket.create_connection((host, port))
+    key, value = random_key(), random_key()
+    # set / get with flags and CAS
+    sock.sendall(bin_request(BIN_SET, key, value, struct.pack('>II', 42, 0)))
+    _, status, _, _, _, _, cas = bin_response(sock)
+    CHECK_EQ(status, BIN_SUCCESS)
+    sock.sendall(bin_request(BIN_GETK, key, opaque=7))
+    opcode, status, extras, rkey, rvalue, opaque, rcas = bin_response(sock)
+    CHECK_EQ((opcode, status, struct.unpack('>I', extras)[0], rkey, rvalue, opaque, rcas), (BIN_GETK, BIN_SUCCESS, 42, key, value, 7, cas))
+    sock.sendall(bin_request(BIN_ADD, key, value, struct.pack('>II', 0, 0)))
+    CHECK_EQ(bin_response(sock)[1], BIN_KEY_EEXISTS)
+    sock.sendall(bin_request(BIN_SET, key, value, struct.pack('>II', 0, 0), cas=cas + 1))
+    CHECK_EQ(bin_response(sock)[1], BIN_KEY_EEXISTS)
+    # append / prepend honor CAS and reply with the new one
+    key2 = random_key()
+    sock.sendall(bin_request(BIN_SET, key2, 'value', struct.pack('>II', 0, 0)))
+    _, status, _, _, _, _, cas2 = bin_response(sock)
+    CHECK_EQ(status, BIN_SUCCESS)
+    sock.sendall(bin_request(BIN_APPEND, key2, '_right', cas=cas2 + 1))
+    CHECK_EQ(bin_response(sock)[1], BIN_KEY_EEXISTS)
+    sock.sendall(bin_request(BIN_APPEND, key2, '_right', cas=cas2))
+    _, status, _, _, _, _, appended_cas = bin_response(sock)
+    CHECK_EQ(status, BIN_SUCCESS)
+    CHECK(appended_cas not in (0, cas2))
+    sock.sendall(bin_request(BIN_PREPEND, key2, 'left_'))
+    _, status, _, _, _, _, prepended_cas = bin_response(sock)
+    CHECK_EQ(status, BIN_SUCCESS)
+    CHECK(prepended_cas not in (0, appended_cas))
+    sock.sendall(bin_request(BIN_GET, key2))
+    _, status, _, _, rvalue, _, rcas = bin_response(sock)
+    CHECK_EQ((status, rvalue, rcas), (BIN_SUCCESS, 'left_value_right', prepended_cas))
+    # quiet commands respond only with errors and hits, noop flushes the pipeline
+    keys = [random_key() for _ in range(10)]
+    pipeline = ''.join(bin_request(BIN_SETQ, k, k, struct.pack('>II', 0, 0)) for k in keys[:5])
+    pipeline += ''.join(bin_request(BIN_GETQ, k, opaque=n) for n, k in enumerate(keys))
+    sock.sendall(pipeline + bin_request(BIN_NOOP, opaque=100))
+    hits = []
+    while True:
+        opcode, status, _, _, rvalue, opaque, _ = bin_response(sock)
+        if opcode == BIN_NOOP:
+            CHECK_EQ(opaque, 100)
+            break
+        CHECK_EQ((opcode, status), (BIN_GETQ, BIN_SUCCESS))
+        CHECK_EQ(rvalue, keys[opaque])
+        hits.append(opaque)
+    CHECK_EQ(hits, range(5))
+    # counters
+    counter = random_key()
+    sock.sendall(bin_request(BIN_INCREMENT, counter, extras=struct.pack('>QQI', 1, 10, 0xffffffff)))
+    CHECK_EQ(bin_response(sock)[1], BIN_KEY_ENOENT)
+    sock.sendall(bin_request(BIN_INCREMENT, counter, extras=struct.pack('>QQI', 1, 10, 0)))
+    CHECK_EQ(struct.unpack('>Q', bin_response(sock)[4])[0], 10)
+    sock.sendall(bin_request(BIN_INCREMENT, counter, extras=struct.pack('>QQI', 5, 10, 0)))
+    CHECK_EQ(struct.unpack('>Q', bin_response(sock)[4])[0], 15)
+    # touch / gat / delete
+    sock.sendall(bin_request(BIN_TOUCH, key, extras=struct.pack('>I', 100)))
+    CHECK_EQ(bin_response(sock)[1], BIN_SUCCESS)
+    sock.sendall(bin_request(BIN_GAT, key, extras=struct.pack('>I', 100)))
+    CHECK_EQ(bin_response(sock)[4], value)
+    sock.sendall(bin_request(BIN_DELETE, key))
+    CHECK_EQ(bin_response(sock)[1], BIN_SUCCESS)
+    sock.sendall(bin_request(BIN_GET, key))
+    CHECK_EQ(bin_response(sock)[1], BIN_KEY_ENOENT)
+    # stats are terminated by the empty packet
+    sock.sendall(bin_request(BIN_STAT))
+    stats = {}
+    while True:
+        _, status, _, rkey, rvalue, _, _ = bin_response(sock)
+        CHECK_EQ(status, BIN_SUCCESS)
+        if not rkey:
+            break
+        stats[rkey] = rvalue
+    CHECK('curr_items' in stats)
+    sock.sendall(bin_request(0x70))
+    CHECK_EQ(bin_response(sock)[1], BIN_UNKNOWN_COMMAND)
+    sock.sendall(bin_request(BIN_QUIT))
+    CHECK_EQ(bin_response(sock)[0], BIN_QUIT)
+    CHECK_EQ(sock.recv(1), '')
+    sock.close()
+    log.info("-   success")
+
+
+def meta_request(sock, request, num_lines):
+    sock.sendall(request)
+    response = ''
+    while response.count('\r\n') < num_lines:
+        chunk = sock.recv(4096)
+        CHECK(chunk)
+        response += chunk
+    return response.split('\r\n')[:num_lines]
+
+
+def basic_meta_protocol_test(host, port):
+    log.info("meta commands")
+    sock = socket.create_connection((host, port))
+    key, value = random_key(), random_key()
+    # set / get with flags, CAS and opaque
+    CHECK_EQ(meta_request(sock, 'ms %s %d F42 T0\r\n%s\r\n' % (key, len(value), value), 1), ['HD'])
+    header, rvalue = meta_request(sock, 'mg %s v f s t c O7\r\n' % key, 2)
+    CHECK_EQ(rvalue, value)
+    flags = header.split()
+    CHECK_EQ((flags[:3], flags[4:7]), (['VA', str(len(value)), 'O7'], ['f42', 's%d' % len(value), 't-1']))
+    cas = int(flags[3][1:])
+    CHECK_EQ(meta_request(sock, 'ms %s 1 C%d\r\nx\r\n' % (key, cas + 1), 1), ['EX'])
+    CHECK_EQ(meta_request(sock, 'ms %s 1 ME\r\nx\r\n' % key, 1), ['NS'])
+    CHECK_EQ(meta_request(sock, 'ms %s 1 MA\r\nx\r\n' % key, 1), ['HD'])
+    CHECK_EQ(meta_request(sock, 'mg %s v T100 t\r\n' % key, 2), ['VA %d t100' % (len(value) + 1), value + 'x'])
+    # base64 encoded key
+    CHECK_EQ(meta_request(sock, 'ms Zm9vYmFy 3 b\r\nabc\r\n', 1), ['HD'])
+    CHECK_EQ(meta_request(sock, 'mg Zm9vYmFy b k v\r\n', 2), ['VA 3 kZm9vYmFy b', 'abc'])
+    CHECK_EQ(meta_request(sock, 'mg foobar v\r\n', 2), ['VA 3', 'abc'])
+    # quiet misses are omitted, noop flushes the pipeline
+    keys = [random_key() for _ in range(4)]
+    pipeline = ''.join('ms %s 1 q\r\n1\r\n' % k for k in keys[:2])
+    pipeline += ''.join('mg %s v q k\r\n' % k for k in keys)
+    CHECK_EQ(meta_request(sock, pipeline + 'mn\r\n', 5), ['VA 1 k' + keys[0], '1', 'VA 1 k' + keys[1], '1', 'MN'])
+    # counters
+    counter = random_key()
+    CHECK_EQ(meta_request(sock, 'ma %s\r\n' % counter, 1), ['NF'])
+    CHECK_EQ(meta_request(sock, 'ma %s N0 J10 v\r\n' % counter, 2), ['VA 2', '10'])
+    CHECK_EQ(meta_request(sock, 'ma %s D5 v\r\n' % counter, 2), ['VA 2', '15'])
+    CHECK_EQ(meta_request(sock, 'ma %s MD D20 v\r\n' % counter, 2), ['VA 1', '0'])
+    # delete
+    CHECK_EQ(meta_request(sock, 'md %s q\r\nmd %s\r\n' % (key, key), 1), ['NF'])
+    CHECK_EQ(meta_request(sock, 'mg %s\r\n' % key, 1), ['EN'])
+    CHECK(meta_request(sock, 'mg %s X\r\n' % key, 1)[0].startswith('CLIENT_ERROR'))
+    sock.close()
+    log.info("-   success")
+
+
+def split_request_test(host, port):
+    log.info("requests received in many parts")
+    sock = socket.create_connection((host, port))
+    sock.setsockopt(socket.IPPROTO_TCP, socket.TCP_NODELAY, 1)
+    key, value = random_key(), random_key() * 100
+    request = 'set %s 0 0 %d\r\n%s\r\n' % (key, len(value), value)
+    # split inside the header, between '\r' and '\n' of the header and all over the data block
+    header_end = request.index('\r\n')
+    parts = [request[:5], request[5:header_end + 1], request[header_end + 1:header_end + 100]]
+    parts += [request[n:n + 4096] for n in range(header_end + 100, len(request), 4096)]
+    for part in parts:
+        sock.sendall(part)
+        time.sleep(0.01)
+    CHECK_EQ(meta_request(sock, '', 1), ['STORED'])
+    CHECK_EQ(meta_request(sock, 'get %s\r\n' % key, 3), ['VALUE %s 0 %d' % (key, len(value)), value, 'END'])
+    # ill-formed request is reported once the header is complete
+    sock.sendall('set %s 0 0 ' % key)
+    time.sleep(0.01)
+    CHECK(meta_request(sock, 'x\r\n', 1)[0].startswith('CLIENT_ERROR'))
+    sock.close()
+    log.info("-   success")
+
+
+def malformed_request_test(host, port):
+    log.info("ill-formed requests")
+    sock = socket.create_connection((host, port))
+    # connection keeps serving requests after the header with invalid or missing <datalen>
+    for request in ('set x 0 0 -1\r\n', 'set x 0 0\r\n', 'ms k abc\r\n'):
+        CHECK(meta_request(sock, request, 1)[0].startswith('CLIENT_ERROR'))
+        CHECK(meta_request(sock, 'version\r\n', 1)[0].startswith('VERSION'))
+    sock.close()
+    log.info("-   success")
+
+
+def large_value_test(host, port):
+    log.info("large values sent from the item memory")
+    key = random_key()
+    old_value, new_value = 'o' * 100000, 'n' * 100000
+    writer = socket.create_connection((host, port))
+    CHECK_EQ(meta_request(writer, 'set %s 0 0 %d\r\n%s\r\n' % (key, len(old_value), old_value), 1), ['STORED'])
+    # value overwritten right after the get
+    request = 'get %s\r\nset %s 0 0 %d\r\n%s\r\nget %s\r\n' % (key, key, len(new_value), new_value, key)
+    CHECK_EQ(meta_request(writer, request, 7), ['VALUE %s 0 %d' % (key, len(old_value)), old_value, 'END', 'STORED',
+                                                'VALUE %s 0 %d' % (key, len(new_value)), new_value, 'END'])
+    # slow reader keeps the replies pending while the value is overwritten by another connection
+    CHECK_EQ(meta_request(writer, 'set %s 0 0 %d\r\n%s\r\n' % (key, len(old_value), old_value), 1), ['STORED'])
+    reader = socket.socket(socket.AF_INET, socket.SOCK_STREAM)
+    reader.setsockopt(socket.SOL_SOCKET, socket.SO_RCVBUF, 4096)
+    reader.connect((host, port))
+    num_gets = 200
+    reader.sendall('get %s\r\n' % key * num_gets)
+    time.sleep(0.2)
+    CHECK_EQ(meta_request(writer, 'set %s 0 0 %d\r\n%s\r\n' % (key, len(new_value), new_value), 1), ['STORED'])
+    CHECK_EQ(meta_request(writer, 'delete %s\r\n' % key, 1), ['DELETED'])
+    # gets handled after the delete are misses
+    response = ''
+    while response.count('END\r\n') < num_gets:
+        chunk = reader.recv(65536)
+        CHECK(chunk)
+        response += chunk
+    lines = response.split('\r\n')
+    num_hits = 0
+    while lines[0] != '':
+        if lines[0] != 'END':
+            CHECK_EQ(lines[0], 'VALUE %s 0 %d' % (key, len(old_value)))
+            CHECK(lines[1] in (old_value, new_value))
+            CHECK_EQ(lines[2], 'END')
+            lines = lines[2:]
+            num_hits += 1
+        lines = lines[1:]
+    CHECK(num_hits > 0)
+    reader.close()
+    writer.close()
+    log.info("-   success")
+
+
+def large_value_receive_test(host, port):
+    log.info("large values received into the item memory")
+    sock = socket.create_connection((host, port))
+    sock.setsockopt(socket.IPPROTO_TCP, socket.TCP_NODELAY, 1)
+    key, value = random_key(), ''.join(random_key() for _ in range(10000))[:300000]
+    # data block arrives in many parts, followed by the pipelined request
+    request = 'set %s 0 0 %d\r\n%s\r\nget %s\r\n' % (key, len(value), value, key)
+    for n in range(0, len(request), 65536):
+        sock.sendall(request[n:n + 65536])
+        time.sleep(0.01)
+    CHECK_EQ(meta_request(sock, '', 4), ['STORED', 'VALUE %s 0 %d' % (key, len(value)), value, 'END'])
+    # value isn't stored until data block is complete
+    sock.sendall('set %s 0 0 %d\r\n%s' % (key, len(value), 'x' * 100000))
+    time.sleep(0.01)
+    reader = socket.create_connection((host, port))
+    CHECK_EQ(meta_request(reader, 'get %s\r\n' % key, 3), ['VALUE %s 0 %d' % (key, len(value)), value, 'END'])
+    CHECK(meta_request(sock, 'x' * (len(value) - 100000) + 'xx\r\n', 1)[0].startswith('CLIENT_ERROR'))
+    CHECK_EQ(meta_request(reader, 'get %s\r\n' % key, 3), ['VALUE %s 0 %d' % (key, len(value)), value, 'END'])
+    sock.close()
+    # connection closed in the middle of the data block
+    sock = socket.create_connection((host, port))
+    sock.sendall('add %s 0 0 %d\r\n%s' % (key, len(value), 'x' * 100000))
+    sock.close()
+    CHECK_EQ(meta_request(reader, 'delete %s\r\n' % key, 1), ['DELETED'])
+    reader.close()
+    log.info("-   success")
+
+
+def slow_reader_test(host, port):
+    log.info("replies piled up by the client which doesn't read them")
+    key, value = random_key(), 'v' * 15000
+    sock = socket.create_connection((host, port))
+    CHECK_EQ(meta_request(sock, 'set %s 0 0 %d\r\n%s\r\n' % (key, len(value), value), 1), ['STORED'])
+    # replies are much larger than the send buffer may grow, requests arrive few at a time
+    num_gets = 5000
+    def send_requests():
+        for _ in range(num_gets / 10):
+            sock.sendall('get %s\r\n' % key * 10)
+            time.sleep(0.0005)
+    sender = threading.Thread(target=send_requests)
+    sender.start()
+    time.sleep(2)
+    expected = 'VALUE %s 0 %d\r\n%s\r\nEND\r\n' % (key, len(value), value)
+    response = ''
+    while len(response) < len(expected) * num_gets:
+        chunk = sock.recv(1024 * 1024)
+        CHECK(chunk)
+        response += chunk
+    sender.join()
+    CHECK(response == expected * num_gets)
+    sock.close()
+    log.info("-   success")
+
+
 def run_fuzzy_test(mc):
     # TODO: !!!
     pass
@@ -181,6 +471,13 @@ def main():
     ver = mc.version()
     log.info("Version: '%s'", ver)
     run_smoke_test(mc)
+    basic_binary_protocol_test('localhost', 11211)
+    basic_meta_protocol_test('localhost', 11211)
+    split_request_test('localhost', 11211)
+    malformed_request_test('localhost', 11211)
+    large_value_test('localhost', 11211)
+    large_value_receive_test('localhost', 11211)
+    slow_reader_test('localhost', 11211)
 
 if __name__ == '__main__':
     logging.basicConfig(level=logging.DEBUG)